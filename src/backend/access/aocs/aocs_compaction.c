@@ -247,7 +247,11 @@ AOCSMoveTuple(TupleTableSlot	*slot,
 	/* Extract all the values of the tuple */
 	slot_getallattrs(slot);
 
-	(void) aocs_insert_values(insertDesc,
+	/*
+	 * The tuple is buffered and written out column by column with the
+	 * tuples that follow; its new TID is final already.
+	 */
+	(void) aocs_insert_buffered(insertDesc,
 			slot_get_values(slot),
 			slot_get_isnull(slot),
 			&newAoTupleId);
@@ -281,6 +285,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	TupleTableSlot	*slot;
 	int compact_segno;
 	int64 movedTupleCount = 0;
+	int64 droppedTupleCount = 0;
 	ResultRelInfo *resultRelInfo;
 	MemTupleBinding *mt_bind;
 	EState *estate;
@@ -289,6 +294,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	AOTupleId *aoTupleId;
 	int64 tupleCount = 0;
 	int64 tuplePerPage = INT_MAX;
+	TimestampTz startTime = GetCurrentTimestamp();
 
 	Assert (Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoCols(aorel));
@@ -361,6 +367,7 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 							tuple,
 							slot,
 							mt_bind);
+			droppedTupleCount++;
 		}
 
 		/* 
@@ -395,6 +402,9 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		"Finished compaction: "
 		"AO segfile %d, relation %s, moved tuple count " INT64_FORMAT, 
 		compact_segno, relname, movedTupleCount);
+
+	AppendOnlyCompaction_ReportFinished(aorel, compact_segno,
+			movedTupleCount, droppedTupleCount, startTime);
  
 	AppendOnlyVisimap_Finish(&visiMap, NoLock);
 
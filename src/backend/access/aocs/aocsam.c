@@ -27,15 +27,19 @@
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
+#include "utils/datum.h"
 #include "utils/datumstream.h"
 #include "access/aocssegfiles.h"
+#include "executor/executor.h"
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbappendonlyam.h"
 #include "miscadmin.h"
+#include "optimizer/var.h"
 #include "pgstat.h"
 #include "storage/procarray.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/relcache.h"
 #include "utils/syscache.h"
 #include "storage/freespace.h"
@@ -45,6 +49,10 @@
 
 #include "utils/debugbreak.h"
 
+/* Is projected column i only read for the rows that pass the late qualifier? */
+#define AOCS_IS_LATE(scan, i) \
+	((scan)->lateProj != NULL && !(scan)->lateEager && (scan)->lateProj[i])
+
 static AOCSScanDesc
 aocs_beginscan_internal(Relation relation,
 		AOCSFileSegInfo **seginfo,
@@ -229,6 +237,8 @@ open_ds_read(Relation rel, DatumStreamRead **ds, TupleDesc relationTupleDesc,
 	}
 }
 
+bool gp_aocs_late_materialization = true;
+
 static void close_ds_read(DatumStreamRead **ds, int nvp)
 {
     int i;
@@ -268,6 +278,31 @@ static void aocs_initscan(AOCSScanDesc scan)
 				 scan->aos_rel->rd_appendonly->version,
 				 scan->aos_rel->rd_appendonly->checksum);
 
+	/*
+	 * The read-ahead budget is for the whole scan; share it among the
+	 * columns we read so that wide projections don't multiply it.
+	 */
+	if (gp_appendonly_read_ahead > 0)
+	{
+		int		nvp = scan->relationTupleDesc->natts;
+		int		nds = 0;
+		int		i;
+
+		for (i = 0; i < nvp; i++)
+		{
+			if (scan->ds[i])
+				nds++;
+		}
+
+		for (i = 0; i < nvp; i++)
+		{
+			if (scan->ds[i])
+				AppendOnlyStorageRead_SetReadAhead(
+									&scan->ds[i]->ao_read,
+									(gp_appendonly_read_ahead / nds) * 1024);
+		}
+	}
+
     pgstat_count_heap_scan(scan->aos_rel);
 }
 
@@ -332,6 +367,11 @@ static int open_next_scan_seg(AOCSScanDesc scan)
 											firstSequence);
 				}
 
+				AppendOnlyZoneMap_SetSegmentFile(&scan->zoneMap,
+												 (FileSegInfo *) curSegInfo);
+				AppendOnlyVisimap_SetSegmentFile(&scan->visibilityMap,
+												 curSegInfo->segno);
+
 				open_all_datumstreamread_segfiles(
 											  scan->aos_rel,
 											  curSegInfo,
@@ -476,6 +516,7 @@ aocs_beginscan_internal(Relation relation,
 
 	scan->buildBlockDirectory = false;
 	scan->blockDirectory = NULL;
+	scan->zoneMapColumn = -1;
 
 	AppendOnlyVisimap_Init(&scan->visibilityMap,
 						   relation->rd_appendonly->visimaprelid,
@@ -516,10 +557,339 @@ void aocs_endscan(AOCSScanDesc scan)
         pfree(scan->seginfo);
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
+	AppendOnlyZoneMap_Finish(&scan->zoneMap);
+
+	if (scan->lateProj)
+		pfree(scan->lateProj);
+
+	if (scan->dictQual)
+		pfree(scan->dictQual);
 
     pfree(scan);
 }
 
+/*
+ * Evaluate the scan's qualifiers on the columns they reference before the
+ * other projected columns are read. Those are then only read for rows
+ * that pass, and their blocks without such rows are never decompressed.
+ *
+ * qualProj marks the columns referenced by qual, an initialized qualifier
+ * list that is evaluated in econtext. The caller evaluates qual again on
+ * the rows that are returned, so it must be free of volatile functions.
+ * Must be called before the first tuple is fetched.
+ */
+void
+aocs_set_late_qual(AOCSScanDesc scan, bool *qualProj, List *qual,
+				   ExprContext *econtext)
+{
+	int nvp = scan->relationTupleDesc->natts;
+	bool *lateProj;
+	bool haveEarly = false;
+	bool haveLate = false;
+	int i;
+
+	Assert(scan->cur_seg < 0);
+
+	if (!gp_aocs_late_materialization || qual == NIL)
+		return;
+
+	lateProj = palloc0(sizeof(bool) * nvp);
+	for (i = 0; i < nvp; i++)
+	{
+		if (!scan->proj[i])
+			continue;
+
+		if (qualProj[i])
+			haveEarly = true;
+		else
+			lateProj[i] = haveLate = true;
+	}
+
+	if (!haveEarly || !haveLate)
+	{
+		pfree(lateProj);
+		return;
+	}
+
+	scan->lateProj = lateProj;
+	scan->lateQual = qual;
+	scan->lateQualContext = econtext;
+}
+
+/*
+ * Evaluate the scan's qualifiers that reference only one variable-length
+ * column once per dictionary code of its dictionary encoded blocks, and
+ * discard the rows whose code is known to fail before anything else is
+ * done with them.  Equality and IN lists on low-cardinality columns are
+ * thus evaluated a few times per block instead of once per row.
+ *
+ * qual is an initialized qualifier list that is evaluated in econtext.
+ * The caller evaluates qual again on the rows that are returned, so it
+ * must be free of volatile functions.  Must be called before the first
+ * tuple is fetched.
+ */
+void
+aocs_set_dictionary_qual(AOCSScanDesc scan, List *qual, ExprContext *econtext)
+{
+	int nvp = scan->relationTupleDesc->natts;
+	List **colQual;
+	ListCell *lc;
+	int i;
+
+	Assert(scan->cur_seg < 0);
+
+	colQual = palloc0(sizeof(List *) * nvp);
+	foreach(lc, qual)
+	{
+		ExprState *clause = (ExprState *) lfirst(lc);
+		List *vars = pull_var_clause((Node *) clause->expr, true);
+		ListCell *lcv;
+		int col = -1;
+
+		foreach(lcv, vars)
+		{
+			Var *var = (Var *) lfirst(lcv);
+
+			if (var->varlevelsup != 0 || var->varattno <= 0 ||
+				(col >= 0 && var->varattno - 1 != col))
+			{
+				col = -1;
+				break;
+			}
+			col = var->varattno - 1;
+		}
+		list_free(vars);
+
+		if (col < 0 || col >= nvp || !scan->proj[col] ||
+			scan->relationTupleDesc->attrs[col]->attlen != -1)
+			continue;
+
+		/* Rows are discarded before the late columns are read */
+		Assert(!(scan->lateProj && scan->lateProj[col]));
+
+		if (colQual[col] == NIL)
+			scan->ndictQual++;
+		colQual[col] = lappend(colQual[col], clause);
+	}
+
+	if (scan->ndictQual > 0)
+	{
+		int n = 0;
+
+		scan->dictQual = palloc0(sizeof(AOCSDictionaryQual) * scan->ndictQual);
+		for (i = 0; i < nvp; i++)
+		{
+			if (colQual[i] == NIL)
+				continue;
+
+			scan->dictQual[n].col = i;
+			scan->dictQual[n].qual = colQual[i];
+			n++;
+		}
+		scan->dictQualContext = econtext;
+	}
+
+	pfree(colQual);
+}
+
+/*
+ * Whether the current row, whose columns referenced by the dictionary
+ * qualifiers are in slot, can still pass them.  Rows of blocks that are
+ * not dictionary encoded are left to the caller.
+ */
+static bool
+aocs_dictionary_qual(AOCSScanDesc scan, TupleTableSlot *slot, bool *null)
+{
+	int i;
+
+	for (i = 0; i < scan->ndictQual; i++)
+	{
+		AOCSDictionaryQual *dq = &scan->dictQual[i];
+		uint32 dictionaryId;
+		int code;
+
+		if (null[dq->col])
+			continue;
+
+		code = datumstreamread_dictionary_code(scan->ds[dq->col], &dictionaryId);
+		if (code < 0)
+			continue;
+
+		if (dictionaryId != dq->dictionaryId)
+		{
+			memset(dq->result, AOCSDictionaryQual_Unknown, sizeof(dq->result));
+			dq->dictionaryId = dictionaryId;
+		}
+
+		if (dq->result[code] == AOCSDictionaryQual_Unknown)
+		{
+			ExprContext *econtext = scan->dictQualContext;
+
+			econtext->ecxt_scantuple = slot;
+			if (ExecQual(dq->qual, econtext, false))
+				dq->result[code] = AOCSDictionaryQual_Pass;
+			else
+				dq->result[code] = AOCSDictionaryQual_Fail;
+			ResetExprContext(econtext);
+		}
+
+		if (dq->result[code] == AOCSDictionaryQual_Fail)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Skip the blocks of the scan's current segment file that cannot contain
+ * rows satisfying the given qualifiers, as shown by the zone maps of one
+ * of the columns they reference. Must be called before the first tuple
+ * is fetched.
+ */
+void
+aocs_set_zonemap_qual(AOCSScanDesc scan, List *qual)
+{
+	int col;
+
+	Assert(scan->cur_seg < 0);
+
+	AppendOnlyZoneMap_Init(&scan->zoneMap,
+						   scan->aos_rel,
+						   scan->appendOnlyMetaDataSnapshot,
+						   qual);
+	if (scan->zoneMap.numKeys == 0)
+		return;
+
+	col = scan->zoneMap.keys[0].sk_attno - 1;
+	if (col >= scan->relationTupleDesc->natts || !scan->proj[col])
+	{
+		AppendOnlyZoneMap_Finish(&scan->zoneMap);
+		return;
+	}
+
+	scan->zoneMapColumn = col;
+}
+
+/*
+ * Position a column's datum stream so that the next datumstreamread_advance
+ * returns the given row. Blocks that end before the row are skipped
+ * without reading their content.
+ */
+static void
+aocs_skip_to_row(DatumStreamRead *ds, int64 rowNum)
+{
+	if (rowNum >= ds->blockFirstRowNum + ds->blockRowCount)
+	{
+		for (;;)
+		{
+			if (datumstreamread_block_header(ds) < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_GP_INTERNAL_ERROR),
+						 errmsg("Unexpected end of column file trying to find row " INT64_FORMAT " in table '%s'",
+								rowNum,
+								AppendOnlyStorageRead_RelationName(&ds->ao_read))));
+
+			if (rowNum < ds->blockFirstRowNum + ds->blockRowCount)
+				break;
+
+			AppendOnlyStorageRead_SkipCurrentBlock(&ds->ao_read);
+		}
+		datumstreamread_block_content(ds);
+	}
+
+	if (rowNum > ds->blockFirstRowNum)
+		datumstreamread_find(ds, rowNum - ds->blockFirstRowNum - 1);
+}
+
+/*
+ * Do the blocks of the segment file just opened lack row numbers, as those
+ * written before 4.0 do?  The first block of each column has been read.
+ */
+static bool
+aocs_seg_lacks_row_numbers(AOCSScanDesc scan)
+{
+	int i;
+
+	for (i = 0; i < scan->relationTupleDesc->natts; i++)
+	{
+		if (scan->proj[i] && !scan->lateProj[i])
+			return scan->ds[i]->blockFirstRowNum < 0;
+	}
+
+	return false;
+}
+
+/*
+ * Read the late columns of row rowNum, which passed the late qualifier,
+ * into the slot.
+ */
+static void
+aocs_fetch_late_columns(AOCSScanDesc scan, TupleTableSlot *slot, int ncol,
+						int64 rowNum)
+{
+	Datum *d = slot_get_values(slot);
+	bool *null = slot_get_isnull(slot);
+	int err;
+	int i;
+
+	Assert(rowNum != INT64CONST(-1));
+	for (i = 0; i < ncol; i++)
+	{
+		if (!scan->lateProj[i])
+			continue;
+
+		aocs_skip_to_row(scan->ds[i], rowNum);
+		err = datumstreamread_advance(scan->ds[i]);
+		Assert(err > 0);
+		datumstreamread_get(scan->ds[i], &d[i], &null[i]);
+	}
+}
+
+/*
+ * Read the next block of the zone map column, skipping the blocks that the
+ * zone maps exclude, and move the other projected columns to the first row
+ * of the block that is read. skippedRows is the number of rows of the
+ * column's current block that were not returned. Returns false at the end
+ * of the segment file.
+ */
+static bool
+aocs_zonemap_next_block(AOCSScanDesc scan, int64 skippedRows)
+{
+	int col = scan->zoneMapColumn;
+	DatumStreamRead *ds = scan->ds[col];
+	int i;
+
+	for (;;)
+	{
+		if (datumstreamread_block_header(ds) < 0)
+			return false;
+
+		if (!AppendOnlyZoneMap_CanSkipBlock(&scan->zoneMap, col,
+											ds->blockFirstRowNum,
+											ds->blockRowCount,
+											ds->blockFileOffset))
+			break;
+
+		AppendOnlyStorageRead_SkipCurrentBlock(&ds->ao_read);
+		skippedRows += ds->blockRowCount;
+	}
+
+	datumstreamread_block_content(ds);
+
+	if (skippedRows > 0)
+	{
+		/* Late columns are positioned when a row qualifies */
+		for (i = 0; i < scan->relationTupleDesc->natts; i++)
+		{
+			if (i != col && scan->proj[i] && !AOCS_IS_LATE(scan, i))
+				aocs_skip_to_row(scan->ds[i], ds->blockFirstRowNum);
+		}
+		scan->cur_seg_row += skippedRows;
+	}
+
+	return true;
+}
+
 void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
 {
 	int ncol;
@@ -530,6 +900,7 @@ void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *sl
 
 	int err = 0;
 	int i;
+	int k;
 	bool isSnapshotAny = (scan->snapshot == SnapshotAny);
 
 	Assert(ScanDirectionIsForward(direction));
@@ -552,20 +923,58 @@ ReadNext:
 				return;
 			}
 			scan->cur_seg_row = 0;
+
+			if (scan->lateProj)
+				scan->lateEager = aocs_seg_lacks_row_numbers(scan);
+
+			/*
+			 * The first block of each column has been read already; skip
+			 * it, too, if the zone maps exclude it.
+			 */
+			if (scan->zoneMapColumn >= 0)
+			{
+				DatumStreamRead *ds = scan->ds[scan->zoneMapColumn];
+
+				if (AppendOnlyZoneMap_CanSkipBlock(&scan->zoneMap,
+												   scan->zoneMapColumn,
+												   ds->blockFirstRowNum,
+												   ds->blockRowCount,
+												   ds->blockFileOffset) &&
+					!aocs_zonemap_next_block(scan, ds->blockRowCount))
+				{
+					close_cur_scan_seg(scan);
+					err = -1;
+					goto ReadNext;
+				}
+			}
 		}
 
 		Assert(scan->cur_seg >= 0);
 
-		/* Read from cur_seg */
-		for(i=0; i<ncol; ++i)
+		/*
+		 * Read from cur_seg.  The zone map column goes first: when it needs
+		 * a new block, blocks excluded by the zone maps are skipped in all
+		 * columns.
+		 */
+		for(k = (scan->zoneMapColumn >= 0) ? -1 : 0; k < ncol; ++k)
 		{
-			if(scan->proj[i])
+			if (k < 0)
+				i = scan->zoneMapColumn;
+			else if (k == scan->zoneMapColumn)
+				continue;
+			else
+				i = k;
+
+			if(scan->proj[i] && !AOCS_IS_LATE(scan, i))
 			{
 				err = datumstreamread_advance(scan->ds[i]);
 				Assert(err >= 0);
 				if(err == 0)
 				{
-					err = datumstreamread_block(scan->ds[i]);
+					if (i == scan->zoneMapColumn)
+						err = aocs_zonemap_next_block(scan, 0) ? 0 : -1;
+					else
+						err = datumstreamread_block(scan->ds[i]);
 					if(err < 0)
 					{
 						/* Ha, cannot read next block,
@@ -630,6 +1039,31 @@ ReadNext:
 
         TupSetVirtualTupleNValid(slot, ncol);
         slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+
+		if (scan->dictQual != NULL &&
+			!aocs_dictionary_qual(scan, slot, null))
+		{
+			rowNum = INT64CONST(-1);
+			goto ReadNext;
+		}
+
+		if (scan->lateQual != NIL)
+		{
+			ExprContext *econtext = scan->lateQualContext;
+
+			/* Only the qualifier's columns are valid in the slot yet */
+			econtext->ecxt_scantuple = slot;
+			if (!ExecQual(scan->lateQual, econtext, false))
+			{
+				ResetExprContext(econtext);
+				rowNum = INT64CONST(-1);
+				goto ReadNext;
+			}
+
+			if (!scan->lateEager)
+				aocs_fetch_late_columns(scan, slot, ncol, rowNum);
+		}
+
         return;
     }
 
@@ -818,12 +1252,139 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 }
 
 
-Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool * null, AOTupleId *aoTupleId)
+/*
+ * Append the value of column i of row rowNum to the column's datum stream,
+ * writing out the current block when it is full.
+ */
+static void
+aocs_insert_column_value(AOCSInsertDesc idesc, int i, Datum value, bool isnull,
+						 int64 rowNum)
+{
+	void *toFree1;
+	Datum datum = value;
+	int err;
+
+	err = datumstreamwrite_put(idesc->ds[i], datum, isnull, &toFree1);
+	if (toFree1 != NULL)
+	{
+		/*
+		 * Use the de-toasted and/or de-compressed as datum instead.
+		 */
+		datum = PointerGetDatum(toFree1);
+	}
+	if(err < 0)
+	{
+		int itemCount = datumstreamwrite_nth(idesc->ds[i]);
+		void *toFree2;
+
+		/* write the block up to this one */
+		datumstreamwrite_block(idesc->ds[i]);
+		if (itemCount > 0)
+		{
+			/* Insert an entry to the block directory */
+			AppendOnlyBlockDirectory_InsertEntry(
+				&idesc->blockDirectory,
+				i,
+				idesc->ds[i]->blockFirstRowNum,
+				AppendOnlyStorageWrite_LastWriteBeginPosition(&idesc->ds[i]->ao_write),
+				itemCount);
+
+			/* since we have written all up to the new tuple,
+			 * the new blockFirstRowNum is the inserted tuple's row number
+			 */
+			idesc->ds[i]->blockFirstRowNum = rowNum;
+		}
+
+		Assert(idesc->ds[i]->blockFirstRowNum == rowNum);
+
+
+		/* now write this new item to the new block */
+		err = datumstreamwrite_put(idesc->ds[i], datum, isnull, &toFree2);
+		Assert(toFree2 == NULL);
+		if (err < 0)
+		{
+			Assert(!isnull);
+			/*
+			 * rle_type is running on a block stream, if an object spans multiple
+			 * blocks than data will not be compressed (if rle_type is set).
+			 */
+			if ((idesc->compType != NULL) && (pg_strcasecmp(idesc->compType, "rle_type") == 0))
+			{
+				idesc->ds[i]->ao_write.storageAttributes.compress = FALSE;
+			}
+
+			err = datumstreamwrite_lob(idesc->ds[i], datum);
+			Assert(err >= 0);
+
+			/* Insert an entry to the block directory */
+			AppendOnlyBlockDirectory_InsertEntry(
+				&idesc->blockDirectory,
+				i,
+				idesc->ds[i]->blockFirstRowNum,
+				AppendOnlyStorageWrite_LastWriteBeginPosition(&idesc->ds[i]->ao_write),
+				1 /*itemCount -- always just the lob just inserted */
+			);
+
+
+			/*
+			 * A lob will live by itself in the block so
+			 * this assignment is for the block that contains tuples
+			 * AFTER the one we are inserting
+			 */
+			idesc->ds[i]->blockFirstRowNum = rowNum + 1;
+		}
+	}
+
+	/*
+	 * Columns with zone maps are pass-by-value, so they never need
+	 * the large object path above.
+	 */
+	AppendOnlyBlockDirectory_AddZoneMapValue(&idesc->blockDirectory,
+											 i, i, value, isnull);
+
+	if (toFree1 != NULL)
+	{
+		pfree(toFree1);
+	}
+}
+
+/*
+ * Account for nrows rows just written after lastSequence.
+ */
+static void
+aocs_insert_advance_sequences(AOCSInsertDesc idesc, int64 nrows)
 {
 	Relation rel = idesc->aoi_rel;
-	int i;
 
-	if (rel->rd_rel->relhasoids)
+	Assert(nrows <= idesc->numSequences);
+
+	idesc->insertCount += nrows;
+	idesc->lastSequence += nrows;
+	idesc->numSequences -= nrows;
+
+	/*
+	 * If the allocated fast sequence numbers are used up, we request for
+	 * a next list of fast sequence numbers.
+	 */
+	if (idesc->numSequences == 0)
+	{
+		int64 firstSequence;
+
+		firstSequence =
+			GetFastSequences(rel->rd_appendonly->segrelid,
+							 idesc->cur_segno,
+							 idesc->lastSequence + 1,
+							 NUM_FAST_SEQUENCES);
+
+		Assert(firstSequence == idesc->lastSequence + 1);
+		idesc->numSequences = NUM_FAST_SEQUENCES;
+	}
+}
+
+static void
+aocs_insert_check(AOCSInsertDesc idesc)
+{
+	if (idesc->aoi_rel->rd_rel->relhasoids)
 		ereport(ERROR,
 				(errcode(ERRCODE_GP_FEATURE_NOT_SUPPORTED),
 				 errmsg("append-only column-oriented tables do not support rows with OIDs")));
@@ -835,121 +1396,220 @@ Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool * null, AOTupleId *a
 		"",	// databaseName
 		RelationGetRelationName(idesc->aoi_rel)); // tableName
 #endif
+}
+
+Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool * null, AOTupleId *aoTupleId)
+{
+	Relation rel = idesc->aoi_rel;
+	int i;
+
+	/* Rows buffered earlier come first. */
+	if (idesc->batchCount > 0)
+		aocs_insert_flush(idesc);
+
+	aocs_insert_check(idesc);
 
 	/* As usual, at this moment, we assume one col per vp */
 	for(i=0; i< RelationGetNumberOfAttributes(rel); ++i)
+		aocs_insert_column_value(idesc, i, d[i], null[i],
+								 idesc->lastSequence + 1);
+
+	aocs_insert_advance_sequences(idesc, 1);
+
+	AOTupleIdInit_Init(aoTupleId);
+	AOTupleIdInit_segmentFileNum(aoTupleId, idesc->cur_segno);
+	AOTupleIdInit_rowNum(aoTupleId, idesc->lastSequence);
+
+	return InvalidOid;
+}
+
+/*
+ * Insert nrows rows given column by column: colValues[i][r] is the value of
+ * column i in row r.  Each column's datum stream is filled with all its
+ * values before moving on to the next column, so only one column's block
+ * is being built at a time.
+ *
+ * The TIDs of the rows are returned in aoTupleIds, unless it is NULL.
+ */
+void
+aocs_insert_values_batch(AOCSInsertDesc idesc, int nrows,
+						 Datum **colValues, bool **colNulls,
+						 AOTupleId *aoTupleIds)
+{
+	int natts = RelationGetNumberOfAttributes(idesc->aoi_rel);
+	int done = 0;
+
+	if (idesc->batchCount > 0)
+		aocs_insert_flush(idesc);
+
+	while (done < nrows)
 	{
-		void *toFree1;
-		Datum datum;
+		int chunk = nrows - done;
+		int i;
+		int r;
 
-		datum = d[i];
-		int err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
-		if (toFree1 != NULL)
+		/* Stay within the fast sequence numbers already allocated. */
+		if (chunk > idesc->numSequences)
+			chunk = (int) idesc->numSequences;
+
+		for (r = 0; r < chunk; r++)
+			aocs_insert_check(idesc);
+
+		for (i = 0; i < natts; i++)
 		{
-			/*
-			 * Use the de-toasted and/or de-compressed as datum instead.
-			 */
-			datum = PointerGetDatum(toFree1);
+			Datum *values = colValues[i] + done;
+			bool *nulls = colNulls[i] + done;
+
+			for (r = 0; r < chunk; r++)
+				aocs_insert_column_value(idesc, i, values[r], nulls[r],
+										 idesc->lastSequence + 1 + r);
 		}
-		if(err < 0)
-		{
-			int itemCount = datumstreamwrite_nth(idesc->ds[i]);
-			void *toFree2;
 
-			/* write the block up to this one */
-			datumstreamwrite_block(idesc->ds[i]);
-			if (itemCount > 0)
+		if (aoTupleIds != NULL)
+		{
+			for (r = 0; r < chunk; r++)
 			{
-				/* Insert an entry to the block directory */
-				AppendOnlyBlockDirectory_InsertEntry(
-					&idesc->blockDirectory,
-					i,
-					idesc->ds[i]->blockFirstRowNum,
-					AppendOnlyStorageWrite_LastWriteBeginPosition(&idesc->ds[i]->ao_write),
-					itemCount);
-
-				/* since we have written all up to the new tuple,
-				 * the new blockFirstRowNum is the inserted tuple's row number
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 1;
-			}
+				AOTupleId *aoTupleId = &aoTupleIds[done + r];
 
-			Assert(idesc->ds[i]->blockFirstRowNum == idesc->lastSequence + 1);
+				AOTupleIdInit_Init(aoTupleId);
+				AOTupleIdInit_segmentFileNum(aoTupleId, idesc->cur_segno);
+				AOTupleIdInit_rowNum(aoTupleId, idesc->lastSequence + 1 + r);
+			}
+		}
 
+		aocs_insert_advance_sequences(idesc, chunk);
+		done += chunk;
+	}
+}
 
-			/* now write this new item to the new block */
-			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree2);
-			Assert(toFree2 == NULL);
-			if (err < 0)
-			{
-				Assert(!null[i]);
-				/*
-				 * rle_type is running on a block stream, if an object spans multiple
-				 * blocks than data will not be compressed (if rle_type is set).
-				 */
-				if ((idesc->compType != NULL) && (pg_strcasecmp(idesc->compType, "rle_type") == 0))
-				{
-					idesc->ds[i]->ao_write.storageAttributes.compress = FALSE;
-				}
+/*
+ * Number of insert descriptors that currently buffer rows.  Inserts thrown
+ * away by an abort are never counted off, so AtEOXact_AOCSInsert() starts
+ * the count over at the end of each transaction.
+ */
+static int aocsBufferingInserts = 0;
 
-				err = datumstreamwrite_lob(idesc->ds[i], datum);
-				Assert(err >= 0);
+/*
+ * Add a row to the insert's buffer; the buffered rows are written with
+ * aocs_insert_values_batch() once the buffer is full, or on
+ * aocs_insert_flush() or aocs_insert_finish().
+ *
+ * Only AOCS_INSERT_BATCH_MAX_INSERTS inserts buffer rows at a time, to
+ * bound the memory of a statement that writes into many partitions.  The
+ * others write each row right away, like aocs_insert_values().
+ *
+ * The row's values are copied, so the caller may reuse d and null.  The
+ * TID returned is the one the row gets when it is written, so it may go
+ * into indexes right away.  Like the rows of a block that is still being
+ * built, a buffered row cannot be fetched until the insert is finished.
+ */
+Oid
+aocs_insert_buffered(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
+{
+	TupleDesc tupleDesc = RelationGetDescr(idesc->aoi_rel);
+	int natts = tupleDesc->natts;
+	MemoryContext oldcontext;
+	int row;
+	int i;
 
-				/* Insert an entry to the block directory */
-				AppendOnlyBlockDirectory_InsertEntry(
-					&idesc->blockDirectory,
-					i,
-					idesc->ds[i]->blockFirstRowNum,
-					AppendOnlyStorageWrite_LastWriteBeginPosition(&idesc->ds[i]->ao_write),
-					1 /*itemCount -- always just the lob just inserted */
-				);
+	if (idesc->batchDisabled)
+		return aocs_insert_values(idesc, d, null, aoTupleId);
 
+	if (idesc->batchValues == NULL)
+	{
+		MemoryContext descContext;
 
-				/*
-				 * A lob will live by itself in the block so
-				 * this assignment is for the block that contains tuples
-				 * AFTER the one we are inserting
-				 */
-				idesc->ds[i]->blockFirstRowNum = idesc->lastSequence + 2;
-			}
+		if (aocsBufferingInserts >= AOCS_INSERT_BATCH_MAX_INSERTS)
+		{
+			idesc->batchDisabled = true;
+			return aocs_insert_values(idesc, d, null, aoTupleId);
 		}
-
-		if (toFree1 != NULL)
+		aocsBufferingInserts++;
+
+		descContext = GetMemoryChunkContext(idesc);
+
+		idesc->batchContext = AllocSetContextCreate(descContext,
+													"AOCS insert batch",
+													ALLOCSET_DEFAULT_MINSIZE,
+													ALLOCSET_DEFAULT_INITSIZE,
+													ALLOCSET_DEFAULT_MAXSIZE);
+		idesc->batchValues = (Datum **)
+			MemoryContextAlloc(descContext, natts * sizeof(Datum *));
+		idesc->batchNulls = (bool **)
+			MemoryContextAlloc(descContext, natts * sizeof(bool *));
+		for (i = 0; i < natts; i++)
 		{
-			pfree(toFree1);
+			idesc->batchValues[i] = (Datum *)
+				MemoryContextAlloc(descContext,
+								   AOCS_INSERT_BATCH_ROWS * sizeof(Datum));
+			idesc->batchNulls[i] = (bool *)
+				MemoryContextAlloc(descContext,
+								   AOCS_INSERT_BATCH_ROWS * sizeof(bool));
 		}
 	}
 
-	idesc->insertCount++;
-	idesc->lastSequence++;
-	if (idesc->numSequences > 0)
-		(idesc->numSequences)--;
+	aocs_insert_check(idesc);
+
+	row = idesc->batchCount;
+	oldcontext = MemoryContextSwitchTo(idesc->batchContext);
+	for (i = 0; i < natts; i++)
+	{
+		Form_pg_attribute attr = tupleDesc->attrs[i];
+
+		idesc->batchNulls[i][row] = null[i];
+		if (null[i] || attr->attbyval)
+			idesc->batchValues[i][row] = d[i];
+		else
+		{
+			idesc->batchBytes += datumGetSize(d[i], false, attr->attlen);
+			idesc->batchValues[i][row] = datumCopy(d[i], false, attr->attlen);
+		}
+	}
+	MemoryContextSwitchTo(oldcontext);
 
-	Assert(idesc->numSequences >= 0);
+	idesc->batchCount++;
 
 	AOTupleIdInit_Init(aoTupleId);
 	AOTupleIdInit_segmentFileNum(aoTupleId, idesc->cur_segno);
-	AOTupleIdInit_rowNum(aoTupleId, idesc->lastSequence);
+	AOTupleIdInit_rowNum(aoTupleId, idesc->lastSequence + idesc->batchCount);
+
+	if (idesc->batchCount >= AOCS_INSERT_BATCH_ROWS ||
+		idesc->batchBytes >= AOCS_INSERT_BATCH_BYTES)
+		aocs_insert_flush(idesc);
+
+	return InvalidOid;
+}
+
+/*
+ * Write the rows buffered by aocs_insert_buffered().
+ */
+void
+aocs_insert_flush(AOCSInsertDesc idesc)
+{
+	int nrows = idesc->batchCount;
+
+	if (nrows == 0)
+		return;
 
 	/*
-	 * If the allocated fast sequence numbers are used up, we request for
-	 * a next list of fast sequence numbers.
+	 * Reset the count first, so aocs_insert_values_batch() does not try to
+	 * flush the buffer it is writing.
 	 */
-	if (idesc->numSequences == 0)
-	{
-		int64 firstSequence;
-
-		firstSequence =
-			GetFastSequences(rel->rd_appendonly->segrelid,
-							 idesc->cur_segno,
-							 idesc->lastSequence + 1,
-							 NUM_FAST_SEQUENCES);
+	idesc->batchCount = 0;
+	aocs_insert_values_batch(idesc, nrows, idesc->batchValues,
+							 idesc->batchNulls, NULL);
 
-		Assert(firstSequence == idesc->lastSequence + 1);
-		idesc->numSequences = NUM_FAST_SEQUENCES;
-	}
+	idesc->batchBytes = 0;
+	MemoryContextReset(idesc->batchContext);
+}
 
-	return InvalidOid;
+/*
+ * Called at the end of each transaction; see aocsBufferingInserts.
+ */
+void
+AtEOXact_AOCSInsert(void)
+{
+	aocsBufferingInserts = 0;
 }
 
 void aocs_insert_finish(AOCSInsertDesc idesc)
@@ -957,6 +1617,14 @@ void aocs_insert_finish(AOCSInsertDesc idesc)
 	Relation rel = idesc->aoi_rel;
 	int i;
 
+	aocs_insert_flush(idesc);
+	if (idesc->batchContext != NULL)
+	{
+		MemoryContextDelete(idesc->batchContext);
+		if (aocsBufferingInserts > 0)
+			aocsBufferingInserts--;
+	}
+
 	for(i=0; i<rel->rd_att->natts; ++i)
 	{
 		int itemCount = datumstreamwrite_nth(idesc->ds[i]);
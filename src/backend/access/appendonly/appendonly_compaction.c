@@ -187,6 +187,33 @@ AppendOnlyCompaction_ShouldCompact(
 	return result;
 }
 
+/*
+ * Reports the compaction of a segment file: how many tuples were moved to
+ * the insert segment file and dropped, and how fast.
+ */
+void
+AppendOnlyCompaction_ReportFinished(Relation aorel,
+		int segno,
+		int64 movedTupleCount,
+		int64 droppedTupleCount,
+		TimestampTz startTime)
+{
+	long secs;
+	int usecs;
+	double elapsed;
+
+	TimestampDifference(startTime, GetCurrentTimestamp(), &secs, &usecs);
+	elapsed = secs + usecs / 1000000.0;
+
+	elogif(Debug_appendonly_print_compaction, LOG,
+		"Append-only compaction finished on relation %s, segment file num %d: "
+		"moved " INT64_FORMAT " tuples and dropped " INT64_FORMAT " tuples "
+		"in %.2f s (%.0f tuples/s)",
+		RelationGetRelationName(aorel), segno,
+		movedTupleCount, droppedTupleCount, elapsed,
+		elapsed > 0 ? (movedTupleCount + droppedTupleCount) / elapsed : 0.0);
+}
+
 /*
  * AppendOnlySegmentFileTruncateToEOF()
  *
@@ -336,11 +363,13 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	MemTupleBinding *mt_bind;
 	int compact_segno;
 	int64 movedTupleCount = 0;
+	int64 droppedTupleCount = 0;
 	ResultRelInfo *resultRelInfo;
 	EState *estate;
 	AOTupleId *aoTupleId;
 	int64 tupleCount = 0;
 	int64 tuplePerPage = INT_MAX;
+	TimestampTz startTime = GetCurrentTimestamp();
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoRows(aorel));
@@ -417,6 +446,7 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 							tuple,
 							slot,
 							mt_bind);
+			droppedTupleCount++;
 		}
 
 		/* 
@@ -447,6 +477,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		   "AO segfile %d, relation %s, moved tuple count " INT64_FORMAT,
 		   compact_segno, relname, movedTupleCount);
 
+	AppendOnlyCompaction_ReportFinished(aorel, compact_segno,
+			movedTupleCount, droppedTupleCount, startTime);
+
 	AppendOnlyVisimap_Finish(&visiMap, NoLock);
 
 	ExecCloseIndices(resultRelInfo);
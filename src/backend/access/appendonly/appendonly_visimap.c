@@ -89,6 +89,10 @@ AppendOnlyVisimap_Finish(
 	AppendOnlyVisimapStore_Finish(&visiMap->visimapStore, lockmode);
 	AppendOnlyVisimapEntry_Finish(&visiMap->visimapEntry);
 
+	/* The entry first row numbers live in the memory context. */
+	visiMap->segmentCache.entryFirstRowNums = NULL;
+	visiMap->segmentCache.segmentFileNum = -1;
+
 	MemoryContextDelete(visiMap->memoryContext);
 	visiMap->memoryContext = NULL;
 }
@@ -133,9 +137,101 @@ AppendOnlyVisimap_Init(
 			appendOnlyMetaDataSnapshot,
 			visiMap->memoryContext);
 
+	visiMap->segmentCache.segmentFileNum = -1;
+	visiMap->segmentCache.entryFirstRowNums = NULL;
+	visiMap->segmentCache.entryCount = 0;
+	visiMap->segmentCache.visibleRangeFirstRowNum = -1;
+
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * Prepares for visibility checks of the rows of the given segment file, in
+ * any order.
+ *
+ * Finds which row number ranges of the segment file have an entry at all,
+ * so that AppendOnlyVisimap_IsVisible does not look in the visimap relation
+ * for the other ranges.  In a segment file without deleted rows no entry is
+ * ever looked for.
+ *
+ * Only done for MVCC snapshots; with other snapshots the entries may change
+ * while the segment file is scanned.
+ */
+void
+AppendOnlyVisimap_SetSegmentFile(
+		AppendOnlyVisimap *visiMap,
+		int segno)
+{
+	AppendOnlyVisimapSegmentCache *cache;
+
+	Assert(visiMap);
+
+	cache = &visiMap->segmentCache;
+
+	if (cache->entryFirstRowNums != NULL)
+	{
+		pfree(cache->entryFirstRowNums);
+		cache->entryFirstRowNums = NULL;
+	}
+	cache->entryCount = 0;
+	cache->visibleRangeFirstRowNum = -1;
+	cache->segmentFileNum = -1;
+
+	if (visiMap->visimapStore.snapshot == NULL ||
+		!IsMVCCSnapshot(visiMap->visimapStore.snapshot))
+		return;
+
+	cache->entryFirstRowNums = AppendOnlyVisimapStore_GetSegmentFileFirstRowNums(
+			&visiMap->visimapStore,
+			segno,
+			&cache->entryCount);
+	cache->segmentFileNum = segno;
+}
+
+/*
+ * Checks if the tuple lies in a row number range without entry of the
+ * segment file set with AppendOnlyVisimap_SetSegmentFile.  Such tuples are
+ * visible according to the visibility map.
+ */
+static bool
+AppendOnlyVisimap_IsKnownVisible(
+		AppendOnlyVisimap *visiMap,
+		AOTupleId *aoTupleId)
+{
+	AppendOnlyVisimapSegmentCache *cache = &visiMap->segmentCache;
+	int64 rangeFirstRowNum;
+	int low;
+	int high;
+
+	if (cache->segmentFileNum != AOTupleIdGet_segmentFileNum(aoTupleId))
+		return false;
+
+	if (cache->entryCount == 0)
+		return true;
+
+	rangeFirstRowNum = AppendOnlyVisimapEntry_GetFirstRowNum(
+			&visiMap->visimapEntry, aoTupleId);
+	if (rangeFirstRowNum == cache->visibleRangeFirstRowNum)
+		return true;
+
+	low = 0;
+	high = cache->entryCount - 1;
+	while (low <= high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (cache->entryFirstRowNums[mid] == rangeFirstRowNum)
+			return false;
+		if (cache->entryFirstRowNums[mid] < rangeFirstRowNum)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	cache->visibleRangeFirstRowNum = rangeFirstRowNum;
+	return true;
+}
+
 /*
  * Moves the visibility map entry so that the given
  * AO tuple id is covered by it.
@@ -191,6 +287,9 @@ AppendOnlyVisimap_IsVisible(
 			"(tupleId) = %s", 
 			AOTupleIdToString(aoTupleId)); 
 
+	if (AppendOnlyVisimap_IsKnownVisible(visiMap, aoTupleId))
+		return true;
+
 	if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
 			aoTupleId))
 	{
@@ -374,6 +374,80 @@ AppendOnlyVisimapStore_GetSegmentFileHiddenTupleCount(
 	return hiddenTupcount;
 }
 
+/*
+ * Returns the first row numbers of all visimap entries of a given segment
+ * file in ascending order.  The entries' bitmaps are not decompressed.
+ *
+ * The array is allocated in the store's memory context; *entryCount is set
+ * to its length.  Returns NULL when there are no entries.
+ */
+int64 *
+AppendOnlyVisimapStore_GetSegmentFileFirstRowNums(
+	AppendOnlyVisimapStore *visiMapStore,
+	int segmentFileNum,
+	int *entryCount)
+{
+	ScanKeyData scanKey;
+	IndexScanDesc indexScan;
+	HeapTuple tuple;
+	TupleDesc heapTupleDesc;
+	int64 *firstRowNums = NULL;
+	int maxEntryCount = 0;
+
+	Assert(visiMapStore);
+	Assert(entryCount);
+	Assert(RelationIsValid(visiMapStore->visimapRelation));
+	Assert(RelationIsValid(visiMapStore->visimapIndex));
+
+	*entryCount = 0;
+	heapTupleDesc = RelationGetDescr(visiMapStore->visimapRelation);
+
+	ScanKeyInit(&scanKey,
+			Anum_pg_aovisimap_segno, /* segno */
+			BTEqualStrategyNumber,
+			F_INT4EQ,
+			Int32GetDatum(segmentFileNum));
+
+	indexScan = AppendOnlyVisimapStore_BeginScan(
+			visiMapStore,
+			1,
+			&scanKey);
+
+	while ((tuple = AppendOnlyVisimapStore_GetNextTuple(visiMapStore,
+					indexScan, ForwardScanDirection)) != NULL)
+	{
+		bool isNull;
+		Datum d;
+
+		d = heap_getattr(tuple, Anum_pg_aovisimap_firstrownum,
+				heapTupleDesc, &isNull);
+		Assert(!isNull);
+
+		if (*entryCount == maxEntryCount)
+		{
+			maxEntryCount = (maxEntryCount == 0 ? 16 : maxEntryCount * 2);
+			if (firstRowNums == NULL)
+				firstRowNums = MemoryContextAlloc(visiMapStore->memoryContext,
+						maxEntryCount * sizeof(int64));
+			else
+				firstRowNums = repalloc(firstRowNums,
+						maxEntryCount * sizeof(int64));
+		}
+		firstRowNums[(*entryCount)++] = DatumGetInt64(d);
+
+		/* The index on (segno, firstrownum) returns them in order. */
+		Assert(*entryCount == 1 ||
+				firstRowNums[*entryCount - 2] < firstRowNums[*entryCount - 1]);
+	}
+	AppendOnlyVisimapStore_EndScan(visiMapStore, indexScan);
+
+	elogif(Debug_appendonly_print_visimap, LOG, 
+			"Append-only visi map store: Found %d entries for "
+			"(segFileNum) = (%u)", *entryCount, segmentFileNum);
+
+	return firstRowNums;
+}
+
 /*
  * Returns the number of hidden tuples in a given releation
  */ 
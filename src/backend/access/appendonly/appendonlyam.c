@@ -203,6 +203,7 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 	int64			eof = 0;
 	bool			finished_all_files = true; /* assume */
 	int32			fileSegNo;
+	FileSegInfo		*fsinfo = NULL;
 
 	Assert(scan->aos_need_new_segfile);   /* only call me when last segfile completed */
 	Assert(!scan->aos_done_all_segfiles); /* don't call me if I told you to stop */
@@ -220,6 +221,9 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 							scan->title,
 							&scan->storageAttributes);
 
+		AppendOnlyStorageRead_SetReadAhead(&scan->storageRead,
+										   gp_appendonly_read_ahead * 1024);
+
 		/*
 		 * There is no guarantee that the current memory context will be preserved between calls,
 		 * so switch to a safe memory context for retrieving compression information.
@@ -274,7 +278,7 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 	while(scan->aos_segfiles_processed < scan->aos_total_segfiles)
 	{
 		/* still have more segment files to read. get info of the next one */
-		FileSegInfo *fsinfo = scan->aos_segfile_arr[scan->aos_segfiles_processed];
+		fsinfo = scan->aos_segfile_arr[scan->aos_segfiles_processed];
 		segno = fsinfo->segno;
 		eof = (int64)fsinfo->eof;
 
@@ -336,6 +340,9 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 		return false;
 	}
 
+	AppendOnlyZoneMap_SetSegmentFile(&scan->zoneMap, fsinfo);
+	AppendOnlyVisimap_SetSegmentFile(&scan->visibilityMap, segno);
+
 	MakeAOSegmentFileName(reln, segno, -1, &fileSegNo, scan->aos_filenamepath);
 	Assert(strlen(scan->aos_filenamepath) + 1 <= scan->aos_filenamepath_maxlen);
 
@@ -1242,20 +1249,37 @@ getNextBlock(
 			return false;
 	}
 
-	if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
-									&scan->storageRead,
-									&scan->executorReadBlock))
+	for (;;)
 	{
-		if (scan->buildBlockDirectory)
+		if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
+										&scan->storageRead,
+										&scan->executorReadBlock))
 		{
-			Assert(scan->blockDirectory != NULL);
-			AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			if (scan->buildBlockDirectory)
+			{
+				Assert(scan->blockDirectory != NULL);
+				AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			}
+
+			/* done reading the file */
+			CloseScannedFileSeg(scan);
+
+			return false;
 		}
 
-		/* done reading the file */
-		CloseScannedFileSeg(scan);
+		/*
+		 * Skip the block without reading its contents if its zone map
+		 * shows that no row in it can satisfy the scan's qualifiers.
+		 */
+		if (!AppendOnlyZoneMap_CanSkipBlock(
+									&scan->zoneMap, 0,
+									scan->executorReadBlock.blockFirstRowNum,
+									scan->executorReadBlock.rowCount,
+									scan->executorReadBlock.headerOffsetInFile))
+			break;
 
-		return false;
+		AppendOnlyStorageRead_SkipCurrentBlock(&scan->storageRead);
+		AppendOnlyExecutionReadBlock_FinishedScanBlock(&scan->executorReadBlock);
 	}
 
 	if (scan->buildBlockDirectory)
@@ -1775,6 +1799,7 @@ appendonly_endscan(AppendOnlyScanDesc scan)
 	AppendOnlyExecutorReadBlock_Finish(&scan->executorReadBlock);
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
+	AppendOnlyZoneMap_Finish(&scan->zoneMap);
 	pfree(scan->aos_filenamepath);
 
 	pfree(scan->title);
@@ -1782,6 +1807,23 @@ appendonly_endscan(AppendOnlyScanDesc scan)
 	pfree(scan);
 }
 
+/* ----------------
+ *		appendonly_set_zonemap_qual - skip blocks by the given qualifiers
+ *
+ * Must be called before the first tuple is fetched.
+ * ----------------
+ */
+void
+appendonly_set_zonemap_qual(AppendOnlyScanDesc scan, List *qual)
+{
+	Assert(scan->aos_segfiles_processed == 0);
+
+	AppendOnlyZoneMap_Init(&scan->zoneMap,
+						   scan->aos_rd,
+						   scan->appendOnlyMetaDataSnapshot,
+						   qual);
+}
+
 /* ----------------
  *		appendonly_getnext	- retrieve next tuple in scan
  * ----------------
@@ -3002,6 +3044,23 @@ appendonly_insert_init(Relation rel, int segno, bool update_mode)
 
 		if (itemLen > 0)
 			memcpy(itemPtr, tup, itemLen);
+
+		if (aoInsertDesc->blockDirectory.keepZoneMaps)
+		{
+			AppendOnlyBlockDirectory *blockDirectory = &aoInsertDesc->blockDirectory;
+			int i;
+
+			for (i = 0; i < blockDirectory->numZoneMapAttnos; i++)
+			{
+				int attno = blockDirectory->zoneMapAttnos[i];
+				bool isnull;
+				Datum value = memtuple_getattr(tup, aoInsertDesc->mt_bind,
+											   attno + 1, &isnull);
+
+				AppendOnlyBlockDirectory_AddZoneMapValue(blockDirectory, 0,
+														 attno, value, isnull);
+			}
+		}
 	}
 	else
 	{
@@ -3031,6 +3090,9 @@ appendonly_insert_init(Relation rel, int segno, bool update_mode)
 		Assert(aoInsertDesc->nonCompressedData == NULL);
 		Assert(!AppendOnlyStorageWrite_IsBufferAllocated(&aoInsertDesc->storageWrite));
 
+		/* The large content has no block directory entry of its own */
+		AppendOnlyBlockDirectory_InvalidateZoneMap(&aoInsertDesc->blockDirectory, 0);
+
 		setupNextWriteBlock(aoInsertDesc);
 	}
 
@@ -19,15 +19,21 @@
 #include "access/heapam.h"
 #include "access/genam.h"
 #include "catalog/indexing.h"
+#include "nodes/primnodes.h"
 #include "parser/parse_oper.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/guc.h"
 #include "utils/fmgroids.h"
+#include "utils/typcache.h"
 #include "cdb/cdbappendonlyam.h"
 
 int gp_blockdirectory_entry_min_range = 0;
 int gp_blockdirectory_minipage_size = NUM_MINIPAGE_ENTRIES;
+int gp_blockdirectory_minipage_cache_size = 8;
+bool gp_appendonly_zone_maps = false;
+
+#define ZONEMAP_VERSION 1
 
 static inline uint32 minipage_size(uint32 nEntry)
 {
@@ -35,6 +41,38 @@ static inline uint32 minipage_size(uint32 nEntry)
 		sizeof(MinipageEntry) * nEntry;
 }
 
+static inline uint32 zonemap_size(uint32 nEntry, int nColumns)
+{
+	return offsetof(ZoneMap, entry) +
+		sizeof(ZoneMapEntry) * nEntry * nColumns;
+}
+
+/*
+ * The block directory relation has no toast table, so the zone map of a
+ * minipage must fit in a heap tuple next to the minipage. Wide row-oriented
+ * tables get fewer entries per minipage.
+ */
+static inline uint32 zonemap_max_entries(int nColumns)
+{
+	return (MaxHeapTupleSize / 2 - offsetof(ZoneMap, entry)) /
+		(sizeof(ZoneMapEntry) * nColumns);
+}
+
+/*
+ * Number of entries after which a minipage is written out.  The zone map
+ * cap only applies while zone maps are kept for the relation.
+ */
+static inline uint32 minipage_max_entries(AppendOnlyBlockDirectory *blockDirectory)
+{
+	uint32 maxEntries = (uint32) gp_blockdirectory_minipage_size;
+
+	if (blockDirectory->keepZoneMaps)
+		maxEntries = Min(maxEntries,
+						 zonemap_max_entries(blockDirectory->numZoneMapColumns));
+
+	return maxEntries;
+}
+
 static void load_last_minipage(
 	AppendOnlyBlockDirectory *blockDirectory,
 	int64 lastSequence,
@@ -62,6 +100,24 @@ insert_new_entry(AppendOnlyBlockDirectory *blockDirectory,
 				 int64 fileOffset,
 				 int64 rowCount,
 				 MinipagePerColumnGroup *minipageInfo);
+static void init_zonemaps(AppendOnlyBlockDirectory *blockDirectory);
+static int find_cached_minipage(
+	MinipagePerColumnGroup *minipageInfo,
+	int segmentFileNum,
+	int64 rowNum);
+static FileSegInfo *swap_cached_minipage(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int cacheNo);
+static void stash_minipage(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo);
+static void set_entry_zone(AppendOnlyBlockDirectory *blockDirectory,
+						   int columnGroupNo,
+						   MinipagePerColumnGroup *minipageInfo,
+						   int entryNo,
+						   int64 rowCount,
+						   bool merge);
 
 void 
 AppendOnlyBlockDirectoryEntry_GetBeginRange(
@@ -139,6 +195,7 @@ init_internal(AppendOnlyBlockDirectory *blockDirectory)
 	/* Initialize the last minipage */
 	blockDirectory->minipages =
 		palloc0(sizeof(MinipagePerColumnGroup) * blockDirectory->numColumnGroups);
+	blockDirectory->minipageCacheSize = 0;
 	for (groupNo = 0; groupNo < blockDirectory->numColumnGroups; groupNo++)
 	{
 		if (blockDirectory->proj && !blockDirectory->proj[groupNo])
@@ -153,9 +210,68 @@ init_internal(AppendOnlyBlockDirectory *blockDirectory)
 		minipageInfo->numMinipageEntries = 0;
 	}
 
+	if (blockDirectory->keepZoneMaps)
+		init_zonemaps(blockDirectory);
+
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * init_zonemaps
+ *
+ * Look up the comparison functions of the columns to summarize, and
+ * allocate the in-memory zone maps. Only pass-by-value types with a
+ * default btree opclass are summarized.
+ */
+static void
+init_zonemaps(AppendOnlyBlockDirectory *blockDirectory)
+{
+	TupleDesc tupleDesc = RelationGetDescr(blockDirectory->aoRel);
+	int natts = tupleDesc->natts;
+	int attno;
+	int groupNo;
+
+	blockDirectory->zoneMapCmp = palloc0(sizeof(FmgrInfo *) * natts);
+	blockDirectory->zoneMapAttnos = palloc0(sizeof(int) * natts);
+	blockDirectory->numZoneMapAttnos = 0;
+
+	for (attno = 0; attno < natts; attno++)
+	{
+		Form_pg_attribute attr = tupleDesc->attrs[attno];
+		TypeCacheEntry *typentry;
+
+		if (attr->attisdropped || !attr->attbyval)
+			continue;
+
+		typentry = lookup_type_cache(attr->atttypid, TYPECACHE_CMP_PROC_FINFO);
+		if (!OidIsValid(typentry->cmp_proc))
+			continue;
+
+		blockDirectory->zoneMapCmp[attno] = &typentry->cmp_proc_finfo;
+		blockDirectory->zoneMapAttnos[blockDirectory->numZoneMapAttnos++] = attno;
+	}
+
+	blockDirectory->numZoneMapColumns = blockDirectory->isAOCol ? 1 : natts;
+	if (blockDirectory->numZoneMapAttnos == 0 ||
+		zonemap_max_entries(blockDirectory->numZoneMapColumns) == 0)
+	{
+		blockDirectory->keepZoneMaps = false;
+		return;
+	}
+
+	for (groupNo = 0; groupNo < blockDirectory->numColumnGroups; groupNo++)
+	{
+		MinipagePerColumnGroup *minipageInfo =
+			&blockDirectory->minipages[groupNo];
+		int nColumns = blockDirectory->numZoneMapColumns;
+
+		minipageInfo->zonemap =
+			palloc0(zonemap_size(NUM_MINIPAGE_ENTRIES, nColumns));
+		minipageInfo->blockZone = palloc0(sizeof(ZoneMapEntry) * nColumns);
+		minipageInfo->blockZoneCount = palloc0(sizeof(int64) * nColumns);
+	}
+}
+
 /*
  * AppendOnlyBlockDirectory_Init_forSearch
  *
@@ -177,6 +293,7 @@ AppendOnlyBlockDirectory_Init_forSearch(
 	bool *proj)
 {
 	blockDirectory->aoRel = aoRel;
+	blockDirectory->keepZoneMaps = false;
 
 	if (!OidIsValid(aoRel->rd_appendonly->blkdirrelid))
 	{
@@ -213,6 +330,8 @@ AppendOnlyBlockDirectory_Init_forSearch(
 		index_open(aoRel->rd_appendonly->blkdiridxid, AccessShareLock);
 
 	init_internal(blockDirectory);
+
+	blockDirectory->minipageCacheSize = gp_blockdirectory_minipage_cache_size;
 }
 
 /*
@@ -239,6 +358,7 @@ AppendOnlyBlockDirectory_Init_forInsert(
 
 	blockDirectory->aoRel = aoRel;
 	blockDirectory->appendOnlyMetaDataSnapshot = appendOnlyMetaDataSnapshot;
+	blockDirectory->keepZoneMaps = false;
 
 	if (!OidIsValid(aoRel->rd_appendonly->blkdirrelid))
 	{
@@ -268,6 +388,10 @@ AppendOnlyBlockDirectory_Init_forInsert(
 	blockDirectory->blkdirIdx =
 		index_open(aoRel->rd_appendonly->blkdiridxid, RowExclusiveLock);
 
+	blockDirectory->keepZoneMaps =
+		gp_appendonly_zone_maps &&
+		AoBlkdirHasZoneMap(RelationGetDescr(blockDirectory->blkdirRel));
+
 	init_internal(blockDirectory);
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -301,6 +425,7 @@ AppendOnlyBlockDirectory_Init_addCol(
 {
 	blockDirectory->aoRel = aoRel;
 	blockDirectory->appendOnlyMetaDataSnapshot = appendOnlyMetaDataSnapshot;
+	blockDirectory->keepZoneMaps = false;
 
 	if (!OidIsValid(aoRel->rd_appendonly->blkdirrelid))
 	{
@@ -536,6 +661,40 @@ AppendOnlyBlockDirectory_GetEntry(
 		}
 	}
 
+	/*
+	 * A minipage this search loaded before may have the entry.  Index
+	 * scans often go back to the same few ranges of rows.
+	 */
+	entry_no = find_cached_minipage(minipageInfo, segmentFileNum, rowNum);
+	if (entry_no != -1)
+	{
+		fsInfo = swap_cached_minipage(blockDirectory, columnGroupNo, entry_no);
+
+		if (segmentFileNum != blockDirectory->currentSegmentFileNum)
+		{
+			/*
+			 * The other column groups' minipages are of the previous
+			 * segment file; put them aside too (see MPP-17061).
+			 */
+			for (tmpGroupNo = 0; tmpGroupNo < blockDirectory->numColumnGroups; tmpGroupNo++)
+			{
+				if (tmpGroupNo != columnGroupNo)
+					stash_minipage(blockDirectory, tmpGroupNo);
+			}
+			blockDirectory->currentSegmentFileNum = segmentFileNum;
+			blockDirectory->currentSegmentFileInfo = fsInfo;
+		}
+
+		entry_no = find_minipage_entry(minipageInfo->minipage,
+									   minipageInfo->numMinipageEntries,
+									   rowNum);
+		Assert(entry_no != -1);
+		return set_directoryentry_range(blockDirectory,
+										columnGroupNo,
+										entry_no,
+										directoryEntry);
+	}
+
 	for (i = 0; i < blockDirectory->totalSegfiles; i++)
 	{
 		fsInfo = blockDirectory->segmentFileInfo[i];
@@ -558,6 +717,18 @@ AppendOnlyBlockDirectory_GetEntry(
 
 	Assert(numScanKeys == 3);
 
+	/*
+	 * Put the minipages being replaced aside, while they still go with
+	 * currentSegmentFileNum.  With no current minipages left, the segment
+	 * file can be switched right away without the risk of MPP-17061
+	 * below.
+	 */
+	for (tmpGroupNo = 0; tmpGroupNo < blockDirectory->numColumnGroups; tmpGroupNo++)
+		stash_minipage(blockDirectory, tmpGroupNo);
+
+	blockDirectory->currentSegmentFileNum = segmentFileNum;
+	blockDirectory->currentSegmentFileInfo = fsInfo;
+
 	for (tmpGroupNo = 0; tmpGroupNo < blockDirectory->numColumnGroups; tmpGroupNo++)
 	{
 		if (blockDirectory->proj && !blockDirectory->proj[tmpGroupNo])
@@ -565,6 +736,23 @@ AppendOnlyBlockDirectory_GetEntry(
 			/* Ignore columns that are not projected. */
 			continue;
 		}
+
+		/*
+		 * Other column groups may have the minipage they need cached
+		 * already.
+		 */
+		if (tmpGroupNo != columnGroupNo)
+		{
+			int cacheNo = find_cached_minipage(&blockDirectory->minipages[tmpGroupNo],
+											   segmentFileNum, rowNum);
+
+			if (cacheNo != -1)
+			{
+				swap_cached_minipage(blockDirectory, tmpGroupNo, cacheNo);
+				continue;
+			}
+		}
+
 		/* Setup the scan keys for the scan. */
 		Assert(scanKeys != NULL);
 		scanKeys[0].sk_argument = Int32GetDatum(segmentFileNum);
@@ -710,11 +898,24 @@ insert_new_entry(
 		
 		if (gp_blockdirectory_entry_min_range > 0 &&
 			fileOffset - entry->fileOffset < gp_blockdirectory_entry_min_range)
+		{
+			/*
+			 * The latest entry now covers the new rows as well, so its
+			 * zone map must summarize them too.
+			 */
+			if (blockDirectory->keepZoneMaps)
+			{
+				entry->rowCount = firstRowNum + rowCount - entry->firstRowNum;
+				set_entry_zone(blockDirectory, columnGroupNo, minipageInfo,
+							   lastEntryNo, rowCount, true);
+			}
 			return true;
+		}
 		
 		/* Update the rowCount in the latest entry */
 		Assert(entry->rowCount <= firstRowNum - entry->firstRowNum);
 
+
 		ereportif(Debug_appendonly_print_blockdirectory, LOG, 
 					(errmsg("Append-only block directory update entry: "
 							"(firstRowNum, columnGroupNo, fileOffset, rowCount) = (" INT64_FORMAT
@@ -729,7 +930,7 @@ insert_new_entry(
 		entry->rowCount = firstRowNum - entry->firstRowNum;
 	}
 	
-	if (minipageInfo->numMinipageEntries >= (uint32)gp_blockdirectory_minipage_size)
+	if (minipageInfo->numMinipageEntries >= minipage_max_entries(blockDirectory))
 	{
 		write_minipage(blockDirectory, columnGroupNo, minipageInfo);
 
@@ -741,6 +942,10 @@ insert_new_entry(
 		 */
 		MemSet(minipageInfo->minipage->entry, 0,
 			   minipageInfo->numMinipageEntries * sizeof(MinipageEntry));
+		if (blockDirectory->keepZoneMaps)
+			MemSet(minipageInfo->zonemap->entry, 0,
+				   minipageInfo->numMinipageEntries *
+				   blockDirectory->numZoneMapColumns * sizeof(ZoneMapEntry));
 		minipageInfo->numMinipageEntries = 0;
 	}
 	
@@ -750,6 +955,9 @@ insert_new_entry(
 	entry->firstRowNum = firstRowNum;
 	entry->fileOffset = fileOffset;
 	entry->rowCount = rowCount;
+
+	set_entry_zone(blockDirectory, columnGroupNo, minipageInfo,
+				   minipageInfo->numMinipageEntries, rowCount, false);
 	
 	minipageInfo->numMinipageEntries++;
 	
@@ -792,6 +1000,149 @@ AppendOnlyBlockDirectory_addCol_InsertEntry(
 							fileOffset,	rowCount, minipageInfo);
 }
 
+/*
+ * AppendOnlyBlockDirectory_AddZoneMapValue
+ *
+ * Add the value of an attribute of a row that was just added to the
+ * current block of a column group to the block's zone map. The zone map
+ * goes to the block directory with the block's entry.
+ */
+void
+AppendOnlyBlockDirectory_AddZoneMapValue(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int attno,
+	Datum value,
+	bool isnull)
+{
+	MinipagePerColumnGroup *minipageInfo;
+	FmgrInfo *cmp;
+	ZoneMapEntry *zone;
+	int col;
+
+	if (!blockDirectory->keepZoneMaps)
+		return;
+
+	cmp = blockDirectory->zoneMapCmp[attno];
+	if (cmp == NULL)
+		return;
+
+	minipageInfo = &blockDirectory->minipages[columnGroupNo];
+	col = blockDirectory->isAOCol ? 0 : attno;
+	zone = &minipageInfo->blockZone[col];
+	minipageInfo->blockZoneCount[col]++;
+
+	if (isnull)
+	{
+		zone->flags |= ZONEMAP_HASNULLS;
+		return;
+	}
+
+	if ((zone->flags & ZONEMAP_HASVALUES) == 0)
+	{
+		zone->minValue = (int64) value;
+		zone->maxValue = (int64) value;
+		zone->flags |= ZONEMAP_HASVALUES;
+	}
+	else if (DatumGetInt32(FunctionCall2(cmp, value, (Datum) zone->minValue)) < 0)
+		zone->minValue = (int64) value;
+	else if (DatumGetInt32(FunctionCall2(cmp, value, (Datum) zone->maxValue)) > 0)
+		zone->maxValue = (int64) value;
+}
+
+/*
+ * AppendOnlyBlockDirectory_InvalidateZoneMap
+ *
+ * Forget the zone map of the latest entry of a column group. This is
+ * used when a row is stored without an entry of its own (a large row),
+ * since the latest entry then grows to cover a row it has not summarized.
+ */
+void
+AppendOnlyBlockDirectory_InvalidateZoneMap(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo)
+{
+	MinipagePerColumnGroup *minipageInfo;
+	int nColumns;
+	int col;
+
+	if (!blockDirectory->keepZoneMaps)
+		return;
+
+	minipageInfo = &blockDirectory->minipages[columnGroupNo];
+	if (minipageInfo->numMinipageEntries == 0)
+		return;
+
+	nColumns = blockDirectory->numZoneMapColumns;
+	for (col = 0; col < nColumns; col++)
+		minipageInfo->zonemap->entry[(minipageInfo->numMinipageEntries - 1) * nColumns + col].flags = 0;
+}
+
+/*
+ * set_entry_zone
+ *
+ * Move the zone map of the current block into minipage entry entryNo, or
+ * merge it into the entry if the entry already covers earlier blocks. The
+ * summary is only valid if a value was added for each of the rowCount rows
+ * of the block; entries added by a scan that builds the block directory,
+ * for example, have no summary.
+ */
+static void
+set_entry_zone(AppendOnlyBlockDirectory *blockDirectory,
+			   int columnGroupNo,
+			   MinipagePerColumnGroup *minipageInfo,
+			   int entryNo,
+			   int64 rowCount,
+			   bool merge)
+{
+	int nColumns = blockDirectory->numZoneMapColumns;
+	int col;
+
+	if (!blockDirectory->keepZoneMaps)
+		return;
+
+	for (col = 0; col < nColumns; col++)
+	{
+		ZoneMapEntry *block = &minipageInfo->blockZone[col];
+		ZoneMapEntry *zone = &minipageInfo->zonemap->entry[entryNo * nColumns + col];
+		int attno = blockDirectory->isAOCol ? columnGroupNo : col;
+		FmgrInfo *cmp = blockDirectory->zoneMapCmp[attno];
+		bool blockValid = (cmp != NULL &&
+						   minipageInfo->blockZoneCount[col] == rowCount);
+
+		if (!merge)
+		{
+			*zone = *block;
+			zone->flags = blockValid ? (block->flags | ZONEMAP_VALID) : 0;
+		}
+		else if (!blockValid || (zone->flags & ZONEMAP_VALID) == 0)
+			zone->flags = 0;
+		else if ((block->flags & ZONEMAP_HASVALUES) != 0)
+		{
+			if ((zone->flags & ZONEMAP_HASVALUES) == 0)
+			{
+				zone->minValue = block->minValue;
+				zone->maxValue = block->maxValue;
+			}
+			else
+			{
+				if (DatumGetInt32(FunctionCall2(cmp, (Datum) block->minValue,
+												(Datum) zone->minValue)) < 0)
+					zone->minValue = block->minValue;
+				if (DatumGetInt32(FunctionCall2(cmp, (Datum) block->maxValue,
+												(Datum) zone->maxValue)) > 0)
+					zone->maxValue = block->maxValue;
+			}
+			zone->flags |= block->flags;
+		}
+		else
+			zone->flags |= block->flags;
+	}
+
+	MemSet(minipageInfo->blockZone, 0, sizeof(ZoneMapEntry) * nColumns);
+	MemSet(minipageInfo->blockZoneCount, 0, sizeof(int64) * nColumns);
+}
+
 /*
  * AppendOnlyBlockDirectory_DeleteSegmentFile
  *
@@ -958,6 +1309,36 @@ extract_minipage(AppendOnlyBlockDirectory *blockDirectory,
 
 	ItemPointerCopy(&tuple->t_self, &minipageInfo->tupleTid);
 
+	/*
+	 * Copy out the zone map, so that it is written back with the minipage.
+	 * Entries without one (made before zone maps were kept, or with a
+	 * different layout) are treated as having no summary.
+	 */
+	if (blockDirectory->keepZoneMaps)
+	{
+		int nColumns = blockDirectory->numZoneMapColumns;
+
+		MemSet(minipageInfo->zonemap->entry, 0,
+			   minipageInfo->numMinipageEntries * nColumns * sizeof(ZoneMapEntry));
+
+		if (AoBlkdirHasZoneMap(tupleDesc) &&
+			!nulls[Anum_pg_aoblkdir_zonemap - 1])
+		{
+			struct varlena *value = (struct varlena *)
+				DatumGetPointer(values[Anum_pg_aoblkdir_zonemap - 1]);
+			ZoneMap *zonemap = (ZoneMap *) pg_detoast_datum(value);
+
+			if (zonemap->version == ZONEMAP_VERSION &&
+				zonemap->nColumns == nColumns &&
+				zonemap->nEntry == minipageInfo->numMinipageEntries)
+				memcpy(minipageInfo->zonemap->entry, zonemap->entry,
+					   zonemap->nEntry * nColumns * sizeof(ZoneMapEntry));
+
+			if ((struct varlena *) zonemap != value)
+				pfree(zonemap);
+		}
+	}
+
 	/*
 	 * When crashes during inserts, or cancellation during inserts,
 	 * there are out-of-date minipage entries in the block directory.
@@ -1117,6 +1498,130 @@ find_minipage_entry(Minipage *minipage,
 		return -1;
 }
 
+/*
+ * find_cached_minipage
+ *
+ * Find a cached minipage of the column group with an entry for the given
+ * row. Return its number in the cache, or -1 if there is none.
+ */
+static int
+find_cached_minipage(MinipagePerColumnGroup *minipageInfo,
+					 int segmentFileNum,
+					 int64 rowNum)
+{
+	int cacheNo;
+
+	for (cacheNo = 0; cacheNo < minipageInfo->numCached; cacheNo++)
+	{
+		MinipageCacheEntry *cached = &minipageInfo->cache[cacheNo];
+
+		/* Unused entries are at the end. */
+		if (cached->numMinipageEntries == 0)
+			break;
+
+		if (cached->segmentFileNum == segmentFileNum &&
+			find_minipage_entry(cached->minipage,
+								cached->numMinipageEntries,
+								rowNum) != -1)
+			return cacheNo;
+	}
+
+	return -1;
+}
+
+/*
+ * swap_cached_minipage
+ *
+ * Make a cached minipage the current minipage of the column group, and
+ * cache the current one in its place as the most recently used. Return
+ * the segment file info of the new current minipage.
+ */
+static FileSegInfo *
+swap_cached_minipage(AppendOnlyBlockDirectory *blockDirectory,
+					 int columnGroupNo,
+					 int cacheNo)
+{
+	MinipagePerColumnGroup *minipageInfo =
+		&blockDirectory->minipages[columnGroupNo];
+	MinipageCacheEntry cached = minipageInfo->cache[cacheNo];
+	MinipageCacheEntry previous;
+
+	previous.segmentFileNum = blockDirectory->currentSegmentFileNum;
+	previous.segmentFileInfo = blockDirectory->currentSegmentFileInfo;
+	previous.minipage = minipageInfo->minipage;
+	previous.numMinipageEntries = minipageInfo->numMinipageEntries;
+
+	minipageInfo->minipage = cached.minipage;
+	minipageInfo->numMinipageEntries = cached.numMinipageEntries;
+
+	if (previous.numMinipageEntries > 0)
+	{
+		memmove(&minipageInfo->cache[1], &minipageInfo->cache[0],
+				cacheNo * sizeof(MinipageCacheEntry));
+		minipageInfo->cache[0] = previous;
+	}
+	else
+	{
+		memmove(&minipageInfo->cache[cacheNo], &minipageInfo->cache[cacheNo + 1],
+				(minipageInfo->numCached - cacheNo - 1) * sizeof(MinipageCacheEntry));
+		minipageInfo->cache[minipageInfo->numCached - 1] = previous;
+	}
+
+	return cached.segmentFileInfo;
+}
+
+/*
+ * stash_minipage
+ *
+ * Move the current minipage of the column group to its cache, evicting
+ * the least recently used one if the cache is full, and leave the column
+ * group without a current minipage.
+ */
+static void
+stash_minipage(AppendOnlyBlockDirectory *blockDirectory,
+			   int columnGroupNo)
+{
+	MinipagePerColumnGroup *minipageInfo =
+		&blockDirectory->minipages[columnGroupNo];
+	int cacheSize = blockDirectory->minipageCacheSize;
+	int cacheNo;
+
+	if (minipageInfo->minipage == NULL ||
+		minipageInfo->numMinipageEntries == 0)
+		return;
+
+	if (cacheSize == 0 || blockDirectory->currentSegmentFileNum < 0)
+	{
+		minipageInfo->numMinipageEntries = 0;
+		return;
+	}
+
+	if (minipageInfo->cache == NULL)
+		minipageInfo->cache = (MinipageCacheEntry *)
+			MemoryContextAllocZero(blockDirectory->memoryContext,
+								   cacheSize * sizeof(MinipageCacheEntry));
+
+	if (minipageInfo->numCached > 0 &&
+		minipageInfo->cache[minipageInfo->numCached - 1].numMinipageEntries == 0)
+		cacheNo = minipageInfo->numCached - 1;
+	else if (minipageInfo->numCached < cacheSize)
+	{
+		cacheNo = minipageInfo->numCached++;
+		minipageInfo->cache[cacheNo].minipage = (Minipage *)
+			MemoryContextAlloc(blockDirectory->memoryContext,
+							   minipage_size(NUM_MINIPAGE_ENTRIES));
+		minipageInfo->cache[cacheNo].numMinipageEntries = 0;
+	}
+	else
+		cacheNo = cacheSize - 1;
+
+	/* Drop what was there; the swap then caches the current minipage. */
+	minipageInfo->cache[cacheNo].numMinipageEntries = 0;
+	swap_cached_minipage(blockDirectory, columnGroupNo, cacheNo);
+
+	Assert(minipageInfo->numMinipageEntries == 0);
+}
+
 /*
  * write_minipage
  *
@@ -1158,6 +1663,27 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 		PointerGetDatum(minipageInfo->minipage);
 	nulls[Anum_pg_aoblkdir_minipage - 1] = false;
 
+	if (AoBlkdirHasZoneMap(heapTupleDesc))
+	{
+		if (blockDirectory->keepZoneMaps &&
+			minipageInfo->numMinipageEntries <=
+			zonemap_max_entries(blockDirectory->numZoneMapColumns))
+		{
+			ZoneMap *zonemap = minipageInfo->zonemap;
+
+			SET_VARSIZE(zonemap,
+						zonemap_size(minipageInfo->numMinipageEntries,
+									 blockDirectory->numZoneMapColumns));
+			zonemap->version = ZONEMAP_VERSION;
+			zonemap->nColumns = blockDirectory->numZoneMapColumns;
+			zonemap->nEntry = minipageInfo->numMinipageEntries;
+			values[Anum_pg_aoblkdir_zonemap - 1] = PointerGetDatum(zonemap);
+			nulls[Anum_pg_aoblkdir_zonemap - 1] = false;
+		}
+		else
+			nulls[Anum_pg_aoblkdir_zonemap - 1] = true;
+	}
+
 	tuple = heaptuple_form_to(heapTupleDesc,
 							  values,
 							  nulls,
@@ -1338,3 +1864,449 @@ AppendOnlyBlockDirectory_End_addCol(
 	MemoryContextDelete(blockDirectory->memoryContext);
 }
 
+
+/*
+ * zonemap_key_from_clause
+ *
+ * If the clause is of the form "column op constant" or "constant op
+ * column", with op one of the btree operators of a summarized column's
+ * type, set up a scan key for it and return true.
+ */
+static bool
+zonemap_key_from_clause(Relation aoRel, Expr *clause, ScanKey key)
+{
+	TupleDesc tupleDesc = RelationGetDescr(aoRel);
+	OpExpr *opexpr;
+	Node *leftop;
+	Node *rightop;
+	Var *var;
+	Const *con;
+	bool commuted;
+	Form_pg_attribute attr;
+	TypeCacheEntry *typentry;
+	Oid lefttype;
+	Oid righttype;
+	int strategy;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (list_length(opexpr->args) != 2)
+		return false;
+
+	leftop = (Node *) linitial(opexpr->args);
+	rightop = (Node *) lsecond(opexpr->args);
+	if (leftop && IsA(leftop, RelabelType))
+		leftop = (Node *) ((RelabelType *) leftop)->arg;
+	if (rightop && IsA(rightop, RelabelType))
+		rightop = (Node *) ((RelabelType *) rightop)->arg;
+
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = (Var *) leftop;
+		con = (Const *) rightop;
+		commuted = false;
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		var = (Var *) rightop;
+		con = (Const *) leftop;
+		commuted = true;
+	}
+	else
+		return false;
+
+	if (var->varlevelsup != 0 ||
+		var->varattno <= 0 || var->varattno > tupleDesc->natts ||
+		con->constisnull)
+		return false;
+
+	attr = tupleDesc->attrs[var->varattno - 1];
+	if (attr->attisdropped || !attr->attbyval ||
+		attr->atttypid != var->vartype ||
+		con->consttype != attr->atttypid)
+		return false;
+
+	op_input_types(opexpr->opno, &lefttype, &righttype);
+	if (lefttype != attr->atttypid || righttype != attr->atttypid)
+		return false;
+
+	typentry = lookup_type_cache(attr->atttypid,
+								 TYPECACHE_CMP_PROC_FINFO |
+								 TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(typentry->cmp_proc) ||
+		!OidIsValid(typentry->btree_opf))
+		return false;
+
+	strategy = get_op_opfamily_strategy(opexpr->opno, typentry->btree_opf);
+	if (strategy == 0)
+		return false;
+
+	if (commuted)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	ScanKeyEntryInitializeWithInfo(key,
+								   0,
+								   var->varattno,
+								   strategy,
+								   InvalidOid,
+								   &typentry->cmp_proc_finfo,
+								   con->constvalue);
+	return true;
+}
+
+/*
+ * AppendOnlyZoneMap_Init
+ *
+ * Set up block skipping for a sequential scan of an append-only relation,
+ * from the scan's qualifiers. Only the simple comparisons between a column
+ * and a constant are used; the qualifiers are still evaluated for every
+ * row that is returned. For column-oriented relations, only the keys on
+ * one column are used, because the scan reads the other columns in step
+ * with it.
+ */
+void
+AppendOnlyZoneMap_Init(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	Relation aoRel,
+	Snapshot appendOnlyMetaDataSnapshot,
+	List *qual)
+{
+	ListCell *lc;
+	int maxKeys;
+
+	MemSet(zoneMapScan, 0, sizeof(AppendOnlyZoneMapScan));
+	zoneMapScan->aoRel = aoRel;
+	zoneMapScan->appendOnlyMetaDataSnapshot = appendOnlyMetaDataSnapshot;
+	zoneMapScan->isAOCol = RelationIsAoCols(aoRel);
+
+	if (!gp_appendonly_zone_maps || qual == NIL ||
+		!OidIsValid(aoRel->rd_appendonly->blkdirrelid))
+		return;
+
+	maxKeys = list_length(qual);
+	zoneMapScan->keys = palloc0(sizeof(ScanKeyData) * maxKeys);
+
+	foreach(lc, qual)
+	{
+		ScanKey key = &zoneMapScan->keys[zoneMapScan->numKeys];
+
+		if (!zonemap_key_from_clause(aoRel, (Expr *) lfirst(lc), key))
+			continue;
+
+		if (zoneMapScan->isAOCol && zoneMapScan->numKeys > 0 &&
+			key->sk_attno != zoneMapScan->keys[0].sk_attno)
+			continue;
+
+		zoneMapScan->numKeys++;
+	}
+
+	if (zoneMapScan->numKeys == 0)
+	{
+		pfree(zoneMapScan->keys);
+		zoneMapScan->keys = NULL;
+		return;
+	}
+
+	zoneMapScan->numRanges = palloc0(sizeof(int) * zoneMapScan->numKeys);
+	zoneMapScan->ranges = palloc0(sizeof(ZoneMapRange *) * zoneMapScan->numKeys);
+
+	/* The zone maps of the current segment file live here */
+	zoneMapScan->memoryContext =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "ZoneMapScanContext",
+							  ALLOCSET_DEFAULT_MINSIZE,
+							  ALLOCSET_DEFAULT_INITSIZE,
+							  ALLOCSET_DEFAULT_MAXSIZE);
+}
+
+/*
+ * AppendOnlyZoneMap_SetSegmentFile
+ *
+ * Load the zone maps of a segment file that the scan is about to read.
+ */
+void
+AppendOnlyZoneMap_SetSegmentFile(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	FileSegInfo *segmentFileInfo)
+{
+	Relation blkdirRel;
+	Relation blkdirIdx;
+	TupleDesc heapTupleDesc;
+	ScanKeyData scanKeys[2];
+	IndexScanDesc idxScanDesc;
+	HeapTuple tuple;
+	MemoryContext oldcxt;
+	int segno;
+	int columnGroupNo;
+	int64 eof;
+	int *maxRanges;
+	int keyNo;
+
+	if (zoneMapScan->numKeys == 0)
+		return;
+
+	MemoryContextResetAndDeleteChildren(zoneMapScan->memoryContext);
+	MemSet(zoneMapScan->numRanges, 0, sizeof(int) * zoneMapScan->numKeys);
+	MemSet(zoneMapScan->ranges, 0, sizeof(ZoneMapRange *) * zoneMapScan->numKeys);
+
+	blkdirRel = heap_open(zoneMapScan->aoRel->rd_appendonly->blkdirrelid,
+						  AccessShareLock);
+	heapTupleDesc = RelationGetDescr(blkdirRel);
+	if (!AoBlkdirHasZoneMap(heapTupleDesc))
+	{
+		heap_close(blkdirRel, AccessShareLock);
+		return;
+	}
+	blkdirIdx = index_open(zoneMapScan->aoRel->rd_appendonly->blkdiridxid,
+						   AccessShareLock);
+
+	if (zoneMapScan->isAOCol)
+	{
+		AOCSFileSegInfo *aocsFileSegInfo = (AOCSFileSegInfo *) segmentFileInfo;
+
+		columnGroupNo = zoneMapScan->keys[0].sk_attno - 1;
+		segno = aocsFileSegInfo->segno;
+		eof = aocsFileSegInfo->vpinfo.entry[columnGroupNo].eof;
+	}
+	else
+	{
+		columnGroupNo = 0;
+		segno = segmentFileInfo->segno;
+		eof = segmentFileInfo->eof;
+	}
+
+	oldcxt = MemoryContextSwitchTo(zoneMapScan->memoryContext);
+
+	maxRanges = palloc0(sizeof(int) * zoneMapScan->numKeys);
+
+	ScanKeyInit(&scanKeys[0],
+				Anum_pg_aoblkdir_segno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(segno));
+	ScanKeyInit(&scanKeys[1],
+				Anum_pg_aoblkdir_columngroupno,
+				BTEqualStrategyNumber,
+				F_INT4EQ,
+				Int32GetDatum(columnGroupNo));
+
+	idxScanDesc = index_beginscan(blkdirRel, blkdirIdx,
+								  zoneMapScan->appendOnlyMetaDataSnapshot,
+								  2, scanKeys);
+
+	while ((tuple = index_getnext(idxScanDesc, ForwardScanDirection)) != NULL)
+	{
+		Datum values[Natts_pg_aoblkdir];
+		bool nulls[Natts_pg_aoblkdir];
+		Minipage *minipage;
+		ZoneMap *zonemap;
+		uint32 entryNo;
+
+		heap_deform_tuple(tuple, heapTupleDesc, values, nulls);
+
+		if (nulls[Anum_pg_aoblkdir_minipage - 1] ||
+			nulls[Anum_pg_aoblkdir_zonemap - 1])
+			continue;
+
+		minipage = (Minipage *)
+			PG_DETOAST_DATUM(values[Anum_pg_aoblkdir_minipage - 1]);
+		zonemap = (ZoneMap *)
+			PG_DETOAST_DATUM(values[Anum_pg_aoblkdir_zonemap - 1]);
+
+		if (zonemap->version != ZONEMAP_VERSION ||
+			zonemap->nEntry != minipage->nEntry ||
+			zonemap->nColumns != (zoneMapScan->isAOCol ?
+								  1 : RelationGetDescr(zoneMapScan->aoRel)->natts))
+			continue;
+
+		for (entryNo = 0; entryNo < minipage->nEntry; entryNo++)
+		{
+			MinipageEntry *entry = &minipage->entry[entryNo];
+
+			if (entry->fileOffset >= eof)
+				break;
+
+			for (keyNo = 0; keyNo < zoneMapScan->numKeys; keyNo++)
+			{
+				int col = zoneMapScan->isAOCol ?
+					0 : zoneMapScan->keys[keyNo].sk_attno - 1;
+				ZoneMapEntry *zone =
+					&zonemap->entry[entryNo * zonemap->nColumns + col];
+				ZoneMapRange *range;
+
+				if ((zone->flags & ZONEMAP_VALID) == 0)
+					continue;
+
+				if (zoneMapScan->numRanges[keyNo] >= maxRanges[keyNo])
+				{
+					if (maxRanges[keyNo] == 0)
+					{
+						maxRanges[keyNo] = NUM_MINIPAGE_ENTRIES;
+						zoneMapScan->ranges[keyNo] =
+							palloc(sizeof(ZoneMapRange) * maxRanges[keyNo]);
+					}
+					else
+					{
+						maxRanges[keyNo] *= 2;
+						zoneMapScan->ranges[keyNo] =
+							repalloc(zoneMapScan->ranges[keyNo],
+									 sizeof(ZoneMapRange) * maxRanges[keyNo]);
+					}
+				}
+
+				range = &zoneMapScan->ranges[keyNo][zoneMapScan->numRanges[keyNo]++];
+				range->firstRowNum = entry->firstRowNum;
+				range->rowCount = entry->rowCount;
+				range->fileOffset = entry->fileOffset;
+				range->zone = *zone;
+			}
+		}
+	}
+
+	index_endscan(idxScanDesc);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	index_close(blkdirIdx, AccessShareLock);
+	heap_close(blkdirRel, AccessShareLock);
+}
+
+/*
+ * AppendOnlyZoneMap_CanSkipBlock
+ *
+ * Return true if the zone maps show that none of the rows of the given
+ * block can satisfy the scan keys.
+ */
+bool
+AppendOnlyZoneMap_CanSkipBlock(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	int columnGroupNo,
+	int64 firstRowNum,
+	int64 rowCount,
+	int64 fileOffset)
+{
+	int keyNo;
+
+	if (zoneMapScan->numKeys == 0)
+		return false;
+
+	for (keyNo = 0; keyNo < zoneMapScan->numKeys; keyNo++)
+	{
+		ScanKey key = &zoneMapScan->keys[keyNo];
+		ZoneMapRange *ranges = zoneMapScan->ranges[keyNo];
+		ZoneMapRange *range;
+		int start = 0;
+		int end = zoneMapScan->numRanges[keyNo] - 1;
+		int found = -1;
+		bool skip;
+
+		if (zoneMapScan->isAOCol && key->sk_attno - 1 != columnGroupNo)
+			continue;
+
+		/* Find the last range that starts at or before the block */
+		while (start <= end)
+		{
+			int mid = (start + end) / 2;
+
+			if (ranges[mid].firstRowNum <= firstRowNum)
+			{
+				found = mid;
+				start = mid + 1;
+			}
+			else
+				end = mid - 1;
+		}
+
+		if (found == -1)
+			continue;
+
+		range = &ranges[found];
+		if (range->fileOffset > fileOffset ||
+			firstRowNum + rowCount > range->firstRowNum + range->rowCount)
+			continue;
+
+		if ((range->zone.flags & ZONEMAP_HASVALUES) == 0)
+			skip = true;
+		else
+		{
+			Datum minValue = (Datum) range->zone.minValue;
+			Datum maxValue = (Datum) range->zone.maxValue;
+			FmgrInfo *cmp = &key->sk_func;
+
+			switch (key->sk_strategy)
+			{
+				case BTLessStrategyNumber:
+					skip = DatumGetInt32(FunctionCall2(cmp, minValue, key->sk_argument)) >= 0;
+					break;
+				case BTLessEqualStrategyNumber:
+					skip = DatumGetInt32(FunctionCall2(cmp, minValue, key->sk_argument)) > 0;
+					break;
+				case BTEqualStrategyNumber:
+					skip = DatumGetInt32(FunctionCall2(cmp, minValue, key->sk_argument)) > 0 ||
+						DatumGetInt32(FunctionCall2(cmp, maxValue, key->sk_argument)) < 0;
+					break;
+				case BTGreaterEqualStrategyNumber:
+					skip = DatumGetInt32(FunctionCall2(cmp, maxValue, key->sk_argument)) < 0;
+					break;
+				case BTGreaterStrategyNumber:
+					skip = DatumGetInt32(FunctionCall2(cmp, maxValue, key->sk_argument)) <= 0;
+					break;
+				default:
+					skip = false;
+					break;
+			}
+		}
+
+		if (skip)
+		{
+			zoneMapScan->blocksSkipped++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+AppendOnlyZoneMap_Finish(
+	AppendOnlyZoneMapScan *zoneMapScan)
+{
+	if (zoneMapScan->memoryContext == NULL)
+		return;
+
+	ereportif(Debug_appendonly_print_scan, LOG,
+			  (errmsg("Append-only scan of relation '%s' skipped " INT64_FORMAT
+					  " blocks by zone maps",
+					  RelationGetRelationName(zoneMapScan->aoRel),
+					  zoneMapScan->blocksSkipped)));
+
+	MemoryContextDelete(zoneMapScan->memoryContext);
+	zoneMapScan->memoryContext = NULL;
+
+	pfree(zoneMapScan->keys);
+	pfree(zoneMapScan->numRanges);
+	pfree(zoneMapScan->ranges);
+	zoneMapScan->keys = NULL;
+	zoneMapScan->numRanges = NULL;
+	zoneMapScan->ranges = NULL;
+	zoneMapScan->numKeys = 0;
+}
@@ -65,13 +65,81 @@ test__AppendOnlyVisimapDelete_Finish_outoforder(void **state)
 }
 
 
+static void
+make_tuple_id(AOTupleId *aoTupleId, int segno, int64 rowNum)
+{
+	AOTupleIdInit_Init(aoTupleId);
+	AOTupleIdInit_segmentFileNum(aoTupleId, segno);
+	AOTupleIdInit_rowNum(aoTupleId, rowNum);
+}
+
+/*
+ * Rows in ranges without a visimap entry are visible without looking for
+ * the entry; rows in the others are not known to be visible.
+ */
+void
+test__AppendOnlyVisimap_IsKnownVisible(void **state)
+{
+	AppendOnlyVisimap visiMap;
+	AOTupleId aoTupleId;
+	int64 entryFirstRowNums[] = {32768, 98304};
+
+	memset(&visiMap, 0, sizeof(visiMap));
+	visiMap.segmentCache.segmentFileNum = 2;
+	visiMap.segmentCache.entryFirstRowNums = entryFirstRowNums;
+	visiMap.segmentCache.entryCount = 2;
+	visiMap.segmentCache.visibleRangeFirstRowNum = -1;
+
+	/* Another segment file: nothing is known. */
+	make_tuple_id(&aoTupleId, 1, 100);
+	assert_false(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+
+	make_tuple_id(&aoTupleId, 2, 100);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 0);
+	assert_true(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+	assert_int_equal(visiMap.segmentCache.visibleRangeFirstRowNum, 0);
+
+	make_tuple_id(&aoTupleId, 2, 40000);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 32768);
+	assert_false(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+
+	make_tuple_id(&aoTupleId, 2, 70000);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 65536);
+	assert_true(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+	assert_int_equal(visiMap.segmentCache.visibleRangeFirstRowNum, 65536);
+
+	make_tuple_id(&aoTupleId, 2, 100000);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 98304);
+	assert_false(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+
+	make_tuple_id(&aoTupleId, 2, 200000);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry);
+	expect_any(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 196608);
+	assert_true(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+
+	/* A segment file without entries has all rows visible. */
+	visiMap.segmentCache.entryCount = 0;
+	make_tuple_id(&aoTupleId, 2, 40000);
+	assert_true(AppendOnlyVisimap_IsKnownVisible(&visiMap, &aoTupleId));
+}
+
 int 
 main(int argc, char* argv[]) 
 {
 	cmockery_parse_arguments(argc, argv);
 
 	const UnitTest tests[] = {
-			unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder)
+			unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder),
+			unit_test(test__AppendOnlyVisimap_IsKnownVisible)
 	};
 
 	MemoryContextInit();
@@ -0,0 +1,90 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../appendonlyblockdirectory.c"
+
+static void
+set_minipage(MinipagePerColumnGroup *minipageInfo,
+			 int64 firstRowNum, int64 rowCount)
+{
+	minipageInfo->minipage->entry[0].firstRowNum = firstRowNum;
+	minipageInfo->minipage->entry[0].fileOffset = 0;
+	minipageInfo->minipage->entry[0].rowCount = rowCount;
+	minipageInfo->minipage->nEntry = 1;
+	minipageInfo->numMinipageEntries = 1;
+}
+
+/*
+ * Minipages replaced by a search are kept, least recently used out first,
+ * and can be made current again.
+ */
+void
+test__stash_minipage__KeepsRecentlyUsed(void **state)
+{
+	AppendOnlyBlockDirectory blockDirectory;
+	MinipagePerColumnGroup minipageInfo;
+	FileSegInfo fsInfo;
+
+	MemSet(&blockDirectory, 0, sizeof(blockDirectory));
+	MemSet(&minipageInfo, 0, sizeof(minipageInfo));
+	blockDirectory.memoryContext = TopMemoryContext;
+	blockDirectory.numColumnGroups = 1;
+	blockDirectory.minipages = &minipageInfo;
+	blockDirectory.minipageCacheSize = 2;
+	blockDirectory.currentSegmentFileNum = 1;
+	blockDirectory.currentSegmentFileInfo = &fsInfo;
+	minipageInfo.minipage = palloc0(minipage_size(NUM_MINIPAGE_ENTRIES));
+
+	set_minipage(&minipageInfo, 1, 100);
+	stash_minipage(&blockDirectory, 0);
+	assert_int_equal(minipageInfo.numMinipageEntries, 0);
+	set_minipage(&minipageInfo, 101, 100);
+	stash_minipage(&blockDirectory, 0);
+
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 150), 0);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 50), 1);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 2, 50), -1);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 250), -1);
+
+	/* The cache is full; rows 1 to 100 go. */
+	set_minipage(&minipageInfo, 201, 100);
+	stash_minipage(&blockDirectory, 0);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 50), -1);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 250), 0);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 150), 1);
+
+	/* Taking a minipage without a current one leaves an unused entry. */
+	assert_true(swap_cached_minipage(&blockDirectory, 0, 1) == &fsInfo);
+	assert_int_equal(minipageInfo.numMinipageEntries, 1);
+	assert_int_equal(minipageInfo.minipage->entry[0].firstRowNum, 101);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 150), -1);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 250), 0);
+	assert_int_equal(minipageInfo.cache[1].numMinipageEntries, 0);
+
+	/* Otherwise the current minipage is cached in its place. */
+	swap_cached_minipage(&blockDirectory, 0, 0);
+	assert_int_equal(minipageInfo.minipage->entry[0].firstRowNum, 201);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 150), 0);
+
+	/* The unused entry is reused before anything is evicted. */
+	stash_minipage(&blockDirectory, 0);
+	assert_int_equal(minipageInfo.numCached, 2);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 250), 0);
+	assert_int_equal(find_cached_minipage(&minipageInfo, 1, 150), 1);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+			unit_test(test__stash_minipage__KeepsRecentlyUsed)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -1094,7 +1094,23 @@ parse_validate_reloptions(StdRdOptions *result, Datum reloptions,
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("compresstype can\'t be used with compresslevel 0")));
-		if (result->compresslevel < 0 || result->compresslevel > 9)
+		if (result->compresstype &&
+			(pg_strcasecmp(result->compresstype, "zstd") == 0))
+		{
+			if (result->compresslevel < 1 || result->compresslevel > 19)
+			{
+				if (validate)
+					ereport(ERROR,
+							(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+							 errmsg("compresslevel=%d is out of range for zstd"
+									" (should be between 1 and 19)",
+									result->compresslevel)));
+
+				result->compresslevel = setDefaultCompressionLevel(
+						result->compresstype);
+			}
+		}
+		else if (result->compresslevel < 0 || result->compresslevel > 9)
 		{
 			if (validate)
 				ereport(ERROR,
@@ -1381,6 +1397,7 @@ void validateAppendOnlyRelOptions(bool ao,
 	if (comptype &&
 		(pg_strcasecmp(comptype, "quicklz") == 0 ||
 		 pg_strcasecmp(comptype, "zlib") == 0 ||
+		 pg_strcasecmp(comptype, "zstd") == 0 ||
 		 pg_strcasecmp(comptype, "rle_type") == 0))
 	{
 
@@ -1393,12 +1410,28 @@ void validateAppendOnlyRelOptions(bool ao,
 							comptype)));
 		}
 
+#ifndef HAVE_LIBZSTD
+		if (pg_strcasecmp(comptype, "zstd") == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("zstd compression is not supported by this build"),
+					 errhint("Compile with --with-zstd to use zstd compression.")));
+#endif
+
 		if (comptype && complevel == 0)
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("compresstype cannot be used with compresslevel 0")));
 
-		if (complevel < 0 || complevel > 9)
+		if (pg_strcasecmp(comptype, "zstd") == 0)
+		{
+			if (complevel < 1 || complevel > 19)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("compresslevel=%d is out of range for zstd "
+								"(should be between 1 and 19)", complevel)));
+		}
+		else if (complevel < 0 || complevel > 9)
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("compresslevel=%d is out of range (should be between 0 and 9)",
@@ -1446,7 +1479,7 @@ void validateAppendOnlyRelOptions(bool ao,
 
 /*
  * if no compressor type was specified, we set to no compression (level 0)
- * otherwise default for both zlib, quicklz and RLE to level 1.
+ * otherwise default for zlib, zstd, quicklz and RLE to level 1.
  */
 static int setDefaultCompressionLevel(char* compresstype)
 {
@@ -60,6 +60,8 @@
 #include "access/clog.h"
 #include "utils/vmem_tracker.h"
 
+#include "cdb/cdbaocsam.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdbvars.h" /* Gp_role, Gp_is_writer, interconnect_setup_timeout */
 
@@ -3558,6 +3560,7 @@ CommitTransaction(void)
 	AtEOXact_CatCache(true);
 
 	AtEOXact_AppendOnly();
+	AtEOXact_AOCSInsert();
 	AtEOXact_GUC(true, 1);
 	AtEOXact_SPI(true);
 	AtEOXact_on_commit_actions(true);
@@ -3566,6 +3569,7 @@ CommitTransaction(void)
 	AtEOXact_Files();
 	AtEOXact_ComboCid();
 	AtEOXact_HashTables(true);
+	AtEOXact_AppendOnlyDecompress();
 	AtEOXact_PgStat(true);
 	pgstat_report_xact_timestamp(0);
 
@@ -3842,6 +3846,7 @@ PrepareTransaction(void)
 	/* Check we've released all catcache entries */
 	AtEOXact_CatCache(true);
 
+	AtEOXact_AOCSInsert();
 	/* PREPARE acts the same as COMMIT as far as GUC is concerned */
 	AtEOXact_GUC(true, 1);
 	AtEOXact_SPI(true);
@@ -3851,6 +3856,7 @@ PrepareTransaction(void)
 	AtEOXact_Files();
 	AtEOXact_ComboCid();
 	AtEOXact_HashTables(true);
+	AtEOXact_AppendOnlyDecompress();
 	/* don't call AtEOXact_PgStat here */
 
 	CurrentResourceOwner = NULL;
@@ -3912,6 +3918,9 @@ AbortTransaction(void)
 	AtAbort_Memory();
 	AtAbort_ResourceOwner();
 
+	/* Stop decompression threads from using memory about to be freed */
+	AtAbort_AppendOnlyDecompress();
+
 	/*
 	 * Release any LW locks we might be holding as quickly as possible.
 	 * (Regular locks, however, must be held till we finish aborting.)
@@ -4068,6 +4077,7 @@ AbortTransaction(void)
 		AtEOXact_CatCache(false);
 
 		AtEOXact_AppendOnly();
+		AtEOXact_AOCSInsert();
 		AtEOXact_GUC(false, 1);
 		AtEOXact_SPI(false);
 		AtEOXact_on_commit_actions(false);
@@ -6180,6 +6190,9 @@ AbortSubTransaction(void)
 	AtSubAbort_Memory();
 	AtSubAbort_ResourceOwner();
 
+	/* Stop decompression threads from using memory about to be freed */
+	AtSubAbort_AppendOnlyDecompress(s->subTransactionId);
+
 	/*
 	 * Release any LW locks we might be holding as quickly as possible.
 	 * (Regular locks, however, must be held till we finish aborting.)
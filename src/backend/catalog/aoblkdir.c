@@ -18,6 +18,7 @@
 #include "catalog/pg_opclass.h"
 #include "catalog/aoblkdir.h"
 #include "catalog/aocatalog.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 
@@ -46,8 +47,15 @@ AlterTableCreateAoBlkdirTableWithOid(Oid relOid, Oid newOid, Oid newIndexOid,
 		return;
 	}
 
-	/* Create a tuple descriptor */
-	tupdesc = CreateTemplateTupleDesc(4, false);
+	/*
+	 * Create a tuple descriptor.  The zonemap column is only added while
+	 * gp_appendonly_zone_maps is on; without it the block directory keeps
+	 * its old layout.
+	 */
+	tupdesc = CreateTemplateTupleDesc(gp_appendonly_zone_maps ?
+									  Natts_pg_aoblkdir :
+									  Anum_pg_aoblkdir_zonemap - 1,
+									  false);
 	TupleDescInitEntry(tupdesc, (AttrNumber) 1,
 					   "segno",
 					   INT4OID,
@@ -64,6 +72,11 @@ AlterTableCreateAoBlkdirTableWithOid(Oid relOid, Oid newOid, Oid newIndexOid,
 					   "minipage",
 					   VARBITOID,
 					   -1, 0);
+	if (gp_appendonly_zone_maps)
+		TupleDescInitEntry(tupdesc, (AttrNumber) Anum_pg_aoblkdir_zonemap,
+						   "zonemap",
+						   BYTEAOID,
+						   -1, 0);
 
 	/*
 	 * We don't want any toast columns here.
@@ -0,0 +1,224 @@
+/*-------------------------------------------------------------------------
+ *
+ * zstd_compression.c
+ *	  Zstandard compression for append-only tables.
+ *
+ * Zstandard decompresses several times faster than zlib at a comparable
+ * compression ratio, which makes it the better choice for tables that are
+ * scanned much more often than they are loaded.  Levels 1 to 19 are
+ * accepted; low levels favour load speed, high levels the ratio.
+ * Decompression speed hardly depends on the level.
+ *
+ * The routines are registered in pg_compression and reached through
+ * GetCompressionImplementation() like the zlib ones.  Without --with-zstd
+ * they raise an error; the reloptions code refuses compresstype=zstd
+ * before a table could be created with it.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_compression.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+
+#ifdef HAVE_LIBZSTD
+
+#include <zstd.h>
+#include <zstd_errors.h>
+
+/* Internal state for zstd */
+typedef struct zstd_state
+{
+	int			level;			/* compression level */
+	bool		compress;		/* compress or decompress? */
+
+	/*
+	 * Contexts are created on first use and reused for every block of the
+	 * table; creating one costs more than compressing a block.  They are
+	 * allocated by the library with malloc, so the destructor must free
+	 * them.
+	 */
+	ZSTD_CCtx  *cctx;
+	ZSTD_DCtx  *dctx;
+} zstd_state;
+
+Datum
+zstd_constructor(PG_FUNCTION_ARGS)
+{
+	/* PG_GETARG_POINTER(0) is TupleDesc that is currently unused. */
+
+	StorageAttributes *sa = PG_GETARG_POINTER(1);
+	CompressionState *cs = palloc0(sizeof(CompressionState));
+	zstd_state *state = palloc0(sizeof(zstd_state));
+	bool		compress = PG_GETARG_BOOL(2);
+
+	cs->opaque = (void *) state;
+	cs->desired_sz = NULL;
+
+	Insist(PointerIsValid(sa->comptype));
+
+	if (sa->complevel == 0)
+		sa->complevel = 1;
+
+	state->level = sa->complevel;
+	state->compress = compress;
+	state->cctx = NULL;
+	state->dctx = NULL;
+
+	PG_RETURN_POINTER(cs);
+}
+
+Datum
+zstd_destructor(PG_FUNCTION_ARGS)
+{
+	CompressionState *cs = PG_GETARG_POINTER(0);
+
+	if (cs != NULL && cs->opaque != NULL)
+	{
+		zstd_state *state = (zstd_state *) cs->opaque;
+
+		if (state->cctx != NULL)
+			ZSTD_freeCCtx(state->cctx);
+		if (state->dctx != NULL)
+			ZSTD_freeDCtx(state->dctx);
+
+		pfree(state);
+	}
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_compress(PG_FUNCTION_ARGS)
+{
+	const void *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	void	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = PG_GETARG_POINTER(4);
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		result;
+
+	if (state->cctx == NULL)
+	{
+		state->cctx = ZSTD_createCCtx();
+		if (state->cctx == NULL)
+			elog(ERROR, "out of memory");
+	}
+
+	result = ZSTD_compressCCtx(state->cctx, dst, dst_sz, src, src_sz,
+							   state->level);
+
+	if (ZSTD_isError(result))
+	{
+		/*
+		 * Like zlib, report incompressible data by claiming the whole
+		 * input size was used; the caller then stores the block
+		 * uncompressed.
+		 */
+		if (ZSTD_getErrorCode(result) == ZSTD_error_dstSize_tooSmall)
+			result = src_sz;
+		else
+			elog(ERROR, "zstd compression failed: %s",
+				 ZSTD_getErrorName(result));
+	}
+
+	*dst_used = (int32) result;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_decompress(PG_FUNCTION_ARGS)
+{
+	const char *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	void	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = PG_GETARG_POINTER(4);
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		result;
+
+	Insist(src_sz > 0 && dst_sz > 0);
+
+	if (state->dctx == NULL)
+	{
+		state->dctx = ZSTD_createDCtx();
+		if (state->dctx == NULL)
+			elog(ERROR, "out of memory");
+	}
+
+	result = ZSTD_decompressDCtx(state->dctx, dst, dst_sz, src, src_sz);
+
+	if (ZSTD_isError(result))
+	{
+		/*
+		 * A too small buffer would be a bug; we should have given a buffer
+		 * big enough in the decompress case.  Anything else is corrupt data.
+		 */
+		if (ZSTD_getErrorCode(result) == ZSTD_error_dstSize_tooSmall)
+			elog(ERROR, "buffer size %d insufficient for compressed data",
+				 dst_sz);
+		else
+			elog(ERROR, "zstd encountered data in an unexpected format: %s",
+				 ZSTD_getErrorName(result));
+	}
+
+	*dst_used = (int32) result;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_validator(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_VOID();
+}
+
+#else							/* HAVE_LIBZSTD */
+
+#define ZSTD_NOT_SUPPORTED() \
+	ereport(ERROR, \
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), \
+			 errmsg("zstd compression is not supported by this build"), \
+			 errhint("Compile with --with-zstd to use zstd compression.")))
+
+Datum
+zstd_constructor(PG_FUNCTION_ARGS)
+{
+	ZSTD_NOT_SUPPORTED();
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_destructor(PG_FUNCTION_ARGS)
+{
+	ZSTD_NOT_SUPPORTED();
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_compress(PG_FUNCTION_ARGS)
+{
+	ZSTD_NOT_SUPPORTED();
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_decompress(PG_FUNCTION_ARGS)
+{
+	ZSTD_NOT_SUPPORTED();
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_validator(PG_FUNCTION_ARGS)
+{
+	ZSTD_NOT_SUPPORTED();
+	PG_RETURN_VOID();
+}
+
+#endif							/* HAVE_LIBZSTD */
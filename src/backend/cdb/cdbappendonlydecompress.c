@@ -0,0 +1,651 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbappendonlydecompress.c
+ *	  Decompress Append-Only Storage Blocks ahead of a scan on worker threads.
+ *
+ * (See .h file for usage comments)
+ *
+ * The worker threads are started on first use and live as long as the
+ * backend.  They wait for slots on one queue shared by all pipelines, so a
+ * column-oriented scan whose columns each have a pipeline still runs at most
+ * gp_appendonly_decompress_workers decompressions at a time.
+ *
+ * A slot and its buffers belong to the pipeline and are palloc'd in the
+ * scan's memory context, so they are charged to the scan by the memory
+ * accounting.  A worker only touches a slot while the slot is in the
+ * RUNNING state, and nobody frees or reuses a slot in that state.  Since
+ * an error frees the scan's memory without ending the scan, transaction and
+ * subtransaction abort first wait for the workers to let go of the slots of
+ * the pipelines that are about to disappear.
+ *
+ * Copyright (c) 2007-2009, Greenplum inc
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <pthread.h>
+#include <zlib.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "access/xact.h"
+#include "cdb/cdbappendonlydecompress.h"
+#include "cdb/cdbgang.h"
+
+typedef enum AppendOnlyDecompressCodec
+{
+	AppendOnlyDecompressCodec_Zlib,
+	AppendOnlyDecompressCodec_Zstd
+} AppendOnlyDecompressCodec;
+
+typedef enum AppendOnlyDecompressSlotState
+{
+	DecompressSlot_Free = 0,
+	DecompressSlot_Queued,
+	DecompressSlot_Running,
+	DecompressSlot_Done,
+	DecompressSlot_Failed
+} AppendOnlyDecompressSlotState;
+
+typedef struct AppendOnlyDecompressSlot
+{
+	AppendOnlyDecompressPipeline *pipeline;
+
+	AppendOnlyDecompressSlotState state;
+	bool		discard;
+			/*
+			 * Set when the scan went past the block while a worker was
+			 * running it; the worker frees the slot when done.
+			 */
+
+	int64		headerOffsetInFile;
+	int32		compressedLen;
+	int32		uncompressedLen;
+
+	uint8	   *compressed;
+	uint8	   *uncompressed;
+
+	struct AppendOnlyDecompressSlot *queueNext;
+} AppendOnlyDecompressSlot;
+
+struct AppendOnlyDecompressPipeline
+{
+	MemoryContext memoryContext;
+
+	AppendOnlyDecompressCodec codec;
+
+	int32		maxBufferLen;
+
+	int			slotCount;
+	AppendOnlyDecompressSlot *slots;
+
+	SubTransactionId createSubid;
+
+	struct AppendOnlyDecompressPipeline *next;
+			/* In the list of live pipelines. */
+};
+
+/*
+ * The mutex protects the queue, the state of every slot and the list of
+ * live pipelines.
+ */
+static pthread_mutex_t DecompressMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t DecompressQueuedCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t DecompressFinishedCond = PTHREAD_COND_INITIALIZER;
+
+static AppendOnlyDecompressSlot *DecompressQueueHead = NULL;
+static AppendOnlyDecompressSlot *DecompressQueueTail = NULL;
+
+static int	DecompressWorkerCount = 0;
+
+static AppendOnlyDecompressPipeline *DecompressPipelines = NULL;
+
+static void *AppendOnlyDecompress_WorkerMain(void *arg);
+static bool AppendOnlyDecompress_StartWorkers(int workers);
+static void AppendOnlyDecompress_Dequeue(AppendOnlyDecompressSlot *slot);
+static void AppendOnlyDecompress_Quiesce(AppendOnlyDecompressPipeline *pipeline);
+
+
+// -----------------------------------------------------------------------------
+// Worker threads
+// -----------------------------------------------------------------------------
+
+/*
+ * Decompress one slot.  Runs without the mutex; must not palloc or elog.
+ */
+static bool
+AppendOnlyDecompress_DoSlot(
+	AppendOnlyDecompressSlot	*slot,
+	void						*zstdContext)
+{
+	switch (slot->pipeline->codec)
+	{
+	case AppendOnlyDecompressCodec_Zlib:
+		{
+			uLongf		destLen = slot->uncompressedLen;
+
+			if (uncompress(slot->uncompressed, &destLen,
+						   slot->compressed, slot->compressedLen) != Z_OK)
+				return false;
+			return (destLen == slot->uncompressedLen);
+		}
+
+	case AppendOnlyDecompressCodec_Zstd:
+#ifdef HAVE_LIBZSTD
+		{
+			size_t		result;
+
+			if (zstdContext == NULL)
+				return false;
+			result = ZSTD_decompressDCtx((ZSTD_DCtx *) zstdContext,
+										 slot->uncompressed,
+										 slot->uncompressedLen,
+										 slot->compressed,
+										 slot->compressedLen);
+			if (ZSTD_isError(result))
+				return false;
+			return (result == slot->uncompressedLen);
+		}
+#else
+		return false;
+#endif
+	}
+
+	return false;
+}
+
+static void *
+AppendOnlyDecompress_WorkerMain(void *arg)
+{
+	void	   *zstdContext = NULL;
+
+	gp_set_thread_sigmasks();
+
+#ifdef HAVE_LIBZSTD
+	/* Allocated with malloc by the library; lives as long as the thread. */
+	zstdContext = ZSTD_createDCtx();
+#endif
+
+	pthread_mutex_lock(&DecompressMutex);
+	for (;;)
+	{
+		AppendOnlyDecompressSlot *slot;
+		bool		ok;
+
+		while (DecompressQueueHead == NULL)
+			pthread_cond_wait(&DecompressQueuedCond, &DecompressMutex);
+
+		slot = DecompressQueueHead;
+		AppendOnlyDecompress_Dequeue(slot);
+		slot->state = DecompressSlot_Running;
+
+		pthread_mutex_unlock(&DecompressMutex);
+
+		ok = AppendOnlyDecompress_DoSlot(slot, zstdContext);
+
+		pthread_mutex_lock(&DecompressMutex);
+
+		if (slot->discard)
+			slot->state = DecompressSlot_Free;
+		else
+			slot->state = (ok ? DecompressSlot_Done : DecompressSlot_Failed);
+		slot->discard = false;
+
+		pthread_cond_broadcast(&DecompressFinishedCond);
+	}
+
+	return NULL;
+}
+
+/*
+ * Make sure at least 'workers' threads are running.
+ *
+ * Returns false when not even one could be started.
+ */
+static bool
+AppendOnlyDecompress_StartWorkers(int workers)
+{
+	while (DecompressWorkerCount < workers)
+	{
+		pthread_t	thread;
+		int			pthread_err;
+
+		pthread_err = gp_pthread_create(&thread,
+										AppendOnlyDecompress_WorkerMain,
+										NULL,
+										"AppendOnlyDecompressPipeline");
+		if (pthread_err != 0)
+		{
+			elog(LOG, "could not start append-only decompression thread: %s",
+				 strerror(pthread_err));
+			break;
+		}
+
+		pthread_detach(thread);
+		DecompressWorkerCount++;
+	}
+
+	return (DecompressWorkerCount > 0);
+}
+
+/*
+ * Unlink a queued slot.  Caller holds the mutex.
+ */
+static void
+AppendOnlyDecompress_Dequeue(AppendOnlyDecompressSlot *slot)
+{
+	AppendOnlyDecompressSlot *prev = NULL;
+	AppendOnlyDecompressSlot *cur;
+
+	for (cur = DecompressQueueHead; cur != NULL; cur = cur->queueNext)
+	{
+		if (cur == slot)
+			break;
+		prev = cur;
+	}
+	Assert(cur == slot);
+
+	if (prev == NULL)
+		DecompressQueueHead = slot->queueNext;
+	else
+		prev->queueNext = slot->queueNext;
+	if (DecompressQueueTail == slot)
+		DecompressQueueTail = prev;
+	slot->queueNext = NULL;
+}
+
+/*
+ * Take all slots of a pipeline away from the workers, waiting for the ones
+ * they are running.  Caller holds the mutex.
+ */
+static void
+AppendOnlyDecompress_Quiesce(AppendOnlyDecompressPipeline *pipeline)
+{
+	int			i;
+
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		AppendOnlyDecompressSlot *slot = &pipeline->slots[i];
+
+		if (slot->state == DecompressSlot_Queued)
+			AppendOnlyDecompress_Dequeue(slot);
+
+		while (slot->state == DecompressSlot_Running)
+			pthread_cond_wait(&DecompressFinishedCond, &DecompressMutex);
+
+		slot->state = DecompressSlot_Free;
+		slot->discard = false;
+	}
+}
+
+
+// -----------------------------------------------------------------------------
+// Pipeline
+// -----------------------------------------------------------------------------
+
+AppendOnlyDecompressPipeline *
+AppendOnlyDecompressPipeline_Create(
+	MemoryContext		memoryContext,
+	char				*compressType,
+	int32				maxBufferLen,
+	int					workers)
+{
+	AppendOnlyDecompressPipeline *pipeline;
+	AppendOnlyDecompressCodec codec;
+	bool		started;
+
+	if (workers <= 0 || compressType == NULL)
+		return NULL;
+
+	if (pg_strcasecmp(compressType, "zlib") == 0)
+		codec = AppendOnlyDecompressCodec_Zlib;
+#ifdef HAVE_LIBZSTD
+	else if (pg_strcasecmp(compressType, "zstd") == 0)
+		codec = AppendOnlyDecompressCodec_Zstd;
+#endif
+	else
+		return NULL;
+
+	pthread_mutex_lock(&DecompressMutex);
+	started = AppendOnlyDecompress_StartWorkers(workers);
+	pthread_mutex_unlock(&DecompressMutex);
+
+	if (!started)
+		return NULL;
+
+	pipeline = (AppendOnlyDecompressPipeline *)
+		MemoryContextAllocZero(memoryContext, sizeof(AppendOnlyDecompressPipeline));
+	pipeline->memoryContext = memoryContext;
+	pipeline->codec = codec;
+	pipeline->maxBufferLen = maxBufferLen;
+	pipeline->createSubid = GetCurrentSubTransactionId();
+
+	/*
+	 * One block in flight per worker.  The buffers are only allocated when a
+	 * slot is first used, so a short scan does not pay for all of them.
+	 */
+	pipeline->slotCount = workers;
+	pipeline->slots = (AppendOnlyDecompressSlot *)
+		MemoryContextAllocZero(memoryContext,
+							   workers * sizeof(AppendOnlyDecompressSlot));
+
+	pthread_mutex_lock(&DecompressMutex);
+	pipeline->next = DecompressPipelines;
+	DecompressPipelines = pipeline;
+	pthread_mutex_unlock(&DecompressMutex);
+
+	return pipeline;
+}
+
+bool
+AppendOnlyDecompressPipeline_HasFreeSlot(
+	AppendOnlyDecompressPipeline	*pipeline)
+{
+	bool		result = false;
+	int			i;
+
+	pthread_mutex_lock(&DecompressMutex);
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		if (pipeline->slots[i].state == DecompressSlot_Free)
+		{
+			result = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&DecompressMutex);
+
+	return result;
+}
+
+bool
+AppendOnlyDecompressPipeline_HasBlock(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile)
+{
+	bool		result = false;
+	int			i;
+
+	pthread_mutex_lock(&DecompressMutex);
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		AppendOnlyDecompressSlot *slot = &pipeline->slots[i];
+
+		if (slot->state != DecompressSlot_Free &&
+			!slot->discard &&
+			slot->headerOffsetInFile == headerOffsetInFile)
+		{
+			result = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&DecompressMutex);
+
+	return result;
+}
+
+bool
+AppendOnlyDecompressPipeline_Submit(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile,
+	uint8							*compressed,
+	int32							compressedLen,
+	int32							uncompressedLen)
+{
+	AppendOnlyDecompressSlot *slot = NULL;
+	int			i;
+
+	if (compressedLen <= 0 || compressedLen > pipeline->maxBufferLen ||
+		uncompressedLen <= 0 || uncompressedLen > pipeline->maxBufferLen)
+		return false;
+
+	/*
+	 * Only we move a slot out of the free state, so a slot found free stays
+	 * free until we queue it.
+	 */
+	pthread_mutex_lock(&DecompressMutex);
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		if (pipeline->slots[i].state == DecompressSlot_Free)
+		{
+			slot = &pipeline->slots[i];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&DecompressMutex);
+
+	if (slot == NULL)
+		return false;
+
+	if (slot->compressed == NULL)
+	{
+		slot->pipeline = pipeline;
+		slot->compressed = (uint8 *)
+			MemoryContextAlloc(pipeline->memoryContext, pipeline->maxBufferLen);
+		slot->uncompressed = (uint8 *)
+			MemoryContextAlloc(pipeline->memoryContext, pipeline->maxBufferLen);
+	}
+
+	memcpy(slot->compressed, compressed, compressedLen);
+	slot->headerOffsetInFile = headerOffsetInFile;
+	slot->compressedLen = compressedLen;
+	slot->uncompressedLen = uncompressedLen;
+
+	pthread_mutex_lock(&DecompressMutex);
+	slot->state = DecompressSlot_Queued;
+	slot->discard = false;
+	slot->queueNext = NULL;
+	if (DecompressQueueTail == NULL)
+		DecompressQueueHead = slot;
+	else
+		DecompressQueueTail->queueNext = slot;
+	DecompressQueueTail = slot;
+	pthread_cond_signal(&DecompressQueuedCond);
+	pthread_mutex_unlock(&DecompressMutex);
+
+	return true;
+}
+
+bool
+AppendOnlyDecompressPipeline_Take(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile,
+	int32							compressedLen,
+	uint8							*contentOut,
+	int32							uncompressedLen)
+{
+	AppendOnlyDecompressSlot *found = NULL;
+	bool		result;
+	int			i;
+
+	pthread_mutex_lock(&DecompressMutex);
+
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		AppendOnlyDecompressSlot *slot = &pipeline->slots[i];
+
+		if (slot->state == DecompressSlot_Free || slot->discard)
+			continue;
+
+		if (slot->headerOffsetInFile == headerOffsetInFile)
+		{
+			found = slot;
+			continue;
+		}
+
+		if (slot->headerOffsetInFile > headerOffsetInFile)
+			continue;
+
+		/*
+		 * The scan went past this block (e.g. skipped it); forget it.
+		 */
+		switch (slot->state)
+		{
+		case DecompressSlot_Queued:
+			AppendOnlyDecompress_Dequeue(slot);
+			slot->state = DecompressSlot_Free;
+			break;
+		case DecompressSlot_Running:
+			slot->discard = true;
+			break;
+		default:
+			slot->state = DecompressSlot_Free;
+			break;
+		}
+	}
+
+	if (found == NULL)
+	{
+		pthread_mutex_unlock(&DecompressMutex);
+		return false;
+	}
+
+	if (found->state == DecompressSlot_Queued)
+	{
+		/*
+		 * No worker got to it yet.  Rather than wait, let the caller
+		 * decompress it while the workers go on with the blocks after it.
+		 */
+		AppendOnlyDecompress_Dequeue(found);
+		found->state = DecompressSlot_Free;
+		pthread_mutex_unlock(&DecompressMutex);
+		return false;
+	}
+
+	while (found->state == DecompressSlot_Running)
+		pthread_cond_wait(&DecompressFinishedCond, &DecompressMutex);
+
+	/*
+	 * A failed block is decompressed again by the caller, which reports the
+	 * error properly.
+	 */
+	result = (found->state == DecompressSlot_Done &&
+			  found->compressedLen == compressedLen &&
+			  found->uncompressedLen == uncompressedLen);
+	if (result)
+		memcpy(contentOut, found->uncompressed, uncompressedLen);
+	found->state = DecompressSlot_Free;
+
+	pthread_mutex_unlock(&DecompressMutex);
+
+	return result;
+}
+
+void
+AppendOnlyDecompressPipeline_Reset(
+	AppendOnlyDecompressPipeline	*pipeline)
+{
+	pthread_mutex_lock(&DecompressMutex);
+	AppendOnlyDecompress_Quiesce(pipeline);
+	pthread_mutex_unlock(&DecompressMutex);
+}
+
+void
+AppendOnlyDecompressPipeline_Free(
+	AppendOnlyDecompressPipeline	*pipeline)
+{
+	AppendOnlyDecompressPipeline **link;
+	int			i;
+
+	pthread_mutex_lock(&DecompressMutex);
+	AppendOnlyDecompress_Quiesce(pipeline);
+	for (link = &DecompressPipelines; *link != NULL; link = &(*link)->next)
+	{
+		if (*link == pipeline)
+		{
+			*link = pipeline->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&DecompressMutex);
+
+	for (i = 0; i < pipeline->slotCount; i++)
+	{
+		if (pipeline->slots[i].compressed != NULL)
+			pfree(pipeline->slots[i].compressed);
+		if (pipeline->slots[i].uncompressed != NULL)
+			pfree(pipeline->slots[i].uncompressed);
+	}
+	pfree(pipeline->slots);
+	pfree(pipeline);
+}
+
+
+// -----------------------------------------------------------------------------
+// Transaction end
+// -----------------------------------------------------------------------------
+
+/*
+ * Called at the start of transaction abort, before any memory is released.
+ * Every pipeline is about to be freed along with its scan.
+ */
+void
+AtAbort_AppendOnlyDecompress(void)
+{
+	AppendOnlyDecompressPipeline *pipeline;
+
+	if (DecompressPipelines == NULL)
+		return;
+
+	pthread_mutex_lock(&DecompressMutex);
+	for (pipeline = DecompressPipelines; pipeline != NULL; pipeline = pipeline->next)
+		AppendOnlyDecompress_Quiesce(pipeline);
+	DecompressPipelines = NULL;
+	pthread_mutex_unlock(&DecompressMutex);
+}
+
+/*
+ * Called at commit and prepare.  Every scan should have freed its pipeline
+ * by now; warn about the ones that are left and stop their workers before
+ * the memory they decompress into is released.
+ */
+void
+AtEOXact_AppendOnlyDecompress(void)
+{
+	AppendOnlyDecompressPipeline *pipeline;
+	int			leaked = 0;
+
+	if (DecompressPipelines == NULL)
+		return;
+
+	pthread_mutex_lock(&DecompressMutex);
+	for (pipeline = DecompressPipelines; pipeline != NULL; pipeline = pipeline->next)
+	{
+		AppendOnlyDecompress_Quiesce(pipeline);
+		leaked++;
+	}
+	DecompressPipelines = NULL;
+	pthread_mutex_unlock(&DecompressMutex);
+
+	elog(WARNING, "leaked %d append-only decompression pipelines", leaked);
+}
+
+/*
+ * Called at the start of subtransaction abort.  Pipelines created in the
+ * aborted subtransaction or its committed children go away; scans of outer ones may carry on, their
+ * pipelines merely lose the blocks decompressed ahead.
+ */
+void
+AtSubAbort_AppendOnlyDecompress(SubTransactionId mySubid)
+{
+	AppendOnlyDecompressPipeline **link;
+
+	if (DecompressPipelines == NULL)
+		return;
+
+	pthread_mutex_lock(&DecompressMutex);
+	link = &DecompressPipelines;
+	while (*link != NULL)
+	{
+		AppendOnlyDecompressPipeline *pipeline = *link;
+
+		AppendOnlyDecompress_Quiesce(pipeline);
+		if (pipeline->createSubid >= mySubid)
+			*link = pipeline->next;
+		else
+			link = &pipeline->next;
+	}
+	pthread_mutex_unlock(&DecompressMutex);
+}
@@ -186,6 +186,12 @@ void AppendOnlyStorageRead_FinishSession(
 
 	oldMemoryContext = MemoryContextSwitchTo(storageRead->memoryContext);
 
+	if (storageRead->decompressPipeline != NULL)
+	{
+		AppendOnlyDecompressPipeline_Free(storageRead->decompressPipeline);
+		storageRead->decompressPipeline = NULL;
+	}
+
 	// UNDONE: This expects the MemoryContext to be what was used for the 'memory' in ~Init
 	BufferedReadFinish(&storageRead->bufferedRead);
 
@@ -321,6 +327,12 @@ static void AppendOnlyStorageRead_FinishOpenFile(
 
 	storageRead->logicalEof = logicalEof;
 
+	/*
+	 * Blocks decompressed ahead are known by their offset in the file.
+	 */
+	if (storageRead->decompressPipeline != NULL)
+		AppendOnlyDecompressPipeline_Reset(storageRead->decompressPipeline);
+
 	BufferedReadSetFile(
 				&storageRead->bufferedRead,
 				storageRead->file,
@@ -455,6 +467,19 @@ void AppendOnlyStorageRead_SetTemporaryRange(
 								  afterFileOffset);
 }
 
+/*
+ * Set how many bytes past the current large read the kernel is asked to
+ * read ahead.  Zero disables read-ahead.
+ */
+void AppendOnlyStorageRead_SetReadAhead(
+	AppendOnlyStorageRead		*storageRead,
+	int32						readAheadLen)
+{
+	Assert(storageRead->isActive);
+
+	BufferedReadSetReadAhead(&storageRead->bufferedRead, readAheadLen);
+}
+
 /*
  * Close the current segment file.
  *
@@ -475,6 +500,9 @@ void AppendOnlyStorageRead_CloseFile(
 
 	storageRead->logicalEof = INT64CONST(0);
 
+	if (storageRead->decompressPipeline != NULL)
+		AppendOnlyDecompressPipeline_Reset(storageRead->decompressPipeline);
+
 	if(storageRead->bufferedRead.file >= 0)
 		BufferedReadCompleteFile(&storageRead->bufferedRead);
 }
@@ -1237,6 +1265,190 @@ uint8 *AppendOnlyStorageRead_GetBuffer(
 	return content;
 }
 
+/*
+ * Submit the compressed blocks that follow the current one to the
+ * decompression pipeline, as far as they are already in the large read.
+ *
+ * The headers are parsed the same way ~_PositionToNextBlock and
+ * ~_ReadNextBlock do, but without consuming anything; a header we cannot
+ * make sense of simply ends the look ahead and is reported when the scan
+ * gets to it.  Large content is not decompressed ahead.
+ */
+static void
+AppendOnlyStorageRead_FeedDecompressPipeline(
+	AppendOnlyStorageRead		*storageRead)
+{
+	AppendOnlyDecompressPipeline *pipeline = storageRead->decompressPipeline;
+	int32		safewrite = storageRead->storageAttributes.safeFSWriteSize;
+	int64		position;
+
+	position = storageRead->current.headerOffsetInFile +
+			   storageRead->current.overallBlockLen;
+
+	while (AppendOnlyDecompressPipeline_HasFreeSlot(pipeline))
+	{
+		uint8	   *header;
+		int32		availableLen;
+		int32		safeWriteRemainder = 0;
+		int			i;
+		AoHeaderKind headerKind;
+		int32		actualHeaderLen;
+		int32		blockLimitLen;
+		int64		fileRemainderLen;
+		int32		overallBlockLen;
+		int32		contentOffset;
+		int32		uncompressedLen;
+		int			executorBlockKind;
+		bool		hasFirstRowNum;
+		int64		firstRowNum;
+		int			rowCount;
+		bool		isCompressed;
+		int32		compressedLen;
+		AOHeaderCheckError checkError;
+
+		if (safewrite > 0)
+			safeWriteRemainder =
+				(int32)((((position + safewrite - 1) / safewrite) * safewrite) - position);
+
+		/*
+		 * Headers do not cross a file-system page boundary.
+		 */
+		if (safeWriteRemainder > 0 &&
+			safeWriteRemainder < storageRead->minimumHeaderLen)
+		{
+			position += safeWriteRemainder;
+			continue;
+		}
+
+		header = BufferedReadPeek(&storageRead->bufferedRead,
+								  position,
+								  &availableLen);
+		if (header == NULL || availableLen < storageRead->minimumHeaderLen)
+			break;
+
+		/*
+		 * Zero padded page remainder.
+		 */
+		for (i = 0; i < storageRead->minimumHeaderLen; i++)
+		{
+			if (header[i] != 0)
+				break;
+		}
+		if (i >= storageRead->minimumHeaderLen)
+		{
+			if (safeWriteRemainder <= 0)
+				break;
+			position += safeWriteRemainder;
+			continue;
+		}
+
+		checkError = AppendOnlyStorageFormat_GetHeaderInfo(
+												header,
+												storageRead->storageAttributes.checksum,
+												&headerKind,
+												&actualHeaderLen);
+		if (checkError != AOHeaderCheckOk || availableLen < actualHeaderLen)
+			break;
+
+		fileRemainderLen = storageRead->bufferedRead.fileLen - position;
+		if (storageRead->maxBufferLen > fileRemainderLen)
+			blockLimitLen = (int32)fileRemainderLen;
+		else
+			blockLimitLen = storageRead->maxBufferLen;
+
+		isCompressed = false;
+		switch (headerKind)
+		{
+		case AoHeaderKind_SmallContent:
+			checkError =
+				AppendOnlyStorageFormat_GetSmallContentHeaderInfo(
+									header,
+									actualHeaderLen,
+									storageRead->storageAttributes.checksum,
+									blockLimitLen,
+									&overallBlockLen,
+									&contentOffset,
+									&uncompressedLen,
+									&executorBlockKind,
+									&hasFirstRowNum,
+									storageRead->storageAttributes.version,
+									&firstRowNum,
+									&rowCount,
+									&isCompressed,
+									&compressedLen);
+			break;
+
+		case AoHeaderKind_NonBulkDenseContent:
+			checkError =
+				AppendOnlyStorageFormat_GetNonBulkDenseContentHeaderInfo(
+									header,
+									actualHeaderLen,
+									storageRead->storageAttributes.checksum,
+									blockLimitLen,
+									&overallBlockLen,
+									&contentOffset,
+									&uncompressedLen,
+									&executorBlockKind,
+									&hasFirstRowNum,
+									storageRead->storageAttributes.version,
+									&firstRowNum,
+									&rowCount);
+			break;
+
+		case AoHeaderKind_BulkDenseContent:
+			checkError =
+				AppendOnlyStorageFormat_GetBulkDenseContentHeaderInfo(
+									header,
+									actualHeaderLen,
+									storageRead->storageAttributes.checksum,
+									blockLimitLen,
+									&overallBlockLen,
+									&contentOffset,
+									&uncompressedLen,
+									&executorBlockKind,
+									&hasFirstRowNum,
+									storageRead->storageAttributes.version,
+									&firstRowNum,
+									&rowCount,
+									&isCompressed,
+									&compressedLen);
+			break;
+
+		default:
+			return;
+		}
+
+		if (checkError != AOHeaderCheckOk ||
+			overallBlockLen <= 0 ||
+			availableLen < overallBlockLen)
+			break;
+
+		if (isCompressed &&
+			!AppendOnlyDecompressPipeline_HasBlock(pipeline, position))
+		{
+			if (!AppendOnlyDecompressPipeline_Submit(
+											pipeline,
+											position,
+											&header[contentOffset],
+											compressedLen,
+											uncompressedLen))
+				break;
+
+			elogif(Debug_appendonly_print_read_block, LOG,
+				   "Append-Only storage read: decompressing ahead block for table '%s' "
+				   "(segment file '%s', header offset in file = " INT64_FORMAT ", "
+				   "compressed length %d, uncompressed length %d)",
+				   storageRead->relationName,
+				   storageRead->segmentFileName,
+				   position,
+				   compressedLen,
+				   uncompressedLen);
+		}
+
+		position += overallBlockLen;
+	}
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
@@ -1422,35 +1634,67 @@ void AppendOnlyStorageRead_Content(
 
 			PGFunction	  decompressor;
 			PGFunction	 *cfns = storageRead->compression_functions;
+			bool		  decompressedAhead;
+
+			if (storageRead->decompressPipeline == NULL &&
+				gp_appendonly_decompress_workers > 0)
+				storageRead->decompressPipeline =
+					AppendOnlyDecompressPipeline_Create(
+										storageRead->memoryContext,
+										storageRead->storageAttributes.compressType,
+										storageRead->maxBufferLen,
+										gp_appendonly_decompress_workers);
+
+			decompressedAhead = false;
+			if (storageRead->decompressPipeline != NULL)
+			{
+				decompressedAhead =
+					AppendOnlyDecompressPipeline_Take(
+										storageRead->decompressPipeline,
+										storageRead->current.headerOffsetInFile,
+										storageRead->current.compressedLen,
+										contentOut,
+										storageRead->current.uncompressedLen);
 
-			/* How can it be valid that decompressor is NULL, gp_decompress_new will
-			 * always crash if decompresor is NULL
-			 */
-			if (cfns == NULL)
-				decompressor = NULL;
-			else
-				decompressor = cfns[COMPRESSION_DECOMPRESS];
-
-			gp_decompress_new(
-				content,				// Compressed data in block.
-				storageRead->current.compressedLen,
-				contentOut,
-				storageRead->current.uncompressedLen,
-				decompressor,
-				storageRead->compressionState,
-				storageRead->bufferCount);
+				/*
+				 * Keep the workers busy with the following blocks while the
+				 * executor works on this one.
+				 */
+				AppendOnlyStorageRead_FeedDecompressPipeline(storageRead);
+			}
+
+			if (!decompressedAhead)
+			{
+				/* How can it be valid that decompressor is NULL, gp_decompress_new will
+				 * always crash if decompresor is NULL
+				 */
+				if (cfns == NULL)
+					decompressor = NULL;
+				else
+					decompressor = cfns[COMPRESSION_DECOMPRESS];
+
+				gp_decompress_new(
+					content,				// Compressed data in block.
+					storageRead->current.compressedLen,
+					contentOut,
+					storageRead->current.uncompressedLen,
+					decompressor,
+					storageRead->compressionState,
+					storageRead->bufferCount);
+			}
 
 			if (Debug_appendonly_print_scan)
 				elog(LOG,
 					"Append-only Storage Read decompressed block for table '%s' "
 					 "(compressed length %d, uncompressed length = %d, segment file '%s', "
-					 "header offset in file = " INT64_FORMAT ", block count " INT64_FORMAT ")",
+					 "header offset in file = " INT64_FORMAT ", block count " INT64_FORMAT ", %s)",
 					 storageRead->relationName,
 					 AppendOnlyStorageFormat_GetCompressedLen(header),
 					 storageRead->current.uncompressedLen,
 					 storageRead->segmentFileName,
 					 storageRead->current.headerOffsetInFile,
-					 storageRead->bufferCount);
+					 storageRead->bufferCount,
+					 (decompressedAhead ? "decompressed ahead" : "decompressed inline"));
 		}
 	}
 
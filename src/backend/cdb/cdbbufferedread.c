@@ -16,6 +16,8 @@
 
 static void BufferedReadIo(
     BufferedRead        *bufferedRead);
+static void BufferedReadPrefetch(
+    BufferedRead        *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
     BufferedRead       *bufferedRead,
     int32              maxReadAheadLen,
@@ -102,6 +104,27 @@ void BufferedReadInit(
 	 */
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
+
+	/*
+	 * Read-ahead support.
+	 */
+	bufferedRead->readAheadLen = 0;
+	bufferedRead->readAheadPosition = 0;
+}
+
+/*
+ * Set the number of bytes to request ahead of the current large read.
+ *
+ * Zero disables read-ahead.  Takes effect with the next large read.
+ */
+void BufferedReadSetReadAhead(
+    BufferedRead         *bufferedRead,
+    int32                readAheadLen)
+{
+	Assert(bufferedRead != NULL);
+	Assert(readAheadLen >= 0);
+
+	bufferedRead->readAheadLen = readAheadLen;
 }
 
 /*
@@ -134,6 +157,8 @@ void BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->readAheadPosition = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -144,6 +169,7 @@ void BufferedReadSetFile(
 		else
 			bufferedRead->largeReadLen = (int32)fileLen;
 		BufferedReadIo(bufferedRead);
+		BufferedReadPrefetch(bufferedRead);
 	}
 }
 
@@ -237,6 +263,68 @@ static void BufferedReadIo(
 		VacuumCostBalance += VacuumCostPageMiss;
 }
 
+/*
+ * Ask the kernel to start reading the part of the file following the
+ * current large read, up to readAheadLen bytes ahead of it.
+ *
+ * Only the part not requested before is advised, and only once it has grown
+ * to a large read (or reaches the end of the file), so there is about one
+ * request per large read.  Read-ahead is a hint; failures are ignored.
+ */
+static void BufferedReadPrefetch(
+    BufferedRead        *bufferedRead)
+{
+	int64 inEffectFileLen;
+	int64 largeReadAfterPos;
+	int64 beginPosition;
+	int64 afterPosition;
+	int32 minPrefetchLen;
+	int   result;
+
+	if (bufferedRead->readAheadLen == 0)
+		return;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	largeReadAfterPos = bufferedRead->largeReadPosition +
+						bufferedRead->largeReadLen;
+
+	afterPosition = largeReadAfterPos + bufferedRead->readAheadLen;
+	if (afterPosition > inEffectFileLen)
+		afterPosition = inEffectFileLen;
+
+	beginPosition = bufferedRead->readAheadPosition;
+	if (beginPosition < largeReadAfterPos)
+		beginPosition = largeReadAfterPos;
+
+	if (beginPosition >= afterPosition)
+		return;
+
+	minPrefetchLen = Min(bufferedRead->maxLargeReadLen,
+						 bufferedRead->readAheadLen);
+	if (afterPosition - beginPosition < minPrefetchLen &&
+		afterPosition < inEffectFileLen)
+		return;
+
+	result = FilePrefetch(bufferedRead->file,
+						  beginPosition,
+						  (int)(afterPosition - beginPosition));
+
+	elogif(Debug_appendonly_print_read_block, LOG,
+		   "Append-Only storage read-ahead: table '%s', segment file '%s', "
+		   "position " INT64_FORMAT ", length %d (result %d)",
+		   bufferedRead->relationName,
+		   bufferedRead->filePathName,
+		   beginPosition,
+		   (int)(afterPosition - beginPosition),
+		   result);
+
+	bufferedRead->readAheadPosition = afterPosition;
+}
+
 static uint8 *BufferedReadUseBeforeBuffer(
     BufferedRead       *bufferedRead,
     int32              maxReadAheadLen,
@@ -316,6 +404,7 @@ static uint8 *BufferedReadUseBeforeBuffer(
 	}
 	
 	BufferedReadIo(bufferedRead);
+	BufferedReadPrefetch(bufferedRead);
 
 	extraLen = maxReadAheadLen - beforeLen;
 	Assert(extraLen > 0);
@@ -434,6 +523,13 @@ void BufferedReadSetTemporaryRange(
 
 		bufferedRead->largeReadPosition = beginFileOffset;
 
+		/*
+		 * A seek means random access (e.g. an index fetch), so forget what
+		 * we asked the kernel for and don't read ahead until reading goes
+		 * on sequentially from here.
+		 */
+		bufferedRead->readAheadPosition = 0;
+
 		if (bufferedRead->largeReadLen > 0)
 			BufferedReadIo(bufferedRead);
 	}
@@ -539,6 +635,7 @@ uint8 *BufferedReadGetNextBuffer(
 		}
 
 		BufferedReadIo(bufferedRead);
+		BufferedReadPrefetch(bufferedRead);
 
 		if (maxReadAheadLen > bufferedRead->largeReadLen)
 			bufferedRead->bufferLen = bufferedRead->largeReadLen;
@@ -641,6 +738,38 @@ uint8 *BufferedReadGrowBuffer(
 	return &bufferedRead->largeReadMemory[bufferedRead->bufferOffset];
 }
 
+/*
+ * Look at file data at a position past the current buffer without
+ * consuming it.
+ *
+ * Only the current large read is looked at; no I/O is done.  Returns NULL
+ * when the position is not within it.
+ */
+uint8 *BufferedReadPeek(
+    BufferedRead       *bufferedRead,
+    int64              position,
+    int32              *availableLen)
+{
+	int64 largeReadAfterPos;
+
+	Assert(bufferedRead != NULL);
+	Assert(bufferedRead->file >= 0);
+	Assert(availableLen != NULL);
+
+	largeReadAfterPos = bufferedRead->largeReadPosition + 
+						bufferedRead->largeReadLen;
+
+	if (position < bufferedRead->largeReadPosition ||
+		position >= largeReadAfterPos)
+	{
+		*availableLen = 0;
+		return NULL;
+	}
+
+	*availableLen = (int32)(largeReadAfterPos - position);
+	return &bufferedRead->largeReadMemory[position - bufferedRead->largeReadPosition];
+}
+
 /*
  * Return the address of the current read buffer.
  */
@@ -685,6 +814,8 @@ void BufferedReadCompleteFile(
 
 	bufferedRead->largeReadPosition = 0;
 	bufferedRead->largeReadLen = 0;
+
+	bufferedRead->readAheadPosition = 0;
 }
 
 
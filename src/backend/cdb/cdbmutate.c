@@ -1122,6 +1122,39 @@ make_motion(Plan       *lefttree,
 	return node;
 }
 
+/*
+ * motion_hash_datatype
+ *    Returns the type under which a hash Motion hashes values of type
+ *    'typeoid': the operand type of its equality operator, with domains
+ *    reduced to their base type.
+ */
+Oid
+motion_hash_datatype(Oid typeoid)
+{
+    List       *eq = list_make1(makeString("="));
+    Oid         eqopoid;
+    Oid         lefttype;
+    Oid         righttype;
+
+    /* Get oid of the equality operator for this data type. */
+    eqopoid = compatible_oper_opid(eq, typeoid, typeoid, true);
+    if ( eqopoid == InvalidOid )
+        ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
+                        errmsg("no equality operator for typid %d",
+                               typeoid)));
+    list_free_deep(eq);
+
+    /* Get the equality operator's operand type. */
+    op_input_types( eqopoid, &lefttype, &righttype );
+    Assert( lefttype == righttype );
+
+    /* If this type is a domain type, get its base type. */
+    if (get_typtype(lefttype) == 'd')
+        lefttype = getBaseType(lefttype);
+
+    return lefttype;
+}
+
 void add_slice_to_motion(Motion *motion,
 		MotionType motionType, List *hashExpr,
 		int numOutputSegs, int *outputSegIdx)
@@ -1147,34 +1180,14 @@ void add_slice_to_motion(Motion *motion,
 	/* Build list of hash key expression data types. */
     if (hashExpr)
     {
-        List       *eq = list_make1(makeString("="));
         ListCell   *cell;
         foreach(cell, hashExpr)
         {
             Node   *expr = (Node *)lfirst(cell);
-            Oid     typeoid = exprType(expr);
-            Oid	    eqopoid;
-            Oid     lefttype;
-            Oid     righttype;
-
-            /* Get oid of the equality operator for this data type. */
-            eqopoid = compatible_oper_opid(eq, typeoid, typeoid, true);
-            if ( eqopoid == InvalidOid )
-                ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
-                                errmsg("no equality operator for typid %d",
-                                       typeoid)));
-
-            /* Get the equality operator's operand type. */
-            op_input_types( eqopoid, &lefttype, &righttype );
-            Assert( lefttype == righttype );
-
-			/* If this type is a domain type, get its base type. */
-			if (get_typtype(lefttype) == 'd')
-				lefttype = getBaseType(lefttype);
-
-            motion->hashDataTypes = lappend_oid(motion->hashDataTypes, lefttype);
+
+            motion->hashDataTypes = lappend_oid(motion->hashDataTypes,
+                                                motion_hash_datatype(exprType(expr)));
         }
-        list_free_deep(eq);
     }
 
 
@@ -10,6 +10,7 @@
 
 #include "catalog/pg_operator.h"
 #include "catalog/pg_proc.h"    /* CDB_PROC_TIDTOI8 */
+#include "catalog/pg_statistic.h"   /* STATISTIC_KIND_MCV */
 #include "catalog/pg_type.h"    /* INT8OID */
 #include "miscadmin.h"          /* work_mem */
 #include "nodes/makefuncs.h"    /* makeFuncExpr() */
@@ -21,10 +22,14 @@
 
 #include "parser/parse_expr.h"	/* exprType() */
 #include "parser/parse_oper.h"
+#include "utils/lsyscache.h"    /* get_attstatsslot() */
+#include "utils/selfuncs.h"     /* examine_variable() */
+#include "utils/syscache.h"
 
 #include "cdb/cdbdef.h"         /* CdbSwap() */
 #include "cdb/cdbllize.h"       /* makeFlow() */
 #include "cdb/cdbhash.h"        /* isGreenplumDbHashable() */
+#include "cdb/cdbmutate.h"      /* motion_hash_datatype() */
 
 #include "cdb/cdbpath.h"        /* me */
 #include "cdb/cdbvars.h"
@@ -1066,6 +1071,169 @@ fail:                           /* can't do this join */
 }                               /* cdbpath_motion_for_join */
 
 
+/*
+ * cdbpath_hot_key_hashes
+ *
+ * Returns an integer List of the cdbhash values of the hot keys of a
+ * path being redistributed on a single column, taken from the column's
+ * most common values (and its null fraction) in pg_statistic.  Returns
+ * NIL if the key isn't a plain column or has no usable statistics.
+ */
+static List *
+cdbpath_hot_key_hashes(PlannerInfo *root, CdbMotionPath *motionpath)
+{
+    PathKey            *pathkey;
+    ListCell           *cell;
+    Node               *keyexpr = NULL;
+    VariableStatData    vardata;
+    List               *hotHashes = NIL;
+    CdbHash            *h;
+    Oid                 hashtype;
+    double              threshold;
+
+    if (list_length(motionpath->path.locus.partkey_h) != 1)
+        return NIL;
+
+    /* Find the member of the key's equivalence class computed by this rel. */
+    pathkey = (PathKey *) linitial(motionpath->path.locus.partkey_h);
+    foreach(cell, pathkey->pk_eclass->ec_members)
+    {
+        EquivalenceMember  *em = (EquivalenceMember *) lfirst(cell);
+        Node               *expr = (Node *) em->em_expr;
+
+        while (IsA(expr, RelabelType))
+            expr = (Node *) ((RelabelType *) expr)->arg;
+
+        if (IsA(expr, Var) &&
+            bms_is_subset(em->em_relids, motionpath->path.parent->relids))
+        {
+            keyexpr = (Node *) em->em_expr;
+            break;
+        }
+    }
+    if (!keyexpr)
+        return NIL;
+
+    hashtype = motion_hash_datatype(exprType(keyexpr));
+    if (!isGreenplumDbHashable(hashtype))
+        return NIL;
+
+    /* A key is hot once it alone would fill gp_skew_hotkey_factor segments. */
+    threshold = gp_skew_hotkey_factor / root->config->cdbpath_segments;
+
+    examine_variable(root, keyexpr, 0, &vardata);
+    if (!HeapTupleIsValid(vardata.statsTuple))
+    {
+        ReleaseVariableStats(vardata);
+        return NIL;
+    }
+
+    h = makeCdbHash(1);
+
+    if (((Form_pg_statistic) GETSTRUCT(vardata.statsTuple))->stanullfrac >= threshold)
+    {
+        cdbhashinit(h);
+        cdbhashnull(h);
+        hotHashes = lappend_int(hotHashes, (int) h->hash);
+    }
+
+    {
+        Datum      *values;
+        int         nvalues;
+        float4     *numbers;
+        int         nnumbers;
+        int         i;
+
+        if (get_attstatsslot(vardata.statsTuple,
+                             vardata.atttype, vardata.atttypmod,
+                             STATISTIC_KIND_MCV, InvalidOid,
+                             &values, &nvalues,
+                             &numbers, &nnumbers))
+        {
+            /* MCVs are stored in decreasing order of frequency. */
+            for (i = 0; i < nvalues && i < nnumbers; i++)
+            {
+                if (numbers[i] < threshold)
+                    break;
+                cdbhashinit(h);
+                cdbhash(h, values[i], hashtype);
+                hotHashes = lappend_int(hotHashes, (int) h->hash);
+            }
+            free_attstatsslot(vardata.atttype, values, nvalues,
+                              numbers, nnumbers);
+        }
+    }
+
+    pfree(h);
+    ReleaseVariableStats(vardata);
+    return hotHashes;
+}                               /* cdbpath_hot_key_hashes */
+
+
+/*
+ * cdbpath_skew_spread_join
+ *
+ * Called for a hash join after cdbpath_motion_for_join() has decided to
+ * redistribute both inputs on the equijoin key.  If the outer (probe)
+ * side has hot keys, marks its motion to spread rows with those keys
+ * round robin over all segments, and the inner (build) side's motion to
+ * broadcast rows with those keys, so every outer row still meets all of
+ * its matching inner rows exactly once.
+ *
+ * That is only correct when inner rows are not preserved by the join and
+ * outer rows are not duplicated, so RIGHT and FULL joins are excluded.
+ *
+ * Returns true if the motions were marked.  The join result then is no
+ * longer collocated on the join key; the caller must give it a strewn
+ * locus.
+ */
+bool
+cdbpath_skew_spread_join(PlannerInfo   *root,
+                         JoinType       jointype,
+                         Path          *outer_path,
+                         Path          *inner_path)
+{
+    CdbMotionPath  *outer;
+    CdbMotionPath  *inner;
+    List           *hotHashes;
+
+    if (!gp_enable_skew_spreading)
+        return false;
+
+    switch (jointype)
+    {
+        case JOIN_INNER:
+        case JOIN_LEFT:
+        case JOIN_IN:
+        case JOIN_LASJ:
+            break;
+        default:
+            return false;
+    }
+
+    if (!IsA(outer_path, CdbMotionPath) ||
+        !IsA(inner_path, CdbMotionPath) ||
+        !CdbPathLocus_IsHashed(outer_path->locus) ||
+        !CdbPathLocus_IsHashed(inner_path->locus) ||
+        CdbPathLocus_Degree(outer_path->locus) != 1 ||
+        CdbPathLocus_Degree(inner_path->locus) != 1)
+        return false;
+
+    outer = (CdbMotionPath *) outer_path;
+    inner = (CdbMotionPath *) inner_path;
+
+    hotHashes = cdbpath_hot_key_hashes(root, outer);
+    if (!hotHashes)
+        return false;
+
+    outer->skewType = MOTIONSKEW_SPREAD;
+    outer->hotHashes = hotHashes;
+    inner->skewType = MOTIONSKEW_BROADCAST;
+    inner->hotHashes = hotHashes;
+    return true;
+}                               /* cdbpath_skew_spread_join */
+
+
 /*
  * cdbpath_dedup_fixup
  *      Modify path to support unique rowid operation for subquery preds.
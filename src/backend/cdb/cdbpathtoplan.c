@@ -191,6 +191,10 @@ cdbpathtoplan_create_motion_plan(PlannerInfo   *root,
         motion = make_hashed_motion(subplan,
                                     hashExpr,
                                     false /* useExecutorVarFormat */);
+
+        /* Hot key routing decided by cdbpath_skew_spread_join() */
+        motion->skewType = path->skewType;
+        motion->hotHashes = path->hotHashes;
     }
     else
         Insist(0);
@@ -79,6 +79,8 @@ int			gp_connections_per_thread; /* How many libpq connections are
 
 int			gp_cached_gang_threshold; /*How many gangs to keep around from stmt to stmt.*/
 
+int			gp_prewarm_gang_count;	/* How many reader gangs to create ahead of need */
+
 int			Gp_segment = UNDEF_SEGMENT;		/* What content this QE is
 												 * handling. */
 
@@ -252,9 +254,24 @@ int			gp_hashjoin_metadata_memory_percent = 20;
 int 		gp_hashagg_spillbatch_min = 0;
 int 		gp_hashagg_spillbatch_max = 0;
 
+/* streamed bottom hashagg passes rows through above this groups/rows ratio */
+double		gp_hashagg_passthrough_ratio = 0.9;
+
 /* hash join to use bloom filter: default to 0, means not used */
 int 	 	gp_hashjoin_bloomfilter = 0;
 
+/* hash join to push filters of its inner keys down to outer scans */
+bool		gp_hashjoin_runtime_filter = true;
+
+/* LIMIT sort to push a filter of the cut-off sort key down to its input scan */
+bool		gp_sort_limit_filter = true;
+
+/* hash join to lay out large in-memory hash tables in bucket order */
+bool		gp_hashjoin_cluster_tuples = true;
+
+/* hash join to build the table of a spilled batch from its smaller side */
+bool		gp_hashjoin_reverse_batches = true;
+
 /* Analyzing aid */
 int 		gp_motion_slice_noop = 0;
 #ifdef ENABLE_LTRACE
@@ -301,6 +318,9 @@ bool		gp_disable_tuple_hints = false;
 int		gp_hashagg_compress_spill_files = 0;
 
 int gp_workfile_compress_algorithm = 0;
+/* Per operator overrides of gp_workfile_compress_algorithm; -1 if not set */
+int gp_workfile_compress_hashjoin = -1;
+int gp_workfile_compress_hashagg = -1;
 bool gp_workfile_checksumming = false;
 int gp_workfile_caching_loglevel = DEBUG1;
 int gp_sessionstate_loglevel = DEBUG1;
@@ -312,6 +332,8 @@ double gp_workfile_limit_per_query = 0;
 int gp_workfile_limit_files_per_query = 0;
 bool gp_workfile_faultinject = false;
 int gp_workfile_bytes_to_checksum = 16;
+/* Shared memory for cross-slice shared Materialize results, in kilobytes */
+int gp_shareinput_shmem_size = 0;
 
 /* The type of work files that HashJoin should use */
 int gp_workfile_type_hashjoin = 0;
@@ -327,6 +349,9 @@ bool		gp_enable_fast_sri=true;
 /* Enable single-mirror pair dispatch. */
 bool		gp_enable_direct_dispatch=true;
 
+/* Send each slice only the part of the plan it executes. */
+bool		gp_enable_slice_plan_dispatch=false;
+
 /* Disable logging while creating mapreduce objects */
 bool        gp_mapreduce_define=false;
 
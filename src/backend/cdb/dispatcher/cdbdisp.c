@@ -365,6 +365,19 @@ cdbdisp_makeDispatcherState(CdbDispatcherState *ds,
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * Replace the message that subsequent cdbdisp_dispatchToGang() calls send.
+ */
+void
+cdbdisp_setQueryText(CdbDispatcherState *ds,
+					 char *queryText,
+					 int queryTextLen)
+{
+	Assert(ds != NULL && ds->dispatchParams != NULL);
+
+	(pDispatchFuncs->setQueryText)(ds, queryText, queryTextLen);
+}
+
 /*
  * Free memory in CdbDispatcherState
  *
@@ -80,13 +80,19 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 static bool
 cdbdisp_checkForCancel_async(struct CdbDispatcherState *ds);
 
+static void
+cdbdisp_setQueryText_async(struct CdbDispatcherState *ds,
+						   char *queryText,
+						   int queryTextLen);
+
 DispatcherInternalFuncs DispatcherAsyncFuncs =
 {
 	NULL,
 	cdbdisp_checkForCancel_async,
 	cdbdisp_makeDispatchParams_async,
 	cdbdisp_checkDispatchResult_async,
-	cdbdisp_dispatchToGang_async
+	cdbdisp_dispatchToGang_async,
+	cdbdisp_setQueryText_async
 };
 
 
@@ -188,6 +194,22 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 	}
 }
 
+/*
+ * Use a different query text for the gangs dispatched to from now on.
+ * dispatchCommand() sends the text right away, so there is nothing else
+ * to update.
+ */
+static void
+cdbdisp_setQueryText_async(struct CdbDispatcherState *ds,
+						   char *queryText,
+						   int queryTextLen)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync*)ds->dispatchParams;
+
+	pParms->query_text = queryText;
+	pParms->query_text_len = queryTextLen;
+}
+
 /*
  * Check dispatch result.
  *
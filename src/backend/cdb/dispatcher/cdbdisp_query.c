@@ -17,6 +17,7 @@
 #include "cdb/cdbvars.h"
 #include "cdb/cdbmutate.h"
 #include "cdb/cdbsrlz.h"
+#include "optimizer/walkers.h"
 #include "tcop/tcopprot.h"
 #include "utils/datum.h"
 #include "utils/guc.h"
@@ -31,6 +32,7 @@
 #include "cdb/cdbdispatchresult.h"
 
 extern bool Test_print_direct_dispatch_info;
+extern bool Test_print_slice_plan_dispatch_info;
 
 /*
  * We need an array describing the relationship between a slice and
@@ -80,8 +82,26 @@ typedef struct DispatchCommandQueryParms
 	/* the map from sliceIndex to gang_id, in array form */
 	int numSlices;
 	int *sliceIndexGangIdMap;
+
+	/*
+	 * The plan that serializedPlantree was made from, for building per-slice
+	 * plans (gp_enable_slice_plan_dispatch).  Not sent itself.
+	 */
+	PlannedStmt *plannedstmt;
 } DispatchCommandQueryParms;
 
+/*
+ * Context for slicePlanPruneWalker
+ */
+typedef struct SlicePlanPruneContext
+{
+	plan_tree_base_prefix base; /* Required prefix for plan_tree_walker/mutator */
+	SliceTable *sliceTable;
+	int sliceIndex;
+	List *motions;				/* Motions whose subtree has been cut off ... */
+	List *subtrees;				/* ... and the subtrees, to put them back */
+} SlicePlanPruneContext;
+
 static void
 cdbdisp_dispatchCommandInternal(const char *strCommand,
 											char *serializedQuerytree,
@@ -125,6 +145,14 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 static int *
 buildSliceIndexGangIdMap(SliceVec *sliceVec, int numSlices, int numTotalSlices);
 
+static char *
+buildSliceQueryString(struct CdbDispatcherState *ds,
+					  DispatchCommandQueryParms *pQueryParms,
+					  SliceTable *sliceTbl,
+					  int sliceIndex,
+					  int *finalLen,
+					  bool *pruned);
+
 /*
  * Compose and dispatch the MPPEXEC commands corresponding to a plan tree
  * within a complete parallel plan. (A plan tree will correspond either
@@ -661,6 +689,7 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
 	pQueryParms->serializedQueryDispatchDesclen = sddesc_len;
 	pQueryParms->rootIdx = rootIdx;
+	pQueryParms->plannedstmt = queryDesc->plannedstmt;
 
 	/*
 	 * sequence server info
@@ -1166,6 +1195,9 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 	int rootIdx = pQueryParms->rootIdx;
 	char *queryText = NULL;
 	int queryTextLength = 0;
+	bool slicePlans;
+	int nDispatched = 0;
+	int nPruned = 0;
 
 	if (log_dispatch_stats)
 		ResetUsage();
@@ -1200,6 +1232,14 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 	if (nSlices > cdb_max_slices)
 		cdb_max_slices = nSlices;
 
+	/*
+	 * With a single slice to dispatch, the whole plan is what it needs
+	 * anyway (apart from an unallocated root running on the QD).
+	 */
+	slicePlans = gp_enable_slice_plan_dispatch &&
+		pQueryParms->plannedstmt != NULL &&
+		nSlices > 1;
+
 	if (DEBUG1 >= log_min_messages)
 	{
 		char msec_str[32];
@@ -1285,11 +1325,29 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 		if (primaryGang->type == GANGTYPE_PRIMARY_WRITER)
 			ds->primaryResults->writer_gang = primaryGang;
 
+		if (slicePlans)
+		{
+			char *sliceText;
+			int sliceTextLength;
+			bool pruned;
+
+			sliceText = buildSliceQueryString(ds, pQueryParms, sliceTbl, si,
+											  &sliceTextLength, &pruned);
+			cdbdisp_setQueryText(ds, sliceText, sliceTextLength);
+			if (pruned)
+				nPruned++;
+		}
+
 		cdbdisp_dispatchToGang(ds, primaryGang, si, &direct);
+		nDispatched++;
 	}
 
 	pfree(sliceVector);
 
+	if (slicePlans && Test_print_slice_plan_dispatch_info)
+		elog(INFO, "Dispatched a pruned plan to %d of %d slices",
+			 nPruned, nDispatched);
+
 	/*
 	 * If bailed before completely dispatched, stop QEs and throw error.
 	 */
@@ -1459,3 +1517,126 @@ buildSliceIndexGangIdMap(SliceVec *sliceVec, int numSlices, int numTotalSlices)
 
 	return sliceIndexGangIdMap;
 }
+
+/*
+ * Is slice sliceIndex the slice ancestorIndex, or below it in the slice tree?
+ */
+static bool
+sliceIsAtOrBelow(SliceTable *sliceTbl, int sliceIndex, int ancestorIndex)
+{
+	while (sliceIndex >= 0)
+	{
+		Slice *slice;
+
+		if (sliceIndex == ancestorIndex)
+			return true;
+
+		slice = (Slice *) list_nth(sliceTbl->slices, sliceIndex);
+		sliceIndex = slice->parentIndex;
+	}
+	return false;
+}
+
+/*
+ * Cut off the subtree beneath every Motion node that the slice being
+ * dispatched neither is, nor lies beneath.  The QEs of the slice reach such
+ * a Motion only as a receiver, or not at all, and never look at what is
+ * below it.
+ */
+static bool
+slicePlanPruneWalker(Node *node, SlicePlanPruneContext *cxt)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Motion))
+	{
+		Motion *motion = (Motion *) node;
+
+		if (motion->plan.lefttree != NULL &&
+			!sliceIsAtOrBelow(cxt->sliceTable, cxt->sliceIndex, motion->motionID))
+		{
+			cxt->motions = lappend(cxt->motions, motion);
+			cxt->subtrees = lappend(cxt->subtrees, motion->plan.lefttree);
+			motion->plan.lefttree = NULL;
+		}
+	}
+
+	return plan_tree_walker(node, slicePlanPruneWalker, cxt);
+}
+
+/*
+ * Build the dispatch message for one slice, carrying only the part of the
+ * plan that the slice executes: the nodes above its sending Motion, its
+ * own subtree, and the receiving Motions at its fringe without their
+ * children.  Everything else in the message is the same as for the whole
+ * plan.
+ *
+ * The plan is pruned in place and put back together before returning, so
+ * the QD's copy is unchanged even if serialization fails.
+ */
+static char *
+buildSliceQueryString(struct CdbDispatcherState *ds,
+					  DispatchCommandQueryParms *pQueryParms,
+					  SliceTable *sliceTbl,
+					  int sliceIndex,
+					  int *finalLen,
+					  bool *pruned)
+{
+	SlicePlanPruneContext cxt;
+	char *splan = NULL;
+	int splan_len = 0;
+	char *fullPlan = pQueryParms->serializedPlantree;
+	int fullPlanLen = pQueryParms->serializedPlantreelen;
+	char *result;
+
+	cxt.base.node = (Node *) pQueryParms->plannedstmt;
+	cxt.sliceTable = sliceTbl;
+	cxt.sliceIndex = sliceIndex;
+	cxt.motions = NIL;
+	cxt.subtrees = NIL;
+
+	PG_TRY();
+	{
+		slicePlanPruneWalker((Node *) pQueryParms->plannedstmt->planTree, &cxt);
+
+		if (cxt.motions != NIL)
+			splan = serializeNode((Node *) pQueryParms->plannedstmt, &splan_len, NULL);
+	}
+	PG_CATCH();
+	{
+		ListCell *lcm;
+		ListCell *lcs;
+
+		forboth(lcm, cxt.motions, lcs, cxt.subtrees)
+			((Motion *) lfirst(lcm))->plan.lefttree = (Plan *) lfirst(lcs);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	{
+		ListCell *lcm;
+		ListCell *lcs;
+
+		forboth(lcm, cxt.motions, lcs, cxt.subtrees)
+			((Motion *) lfirst(lcm))->plan.lefttree = (Plan *) lfirst(lcs);
+	}
+
+	*pruned = (splan != NULL);
+
+	/* Nothing to cut off; this slice gets the whole plan. */
+	if (splan == NULL)
+		return buildGpQueryString(ds, pQueryParms, finalLen);
+
+	pQueryParms->serializedPlantree = splan;
+	pQueryParms->serializedPlantreelen = splan_len;
+	result = buildGpQueryString(ds, pQueryParms, finalLen);
+	pQueryParms->serializedPlantree = fullPlan;
+	pQueryParms->serializedPlantreelen = fullPlanLen;
+
+	pfree(splan);
+	list_free(cxt.motions);
+	list_free(cxt.subtrees);
+
+	return result;
+}
@@ -153,13 +153,19 @@ cdbdisp_dispatchToGang_internal(struct CdbDispatcherState *ds,
 								int sliceIndex,
 								CdbDispatchDirectDesc * dispDirect);
 
+static void
+cdbdisp_setQueryText_internal(struct CdbDispatcherState *ds,
+							  char *queryText,
+							  int queryTextLen);
+
 DispatcherInternalFuncs DispatcherSyncFuncs =
 {
     cdbdisp_waitThreads,
 	cdbdisp_shouldCancel,
 	cdbdisp_makeDispatchThreads,
 	CdbCheckDispatchResult_internal,
-	cdbdisp_dispatchToGang_internal
+	cdbdisp_dispatchToGang_internal,
+	cdbdisp_setQueryText_internal
 };
 
 /*
@@ -296,6 +302,27 @@ cdbdisp_dispatchToGang_internal(struct CdbDispatcherState *ds,
 	ELOG_DISPATCHER_DEBUG("dispatchToGang: Total threads now %d", pThreads->threadCount);
 }
 
+/*
+ * Use a different query text for the gangs dispatched to from now on.
+ * Threads that have been started already keep the text they were given.
+ */
+static void
+cdbdisp_setQueryText_internal(struct CdbDispatcherState *ds,
+							  char *queryText,
+							  int queryTextLen)
+{
+	CdbDispatchCmdThreads *pThreads = (CdbDispatchCmdThreads*)ds->dispatchParams;
+	int	i;
+
+	for (i = pThreads->threadCount; i < pThreads->dispatchCommandParmsArSize; i++)
+	{
+		DispatchCommandParms *pParms = &pThreads->dispatchCommandParmsAr[i];
+
+		pParms->query_text = queryText;
+		pParms->query_text_len = queryTextLen;
+	}
+}
+
 void
 CdbCheckDispatchResult_internal(struct CdbDispatcherState *ds,
 								DispatchWaitMode waitMode)
@@ -265,6 +265,71 @@ allocateWriterGang()
 	return writerGang;
 }
 
+/*
+ * Make sure that at least nreaders primary reader gangs are available, so
+ * that the following allocateReaderGang() calls for them don't have to
+ * connect to the segments one gang after another.
+ *
+ * gp_prewarm_segworkers raises the number to keep available: gangs beyond
+ * what this statement needs are created in the same round and parked on the
+ * available list for later statements of the session.  It is capped at
+ * gp_cached_segworkers_threshold, since cleanupPortalGangs() would destroy
+ * the extra gangs again at the end of the statement.
+ *
+ * With asynchronous gang creation (gp_connections_per_thread = 0) all the
+ * missing gangs are connected in parallel; if that fails, allocateReaderGang()
+ * creates the gangs as it always has.  With threaded gang creation the
+ * missing gangs are created one after another here.
+ */
+void
+prepareReaderGangs(int nreaders)
+{
+	MemoryContext oldContext;
+	List	   *gangs;
+	int			nwanted;
+	int			missing;
+
+	if (Gp_role != GP_ROLE_DISPATCH)
+		return;
+
+	/* Top up to the prewarm count on every statement that assigns gangs. */
+	nwanted = Max(nreaders, Min(gp_prewarm_gang_count, gp_cached_gang_threshold));
+
+	missing = nwanted - list_length(availableReaderGangsN);
+	if (missing <= 0)
+		return;
+
+	ELOG_DISPATCHER_DEBUG("prepareReaderGangs: creating %d reader N-gangs, %d available",
+			missing, list_length(availableReaderGangsN));
+
+	insist_log(IsTransactionOrTransactionBlock(),
+			"cannot allocate segworker group outside of transaction");
+
+	Assert(GangContext != NULL);
+	oldContext = MemoryContextSwitchTo(GangContext);
+
+	if (pCreateGangFunc == pCreateGangFuncAsync)
+	{
+		gangs = createReaderGangs_async(gang_id_counter, missing);
+		if (gangs != NIL)
+			gang_id_counter += missing;
+	}
+	else
+	{
+		int			i;
+
+		gangs = NIL;
+		for (i = 0; i < missing; i++)
+			gangs = lappend(gangs, createGang(GANGTYPE_PRIMARY_READER,
+											  gang_id_counter++,
+											  getgpsegmentCount(), 0));
+	}
+
+	availableReaderGangsN = list_concat(availableReaderGangsN, gangs);
+
+	MemoryContextSwitchTo(oldContext);
+}
+
 /*
  * Creates a new gang by logging on a session to each segDB involved.
  *
@@ -23,6 +23,7 @@
 #include "tcop/tcopprot.h"
 #include "cdb/cdbfts.h"
 #include "cdb/cdbgang.h"
+#include "cdb/cdbgang_async.h"
 #include "cdb/cdbvars.h"
 #include "miscadmin.h"
 #include "utils/gp_atomic.h"
@@ -289,6 +290,197 @@ exit:
 	return NULL;
 }
 
+/*
+ * Creates ngangs primary reader gangs at once, with ids first_gang_id,
+ * first_gang_id + 1, ...  The connection attempts for all of them are
+ * started before any is waited for, so the gangs come up in about the time
+ * it takes to create one.
+ *
+ * This is an optimization only.  If any connection fails, all the gangs are
+ * destroyed and NIL is returned; the caller then creates gangs one at a time
+ * through createGang_async(), which knows how to retry and how to react to
+ * segment failures.  Errors other than connection failures are re-thrown.
+ *
+ * call this function in GangContext memory context.
+ */
+List *
+createReaderGangs_async(int first_gang_id, int ngangs)
+{
+	List	   *volatile gangs = NIL;
+	int			size = getgpsegmentCount();
+	int			total = size * ngangs;
+	volatile int successful_connections = 0;
+	ListCell   *lc;
+
+	ELOG_DISPATCHER_DEBUG("createReaderGangs_async first_gang_id = %d, ngangs = %d",
+			first_gang_id, ngangs);
+
+	Assert(ngangs > 0);
+	Assert(CurrentResourceOwner != NULL);
+	Assert(CurrentMemoryContext == GangContext);
+
+	if (!isPrimaryWriterGangAlive())
+		return NIL;
+
+	PG_TRY();
+	{
+		SegmentDatabaseDescriptor **segdbs;
+		struct pollfd *fds;
+		struct timeval startTS;
+		char	   *options;
+		int			g;
+		int			i;
+
+		options = makeOptions();
+		segdbs = (SegmentDatabaseDescriptor **)
+			palloc(total * sizeof(SegmentDatabaseDescriptor *));
+		fds = (struct pollfd *) palloc0(total * sizeof(struct pollfd));
+
+		/* Launch the connection attempts of all the gangs. */
+		for (g = 0; g < ngangs; g++)
+		{
+			Gang	   *gp;
+
+			gp = buildGangDefinition(GANGTYPE_PRIMARY_READER,
+									 first_gang_id + g, size, 0);
+			gangs = lappend(gangs, gp);
+
+			MemoryContextSwitchTo(gp->perGangContext);
+			for (i = 0; i < size; i++)
+			{
+				SegmentDatabaseDescriptor *segdbDesc = &gp->db_descriptors[i];
+				char		gpqeid[100];
+
+				segdbs[g * size + i] = segdbDesc;
+
+				build_gpqeid_param(gpqeid, sizeof(gpqeid),
+								   segdbDesc->segindex, false,
+								   gp->gang_id);
+
+				cdbconn_doConnectStart(segdbDesc, gpqeid, options);
+				if (cdbconn_isBadConnection(segdbDesc))
+				{
+					ereport(LOG, (errcode(ERRCODE_GP_INTERNAL_ERROR),
+								  errmsg("Master unable to connect to %s with options %s: %s",
+										 segdbDesc->whoami,
+										 options,
+										 PQerrorMessage(segdbDesc->conn))));
+					ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+									errmsg("failed to acquire resources on one or more segments")));
+				}
+			}
+			MemoryContextSwitchTo(GangContext);
+		}
+
+		/* Poll all of them until they are complete or we reach timeout. */
+		gettimeofday(&startTS, NULL);
+
+		for (;;)
+		{
+			int			nready;
+			int			timeout;
+			int			nfds = 0;
+
+			for (i = 0; i < total; i++)
+			{
+				SegmentDatabaseDescriptor *segdbDesc = segdbs[i];
+				PostgresPollingStatusType pollStatus;
+
+				if (cdbconn_isConnectionOk(segdbDesc))
+					continue;
+
+				pollStatus = PQconnectPoll(segdbDesc->conn);
+				switch (pollStatus)
+				{
+					case PGRES_POLLING_OK:
+						cdbconn_doConnectComplete(segdbDesc);
+						successful_connections++;
+						break;
+
+					case PGRES_POLLING_READING:
+						fds[nfds].fd = PQsocket(segdbDesc->conn);
+						fds[nfds].events = POLLIN;
+						nfds++;
+						break;
+
+					case PGRES_POLLING_WRITING:
+						fds[nfds].fd = PQsocket(segdbDesc->conn);
+						fds[nfds].events = POLLOUT;
+						nfds++;
+						break;
+
+					default:
+						elog(LOG, "Failed to connect to %s", segdbDesc->whoami);
+						ereport(ERROR,
+								(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+								 errmsg("failed to acquire resources on one or more segments")));
+						break;
+				}
+			}
+
+			if (nfds == 0)
+				break;
+
+			timeout = getTimeout(&startTS);
+
+			nready = poll(fds, nfds, timeout);
+
+			if (nready < 0)
+			{
+				int	sock_errno = SOCK_ERRNO;
+				if (sock_errno == EINTR)
+					continue;
+
+				ereport(LOG, (errcode_for_socket_access(),
+							  errmsg("poll() failed while connecting to segments")));
+				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+								errmsg("failed to acquire resources on one or more segments")));
+			}
+			else if (nready == 0)
+			{
+				if (timeout != 0)
+					continue;
+
+				elog(LOG, "poll() timeout while connecting to segments");
+				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+								errmsg("failed to acquire resources on one or more segments")));
+			}
+		}
+
+		if (successful_connections != total)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments")));
+
+		pfree(fds);
+		pfree(segdbs);
+	}
+	PG_CATCH();
+	{
+		ErrorData  *edata;
+
+		MemoryContextSwitchTo(GangContext);
+
+		foreach(lc, gangs)
+			disconnectAndDestroyGang((Gang *) lfirst(lc));
+		list_free(gangs);
+
+		edata = CopyErrorData();
+		if (edata->sqlerrcode != ERRCODE_GP_INTERCONNECTION_ERROR)
+			PG_RE_THROW();
+		FreeErrorData(edata);
+		FlushErrorState();
+
+		ELOG_DISPATCHER_DEBUG("createReaderGangs_async: %d of %d connections succeeded, "
+				"falling back to creating gangs one at a time",
+				successful_connections, total);
+		return NIL;
+	}
+	PG_END_TRY();
+
+	setLargestGangsize(size);
+	return gangs;
+}
+
 static int getTimeout(const struct timeval* startTS)
 {
 	struct timeval now;
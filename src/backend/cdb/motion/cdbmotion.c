@@ -627,6 +627,49 @@ RecvTupleFrom(MotionLayerState *mlStates,
 	return recvRC;
 }
 
+/*
+ * Receive up to maxTuples tuples from one sender of an order-preserving
+ * motion node.  The first tuple is received with RecvTupleFrom(), so this
+ * blocks until at least one tuple or the end of the stream has arrived.
+ * After that we only drain tuples that the chunk sorter has already
+ * reassembled for this sender; no further network I/O is done, so a sender
+ * that is slow to produce cannot hold up the merge.
+ *
+ * Returns the number of tuples stored into tuples[]; 0 means end of stream.
+ */
+int
+RecvTupleBatchFrom(MotionLayerState *mlStates,
+				   ChunkTransportState *transportStates,
+				   int16 motNodeID,
+				   HeapTuple *tuples,
+				   int maxTuples,
+				   int16 srcRoute)
+{
+	MotionNodeEntry *pMNEntry;
+	ChunkSorterEntry *pCSEntry;
+	int			ntuples;
+
+	AssertArg(srcRoute != ANY_ROUTE);
+	AssertArg(maxTuples > 0);
+
+	if (RecvTupleFrom(mlStates, transportStates, motNodeID,
+					  &tuples[0], srcRoute) != GOT_TUPLE)
+		return 0;
+
+	pMNEntry = getMotionNodeEntry(mlStates, motNodeID, "RecvTupleBatchFrom");
+	pCSEntry = getChunkSorterEntry(mlStates, pMNEntry, srcRoute);
+
+	for (ntuples = 1; ntuples < maxTuples; ntuples++)
+	{
+		tuples[ntuples] = htfifo_gettuple(pCSEntry->ready_tuples);
+		if (tuples[ntuples] == NULL)
+			break;
+		statRecvTuple(pMNEntry, pCSEntry, GOT_TUPLE);
+	}
+
+	return ntuples;
+}
+
 
 /*
  * This helper function is the receive-tuple workhorse.  It pulls
@@ -84,6 +84,113 @@ test__BufferedReadUseBeforeBuffer__IsNextReadLenZero(void **state)
 	PG_END_TRY();	
 }
 
+void
+test__BufferedReadPrefetch__AdvisesAheadOfLargeRead(void **state)
+{
+	BufferedRead *bufferedRead = palloc(sizeof(BufferedRead));
+	int32 memoryLen = 512; /* maxBufferLen + largeReadLen */
+	uint8 *memory = malloc(memoryLen);
+	char *relname = "test";
+	int32 maxBufferLen = 128;
+	int32 maxLargeReadLen = 128;
+
+	memset(bufferedRead, 0 , sizeof(BufferedRead));
+	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, relname);
+
+	bufferedRead->file = 1;
+	bufferedRead->fileLen = 1000;
+	bufferedRead->largeReadPosition = 0;
+	bufferedRead->largeReadLen = 128;
+
+	/*
+	 * Read-ahead is off by default; FilePrefetch must not be called.
+	 */
+	BufferedReadPrefetch(bufferedRead);
+	assert_int_equal(bufferedRead->readAheadPosition, 0);
+
+	BufferedReadSetReadAhead(bufferedRead, 256);
+
+	/*
+	 * The whole window after the first large read is requested.
+	 */
+	expect_value(FilePrefetch, file, 1);
+	expect_value(FilePrefetch, offset, 128);
+	expect_value(FilePrefetch, amount, 256);
+	will_return(FilePrefetch, 0);
+	BufferedReadPrefetch(bufferedRead);
+	assert_int_equal(bufferedRead->readAheadPosition, 384);
+
+	/*
+	 * After the next large read, only the part not requested yet.
+	 */
+	bufferedRead->largeReadPosition = 128;
+	expect_value(FilePrefetch, file, 1);
+	expect_value(FilePrefetch, offset, 384);
+	expect_value(FilePrefetch, amount, 128);
+	will_return(FilePrefetch, 0);
+	BufferedReadPrefetch(bufferedRead);
+	assert_int_equal(bufferedRead->readAheadPosition, 512);
+
+	/*
+	 * The window stops at the end of the file, even when the remainder is
+	 * less than a large read.
+	 */
+	bufferedRead->largeReadPosition = 768;
+	expect_value(FilePrefetch, file, 1);
+	expect_value(FilePrefetch, offset, 896);
+	expect_value(FilePrefetch, amount, 104);
+	will_return(FilePrefetch, 0);
+	BufferedReadPrefetch(bufferedRead);
+	assert_int_equal(bufferedRead->readAheadPosition, 1000);
+
+	/*
+	 * Nothing left to request.
+	 */
+	bufferedRead->largeReadPosition = 872;
+	BufferedReadPrefetch(bufferedRead);
+	assert_int_equal(bufferedRead->readAheadPosition, 1000);
+}
+
+void
+test__BufferedReadPeek__OnlyWithinLargeRead(void **state)
+{
+	BufferedRead *bufferedRead = palloc(sizeof(BufferedRead));
+	int32 memoryLen = 512; /* maxBufferLen + largeReadLen */
+	uint8 *memory = malloc(memoryLen);
+	char *relname = "test";
+	int32 maxBufferLen = 128;
+	int32 maxLargeReadLen = 128;
+	int32 availableLen;
+	uint8 *peek;
+
+	memset(bufferedRead, 0 , sizeof(BufferedRead));
+	BufferedReadInit(bufferedRead, memory, memoryLen, maxBufferLen, maxLargeReadLen, relname);
+
+	bufferedRead->file = 1;
+	bufferedRead->fileLen = 1000;
+	bufferedRead->largeReadPosition = 256;
+	bufferedRead->largeReadLen = 100;
+
+	peek = BufferedReadPeek(bufferedRead, 256, &availableLen);
+	assert_true(peek == bufferedRead->largeReadMemory);
+	assert_int_equal(availableLen, 100);
+
+	peek = BufferedReadPeek(bufferedRead, 300, &availableLen);
+	assert_true(peek == &bufferedRead->largeReadMemory[44]);
+	assert_int_equal(availableLen, 56);
+
+	/*
+	 * Neither data already consumed nor data not read yet is looked at.
+	 */
+	peek = BufferedReadPeek(bufferedRead, 255, &availableLen);
+	assert_true(peek == NULL);
+	assert_int_equal(availableLen, 0);
+
+	peek = BufferedReadPeek(bufferedRead, 356, &availableLen);
+	assert_true(peek == NULL);
+	assert_int_equal(availableLen, 0);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -91,7 +198,9 @@ main(int argc, char* argv[])
 
 	const UnitTest tests[] = {
 		unit_test(test__BufferedReadUseBeforeBuffer__IsNextReadLenZero),
-		unit_test(test__BufferedReadInit__IsConsistent)
+		unit_test(test__BufferedReadInit__IsConsistent),
+		unit_test(test__BufferedReadPrefetch__AdvisesAheadOfLargeRead),
+		unit_test(test__BufferedReadPeek__OnlyWithinLargeRead)
 	};
 
 	MemoryContextInit();
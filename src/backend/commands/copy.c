@@ -4249,7 +4249,7 @@ CopyFrom(CopyState cstate)
 					{
 						AOTupleId aoTupleId;
 						
-                        aocs_insert_values(resultRelInfo->ri_aocsInsertDesc, values, nulls, &aoTupleId);
+                        aocs_insert_buffered(resultRelInfo->ri_aocsInsertDesc, values, nulls, &aoTupleId);
 						if (resultRelInfo->ri_NumIndices > 0)
 							ExecInsertIndexTuples(slot, (ItemPointer)&aoTupleId, estate, false);
 					}
@@ -1682,6 +1682,18 @@ explain_outNode(StringInfo str,
 							"Merge Key",
 							str, indent, es);
 
+				if (pMotion->skewType != MOTIONSKEW_NONE)
+				{
+					int			i;
+
+					for (i = 0; i < indent; i++)
+						appendStringInfoString(str, "  ");
+					appendStringInfo(str, "  Hot Keys: %d %s\n",
+									 list_length(pMotion->hotHashes),
+									 pMotion->skewType == MOTIONSKEW_SPREAD ?
+									 "spread" : "broadcast");
+				}
+
                 /* Descending into a new slice. */
                 if (sliceTable)
                     es->currentSlice = (Slice *)list_nth(sliceTable->slices,
@@ -8,6 +8,7 @@
 
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "optimizer/clauses.h"
 #include "cdb/cdbaocsam.h"
 
 static void
@@ -101,6 +102,29 @@ BeginScanAOCSRelation(ScanState *scanState)
 					   appendOnlyMetaDataSnapshot,
 					   NULL /* relationTupleDesc */,
 					   node->opaque->proj);
+	aocs_set_zonemap_qual(node->opaque->scandesc, node->ss.ps.plan->qual);
+
+	/*
+	 * Read the columns of the qualifiers first, and the rest only for the
+	 * rows that pass. ExecScan evaluates the qualifiers once more on those
+	 * rows, so volatile qualifiers (and costly subplans) are left alone.
+	 */
+	if (node->ss.ps.qual != NIL &&
+		!contain_volatile_functions((Node *) node->ss.ps.plan->qual) &&
+		!contain_subplans((Node *) node->ss.ps.plan->qual))
+	{
+		bool *qualProj = palloc0(sizeof(bool) * node->opaque->ncol);
+
+		GetNeededColumnsForScan((Node *) node->ss.ps.plan->qual,
+								qualProj, node->opaque->ncol);
+		aocs_set_late_qual(node->opaque->scandesc, qualProj,
+						   node->ss.ps.qual, node->ss.ps.ps_ExprContext);
+		pfree(qualProj);
+
+		/* Filter on dictionary codes, see aocs_set_dictionary_qual */
+		aocs_set_dictionary_qual(node->opaque->scandesc, node->ss.ps.qual,
+								 node->ss.ps.ps_ExprContext);
+	}
 
 	node->ss.scan_state = SCAN_SCAN;
 }
@@ -116,6 +140,7 @@ EndScanAOCSRelation(ScanState *scanState)
 	Assert(node->opaque != NULL &&
 		   node->opaque->scandesc != NULL);
 
+	ExplainZoneMapScan(scanState, &node->opaque->scandesc->zoneMap);
 	aocs_endscan(node->opaque->scandesc);
         
 	FreeAOCSScanOpaque(scanState);
@@ -9,6 +9,7 @@
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
 #include "cdb/cdbappendonlyam.h"
+#include "lib/stringinfo.h"
 
 TupleTableSlot *
 AppendOnlyScanNext(ScanState *scanState)
@@ -67,6 +68,7 @@ BeginScanAppendOnlyRelation(ScanState *scanState)
 			node->ss.ps.state->es_snapshot, 
 			appendOnlyMetaDataSnapshot,
 			0, NULL);
+	appendonly_set_zonemap_qual(node->aos_ScanDesc, node->ss.ps.plan->qual);
 	node->ss.scan_state = SCAN_SCAN;
 }
 
@@ -79,6 +81,7 @@ EndScanAppendOnlyRelation(ScanState *scanState)
 	Assert(node->aos_ScanDesc != NULL);
 
 	Assert((node->ss.scan_state & SCAN_SCAN) != 0);
+	ExplainZoneMapScan(scanState, &node->aos_ScanDesc->zoneMap);
 	appendonly_endscan(node->aos_ScanDesc);
 
 	node->aos_ScanDesc = NULL;
@@ -86,6 +89,27 @@ EndScanAppendOnlyRelation(ScanState *scanState)
 	node->ss.scan_state = SCAN_INIT;
 }
 
+/*
+ * For EXPLAIN ANALYZE, note how many blocks the scan skipped by zone maps.
+ */
+void
+ExplainZoneMapScan(ScanState *scanState, AppendOnlyZoneMapScan *zoneMapScan)
+{
+	MemoryContext oldcxt;
+
+	if (scanState->ps.instrument == NULL ||
+		zoneMapScan->blocksSkipped == 0)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(scanState->ps.state->es_query_cxt);
+	if (scanState->ps.cdbexplainbuf == NULL)
+		scanState->ps.cdbexplainbuf = makeStringInfo();
+	appendStringInfo(scanState->ps.cdbexplainbuf,
+					 "Zone maps skipped " INT64_FORMAT " blocks.\n",
+					 zoneMapScan->blocksSkipped);
+	MemoryContextSwitchTo(oldcxt);
+}
+
 void
 ReScanAppendOnlyRelation(ScanState *scanState)
 {
@@ -89,6 +89,21 @@ typedef enum InputRecordType
 #define HAVE_FREESPACE(hashtable) \
    (GET_TOTAL_USED_SIZE(hashtable) < (hashtable)->max_mem)
 
+/*
+ * Layout of the open-addressed hash table; see HashAggTable.
+ *
+ * A slot's tag is 0 when the slot is empty.  Otherwise it holds the top 7
+ * bits of the entry's hash value, with the high bit set.  The home group of
+ * a hash value is taken from the top bits of its Fibonacci hash, so that
+ * the low bits shared by all the groups of a reloaded batch do not matter.
+ */
+#define HHA_GROUP_SLOTS			8
+#define HHA_MIN_SLOTS			16
+#define HHA_MAX_FILL_PERCENT	87
+#define HHA_TAG(hashkey)		((uint8) (0x80 | ((hashkey) >> 25)))
+#define HHA_ONES				UINT64CONST(0x0101010101010101)
+#define HHA_HIGHS				UINT64CONST(0x8080808080808080)
+
 /* Methods that handle batch files */
 static SpillSet *createSpillSet(unsigned branching_factor, unsigned parent_hash_bit);
 static int closeSpillFile(AggState *aggstate, SpillSet *spill_set, int file_no);
@@ -108,10 +123,13 @@ static void spill_hash_table(AggState *aggstate);
 static void init_agg_hash_iter(HashAggTable* ht);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
 										   InputRecordType input_type, int32 input_size,
-										   uint32 hashkey, unsigned parent_hash_bit, bool *p_isnew);
+										   uint32 hashkey, bool *p_isnew);
+static bool grow_agg_hash_table(AggState *aggstate);
+static void init_agg_hash_keys(AggState *aggstate);
 static void agg_hash_table_stat_upd(HashAggTable *ht);
 static void reset_agg_hash_table(AggState *aggstate);
 static bool agg_hash_reload(AggState *aggstate);
+static HashAggEntry *agg_hash_passthrough(AggState *aggstate);
 static inline void *mpool_cxt_alloc(void *manager, Size len);
 
 static inline void *mpool_cxt_alloc(void *manager, Size len)
@@ -261,7 +279,6 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	entry->tuple_and_aggs = NULL;
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
-	entry->next = NULL;
 
 	/*
 	 * Copy memtuple into group_buf. Remember to always allocate
@@ -333,7 +350,6 @@ makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
 	entry->tuple_and_aggs = copy_tuple_and_aggs;
-	entry->next = NULL;
 
 	/* Initialize per group data */
 	adjustInputGroup(aggstate, entry->tuple_and_aggs, mt_bind);
@@ -363,6 +379,162 @@ setGroupAggs(HashAggTable *hashtable, MemTupleBinding *mt_bind, HashAggEntry *en
 	}
 }
 
+/*
+ * Load the tags of a group of slots as one word.
+ */
+static inline uint64
+hha_group_tags(HashAggTable *hashtable, unsigned group)
+{
+	uint64		word;
+
+	memcpy(&word, hashtable->tags + group * HHA_GROUP_SLOTS, sizeof(word));
+	return word;
+}
+
+/*
+ * Does some slot of the group (whose tags are in word) hold the given tag?
+ * May say yes when no slot does, never the other way around.
+ */
+static inline bool
+hha_group_may_match(uint64 word, uint8 tag)
+{
+	uint64		x = word ^ (HHA_ONES * tag);
+
+	return ((x - HHA_ONES) & ~x & HHA_HIGHS) != 0;
+}
+
+/*
+ * Does the group (whose tags are in word) have an empty slot?
+ */
+static inline bool
+hha_group_has_empty(uint64 word)
+{
+	return (~word & HHA_HIGHS) != 0;
+}
+
+/*
+ * The first group probed for a hash value.
+ */
+static inline unsigned
+hha_home_group(HashAggTable *hashtable, uint32 hashkey)
+{
+	return ((uint32) (hashkey * 2654435769U) >> hashtable->bucket_shift) /
+		HHA_GROUP_SLOTS;
+}
+
+/*
+ * Find the slot that a new entry with the given hash value goes to: the
+ * first empty slot in probe order.  The table must not be full.
+ */
+static unsigned
+hha_find_empty_slot(HashAggTable *hashtable, uint32 hashkey)
+{
+	unsigned	group_mask = hashtable->nbuckets / HHA_GROUP_SLOTS - 1;
+	unsigned	group = hha_home_group(hashtable, hashkey);
+
+	Assert(hashtable->nused < hashtable->nbuckets);
+
+	for (;;)
+	{
+		if (hha_group_has_empty(hha_group_tags(hashtable, group)))
+		{
+			unsigned	slot = group * HHA_GROUP_SLOTS;
+
+			while (hashtable->tags[slot] != 0)
+				slot++;
+			return slot;
+		}
+		group = (group + 1) & group_mask;
+	}
+}
+
+/*
+ * Bytes used per slot of the hash table.
+ */
+static inline double
+hha_slot_size(HashAggTable *hashtable, int numCols)
+{
+	double		size = sizeof(uint8) + sizeof(HashAggEntry *);
+
+	if (hashtable->keys != NULL)
+		size += numCols * (sizeof(Datum) + sizeof(bool));
+	return size;
+}
+
+/*
+ * Put an entry, whose grouping keys are in keys/keynulls, in the given
+ * empty slot.
+ */
+static inline void
+hha_fill_slot(HashAggTable *hashtable, unsigned slot, HashAggEntry *entry,
+			  Datum *keys, bool *keynulls, int numCols)
+{
+	Assert(hashtable->tags[slot] == 0);
+
+	hashtable->tags[slot] = HHA_TAG(entry->hashvalue);
+	hashtable->buckets[slot] = entry;
+	if (hashtable->keys != NULL)
+	{
+		memcpy(&hashtable->keys[slot * numCols], keys, numCols * sizeof(Datum));
+		memcpy(&hashtable->keynulls[slot * numCols], keynulls, numCols * sizeof(bool));
+	}
+	hashtable->nused++;
+}
+
+/*
+ * Function: agg_hash_keys_match
+ *
+ * Does the entry in the given slot have the grouping keys in
+ * hashtable->input_keys?
+ */
+static inline bool
+agg_hash_keys_match(AggState *aggstate, unsigned slot, uint32 hashkey)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	Agg		   *agg = (Agg *) aggstate->ss.ps.plan;
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	HashAggEntry *entry = NULL;
+	int			i;
+
+	/*
+	 * Without inline keys the entry must be looked at anyway, so compare
+	 * the full hash values first.
+	 */
+	if (hashtable->keys == NULL)
+	{
+		entry = hashtable->buckets[slot];
+		if (entry->hashvalue != hashkey)
+			return false;
+	}
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		Datum		input_datum = hashtable->input_keys[i];
+		bool		input_isNull = hashtable->input_keynulls[i];
+		Datum		entry_datum;
+		bool		entry_isNull;
+
+		if (hashtable->keys != NULL)
+		{
+			entry_datum = hashtable->keys[slot * agg->numCols + i];
+			entry_isNull = hashtable->keynulls[slot * agg->numCols + i];
+		}
+		else
+			entry_datum = memtuple_getattr((MemTuple) entry->tuple_and_aggs, mt_bind,
+										   agg->grpColIdx[i], &entry_isNull);
+
+		if (!input_isNull && !entry_isNull &&
+			DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
+									   input_datum,
+									   entry_datum)))
+			continue;			/* Both non-NULL and equal. */
+		if (!(input_isNull && entry_isNull))
+			return false;		/* NULLs match in group keys. */
+	}
+
+	return true;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -384,85 +556,93 @@ static HashAggEntry *
 lookup_agg_hash_entry(AggState *aggstate,
 					  void *input_record,
 					  InputRecordType input_type, int32 input_size,
-					  uint32 hashkey, unsigned parent_hash_bit, bool *p_isnew)
+					  uint32 hashkey, bool *p_isnew)
 {
-	HashAggEntry *entry;
+	HashAggEntry *entry = NULL;
 	HashAggTable *hashtable = aggstate->hhashtable;
 	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
 	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
-	unsigned int bucket_idx;
-	uint64 bloomval;			/* bloom filter value */
-   
+	unsigned	group_mask = hashtable->nbuckets / HHA_GROUP_SLOTS - 1;
+	unsigned	group;
+	uint8		tag = HHA_TAG(hashkey);
+	int			i;
+
 	Assert(mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
 
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
-	bucket_idx = (hashkey >> parent_hash_bit) % (hashtable->nbuckets);
-	bloomval = ((uint64)1) << ((hashkey >> 23) & 0x3f);
-	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
-			 hashtable->buckets[bucket_idx]);
 
 	/*
-	 * Search entry chain for the bucket. If such an entry found in the
-	 * chain, move it to the front of the chain. Otherwise, if there
-	 * are any space left, create a new entry, and insert it in
-	 * the front of the chain.
+	 * Extract the grouping keys of the input once, rather than for each
+	 * entry they are compared with.
 	 */
-	while (entry != NULL)
+	for (i = 0; i < agg->numCols; i++)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
+		AttrNumber	att = agg->grpColIdx[i];
 
-		if (hashkey != entry->hashvalue)
+		switch(input_type)
 		{
-			entry = entry->next;
-			continue;
+			case INPUT_RECORD_TUPLE:
+				hashtable->input_keys[i] =
+					slot_getattr((TupleTableSlot *)input_record, att,
+								 &hashtable->input_keynulls[i]);
+				break;
+			case INPUT_RECORD_GROUP_AND_AGGS:
+				hashtable->input_keys[i] =
+					memtuple_getattr((MemTuple)input_record, mt_bind, att,
+									 &hashtable->input_keynulls[i]);
+				break;
+			default:
+				insist_log(false, "invalid record type %d", input_type);
 		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
+	}
+
+	/*
+	 * Probe the groups of slots from the home group on, until the entry
+	 * is found or a group with an empty slot ends the search.
+	 */
+	group = hha_home_group(hashtable, hashkey);
+	for (;;)
+	{
+		uint64		word = hha_group_tags(hashtable, group);
+
+		if (hha_group_may_match(word, tag))
 		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
+			unsigned	slot = group * HHA_GROUP_SLOTS;
+
+			for (i = 0; i < HHA_GROUP_SLOTS; i++, slot++)
 			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
+				if (hashtable->tags[slot] == tag &&
+					agg_hash_keys_match(aggstate, slot, hashkey))
+				{
+					entry = hashtable->buckets[slot];
 					break;
-				default:
-					insist_log(false, "invalid record type %d", input_type);
+				}
 			}
-
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
-
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
+			if (entry != NULL)
+				break;
 		}
-		
-		/* Break if found an existing matching entry. */
-		if (match)
-			break;
 
-		entry = entry->next;
+		if (hha_group_has_empty(word))
+			break;
+		group = (group + 1) & group_mask;
 	}
 
 	if (entry == NULL)
 	{
+		/* Make room for one more entry, or give up if memory is short. */
+		if ((double) (hashtable->nused + 1) * 100 >
+			(double) hashtable->nbuckets * HHA_MAX_FILL_PERCENT &&
+			!grow_agg_hash_table(aggstate))
+		{
+			(void) MemoryContextSwitchTo(oldcxt);
+			return NULL;
+		}
+
 		/* Create a new matching entry. */
 		switch(input_type)
 		{
@@ -475,19 +655,19 @@ lookup_agg_hash_entry(AggState *aggstate,
 			default:
 				insist_log(false, "invalid record type %d", input_type);
 		}
-			
+
 		if (entry != NULL)
 		{
-			entry->next = hashtable->buckets[bucket_idx];
-			hashtable->buckets[bucket_idx] = entry;
-			hashtable->bloom[bucket_idx] |= bloomval;
-			
+			hha_fill_slot(hashtable, hha_find_empty_slot(hashtable, hashkey),
+						  entry, hashtable->input_keys, hashtable->input_keynulls,
+						  agg->numCols);
+
 			hashtable->num_ht_groups++;
 
 			*p_isnew = true; /* created a new entry */
 		}
 		/*
-		  else no matching entry, and no room to create one. 
+		  else no matching entry, and no room to create one.
 		*/
 	}
 
@@ -496,6 +676,122 @@ lookup_agg_hash_entry(AggState *aggstate,
 	return entry;
 }
 
+/*
+ * Function: grow_agg_hash_table
+ *
+ * Double the number of slots in the hash table, if memory allows.
+ * Returns false if it does not.
+ */
+static bool
+grow_agg_hash_table(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	int			numCols = ((Agg *) aggstate->ss.ps.plan)->numCols;
+	unsigned	old_nbuckets = hashtable->nbuckets;
+	uint8	   *old_tags = hashtable->tags;
+	HashAggEntry **old_buckets = hashtable->buckets;
+	Datum	   *old_keys = hashtable->keys;
+	bool	   *old_keynulls = hashtable->keynulls;
+	double		old_size = old_nbuckets * hha_slot_size(hashtable, numCols);
+	unsigned	slot;
+	MemoryContext oldcxt;
+
+	if (old_nbuckets > UINT_MAX / 2 ||
+		GET_TOTAL_USED_SIZE(hashtable) + 2 * old_size >= hashtable->max_mem)
+		return false;
+
+	oldcxt = MemoryContextSwitchTo(aggstate->aggcontext);
+
+	hashtable->nbuckets = old_nbuckets * 2;
+	hashtable->bucket_shift--;
+	hashtable->nused = 0;
+	hashtable->tags = (uint8 *) palloc0(hashtable->nbuckets * sizeof(uint8));
+	hashtable->buckets = (HashAggEntry **) palloc(hashtable->nbuckets * sizeof(HashAggEntry *));
+	if (old_keys != NULL)
+	{
+		hashtable->keys = (Datum *) palloc(hashtable->nbuckets * numCols * sizeof(Datum));
+		hashtable->keynulls = (bool *) palloc(hashtable->nbuckets * numCols * sizeof(bool));
+	}
+
+	for (slot = 0; slot < old_nbuckets; slot++)
+	{
+		HashAggEntry *entry = old_buckets[slot];
+
+		if (old_tags[slot] == 0)
+			continue;
+
+		hha_fill_slot(hashtable, hha_find_empty_slot(hashtable, entry->hashvalue),
+					  entry,
+					  old_keys ? &old_keys[slot * numCols] : NULL,
+					  old_keys ? &old_keynulls[slot * numCols] : NULL,
+					  numCols);
+	}
+
+	pfree(old_tags);
+	pfree(old_buckets);
+	if (old_keys != NULL)
+	{
+		pfree(old_keys);
+		pfree(old_keynulls);
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+
+	hashtable->mem_for_metadata += old_size;
+	hashtable->total_buckets += old_nbuckets;
+
+	elog(HHA_MSG_LVL, "HashAgg: grew hash table to %u slots", hashtable->nbuckets);
+
+	return true;
+}
+
+/*
+ * Function: init_agg_hash_keys
+ *
+ * Set up the grouping key buffers of the hash table, once the input tuple
+ * descriptor is known.  Keys are kept inline in the table when all the
+ * grouping columns are passed by value.
+ */
+static void
+init_agg_hash_keys(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	Agg		   *agg = (Agg *) aggstate->ss.ps.plan;
+	TupleDesc	tupdesc = aggstate->hashslot->tts_tupleDescriptor;
+	bool		byval = true;
+	MemoryContext oldcxt;
+	int			i;
+
+	Assert(hashtable->nused == 0);
+
+	oldcxt = MemoryContextSwitchTo(aggstate->aggcontext);
+
+	if (hashtable->input_keys == NULL)
+	{
+		hashtable->input_keys = (Datum *) palloc(Max(agg->numCols, 1) * sizeof(Datum));
+		hashtable->input_keynulls = (bool *) palloc(Max(agg->numCols, 1) * sizeof(bool));
+		hashtable->mem_for_metadata += agg->numCols * (sizeof(Datum) + sizeof(bool));
+	}
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		if (!tupdesc->attrs[agg->grpColIdx[i] - 1]->attbyval)
+			byval = false;
+	}
+
+	if (byval && agg->numCols > 0 && hashtable->keys == NULL)
+	{
+		hashtable->keys = (Datum *)
+			palloc(hashtable->nbuckets * agg->numCols * sizeof(Datum));
+		hashtable->keynulls = (bool *)
+			palloc(hashtable->nbuckets * agg->numCols * sizeof(bool));
+		hashtable->mem_for_metadata +=
+			hashtable->nbuckets * agg->numCols * (sizeof(Datum) + sizeof(bool));
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
 /* Function: calcHashAggTableSizes
  *
  * Check if the current memory quota is enough to handle the aggregation
@@ -566,9 +862,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	nbuckets = (((unsigned)1) << ((unsigned)ceil(log(nbuckets) / log(2))));
 
 	/*
-	 * Always set nbuckets greater than gp_hashagg_default_nbatches since
-	 * the spilling relies on this fact to choose which files to spill
-	 * groups to.
+	 * This is only the initial number of hash table slots; the table grows
+	 * as groups are added.  Start with at least as many slots as batches.
 	 */
 	if (nbuckets < gp_hashagg_default_nbatches)
 		nbuckets = gp_hashagg_default_nbatches;
@@ -696,11 +991,17 @@ create_agg_hash_table(AggState *aggstate)
 		elog(ERROR, ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY);
 	}
 
-	/* Initialize the hash buckets */
-	hashtable->nbuckets = hashtable->hats.nbuckets;
+	/* Initialize the hash slots; the table grows as needed. */
+	hashtable->nbuckets = HHA_MIN_SLOTS;
+	hashtable->bucket_shift = 32 - 4;
+	while (hashtable->nbuckets < hashtable->hats.nbuckets)
+	{
+		hashtable->nbuckets <<= 1;
+		hashtable->bucket_shift--;
+	}
 	hashtable->total_buckets = hashtable->nbuckets;
-	hashtable->buckets = (HashAggEntry **)palloc0(hashtable->nbuckets * sizeof(HashAggEntry *));
-	hashtable->bloom = (uint64 *)palloc0(hashtable->nbuckets * sizeof(uint64));
+	hashtable->tags = (uint8 *)palloc0(hashtable->nbuckets * sizeof(uint8));
+	hashtable->buckets = (HashAggEntry **)palloc(hashtable->nbuckets * sizeof(HashAggEntry *));
 
 	MemoryContextSwitchTo(hashtable->entry_cxt);
 	
@@ -720,8 +1021,7 @@ create_agg_hash_table(AggState *aggstate)
 
 	hashtable->max_mem = 1024.0 * operatorMemKB;
 	hashtable->mem_for_metadata = sizeof(HashAggTable)
-		+ hashtable->nbuckets * sizeof(HashAggEntry *)
-		+ hashtable->nbuckets * sizeof(uint64)
+		+ hashtable->nbuckets * (sizeof(HashAggEntry *) + sizeof(uint8))
 		+ sizeof(GroupKeysAndAggs);
 	hashtable->mem_wanted = hashtable->mem_for_metadata;
 	hashtable->mem_used = hashtable->mem_for_metadata;
@@ -814,6 +1114,8 @@ agg_hash_initial_pass(AggState *aggstate)
 			
 			hashtable->hashkey_buf = (HashKey *)palloc0(size);
 			hashtable->mem_for_metadata += size;
+
+			init_agg_hash_keys(aggstate);
 		}
 
 		/* set up for advance_aggregates call */
@@ -823,7 +1125,7 @@ agg_hash_initial_pass(AggState *aggstate)
 		 * input tuple's group. */
 		hashkey = calc_hash_value(aggstate, outerslot);
 		entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
-									  INPUT_RECORD_TUPLE, 0, hashkey, 0, &isNew);
+									  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
 		
 		if (entry == NULL)
 		{
@@ -853,7 +1155,7 @@ agg_hash_initial_pass(AggState *aggstate)
 			spill_hash_table(aggstate);
 
 			entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
-										  INPUT_RECORD_TUPLE, 0, hashkey, 0, &isNew);
+										  INPUT_RECORD_TUPLE, 0, hashkey, &isNew);
 		}
 
 		setGroupAggs(hashtable, mt_bind, entry);
@@ -1174,11 +1476,10 @@ obtain_spill_set(HashAggTable *hashtable)
 /* Spill all entries from the hash table to file in order to make room
  * for new hash entries.
  *
- * We want to maximize the sequential writes to each spill file. Since
- * the number of buckets and the number of batches (#batches) are the power of 2,
- * We simply write bucket 0, #batches, 2 * #batches, ... to the batch 0;
- * write bucket 1, (#batches + 1), (2 * #batches + 1), ... to the batch 1;
- * and etc.
+ * An entry goes to the batch given by the bits of its hash value just
+ * above the ones that chose the batch being processed (none in the
+ * initial pass), so that groups with matching grouping keys end up in
+ * the same batch.
  */
 static void
 spill_hash_table(AggState *aggstate)
@@ -1186,7 +1487,8 @@ spill_hash_table(AggState *aggstate)
 	HashAggTable *hashtable = aggstate->hhashtable;
 	SpillSet *spill_set;
 	SpillFile *spill_file;
-	int bucket_no;
+	unsigned slot;
+	unsigned hash_bit;
 	int file_no;
 	MemoryContext oldcxt;
 	uint64 old_num_spill_groups = hashtable->num_spill_groups;
@@ -1206,10 +1508,8 @@ spill_hash_table(AggState *aggstate)
 	/* Book keeping. */
 	hashtable->is_spilling = true;
 
-	Assert(hashtable->nbuckets > spill_set->num_spill_files);
-
 	/*
-	 * Write each spill file. Write the last spill file first, since it will
+	 * Open each spill file. Open the last spill file first, since it will
 	 * be processed the last.
 	 */
 	for (file_no = spill_set->num_spill_files - 1; file_no >= 0; file_no--)
@@ -1231,43 +1531,37 @@ spill_hash_table(AggState *aggstate)
 			
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
+	}
 
-		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
-			 bucket_no += spill_set->num_spill_files)
-		{
-			HashAggEntry *entry = hashtable->buckets[bucket_no];
-			
-			/* Ignore empty chains. */
-			if (entry == NULL) continue;
-			
-			/* Write all entries in the hash chain. */
-			while ( entry  != NULL )
-			{
-				HashAggEntry *spill_entry = entry;
-				entry = spill_entry->next;
+	/* Write all entries in the hash table. */
+	hash_bit = spill_set->spill_files[0].batch_hash_bit;
+	for (slot = 0; slot < hashtable->nbuckets; slot++)
+	{
+		HashAggEntry *spill_entry = hashtable->buckets[slot];
+		int32 written_bytes;
 
-				if (spill_entry != NULL)
-				{
-					int32 written_bytes;
-					
-					written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
-					spill_file->file_info->ntuples++;
-					spill_file->file_info->total_bytes += written_bytes;
+		/* Ignore empty slots. */
+		if (hashtable->tags[slot] == 0) continue;
 
-					hashtable->num_spill_groups++;
+		file_no = (spill_entry->hashvalue >> hash_bit) % spill_set->num_spill_files;
+		spill_file = &spill_set->spill_files[file_no];
 
-					Gpmon_M_Incr(GpmonPktFromAggState(aggstate), GPMON_AGG_SPILLTUPLE);
-					Gpmon_M_Add(GpmonPktFromAggState(aggstate), GPMON_AGG_SPILLBYTE, written_bytes);
+		written_bytes = writeHashEntry(aggstate, spill_file->file_info, spill_entry);
+		spill_file->file_info->ntuples++;
+		spill_file->file_info->total_bytes += written_bytes;
 
-					Gpmon_M_Incr(GpmonPktFromAggState(aggstate), GPMON_AGG_CURRSPILLPASS_TUPLE);
-					Gpmon_M_Add(GpmonPktFromAggState(aggstate), GPMON_AGG_CURRSPILLPASS_BYTE, written_bytes);
-				}
-			}
+		hashtable->num_spill_groups++;
 
-			hashtable->buckets[bucket_no] = NULL;
-		}
+		Gpmon_M_Incr(GpmonPktFromAggState(aggstate), GPMON_AGG_SPILLTUPLE);
+		Gpmon_M_Add(GpmonPktFromAggState(aggstate), GPMON_AGG_SPILLBYTE, written_bytes);
+
+		Gpmon_M_Incr(GpmonPktFromAggState(aggstate), GPMON_AGG_CURRSPILLPASS_TUPLE);
+		Gpmon_M_Add(GpmonPktFromAggState(aggstate), GPMON_AGG_CURRSPILLPASS_BYTE, written_bytes);
 	}
 
+	MemSet(hashtable->tags, 0, hashtable->nbuckets * sizeof(uint8));
+	hashtable->nused = 0;
+
 	/* Reset the buffer */
 	CdbCellBuf_Reset(&(hashtable->entry_buf));
 	mpool_reset(hashtable->group_buf);
@@ -1360,23 +1654,28 @@ writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 /*
  * agg_hash_table_stat_upd
  *      collect hash chain statistics for EXPLAIN ANALYZE
+ *
+ * The "chain length" of an entry is the number of groups of slots probed
+ * to find it.
  */
 static void
 agg_hash_table_stat_upd(HashAggTable *ht)
 {
     unsigned int	i;
+    unsigned int	ngroups = ht->nbuckets / HHA_GROUP_SLOTS;
 
     for (i = 0; i < ht->nbuckets; i++)
     {
         HashAggEntry   *entry = ht->buckets[i];
-        int             chainlength = 0;
-
-        if (entry)
-        {
-            for (chainlength = 0; entry; chainlength++)
-                entry = entry->next;
-            cdbexplain_agg_upd(&ht->chainlength, chainlength, i);
-        }
+        unsigned int    home;
+        int             chainlength;
+
+        if (ht->tags[i] == 0)
+            continue;
+
+        home = hha_home_group(ht, entry->hashvalue);
+        chainlength = (i / HHA_GROUP_SLOTS + ngroups - home) % ngroups + 1;
+        cdbexplain_agg_upd(&ht->chainlength, chainlength, i);
     }
 }                               /* agg_hash_table_stat_upd */
 
@@ -1388,7 +1687,6 @@ void init_agg_hash_iter(HashAggTable* hashtable)
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
-	hashtable->next_entry = NULL;
 }
 
 /* Function: agg_hash_iter
@@ -1404,34 +1702,32 @@ HashAggEntry *
 agg_hash_iter(AggState *aggstate)
 {
 	HashAggTable* hashtable = aggstate->hhashtable;
-	HashAggEntry *entry = hashtable->next_entry;
+	HashAggEntry *entry = NULL;
 	SpillSet *spill_set = hashtable->spill_set;
 	MemoryContext oldcxt;
 
 	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
 
+	if (hashtable->is_passthrough)
+		return agg_hash_passthrough(aggstate);
+
 	if (hashtable->curr_spill_file != NULL)
 		spill_set = hashtable->curr_spill_file->spill_set;
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	while (entry == NULL &&
-		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	while (hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
-		if (entry != NULL)
+		if (hashtable->tags[hashtable->curr_bucket_idx] != 0)
 		{
+			entry = hashtable->buckets[hashtable->curr_bucket_idx];
 			Assert(entry->is_primodial);
 			break;
 		}
 	}
 
 	if (entry != NULL)
-	{
 		hashtable->num_output_groups++;
-		hashtable->next_entry = entry->next;
-		entry->next = NULL;
-	}
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -1500,16 +1796,111 @@ readHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 bool
 agg_hash_stream(AggState *aggstate)
 {
+	HashAggTable *hashtable = aggstate->hhashtable;
+	uint64 pass_tuples = hashtable->num_tuples - hashtable->num_pass_start_tuples;
+
 	Assert( ((Agg *) aggstate->ss.ps.plan)->streaming );
-	
+
+	/* Passthrough ends the input; the rows were all returned by the iterator. */
+	if (hashtable->is_passthrough)
+		return false;
+
+	/*
+	 * If the pass just streamed out hardly reduced its input, grouping the
+	 * rest of the input is not worth the hashing: the top stage has to
+	 * combine the groups again anyway. Pass the remaining rows through as
+	 * one group each instead.
+	 */
+	if (gp_hashagg_passthrough_ratio > 0 && pass_tuples > 0 &&
+		(double) hashtable->num_ht_groups >=
+		gp_hashagg_passthrough_ratio * (double) pass_tuples)
+	{
+		elog(HHA_MSG_LVL,
+			 "HashAgg: " INT64_FORMAT " groups from " INT64_FORMAT " tuples, "
+			 "passing the remaining tuples through",
+			 hashtable->num_ht_groups, pass_tuples);
+
+		reset_agg_hash_table(aggstate);
+		hashtable->is_passthrough = true;
+
+		return true;
+	}
+
 	elog(HHA_MSG_LVL,
 		"HashAgg: streaming");
 
 	reset_agg_hash_table(aggstate);
+	hashtable->num_pass_start_tuples = hashtable->num_tuples;
 	
 	return agg_hash_initial_pass(aggstate);
 }
 
+/* Function: agg_hash_passthrough
+ *
+ * Read the next input tuple of a streaming aggregation that stopped
+ * grouping, and return an entry holding its group of one, with the
+ * aggregates advanced over it. The entry is not in the hash table.
+ *
+ * The previous entry is consumed by the time this is called again, so the
+ * entry memory is simply reset when it runs out.
+ *
+ * Returns NULL when the input is exhausted.
+ */
+static HashAggEntry *
+agg_hash_passthrough(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	TupleTableSlot *outerslot;
+	HashAggEntry *entry;
+	int tup_len;
+
+	if (hashtable->prev_slot != NULL)
+	{
+		outerslot = hashtable->prev_slot;
+		hashtable->prev_slot = NULL;
+	}
+	else
+		outerslot = ExecProcNode(outerPlanState(aggstate));
+
+	if (TupIsNull(outerslot))
+		return NULL;
+
+	Gpmon_M_Incr(GpmonPktFromAggState(aggstate), GPMON_QEXEC_M_ROWSIN);
+
+	tmpcontext->ecxt_outertuple = outerslot;
+
+	entry = makeHashAggEntryForInput(aggstate, outerslot, 0);
+	if (entry == NULL)
+	{
+		CdbCellBuf_Reset(&(hashtable->entry_buf));
+		mpool_reset(hashtable->group_buf);
+
+		entry = makeHashAggEntryForInput(aggstate, outerslot, 0);
+		if (entry == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_INTERNAL_ERROR),
+					 ERRMSG_GP_INSUFFICIENT_STATEMENT_MEMORY));
+	}
+
+	setGroupAggs(hashtable, mt_bind, entry);
+
+	tup_len = memtuple_get_size((MemTuple)entry->tuple_and_aggs, mt_bind);
+	MemSet((char *)entry->tuple_and_aggs + MAXALIGN(tup_len), 0,
+		   aggstate->numaggs * sizeof(AggStatePerGroupData));
+	initialize_aggregates(aggstate, aggstate->peragg, hashtable->groupaggs->aggs,
+						  &(aggstate->mem_manager));
+	advance_aggregates(aggstate, hashtable->groupaggs->aggs, &(aggstate->mem_manager));
+
+	hashtable->num_tuples++;
+	hashtable->num_output_groups++;
+
+	ResetExprContext(tmpcontext);
+
+	return entry;
+}
+
 /*
  * Function: agg_hash_load
  *
@@ -1525,7 +1916,6 @@ agg_hash_reload(AggState *aggstate)
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
 	bool has_tuples = false;
 	SpillFile *spill_file = hashtable->curr_spill_file;
-	int reloaded_hash_bit;
 
 	/*
 	 * Record the start value for mem_for_metadata, since its value
@@ -1541,10 +1931,6 @@ agg_hash_reload(AggState *aggstate)
 	hashtable->num_reloads++;
 	hashtable->total_buckets += hashtable->nbuckets;
 
-	reloaded_hash_bit = spill_file->batch_hash_bit +
-		(unsigned)ceil(log(spill_file->parent_spill_set->num_spill_files)/log(2));
-
-
 	if (spill_file->file_info != NULL &&
 		spill_file->file_info->wfile != NULL)
 	{
@@ -1586,7 +1972,7 @@ agg_hash_reload(AggState *aggstate)
 		tmpcontext->ecxt_outertuple = aggstate->hashslot;
 
 		entry = lookup_agg_hash_entry(aggstate, input, INPUT_RECORD_GROUP_AND_AGGS, input_size,
-									  hashkey, reloaded_hash_bit, &isNew);
+									  hashkey, &isNew);
 		
 		if (entry == NULL)
 		{
@@ -1610,7 +1996,7 @@ agg_hash_reload(AggState *aggstate)
 			spill_hash_table(aggstate);
 
 			entry = lookup_agg_hash_entry(aggstate, input, INPUT_RECORD_GROUP_AND_AGGS, input_size,
-										  hashkey, reloaded_hash_bit, &isNew);
+										  hashkey, &isNew);
 		}
 
 		if (!isNew)
@@ -1909,6 +2295,9 @@ agg_hash_next_pass(AggState *aggstate)
 
 		appendStringInfo(hbuf, ".\n");
 
+		if (hashtable->work_set != NULL)
+			workfile_mgr_explain_compression(&hashtable->work_set->compress_stats, hbuf);
+
         /* Hash chain statistics */
         if (hashtable->chainlength.vcnt > 0)
             appendStringInfo(hbuf,
@@ -1936,8 +2325,8 @@ void reset_agg_hash_table(AggState *aggstate)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 	
-	MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggEntry*));
-	MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+	MemSet(hashtable->tags, 0, hashtable->nbuckets * sizeof(uint8));
+	hashtable->nused = 0;
 	hashtable->num_ht_groups = 0;
 
 	CdbCellBuf_Reset(&(hashtable->entry_buf));
@@ -1975,8 +2364,18 @@ void destroy_agg_hash_table(AggState *aggstate)
 		reset_agg_hash_table(aggstate);
 
 		/* destroy_batches(aggstate->hhashtable); */
+		pfree(aggstate->hhashtable->tags);
 		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
+		if (aggstate->hhashtable->keys)
+		{
+			pfree(aggstate->hhashtable->keys);
+			pfree(aggstate->hhashtable->keynulls);
+		}
+		if (aggstate->hhashtable->input_keys)
+		{
+			pfree(aggstate->hhashtable->input_keys);
+			pfree(aggstate->hhashtable->input_keynulls);
+		}
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
@@ -3256,7 +3256,11 @@ ExecInsert(TupleTableSlot *slot,
 																resultRelInfo->ri_aosegno, false);
 		}
 
-		newId = aocs_insert(resultRelInfo->ri_aocsInsertDesc, partslot);
+		/*
+		 * The row may only be written out with the rows that follow it,
+		 * but its TID is final, so index entries can be made right away.
+		 */
+		newId = aocs_insert_slot_buffered(resultRelInfo->ri_aocsInsertDesc, partslot);
 		aoTupleId = *((AOTupleId*)slot_get_ctid(partslot));
 	}
 	else if (rel_is_external)
@@ -5110,7 +5114,7 @@ intorel_receive(TupleTableSlot *slot, DestReceiver *self)
 		if(myState->aocs_ins == NULL)
 			myState->aocs_ins = aocs_insert_init(into_rel, RESERVED_SEGNO, false);
 
-		aocs_insert(myState->aocs_ins, slot);
+		aocs_insert_slot_buffered(myState->aocs_ins, slot);
 	}
 	else
 	{
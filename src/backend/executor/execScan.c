@@ -17,6 +17,9 @@
 #include "codegen/codegen_wrapper.h"
 
 #include "executor/executor.h"
+#include "executor/hashjoin.h"
+#include "executor/nodeHash.h"
+#include "executor/nodeSort.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 #include "utils/debugbreak.h"
@@ -62,6 +65,8 @@ getScanMethod(int tableType)
 
 
 static bool tlist_matches_tupdesc(PlanState *ps, List *tlist, Index varno, TupleDesc tupdesc);
+static bool ExecScanRuntimeFiltersPass(List *runtimeFilters,
+						   ExprContext *econtext, TupleTableSlot *slot);
 
 
 /* ----------------------------------------------------------------
@@ -89,18 +94,22 @@ ExecScan(ScanState *node,
 	ExprContext *econtext;
 	List	   *qual;
 	ProjectionInfo *projInfo;
+	List	   *runtimeFilters;
+	SortLimitFilter *sortLimitFilter;
 
 	/*
 	 * Fetch data from node
 	 */
 	qual = node->ps.qual;
 	projInfo = node->ps.ps_ProjInfo;
+	runtimeFilters = node->ss_runtimeFilters;
+	sortLimitFilter = node->ss_sortLimitFilter;
 
 	/*
 	 * If we have neither a qual to check nor a projection to do, just skip
 	 * all the overhead and return the raw scan tuple.
 	 */
-	if (!qual && !projInfo)
+	if (!qual && !projInfo && !runtimeFilters && !sortLimitFilter)
 		return (*accessMtd) (node);
 
 	/*
@@ -144,6 +153,28 @@ ExecScan(ScanState *node,
 		 */
 		econtext->ecxt_scantuple = slot;
 
+		/*
+		 * CDB: drop the tuple early if a hash join above us already knows
+		 * that it cannot find a match.
+		 */
+		if (runtimeFilters && !ExecScanRuntimeFiltersPass(runtimeFilters,
+														  econtext, slot))
+		{
+			ResetExprContext(econtext);
+			continue;
+		}
+
+		/*
+		 * CDB: likewise if a LIMIT sort above us already has enough tuples
+		 * that sort before this one.
+		 */
+		if (sortLimitFilter && !ExecSortLimitFilterPasses(sortLimitFilter,
+														  econtext, slot))
+		{
+			ResetExprContext(econtext);
+			continue;
+		}
+
 		/*
 		 * check that the current tuple satisfies the qual-clause
 		 *
@@ -180,6 +211,27 @@ ExecScan(ScanState *node,
 	}
 }
 
+/*
+ * ExecScanRuntimeFiltersPass
+ *		Check a scan tuple against the runtime filters of the hash joins
+ *		above the scan.
+ */
+static bool
+ExecScanRuntimeFiltersPass(List *runtimeFilters,
+						   ExprContext *econtext, TupleTableSlot *slot)
+{
+	ListCell   *lc;
+
+	foreach(lc, runtimeFilters)
+	{
+		HashJoinRuntimeFilterProbe *probe = lfirst(lc);
+
+		if (!ExecHashRuntimeFilterPasses(probe, econtext, slot))
+			return false;
+	}
+	return true;
+}
+
 /*
  * ExecAssignScanProjectionInfo
  *		Set up projection info for a scan node, if necessary.
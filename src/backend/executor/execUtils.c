@@ -1738,9 +1738,15 @@ AssignGangs(QueryDesc *queryDesc)
 				inv.vecNgangs[i] = allocateWriterGang();
 
 				Assert(inv.vecNgangs[i] != NULL);
+
+				/* Connect all the reader gangs we lack at once. */
+				prepareReaderGangs(inv.numNgangs - 1);
 			}
 			else
 			{
+				if (i == 0)
+					prepareReaderGangs(inv.numNgangs);
+
 				inv.vecNgangs[i] = allocateReaderGang(GANGTYPE_PRIMARY_READER, queryDesc->portal_name);
 			}
 		}
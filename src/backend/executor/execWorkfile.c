@@ -450,6 +450,15 @@ ExecWorkFile_Close(ExecWorkFile *workfile)
 				ExecWorkFile_AdjustBFZSize(workfile, file_size);
 			}
 
+			if (workfile->work_set != NULL)
+			{
+				workfile_compress_stats *stats = &workfile->work_set->compress_stats;
+
+				stats->raw_bytes += bfz_file->rawBytes;
+				stats->stored_bytes += bfz_file->storedBytes;
+				stats->secs += bfz_file->compressSecs;
+			}
+
 			bfz_close(bfz_file, true, true);
 			break;
 		default:
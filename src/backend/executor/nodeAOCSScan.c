@@ -46,6 +46,7 @@ static void OpenAOCSScanRelation(AOCSScanState *node)
 			appendOnlyMetaDataSnapshot,
 			NULL /* relationTupleDesc */,
 			node->proj);
+	aocs_set_zonemap_qual(node->scandesc, node->ss.ps.plan->qual);
 
 	node->ss.scan_state = SCAN_SCAN;
 }
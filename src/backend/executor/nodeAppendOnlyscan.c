@@ -203,6 +203,7 @@ static void OpenAOScanRelation(AppendOnlyScanState *node)
 			node->ss.ps.state->es_snapshot,
 			appendOnlyMetaDataSnapshot,
 			0, NULL);
+	appendonly_set_zonemap_qual(node->aos_ScanDesc, node->ss.ps.plan->qual);
 	node->ss.scan_state = SCAN_SCAN;
 }
 
@@ -26,6 +26,7 @@
 #include <limits.h>
 
 #include "access/hash.h"
+#include "catalog/pg_type.h"
 #include "commands/tablespace.h"
 #include "executor/execdebug.h"
 #include "executor/hashjoin.h"
@@ -34,6 +35,7 @@
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
 #include "parser/parse_expr.h"
+#include "utils/date.h"
 #include "utils/dynahash.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
@@ -52,6 +54,10 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
                             int             ibatch_end,
                             const char     *title);
 static void ExecHashTableReallocBatchData(HashJoinTable hashtable, int new_nbatch);
+static void ExecHashRuntimeFilterStart(HashState *hashState);
+static void ExecHashRuntimeFilterAdd(HashState *hashState,
+						 ExprContext *econtext, uint32 hashvalue);
+static void ExecHashRuntimeFilterFinish(HashState *hashState);
 
 void ExecChooseHashTableSize(double ntuples, int tupwidth,
 						int *numbuckets,
@@ -115,6 +121,9 @@ MultiExecHash(HashState *node)
 
 	SIMPLE_FAULT_INJECTOR(MultiExecHashLargeVmem);
 
+	if (node->hs_runtimeFilter)
+		ExecHashRuntimeFilterStart(node);
+
 	/*
 	 * get all inner tuples and insert into the hash table (or temp files)
 	 */
@@ -133,6 +142,8 @@ MultiExecHash(HashState *node)
 		if (ExecHashGetHashValue(node, hashtable, econtext, hashkeys, false,
 								 node->hs_keepnull, &hashvalue, &hashkeys_null))
 		{
+			if (node->hs_runtimeFilter)
+				ExecHashRuntimeFilterAdd(node, econtext, hashvalue);
 			ExecHashTableInsert(node, hashtable, slot, hashvalue);
 		}
 
@@ -147,6 +158,11 @@ MultiExecHash(HashState *node)
 		}
 	}
 
+	if (node->hs_runtimeFilter)
+		ExecHashRuntimeFilterFinish(node);
+
+	ExecHashTableCluster(node, hashtable);
+
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
 
@@ -316,6 +332,7 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->bloom = NULL;
 	hashtable->nbatch = nbatch;
 	hashtable->curbatch = 0;
+	hashtable->reversed = false;
 	hashtable->nbatch_original = nbatch;
 	hashtable->nbatch_outstart = nbatch;
 	hashtable->growEnabled = true;
@@ -686,6 +703,9 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 
 	if (hashtable->work_set != NULL)
 	{
+		if (hashtable->stats != NULL)
+			hashtable->stats->compress_stats = hashtable->work_set->compress_stats;
+
 		workfile_mgr_close_set(hashtable->work_set);
 		hashtable->work_set = NULL;
 	}
@@ -988,6 +1008,52 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 	END_MEMORY_ACCOUNT();
 }
 
+/*
+ * ExecHashTableInsertReversed
+ *		insert an outer tuple into the hash table of a batch whose roles
+ *		are reversed
+ *
+ * ExecHashJoinNewBatch only reverses a batch whose outer side fits in
+ * memory, so unlike ExecHashTableInsert this never spills.
+ */
+void
+ExecHashTableInsertReversed(HashState *hashState, HashJoinTable hashtable,
+							TupleTableSlot *slot,
+							uint32 hashvalue)
+{
+	MemTuple tuple = ExecFetchSlotMemTuple(slot, false);
+	HashJoinBatchData  *batch = hashtable->batches[hashtable->curbatch];
+	HashJoinTuple hashTuple;
+	int			bucketno;
+	int			batchno;
+	int			hashTupleSize;
+
+	START_MEMORY_ACCOUNT(hashState->ps.memoryAccount);
+	{
+	Assert(hashtable->reversed);
+
+	ExecHashGetBucketAndBatch(hashtable, hashvalue,
+			&bucketno, &batchno);
+	Assert(batchno == hashtable->curbatch);
+
+	hashTupleSize = HJTUPLE_OVERHEAD + memtuple_get_size(tuple, NULL);
+	batch->innertuples++;
+	batch->innerspace += hashTupleSize;
+
+	hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->batchCxt,
+			hashTupleSize);
+	hashTuple->hashvalue = hashvalue;
+	memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, memtuple_get_size(tuple, NULL));
+	hashTuple->next = hashtable->buckets[bucketno];
+	hashtable->buckets[bucketno] = hashTuple;
+	hashtable->totalTuples += 1;
+
+	if(gp_hashjoin_bloomfilter!=0)
+		hashtable->bloom[bucketno] |= BLOOMVAL(hashvalue);
+	}
+	END_MEMORY_ACCOUNT();
+}
+
 /*
  * ExecHashGetHashValue
  *		Compute the hash value for a tuple
@@ -1145,6 +1211,8 @@ ExecHashGetBucketAndBatch(HashJoinTable hashtable,
  *		scan a hash bucket for matches to the current outer tuple
  *
  * The current outer tuple must be stored in econtext->ecxt_outertuple.
+ * If the roles of the current batch are reversed, it is the current inner
+ * tuple, in econtext->ecxt_innertuple, and the bucket holds outer tuples.
  */
 HashJoinTuple
 ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
@@ -1172,15 +1240,22 @@ ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
 
 	while (hashTuple != NULL)
 	{
+		/* start loading the next tuple while this one is checked */
+		HJ_PREFETCH(hashTuple->next);
+
 		if (hashTuple->hashvalue == hashvalue)
 		{
-			TupleTableSlot *inntuple;
-
 			/* insert hashtable's tuple into exec slot so ExecQual sees it */
-			inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
-					hjstate->hj_HashTupleSlot,
-					false);	/* do not pfree */
-			econtext->ecxt_innertuple = inntuple;
+			if (hashtable->reversed)
+				econtext->ecxt_outertuple =
+					ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+							hjstate->hj_OuterTupleSlot,
+							false);	/* do not pfree */
+			else
+				econtext->ecxt_innertuple =
+					ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+							hjstate->hj_HashTupleSlot,
+							false);	/* do not pfree */
 
 			/* reset temp memory each time to avoid leaks from qual expr */
 			ResetExprContext(econtext);
@@ -1243,6 +1318,101 @@ ExecHashTableReset(HashState *hashState, HashJoinTable hashtable)
 	END_MEMORY_ACCOUNT();
 }
 
+/*
+ * ExecHashTableCluster
+ *
+ *		lay out the tuples of the current batch in bucket order
+ *
+ * The tuples are allocated one at a time as the inner side is read, so the
+ * tuples of a bucket end up scattered over the whole table, and each step
+ * along a bucket chain is a cache miss once the table is much larger than
+ * the CPU cache.  Once a large batch is complete, copy its tuples into big
+ * chunks in bucket order, so that each chain, and the chains of
+ * neighbouring buckets, are contiguous in memory.  The old copies go away
+ * with the old batch context.
+ *
+ * Both copies exist while this runs, so it is only done when that still
+ * fits in the memory allowed for the hash table.
+ */
+void
+ExecHashTableCluster(HashState *hashState, HashJoinTable hashtable)
+{
+	HashJoinBatchData *batch = hashtable->batches[hashtable->curbatch];
+	int			nbuckets = hashtable->nbuckets;
+	MemoryContext newcxt;
+	MemoryContext oldcxt;
+	HashJoinTuple *newbuckets;
+	char	   *chunk = NULL;
+	Size		chunkfree = 0;
+	int			i;
+
+	if (!gp_hashjoin_cluster_tuples ||
+		batch->innerspace < HJ_CLUSTER_MIN_SPACE ||
+		batch->innerspace > hashtable->spaceAllowed / 2)
+		return;
+
+	START_MEMORY_ACCOUNT(hashState->ps.memoryAccount);
+	{
+	newcxt = AllocSetContextCreate(hashtable->hashCxt,
+								   "HashBatchContext",
+								   ALLOCSET_DEFAULT_MINSIZE,
+								   ALLOCSET_DEFAULT_INITSIZE,
+								   ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(newcxt);
+
+	newbuckets = (HashJoinTuple *) palloc0(nbuckets * sizeof(HashJoinTuple));
+
+	for (i = 0; i < nbuckets; i++)
+	{
+		HashJoinTuple *link = &newbuckets[i];
+		HashJoinTuple tuple;
+
+		if (i + HJ_PREFETCH_DISTANCE < nbuckets)
+			HJ_PREFETCH(hashtable->buckets[i + HJ_PREFETCH_DISTANCE]);
+
+		for (tuple = hashtable->buckets[i]; tuple != NULL; tuple = tuple->next)
+		{
+			Size		tupleSize;
+			HashJoinTuple copy;
+
+			HJ_PREFETCH(tuple->next);
+
+			tupleSize = HJTUPLE_OVERHEAD +
+				memtuple_get_size(HJTUPLE_MINTUPLE(tuple), NULL);
+			if (MAXALIGN(tupleSize) > chunkfree)
+			{
+				chunkfree = Max(MAXALIGN(tupleSize), HJ_CLUSTER_CHUNK_SIZE);
+				chunk = palloc(chunkfree);
+			}
+
+			copy = (HashJoinTuple) chunk;
+			chunk += MAXALIGN(tupleSize);
+			chunkfree -= MAXALIGN(tupleSize);
+
+			memcpy(copy, tuple, tupleSize);
+			copy->next = NULL;
+			*link = copy;
+			link = &copy->next;
+		}
+	}
+
+	if (hashtable->bloom != NULL)
+	{
+		uint64	   *newbloom = (uint64 *) palloc(nbuckets * sizeof(uint64));
+
+		memcpy(newbloom, hashtable->bloom, nbuckets * sizeof(uint64));
+		hashtable->bloom = newbloom;
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+
+	MemoryContextDelete(hashtable->batchCxt);
+	hashtable->batchCxt = newcxt;
+	hashtable->buckets = newbuckets;
+	}
+	END_MEMORY_ACCOUNT();
+}
+
 void
 ExecReScanHash(HashState *node, ExprContext *exprCtxt)
 {
@@ -1396,6 +1566,10 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				hashtable->nbatch_outstart,
 				hashtable->nbatch,
 				"Secondary Overflow");
+
+    	if (hashtable->work_set != NULL)
+    		stats->compress_stats = hashtable->work_set->compress_stats;
+    	workfile_mgr_explain_compression(&stats->compress_stats, buf);
     }
 
     /* Report hash chain statistics. */
@@ -1415,6 +1589,23 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
                              hashtable->nbatch - stats->nonemptybatches);
         appendStringInfoChar(buf, '\n');
     }
+
+    /* Report batches whose hash table was built from the outer side. */
+    if (stats->reversedbatches > 0)
+        appendStringInfo(buf,
+                         "Built %d of %d batches from the outer side.\n",
+                         stats->reversedbatches,
+                         hashtable->nbatch);
+
+    /* Report how much the runtime filter saved the outer side. */
+    if (hjstate->hj_RuntimeFilter &&
+        hjstate->hj_RuntimeFilter->nchecked > 0)
+        appendStringInfo(buf,
+                         "Runtime filter rejected %.0f of %.0f outer tuples%s.\n",
+                         hjstate->hj_RuntimeFilter->nrejected,
+                         hjstate->hj_RuntimeFilter->nchecked,
+                         hjstate->hj_RuntimeFilter->disabled ?
+                         ", then was disabled" : "");
 }                               /* ExecHashTableExplainEnd */
 
 
@@ -1586,10 +1777,18 @@ ExecHashTableExplainBatchEnd(HashState *hashState, HashJoinTable hashtable)
         /* How much was read from inner workfile for current batch? */
         batchstats->irdbytes = batchstats->innerfilesize;
 
-        /* How much was read from outer workfiles for current batch? */
-		if (hashtable->batches[curbatch]->outerside.workfile != NULL)
-            batchstats->ordbytes =
-				ExecWorkFile_Tell64(hashtable->batches[curbatch]->outerside.workfile);
+        /*
+         * How much was read from outer workfiles for current batch?  If the
+         * roles of the batch are reversed, the outer workfile is the one the
+         * hash table was built from, and was counted as the inner one.
+         */
+		if (hashtable->reversed)
+		{
+			if (batch->innerside.workfile != NULL)
+				batchstats->ordbytes = ExecWorkFile_Tell64(batch->innerside.workfile);
+		}
+		else if (batch->outerside.workfile != NULL)
+            batchstats->ordbytes = ExecWorkFile_Tell64(batch->outerside.workfile);
 
 		/*
 		 * How much was written to workfiles for the remaining batches?
@@ -1653,3 +1852,341 @@ initGpmonPktForHash(Plan *planNode, gpmon_packet_t *gpmon_pkt, EState *estate)
 							 NULL); 
 	}
 }
+
+/*
+ * Runtime join filters.
+ *
+ * While the inner side is read, the hash values of the inner tuples are
+ * collected in an array; when the inner side is complete, they are set in a
+ * Bloom filter of at least RUNTIME_FILTER_BITS_PER_TUPLE bits per tuple,
+ * with RUNTIME_FILTER_NPROBES bits per value.  That gives roughly a 2%
+ * false positive rate, independent of how the hash table itself is split
+ * into batches.
+ *
+ * Past RUNTIME_FILTER_MAX_TUPLES inner tuples, or past a
+ * 1/RUNTIME_FILTER_MAX_SPACE_FRACTION share of the hash table's operator
+ * memory, the filter is given up: it would take too much memory, and a join
+ * with that large an inner side rarely rejects enough outer tuples to pay
+ * for the check.  The memory the filter does take is subtracted from the
+ * hash table's spaceAllowed, so that the two together stay within the
+ * operator memory.
+ *
+ * A filter that rejects fewer than 1/RUNTIME_FILTER_MIN_REJECT_FRACTION of
+ * the first RUNTIME_FILTER_SAMPLE_TUPLES outer tuples checked after a build
+ * is only costing time, and is disabled until the next build.
+ */
+#define RUNTIME_FILTER_MIN_HASHVALUES	1024
+#define RUNTIME_FILTER_MAX_TUPLES		(1 << 21)
+#define RUNTIME_FILTER_MAX_SPACE_FRACTION	4
+#define RUNTIME_FILTER_SAMPLE_TUPLES	4096
+#define RUNTIME_FILTER_MIN_REJECT_FRACTION	20
+#define RUNTIME_FILTER_BITS_PER_TUPLE	8
+#define RUNTIME_FILTER_MIN_BITS			1024
+#define RUNTIME_FILTER_NPROBES			3
+
+/*
+ * Second hash for double hashing: the halves of the hash value swapped,
+ * forced odd so that the probes are distinct.
+ */
+#define RUNTIME_FILTER_STEP(h)	((((h) >> 16) | ((h) << 16)) | 1)
+
+static inline int64
+runtime_filter_int_value(Oid typid, Datum value)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (int64) DatumGetInt16(value);
+		case INT4OID:
+			return (int64) DatumGetInt32(value);
+		case DATEOID:
+			return (int64) DatumGetDateADT(value);
+		default:
+			Assert(typid == INT8OID);
+			return DatumGetInt64(value);
+	}
+}
+
+/*
+ * Forget the filter of a previous build.  Until ExecHashRuntimeFilterFinish,
+ * the filter lets everything pass.
+ *
+ * The hash table is new, with all of the operator memory to itself; the
+ * space of the previous build went with the old one.
+ */
+static void
+ExecHashRuntimeFilterStart(HashState *hashState)
+{
+	HashJoinRuntimeFilter *filter = hashState->hs_runtimeFilter;
+
+	filter->ready = false;
+	filter->overflowed = false;
+	filter->nhashvalues = 0;
+	filter->rangeEmpty = true;
+	filter->space = 0;
+	filter->disabled = false;
+	filter->samplechecked = 0;
+	filter->samplerejected = 0;
+
+	if (filter->bits)
+	{
+		pfree(filter->bits);
+		filter->bits = NULL;
+	}
+}
+
+/*
+ * Take newspace bytes for the filter out of the hash table's operator
+ * memory, in place of what it has now.  Returns false if that would be
+ * more than the filter's share.
+ */
+static bool
+runtime_filter_reserve(HashJoinTable hashtable, HashJoinRuntimeFilter *filter,
+					   Size newspace)
+{
+	Size		operatorMem = hashtable->spaceAllowed + filter->space;
+
+	if (newspace > operatorMem / RUNTIME_FILTER_MAX_SPACE_FRACTION)
+		return false;
+
+	hashtable->spaceAllowed = operatorMem - newspace;
+	filter->space = newspace;
+	return true;
+}
+
+/*
+ * Add an inner tuple, whose hash value and keys have just been computed in
+ * econtext.
+ */
+static void
+ExecHashRuntimeFilterAdd(HashState *hashState,
+						 ExprContext *econtext, uint32 hashvalue)
+{
+	HashJoinRuntimeFilter *filter = hashState->hs_runtimeFilter;
+	HashJoinTable hashtable = hashState->hashtable;
+
+	if (filter->overflowed)
+		return;
+
+	if (filter->nhashvalues >= filter->maxhashvalues)
+	{
+		int			newmax;
+
+		if (filter->hashvalues == NULL)
+			newmax = RUNTIME_FILTER_MIN_HASHVALUES;
+		else
+			newmax = filter->maxhashvalues * 2;
+
+		if (filter->maxhashvalues >= RUNTIME_FILTER_MAX_TUPLES ||
+			!runtime_filter_reserve(hashtable, filter,
+									newmax * sizeof(uint32)))
+		{
+			filter->overflowed = true;
+			if (filter->hashvalues)
+				pfree(filter->hashvalues);
+			filter->hashvalues = NULL;
+			filter->maxhashvalues = 0;
+			hashtable->spaceAllowed += filter->space;
+			filter->space = 0;
+			return;
+		}
+
+		START_MEMORY_ACCOUNT(hashState->ps.memoryAccount);
+		{
+		if (filter->hashvalues == NULL)
+			filter->hashvalues = (uint32 *)
+				MemoryContextAlloc(filter->mcxt, newmax * sizeof(uint32));
+		else
+			filter->hashvalues = (uint32 *)
+				repalloc(filter->hashvalues, newmax * sizeof(uint32));
+		filter->maxhashvalues = newmax;
+		}
+		END_MEMORY_ACCOUNT();
+	}
+
+	filter->hashvalues[filter->nhashvalues++] = hashvalue;
+
+	if (filter->rangeKey)
+	{
+		Datum		keyval;
+		bool		isNull = false;
+		int64		value;
+
+		keyval = ExecEvalExpr(filter->rangeKey, econtext, &isNull, NULL);
+		if (isNull)
+			return;
+
+		value = runtime_filter_int_value(filter->innerRangeType, keyval);
+		if (filter->rangeEmpty)
+		{
+			filter->rangeMin = filter->rangeMax = value;
+			filter->rangeEmpty = false;
+		}
+		else if (value < filter->rangeMin)
+			filter->rangeMin = value;
+		else if (value > filter->rangeMax)
+			filter->rangeMax = value;
+	}
+}
+
+/*
+ * The inner side is complete: build the Bloom filter.
+ */
+static void
+ExecHashRuntimeFilterFinish(HashState *hashState)
+{
+	HashJoinRuntimeFilter *filter = hashState->hs_runtimeFilter;
+	HashJoinTable hashtable = hashState->hashtable;
+	uint64		nbits;
+	int			i;
+
+	if (filter->overflowed || filter->nhashvalues == 0)
+		return;
+
+	nbits = RUNTIME_FILTER_MIN_BITS;
+	while (nbits < (uint64) filter->nhashvalues * RUNTIME_FILTER_BITS_PER_TUPLE)
+		nbits <<= 1;
+
+	/*
+	 * The bits are needed alongside the hash values for a moment; both must
+	 * fit in the filter's share.
+	 */
+	if (!runtime_filter_reserve(hashtable, filter,
+								filter->space + nbits / 8))
+	{
+		pfree(filter->hashvalues);
+		filter->hashvalues = NULL;
+		filter->maxhashvalues = 0;
+		hashtable->spaceAllowed += filter->space;
+		filter->space = 0;
+		return;
+	}
+
+	START_MEMORY_ACCOUNT(hashState->ps.memoryAccount);
+	{
+	filter->bits = (uint64 *) MemoryContextAllocZero(filter->mcxt, nbits / 8);
+	}
+	END_MEMORY_ACCOUNT();
+	filter->bitmask = (uint32) (nbits - 1);
+
+	for (i = 0; i < filter->nhashvalues; i++)
+	{
+		uint32		h = filter->hashvalues[i];
+		uint32		step = RUNTIME_FILTER_STEP(h);
+		int			j;
+
+		for (j = 0; j < RUNTIME_FILTER_NPROBES; j++)
+		{
+			uint32		bit = h & filter->bitmask;
+
+			filter->bits[bit >> 6] |= ((uint64) 1) << (bit & 63);
+			h += step;
+		}
+	}
+
+	pfree(filter->hashvalues);
+	filter->hashvalues = NULL;
+	filter->maxhashvalues = 0;
+	runtime_filter_reserve(hashtable, filter, nbits / 8);
+
+	filter->ready = true;
+}
+
+/*
+ * Can the tuple in slot, produced by a scan below the hash join, find a
+ * match on the inner side?  The keys are hashed the same way as
+ * ExecHashGetHashValue hashes the outer tuples.
+ */
+bool
+ExecHashRuntimeFilterPasses(HashJoinRuntimeFilterProbe *probe,
+							ExprContext *econtext,
+							TupleTableSlot *slot)
+{
+	HashJoinRuntimeFilter *filter = probe->filter;
+	MemoryContext oldContext;
+	uint32		hashkey = 0;
+	uint32		step;
+	bool		passes = true;
+	int			i;
+
+	if (!filter->ready || filter->disabled)
+		return true;
+
+	filter->nchecked++;
+	filter->samplechecked++;
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		Datum		keyval;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		keyval = slot_getattr(slot, probe->attnos[i], &isNull);
+
+		if (isNull)
+		{
+			if (filter->hashStrict[i])
+			{
+				passes = false;
+				break;
+			}
+			/* else, leave hashkey unmodified, equivalent to hashcode 0 */
+			continue;
+		}
+
+		if (i == 0 && filter->rangeKey)
+		{
+			int64		value;
+
+			value = runtime_filter_int_value(filter->outerRangeType, keyval);
+			if (filter->rangeEmpty ||
+				value < filter->rangeMin || value > filter->rangeMax)
+			{
+				passes = false;
+				break;
+			}
+		}
+
+		hashkey ^= DatumGetUInt32(FunctionCall1(&filter->outer_hashfunctions[i],
+												keyval));
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	step = RUNTIME_FILTER_STEP(hashkey);
+	for (i = 0; passes && i < RUNTIME_FILTER_NPROBES; i++)
+	{
+		uint32		bit = hashkey & filter->bitmask;
+
+		if ((filter->bits[bit >> 6] & (((uint64) 1) << (bit & 63))) == 0)
+			passes = false;
+		hashkey += step;
+	}
+
+	if (!passes)
+	{
+		filter->nrejected++;
+		filter->samplerejected++;
+	}
+
+	/* Is the filter worth checking? */
+	if (filter->samplechecked == RUNTIME_FILTER_SAMPLE_TUPLES &&
+		filter->samplerejected * RUNTIME_FILTER_MIN_REJECT_FRACTION <
+		filter->samplechecked)
+		filter->disabled = true;
+
+	return passes;
+}
+
+void
+ExecHashRuntimeFilterReport(HashJoinRuntimeFilter *filter)
+{
+	if (filter->nchecked > 0)
+		elog(DEBUG1, "hash join runtime filter rejected %.0f of %.0f outer tuples%s",
+			 filter->nrejected, filter->nchecked,
+			 filter->disabled ? ", then was disabled" : "");
+}
@@ -21,7 +21,11 @@
 #include "executor/instrument.h"        /* Instrumentation */
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "catalog/pg_type.h"
+#include "parser/parse_expr.h"
+#include "parser/parsetree.h"
 #include "utils/faultinjector.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
 #include "cdb/cdbvars.h"
@@ -36,6 +40,8 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinBatchSide *side,
 						  uint32 *hashvalue,
 						  TupleTableSlot *tupleSlot);
 static int	ExecHashJoinNewBatch(HashJoinState *hjstate);
+static bool ExecHashJoinReverseBatch(HashJoinState *hjstate,
+						 HashJoinBatchData *batch);
 static bool isNotDistinctJoin(List *qualList);
 
 static void ReleaseHashTable(HashJoinState *node);
@@ -47,7 +53,9 @@ static bool isHashtableEmpty(HashJoinTable hashtable);
  *		This function implements the Hybrid Hashjoin algorithm.
  *
  *		Note: the relation we build hash table on is the "inner"
- *			  the other one is "outer".
+ *			  the other one is "outer".  The roles of a later batch
+ *			  may be reversed, see ExecHashJoinReverseBatch; then the
+ *			  "outer" tuples below are inner tuples, and vice versa.
  * ----------------------------------------------------------------
  */
 TupleTableSlot *				/* return: a tuple or NULL */
@@ -289,8 +297,13 @@ ExecHashJoin(HashJoinState *node)
 
 			Gpmon_M_Incr(GpmonPktFromHashJoinState(node), GPMON_QEXEC_M_ROWSIN); 
 			CheckSendPlanStateGpmonPkt(&node->js.ps);
-			node->js.ps.ps_OuterTupleSlot = outerTupleSlot;
-			econtext->ecxt_outertuple = outerTupleSlot;
+			if (hashtable->reversed)
+				econtext->ecxt_innertuple = outerTupleSlot;
+			else
+			{
+				node->js.ps.ps_OuterTupleSlot = outerTupleSlot;
+				econtext->ecxt_outertuple = outerTupleSlot;
+			}
 			node->hj_NeedNewOuter = false;
 			node->hj_MatchedOuter = false;
 
@@ -313,12 +326,14 @@ ExecHashJoin(HashJoinState *node)
 				 * Need to postpone this outer tuple to a later batch. Save it
 				 * in the corresponding outer-batch file.
 				 */
+				HashJoinBatchData *batch = hashtable->batches[batchno];
+
 				Assert(batchno != 0);
 				Assert(batchno > hashtable->curbatch);
 				ExecHashJoinSaveTuple(&node->js.ps, ExecFetchSlotMemTuple(outerTupleSlot, false),
 									  hashvalue,
 									  hashtable,
-                                      &hashtable->batches[batchno]->outerside,
+									  hashtable->reversed ? &batch->innerside : &batch->outerside,
 									  hashtable->bfCxt);
 				node->hj_NeedNewOuter = true;
 				continue;		/* loop around for a new outer tuple */
@@ -351,10 +366,18 @@ ExecHashJoin(HashJoinState *node)
 			/*
 			 * we've got a match, but still need to test non-hashed quals
 			 */
-			inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(curtuple),
-										 node->hj_HashTupleSlot,
-										 false);	/* don't pfree */
-			econtext->ecxt_innertuple = inntuple;
+			if (hashtable->reversed)
+				econtext->ecxt_outertuple =
+					ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(curtuple),
+										  node->hj_OuterTupleSlot,
+										  false);	/* don't pfree */
+			else
+			{
+				inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(curtuple),
+												 node->hj_HashTupleSlot,
+												 false);	/* don't pfree */
+				econtext->ecxt_innertuple = inntuple;
+			}
 
 			/* reset temp memory each time to avoid leaks from qual expr */
 			ResetExprContext(econtext);
@@ -425,6 +448,234 @@ ExecHashJoin(HashJoinState *node)
 	}
 }
 
+/*
+ * Is the type one whose values a runtime filter can keep a range of?
+ */
+static bool
+runtime_filter_range_type(Oid typid)
+{
+	return typid == INT2OID || typid == INT4OID || typid == INT8OID ||
+		typid == DATEOID;
+}
+
+/*
+ * Strip binary-compatible relabeling off a join key.
+ */
+static Expr *
+runtime_filter_strip_relabel(Expr *expr)
+{
+	while (expr && IsA(expr, RelabelType))
+		expr = ((RelabelType *) expr)->arg;
+	return expr;
+}
+
+/*
+ * The expression producing attribute attno of a plan's result tuples, or
+ * NULL.
+ */
+static Expr *
+runtime_filter_tlist_expr(List *targetlist, AttrNumber attno)
+{
+	TargetEntry *tle = get_tle_by_resno(targetlist, attno);
+
+	if (tle == NULL)
+		return NULL;
+	return runtime_filter_strip_relabel(tle->expr);
+}
+
+/*
+ * Hand the runtime filter to the scans below ps that produce the outer
+ * join keys, found at attributes attnos of ps's result tuples.  Only plain
+ * column references are followed: through the outer side of other hash
+ * joins, and into all the children of an Append.  Anything else, notably a
+ * Motion, ends the search.
+ *
+ * Returns the number of scans that got the filter.
+ */
+static int
+ExecHashJoinPushRuntimeFilterTo(PlanState *ps, HashJoinRuntimeFilter *filter,
+								AttrNumber *attnos)
+{
+	AttrNumber *childattnos;
+	int			i;
+
+	switch (nodeTag(ps))
+	{
+		case T_SeqScanState:
+		case T_AppendOnlyScanState:
+		case T_AOCSScanState:
+		case T_TableScanState:
+			{
+				ScanState  *scanstate = (ScanState *) ps;
+				HashJoinRuntimeFilterProbe *probe;
+
+				childattnos = (AttrNumber *) palloc(filter->nkeys * sizeof(AttrNumber));
+				for (i = 0; i < filter->nkeys; i++)
+				{
+					Var		   *var;
+
+					if (ps->ps_ProjInfo == NULL)
+					{
+						childattnos[i] = attnos[i];
+						continue;
+					}
+
+					var = (Var *) runtime_filter_tlist_expr(ps->plan->targetlist,
+															attnos[i]);
+					if (var == NULL || !IsA(var, Var) || var->varattno <= 0)
+					{
+						pfree(childattnos);
+						return 0;
+					}
+					childattnos[i] = var->varattno;
+				}
+
+				probe = (HashJoinRuntimeFilterProbe *) palloc(sizeof(HashJoinRuntimeFilterProbe));
+				probe->filter = filter;
+				probe->attnos = childattnos;
+				scanstate->ss_runtimeFilters = lappend(scanstate->ss_runtimeFilters,
+													   probe);
+				return 1;
+			}
+
+		case T_HashJoinState:
+			{
+				int			npushed;
+
+				childattnos = (AttrNumber *) palloc(filter->nkeys * sizeof(AttrNumber));
+				for (i = 0; i < filter->nkeys; i++)
+				{
+					Var		   *var;
+
+					var = (Var *) runtime_filter_tlist_expr(ps->plan->targetlist,
+															attnos[i]);
+					if (var == NULL || !IsA(var, Var) || var->varno != OUTER)
+					{
+						pfree(childattnos);
+						return 0;
+					}
+					childattnos[i] = var->varattno;
+				}
+
+				npushed = ExecHashJoinPushRuntimeFilterTo(outerPlanState(ps),
+														  filter, childattnos);
+				pfree(childattnos);
+				return npushed;
+			}
+
+		case T_AppendState:
+			{
+				AppendState *appendstate = (AppendState *) ps;
+				int			npushed = 0;
+
+				if (ps->ps_ProjInfo != NULL)
+					return 0;
+
+				for (i = appendstate->as_firstplan; i <= appendstate->as_lastplan; i++)
+				{
+					if (appendstate->appendplans[i] != NULL)
+						npushed += ExecHashJoinPushRuntimeFilterTo(appendstate->appendplans[i],
+																   filter, attnos);
+				}
+				return npushed;
+			}
+
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Set up the runtime filter of an inner or IN hash join, if any scan on its
+ * outer side can use it.  See hashjoin.h.
+ */
+static void
+ExecHashJoinPushRuntimeFilter(HashJoinState *hjstate)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	HashJoinRuntimeFilter *filter;
+	AttrNumber *attnos;
+	Expr	   *outerkey = NULL;
+	Expr	   *innerkey = NULL;
+	ListCell   *lc;
+	int			nkeys;
+	int			i;
+
+	if (node->join.jointype != JOIN_INNER && node->join.jointype != JOIN_IN)
+		return;
+	if (hjstate->hj_nonequijoin || node->hashqualclauses != NIL)
+		return;
+
+	nkeys = list_length(node->hashclauses);
+	if (nkeys == 0)
+		return;
+
+	/* The outer keys must be columns of the outer tuples. */
+	attnos = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+	i = 0;
+	foreach(lc, node->hashclauses)
+	{
+		OpExpr	   *clause = (OpExpr *) lfirst(lc);
+		Var		   *var;
+
+		Assert(IsA(clause, OpExpr));
+		outerkey = (Expr *) linitial(clause->args);
+		innerkey = (Expr *) lsecond(clause->args);
+
+		var = (Var *) runtime_filter_strip_relabel(outerkey);
+		if (!IsA(var, Var) || var->varno != OUTER || !op_strict(clause->opno))
+		{
+			pfree(attnos);
+			return;
+		}
+		attnos[i++] = var->varattno;
+	}
+
+	filter = (HashJoinRuntimeFilter *) palloc0(sizeof(HashJoinRuntimeFilter));
+	filter->nkeys = nkeys;
+	filter->mcxt = CurrentMemoryContext;
+	filter->outer_hashfunctions = (FmgrInfo *) palloc(nkeys * sizeof(FmgrInfo));
+	filter->hashStrict = (bool *) palloc(nkeys * sizeof(bool));
+
+	i = 0;
+	foreach(lc, hjstate->hj_HashOperators)
+	{
+		Oid			hashop = lfirst_oid(lc);
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hashop);
+		fmgr_info(left_hashfn, &filter->outer_hashfunctions[i]);
+		filter->hashStrict[i] = op_strict(hashop);
+		i++;
+	}
+
+	/* A single integer key also gets a range check. */
+	if (nkeys == 1 &&
+		runtime_filter_range_type(exprType((Node *) outerkey)) &&
+		runtime_filter_range_type(exprType((Node *) innerkey)))
+	{
+		filter->rangeKey = (ExprState *) linitial(hjstate->hj_InnerHashKeys);
+		filter->outerRangeType = exprType((Node *) outerkey);
+		filter->innerRangeType = exprType((Node *) innerkey);
+	}
+
+	if (ExecHashJoinPushRuntimeFilterTo(outerPlanState(hjstate), filter, attnos) == 0)
+	{
+		pfree(filter->outer_hashfunctions);
+		pfree(filter->hashStrict);
+		pfree(filter);
+	}
+	else
+	{
+		hjstate->hj_RuntimeFilter = filter;
+		((HashState *) innerPlanState(hjstate))->hs_runtimeFilter = filter;
+	}
+	pfree(attnos);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitHashJoin
  *
@@ -608,6 +859,9 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rclauses;
 
+	if (gp_hashjoin_runtime_filter)
+		ExecHashJoinPushRuntimeFilter(hjstate);
+
 	hjstate->js.ps.ps_OuterTupleSlot = NULL;
 	hjstate->hj_NeedNewOuter = true;
 	hjstate->hj_MatchedOuter = false;
@@ -649,6 +903,9 @@ ExecEndHashJoin(HashJoinState *node)
 		node->hj_HashTable = NULL;
 	}
 
+	if (node->hj_RuntimeFilter)
+		ExecHashRuntimeFilterReport(node->hj_RuntimeFilter);
+
 	/*
 	 * Free the exprcontext
 	 */
@@ -680,6 +937,9 @@ ExecEndHashJoin(HashJoinState *node)
  * Returns a null slot if no more outer tuples.  On success, the tuple's
  * hash value is stored at *hashvalue --- this is either originally computed,
  * or re-read from the temp file.
+ *
+ * If the roles of the current batch are reversed, this returns the inner
+ * tuples of the batch instead, in hj_HashTupleSlot.
  */
 static TupleTableSlot *
 ExecHashJoinOuterGetTuple(PlanState *outerNode,
@@ -776,9 +1036,14 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 		if (QueryFinishPending)
 			return NULL;
 
-		slot = ExecHashJoinGetSavedTuple(&hashtable->batches[curbatch]->outerside,
-										 hashvalue,
-										 hjstate->hj_OuterTupleSlot);
+		if (hashtable->reversed)
+			slot = ExecHashJoinGetSavedTuple(&hashtable->batches[curbatch]->innerside,
+											 hashvalue,
+											 hjstate->hj_HashTupleSlot);
+		else
+			slot = ExecHashJoinGetSavedTuple(&hashtable->batches[curbatch]->outerside,
+											 hashvalue,
+											 hjstate->hj_OuterTupleSlot);
 		if (!TupIsNull(slot))
 			return slot;
 		curbatch = ExecHashJoinNewBatch(hjstate);
@@ -829,8 +1094,8 @@ start_over:
 	if (curbatch > 0)
 	{
 		/*
-		 * We no longer need the previous outer batch file; close it right
-		 * away to free disk space.
+		 * We no longer need the previous outer batch file (or inner one, if
+		 * the batch was reversed); close it right away to free disk space.
 		 */
 		batch = hashtable->batches[curbatch];
 		if (batch->outerside.workfile != NULL)
@@ -838,7 +1103,13 @@ start_over:
 			workfile_mgr_close_file(hashtable->work_set, batch->outerside.workfile);
 		}
 		batch->outerside.workfile = NULL;
+		if (batch->innerside.workfile != NULL)
+		{
+			workfile_mgr_close_file(hashtable->work_set, batch->innerside.workfile);
+		}
+		batch->innerside.workfile = NULL;
 	}
+	hashtable->reversed = false;
 
 	/*
 	 * We can always skip over any batches that are completely empty on both
@@ -906,6 +1177,77 @@ start_over:
      */
     ExecHashTableReset(hashState, hashtable);
 
+	if (ExecHashJoinReverseBatch(hjstate, batch))
+	{
+		bool result;
+
+		/*
+		 * Build the hash table from the outer batch instead, and probe it
+		 * with the inner batch.  Outer tuples that now belong to a later
+		 * batch are passed on to it.
+		 */
+		hashtable->reversed = true;
+		if (hashtable->stats)
+			hashtable->stats->reversedbatches++;
+
+		result = ExecWorkFile_Rewind(batch->outerside.workfile);
+		if (!result)
+		{
+			ereport(ERROR, (errcode_for_file_access(),
+					errmsg("could not access temporary file")));
+		}
+
+		for (;;)
+		{
+			int			bucketno;
+			int			batchno;
+
+			CHECK_FOR_INTERRUPTS();
+
+			if (QueryFinishPending)
+				return nbatch;
+
+			slot = ExecHashJoinGetSavedTuple(&batch->outerside,
+					&hashvalue,
+					hjstate->hj_OuterTupleSlot);
+			if (!slot)
+				break;
+
+			ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+			if (batchno == curbatch)
+				ExecHashTableInsertReversed(hashState, hashtable, slot, hashvalue);
+			else
+			{
+				Assert(batchno > curbatch);
+				ExecHashJoinSaveTuple(&hjstate->js.ps, ExecFetchSlotMemTuple(slot, false),
+									  hashvalue,
+									  hashtable,
+									  &hashtable->batches[batchno]->outerside,
+									  hashtable->bfCxt);
+			}
+		}
+
+		if (hjstate->js.ps.instrument)
+		{
+			Assert(hashtable->stats);
+			hashtable->stats->batchstats[curbatch].innerfilesize =
+				ExecWorkFile_Tell64(batch->outerside.workfile);
+		}
+		workfile_mgr_close_file(hashtable->work_set, batch->outerside.workfile);
+		batch->outerside.workfile = NULL;
+
+		ExecHashTableCluster(hashState, hashtable);
+
+		result = ExecWorkFile_Rewind(batch->innerside.workfile);
+		if (!result)
+		{
+			ereport(ERROR, (errcode_for_file_access(),
+					errmsg("could not access temporary file")));
+		}
+
+		return curbatch;
+	}
+
 	if (batch->innerside.workfile != NULL)
 	{
 		/* Rewind batch file */
@@ -950,6 +1292,8 @@ start_over:
 		}
 	    workfile_mgr_close_file(hashtable->work_set, batch->innerside.workfile);
 	    batch->innerside.workfile = NULL;
+
+		ExecHashTableCluster(hashState, hashtable);
 	}
 
     /*
@@ -971,6 +1315,37 @@ start_over:
     return curbatch;
 }
 
+/*
+ * ExecHashJoinReverseBatch
+ *		should the current batch be joined with its roles reversed?
+ *
+ * A batch of an inner join can just as well build its hash table from the
+ * outer side and probe it with the inner side.  That is worth it when the
+ * outer side is the smaller one and fits in memory: the table is smaller,
+ * and an inner side too large for memory is not split again by
+ * ExecHashIncreaseNumBatches, which would write its tuples out once more.
+ */
+static bool
+ExecHashJoinReverseBatch(HashJoinState *hjstate, HashJoinBatchData *batch)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	double		innerspace;
+	double		outerspace;
+
+	if (!gp_hashjoin_reverse_batches ||
+		hjstate->js.jointype != JOIN_INNER ||
+		batch->innerside.workfile == NULL ||
+		batch->outerside.workfile == NULL)
+		return false;
+
+	innerspace = batch->innerside.total_bytes +
+		(double) batch->innerside.total_tuples * HJTUPLE_OVERHEAD;
+	outerspace = batch->outerside.total_bytes +
+		(double) batch->outerside.total_tuples * HJTUPLE_OVERHEAD;
+
+	return outerspace < innerspace && outerspace <= hashtable->spaceAllowed;
+}
+
 /*
  * ExecHashJoinSaveTuple
  *		save a tuple to a batch file.
@@ -1036,6 +1411,7 @@ ExecHashJoinSaveTuple(PlanState *ps, MemTuple tuple, uint32 hashvalue,
 	}
 
 	batchside->total_tuples++;
+	batchside->total_bytes += memtuple_get_size(tuple, NULL);
 
 	if(ps)
 	{
@@ -1133,6 +1509,10 @@ ExecReScanHashJoin(HashJoinState *node, ExprContext *exprCtxt)
 			pfree(node->hj_HashTable);
 			node->hj_HashTable = NULL;
 
+			/* the filter is stale until the hash table is rebuilt */
+			if (node->hj_RuntimeFilter)
+				node->hj_RuntimeFilter->ready = false;
+
 			/*
 			 * if chgParam of subnode is not null then plan will be re-scanned
 			 * by first ExecProcNode.
@@ -12,7 +12,6 @@
 
 #include "access/heapam.h"
 #include "nodes/execnodes.h" /* Slice, SliceTable */
-#include "cdb/cdbheap.h"
 #include "cdb/cdbmotion.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
@@ -46,23 +45,6 @@
 #include "lib/stringinfo.h"     /* StringInfo */
 #endif
 
-/*
- * CdbTupleHeapInfo
- *
- * A priority queue element holding the next tuple of the
- * sorted tuple stream received from a particular sender.
- * Used by sorted receiver (Merge Receive).
- */
-typedef struct CdbTupleHeapInfo
-{
-	/* Next tuple from this sender */
-    HeapTuple	tuple;
-
-    /* Which sender did this tuple come from? */
-	int			sourceRouteId;
-
-} CdbTupleHeapInfo;
-
 /*
  * CdbMergeComparatorContext
  *
@@ -100,6 +82,52 @@ CdbMergeComparator_CreateContext(TupleDesc      tupDesc,
 static void
 CdbMergeComparator_DestroyContext(CdbMergeComparatorContext *ctx);
 
+/*
+ * Number of tuples a sorted receiver takes from a sender's chunk sorter
+ * queue in one go.
+ */
+#define MOTION_MERGE_BATCH	32
+
+/*
+ * CdbMergeSource
+ *
+ * The sorted tuple stream received from one sender, as seen by the merge.
+ * Tuples are taken from the motion layer in runs of up to MOTION_MERGE_BATCH,
+ * and the first sort key of each is extracted once, as the run is received,
+ * so that most comparisons in the merge don't have to touch the tuples.
+ * Used by sorted receiver (Merge Receive).
+ */
+typedef struct CdbMergeSource
+{
+	HeapTuple	tuples[MOTION_MERGE_BATCH];	/* received, not yet returned */
+	Datum		datum1[MOTION_MERGE_BATCH];	/* first sort key of tuples[i] */
+	bool		isnull1[MOTION_MERGE_BATCH];
+	int			ntuples;		/* number of valid entries in tuples[] */
+	int			next;			/* index of this sender's current tuple */
+	int			routeId;		/* which sender is this? */
+	bool		eos;			/* sender has sent end-of-stream */
+} CdbMergeSource;
+
+/*
+ * CdbMergeTree
+ *
+ * Loser tree (tournament tree) over the senders of a sorted motion.  Each
+ * internal node losers[1..nsources-1] holds the source that lost the match
+ * played there; losers[0] holds the overall winner, i.e. the source whose
+ * current tuple is to be returned next.  After the winner advances, only
+ * the matches on its path to the root are replayed, which costs
+ * log2(nsources) comparisons per tuple.  A source at end-of-stream loses
+ * against every other source.
+ * Used by sorted receiver (Merge Receive).
+ */
+typedef struct CdbMergeTree
+{
+	CdbMergeComparatorContext *cmpctx;
+	int			nsources;
+	CdbMergeSource *sources;
+	int		   *losers;
+} CdbMergeTree;
+
 
 /*=========================================================================
  * FUNCTIONS PROTOTYPES
@@ -112,8 +140,13 @@ static TupleTableSlot *execMotionSortedReceiver_mk(MotionState * node);
 static void execMotionSortedReceiverFirstTime(MotionState * node);
 
 static int
-CdbMergeComparator(void *lhs, void *rhs, void *context);
+CdbMergeComparator(CdbMergeComparatorContext *ctx,
+				   HeapTuple ltup, HeapTuple rtup, int firstKey);
+static int	CdbMergeTree_Compare(CdbMergeTree *tree, int lsrc, int rsrc);
+static void CdbMergeTree_Replay(CdbMergeTree *tree, int src);
+static void CdbMergeSource_Fill(MotionState *node, CdbMergeSource *source);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h);
+static int	cmp_uint32(const void *a, const void *b);
 
 static void doSendEndOfStream(Motion * motion, MotionState * node);
 static void doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
@@ -503,6 +536,9 @@ typedef struct MotionMKHeapReaderContext
 {
     MotionState *node;
     int srcRoute;
+    HeapTuple batch[MOTION_MERGE_BATCH];   /* received, not yet given to the heap */
+    int nbatch;
+    int next;
 } MotionMKHeapReaderContext;
 
 typedef struct MotionMKHeapContext
@@ -517,10 +553,8 @@ static bool motion_mkhp_read(void *vpctxt, MKEntry *a)
     MotionMKHeapReaderContext *ctxt = (MotionMKHeapReaderContext *) vpctxt;
     MotionState *node = ctxt->node;
 
-    HeapTuple inputTuple = NULL;
 	Motion *motion = (Motion *) node->ps.plan;
 
-    ReceiveReturnCode recvRC;
     if ( ctxt->srcRoute < 0 )
     {
     	/* routes have not been set yet so set them */
@@ -549,20 +583,26 @@ static bool motion_mkhp_read(void *vpctxt, MKEntry *a)
 
     MemSet(a, 0, sizeof(MKEntry));
 
-    /* Receive the successor of the tuple that we returned last time. */
-    recvRC = RecvTupleFrom(node->ps.state->motionlayer_context,
-							   node->ps.state->interconnect_context,
-							   motion->motionID, 
-							   &inputTuple,
-							   ctxt->srcRoute);
-
-    if (recvRC == GOT_TUPLE)
+    /*
+     * Receive the successor of the tuple that we returned last time, taking
+     * along whatever else this sender has queued up already.
+     */
+    if (ctxt->next >= ctxt->nbatch)
     {
-        a->ptr = inputTuple;
-        return true;
+        ctxt->nbatch = RecvTupleBatchFrom(node->ps.state->motionlayer_context,
+                                          node->ps.state->interconnect_context,
+                                          motion->motionID,
+                                          ctxt->batch,
+                                          MOTION_MERGE_BATCH,
+                                          ctxt->srcRoute);
+        ctxt->next = 0;
+        if (ctxt->nbatch == 0)
+            return false;
     }
 
-    return false;
+    a->ptr = ctxt->batch[ctxt->next];
+    ctxt->batch[ctxt->next++] = NULL;
+    return true;
 }
 
 static Datum tupsort_fetch_datum_motion(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut)
@@ -603,7 +643,7 @@ static void create_motion_mk_heap(MotionState *node)
 
     for(i=0; i<nreader; ++i)
     {
-        MotionMKHeapReaderContext *hrctxt = palloc(sizeof(MotionMKHeapContext));
+        MotionMKHeapReaderContext *hrctxt = palloc0(sizeof(MotionMKHeapReaderContext));
 
         hrctxt->node = node;
         hrctxt->srcRoute = -1; /* set to a negative to indicate that we need to update it to the real value */
@@ -663,22 +703,20 @@ execMotionSortedReceiver_mk(MotionState * node)
     return slot;
 }
     
-/* Sorted receiver using CdbHeap */
+/* Sorted receiver using a loser tree */
 static TupleTableSlot *
 execMotionSortedReceiver(MotionState * node)
 {
 	TupleTableSlot *slot;
-    CdbHeap        *hp = (CdbHeap *) node->tupleheap;
-	HeapTuple	tuple,
-				inputTuple;
+    CdbMergeTree   *tree = (CdbMergeTree *) node->tupleheap;
+    CdbMergeSource *source;
+	HeapTuple	tuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
-	ReceiveReturnCode recvRC;
-	CdbTupleHeapInfo *tupHeapInfo;
 
 	AssertState(motion->motionType == MOTIONTYPE_FIXED &&
 			motion->numOutputSegs <= 1 &&
 			motion->sendSorted &&
-			hp != NULL);
+			tree != NULL);
 
 	/* Notify senders and return EOS if caller doesn't want any more data. */
     if (node->stopRequested)
@@ -690,67 +728,34 @@ execMotionSortedReceiver(MotionState * node)
 		return NULL;
 	}
 
-	/* On first call, fill the priority queue with each sender's first tuple. */
+	/* On first call, receive from every sender and play the tournament. */
 	if (!node->tupleheapReady)
 	{
 		execMotionSortedReceiverFirstTime(node);
 	}
 
     /*
-     * Delete from the priority queue the element that we fetched last
-     * time.  Receive and insert the next tuple from that same sender.
+     * Advance the sender whose tuple we returned last time, receiving more
+     * from it if its run is used up, and replay its path of the tree.
      */
     else
 	{
-        /* Old element is still at the head of the pq. */
-        AssertState(NULL != (tupHeapInfo = CdbHeap_Min(CdbTupleHeapInfo, hp)) &&
-                    tupHeapInfo->tuple == NULL &&
-                    tupHeapInfo->sourceRouteId == node->routeIdNext);
-
-        /* Receive the successor of the tuple that we returned last time. */
-        recvRC = RecvTupleFrom(node->ps.state->motionlayer_context,
-							   node->ps.state->interconnect_context,
-							   motion->motionID, 
-							   &inputTuple,
-							   node->routeIdNext);
-
-        /* Substitute it in the pq for its predecessor. */
-		if (recvRC == GOT_TUPLE)
-		{
-            CdbTupleHeapInfo info;
-
-            info.tuple = inputTuple;
-            info.sourceRouteId = node->routeIdNext;
-
-            CdbHeap_DeleteMinAndInsert(hp, &info);
+        source = &tree->sources[tree->losers[0]];
 
-            node->numTuplesFromAMS++;
+        /* Old winner is still at the root of the tree. */
+        AssertState(!source->eos &&
+                    source->tuples[source->next] == NULL &&
+                    source->routeId == node->routeIdNext);
 
-#ifdef CDB_MOTION_DEBUG
-            if (node->numTuplesFromAMS <= 20)
-            {
-                StringInfoData  buf;
-
-                initStringInfo(&buf);
-                appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
-                                 motion->motionID,
-                                 node->routeIdNext,
-                                 node->numTuplesFromAMS);
-                formatTuple(&buf, inputTuple, ExecGetResultType(&node->ps),
-                            node->outputFunArray);
-                elog(DEBUG3, buf.data);
-                pfree(buf.data);
-            }
-#endif
-		}
+        if (++source->next >= source->ntuples)
+            CdbMergeSource_Fill(node, source);
 
-        /* At EOS, drop this sender from the priority queue. */
-        else if (!CdbHeap_IsEmpty(hp))
-            CdbHeap_DeleteMin(hp);
+        CdbMergeTree_Replay(tree, tree->losers[0]);
 	}
 
     /* Finished if all senders have returned EOS. */
-    if (CdbHeap_IsEmpty(hp))
+    source = &tree->sources[tree->losers[0]];
+    if (source->eos)
     {
         Assert(node->numTuplesFromAMS == node->numTuplesToParent);
 		Assert(node->numTuplesFromChild == 0);
@@ -759,26 +764,28 @@ execMotionSortedReceiver(MotionState * node)
     }
 
     /*
-     * Our next result tuple, with lowest key among all senders, is now
-     * at the head of the priority queue.  Get it from there.
+     * Our next result tuple, with lowest key among all senders, is the
+     * current tuple of the winning sender.
      *
-     * We transfer ownership of the tuple from the pq element to
-     * our caller, but the pq element itself will remain in place
-     * until the next time we are called, to avoid an unnecessary
-     * rearrangement of the priority queue.
+     * We transfer ownership of the tuple from the sender's run to our
+     * caller, but the sender stays at the root of the tree until the next
+     * time we are called, so that we don't block receiving its successor
+     * before the caller has had this one.
      */
-	tupHeapInfo = CdbHeap_Min(CdbTupleHeapInfo, hp);	
-    tuple = tupHeapInfo->tuple;
-	node->routeIdNext = tupHeapInfo->sourceRouteId;
+    tuple = source->tuples[source->next];
+	node->routeIdNext = source->routeId;
 
-    /* Zap dangling tuple ptr for safety. PQ element doesn't own it anymore. */
-    tupHeapInfo->tuple = NULL;
+    /* Zap dangling tuple ptr for safety. The run doesn't own it anymore. */
+    source->tuples[source->next] = NULL;
 
     /* Update counters. */
     node->numTuplesToParent++;
 
-    /* Store tuple in our result slot. */
-    slot = outerPlanState(node)->ps_ResultTupleSlot;
+    /*
+     * Store tuple in our result slot.  Don't use the child's slot: with
+     * gp_enable_slice_plan_dispatch a receiving Motion has no child here.
+     */
+    slot = node->ps.ps_ResultTupleSlot;
     slot = ExecStoreGenericTuple(tuple, slot, true /* shouldFree */);
 
 #ifdef CDB_MOTION_DEBUG
@@ -806,70 +813,64 @@ execMotionSortedReceiver(MotionState * node)
 void
 execMotionSortedReceiverFirstTime(MotionState * node)
 {
-	HeapTuple	inputTuple;
-    CdbHeap    *hp = (CdbHeap *) node->tupleheap;
+    CdbMergeTree *tree = (CdbMergeTree *) node->tupleheap;
 	Motion	   *motion = (Motion *) node->ps.plan;
 	int			iSegIdx;
     int         n = 0;
+    int         k = tree->nsources;
+    int        *winners;
     ListCell *lcProcess;
 
-	ReceiveReturnCode recvRC;
-
 	Slice *sendSlice = (Slice *)list_nth(node->ps.state->es_sliceTable->slices, motion->motionID);
 	Assert(sendSlice->sliceIndex == motion->motionID);
 
 	/*
-	 * We need to get a tuple from every sender, and stick it into the heap.
+	 * We need to get the first run of tuples from every sender.
 	 */
 	foreach_with_count(lcProcess, sendSlice->primaryProcesses, iSegIdx)
 	{
 		if ( lfirst(lcProcess) == NULL)
 			continue; /* skip this one: we are not receiving from it */
 
+		Assert(n < k);
+
 		/*
 		 * another place where we are mapping segid space to routeid space. so
 		 * route[x] = inputSegIdx[x] now.
 		 */
-		recvRC = RecvTupleFrom(node->ps.state->motionlayer_context,
-							   node->ps.state->interconnect_context,
-							   motion->motionID, &inputTuple, iSegIdx);
-
-		if (recvRC == GOT_TUPLE)
-		{
-            CdbTupleHeapInfo   *infoArray = (CdbTupleHeapInfo *)hp->slotArray;
-            CdbTupleHeapInfo   *info = &infoArray[n];
-            n++;
-
-            info->tuple = inputTuple;
-            info->sourceRouteId = iSegIdx;
-
-            node->numTuplesFromAMS++;
-
-#ifdef CDB_MOTION_DEBUG
-            if (node->numTuplesFromAMS <= 20)
-            {
-                StringInfoData  buf;
-
-                initStringInfo(&buf);
-                appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
-                                 motion->motionID,
-                                 iSegIdx,
-                                 node->numTuplesFromAMS);
-                formatTuple(&buf, inputTuple, ExecGetResultType(&node->ps),
-                            node->outputFunArray);
-                elog(DEBUG3, buf.data);
-                pfree(buf.data);
-            }
-#endif
-		}
+		tree->sources[n].routeId = iSegIdx;
+		CdbMergeSource_Fill(node, &tree->sources[n]);
+		n++;
 	}
 	Assert(iSegIdx == node->numInputSegs);
+	Assert(n == k);
 
     /*
-     * Rearrange the infoArray to satisfy the heap property.
-     * This is quicker than inserting the initial elements one by one.
+     * Play the initial tournament bottom-up.  winners[k + i] is leaf i;
+     * winners[j] for 0 < j < k is the winner of the match at internal node
+     * j, whose loser is kept in the tree.
      */
-    CdbHeap_Heapify(hp, n);
+    winners = (int *) palloc(2 * k * sizeof(int));
+    for (n = 0; n < k; n++)
+        winners[k + n] = n;
+    for (n = k - 1; n > 0; n--)
+    {
+        int     l = winners[2 * n];
+        int     r = winners[2 * n + 1];
+
+        if (CdbMergeTree_Compare(tree, r, l) < 0)
+        {
+            winners[n] = r;
+            tree->losers[n] = l;
+        }
+        else
+        {
+            winners[n] = l;
+            tree->losers[n] = r;
+        }
+    }
+    tree->losers[0] = (k > 1) ? winners[1] : 0;
+    pfree(winners);
 
 	node->tupleheapReady = true;
 }                               /* execMotionSortedReceiverFirstTime */
@@ -915,6 +916,8 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	motionstate->stopRequested = false;
 	motionstate->hashExpr = NULL;
 	motionstate->cdbhash = NULL;
+	motionstate->hotHashes = NULL;
+	motionstate->numHotHashes = 0;
 
     /* Look up the sending gang's slice table entry. */
     sendSlice = (Slice *)list_nth(sliceTable->slices, node->motionID);
@@ -1029,6 +1032,25 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 		 * Create hash API reference
 		 */
 		motionstate->cdbhash = makeCdbHash(node->numOutputSegs);
+
+		/*
+		 * Hot keys are looked up by binary search for every tuple.  Start
+		 * spreading at our own segment so that the senders don't all pick
+		 * the same first route.
+		 */
+		if (node->skewType != MOTIONSKEW_NONE && node->hotHashes != NIL)
+		{
+			ListCell   *lc;
+			int			i = 0;
+
+			motionstate->numHotHashes = list_length(node->hotHashes);
+			motionstate->hotHashes = palloc(motionstate->numHotHashes * sizeof(uint32));
+			foreach(lc, node->hotHashes)
+				motionstate->hotHashes[i++] = (uint32) lfirst_int(lc);
+			qsort(motionstate->hotHashes, motionstate->numHotHashes,
+				  sizeof(uint32), cmp_uint32);
+			motionstate->hotSpreadNext = (uint32) Max(GpIdentity.segindex, 0);
+		}
     }
 
 	/* Merge Receive: Set up the key comparator and priority queue. */
@@ -1038,21 +1060,25 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
             create_motion_mk_heap(motionstate);
         else
         {
-            CdbMergeComparatorContext  *mcContext;
+            CdbMergeTree   *tree;
+
+            tree = (CdbMergeTree *) palloc0(sizeof(*tree));
 
             /* Allocate context object for the key comparator. */
-            mcContext = CdbMergeComparator_CreateContext(tupDesc,
+            tree->cmpctx = CdbMergeComparator_CreateContext(tupDesc,
                     node->numSortCols,
                     node->sortColIdx,
 														 node->sortOperators,
 				node->nullsFirst);
 
-            /* Create the priority queue structure. */
-            motionstate->tupleheap = CdbHeap_Create(CdbMergeComparator,
-                    mcContext,
-                    motionstate->numInputSegs,
-                    sizeof(CdbTupleHeapInfo),
-                    NULL);
+            /* Create the loser tree with one source per sender. */
+            Assert(motionstate->numInputSegs >= 1);
+            tree->nsources = motionstate->numInputSegs;
+            tree->sources = (CdbMergeSource *)
+                palloc0(tree->nsources * sizeof(CdbMergeSource));
+            tree->losers = (int *) palloc0(tree->nsources * sizeof(int));
+
+            motionstate->tupleheap = tree;
         }
 	}
 
@@ -1188,9 +1214,27 @@ ExecEndMotion(MotionState * node)
             destroy_motion_mk_heap(node);
         else
         {
-            CdbHeap *hp = (CdbHeap *) node->tupleheap;
-            CdbMergeComparator_DestroyContext(hp->comparatorContext);
-            CdbHeap_Destroy(hp);
+            CdbMergeTree   *tree = (CdbMergeTree *) node->tupleheap;
+            int             i;
+            int             j;
+
+            /* Free tuples that were received but never returned. */
+            for (i = 0; i < tree->nsources; i++)
+            {
+                CdbMergeSource *source = &tree->sources[i];
+
+                for (j = source->next; j < source->ntuples; j++)
+                {
+                    if (source->tuples[j] != NULL)
+                        pfree(source->tuples[j]);
+                }
+            }
+
+            CdbMergeComparator_DestroyContext(tree->cmpctx);
+            pfree(tree->cmpctx);
+            pfree(tree->sources);
+            pfree(tree->losers);
+            pfree(tree);
         }
         node->tupleheap = NULL;
 	}
@@ -1201,6 +1245,11 @@ ExecEndMotion(MotionState * node)
 		pfree(node->cdbhash);
 		node->cdbhash = NULL;
 	}
+	if (node->hotHashes != NULL)
+	{
+		pfree(node->hotHashes);
+		node->hotHashes = NULL;
+	}
 
 	/*
 	 * Free up this motion node's resources in the Motion Layer.
@@ -1231,16 +1280,13 @@ ExecEndMotion(MotionState * node)
 
 /*
  * CdbMergeComparator:
- * Used to compare tuples for a sorted motion node.
+ * Used to compare tuples for a sorted motion node, starting at the
+ * firstKey'th sort column.
  */
 int
-CdbMergeComparator(void *lhs, void *rhs, void *context)
+CdbMergeComparator(CdbMergeComparatorContext *ctx,
+                   HeapTuple ltup, HeapTuple rtup, int firstKey)
 {
-    CdbMergeComparatorContext  *ctx = (CdbMergeComparatorContext *)context;
-    CdbTupleHeapInfo   *linfo = (CdbTupleHeapInfo *) lhs;
-    CdbTupleHeapInfo   *rinfo = (CdbTupleHeapInfo *) rhs;
-    HeapTuple           ltup = linfo->tuple;
-    HeapTuple           rtup = rinfo->tuple;
     FmgrInfo           *sortFunctions;
 	int				   *cmpFlags;
     int                 numSortCols;
@@ -1256,7 +1302,7 @@ CdbMergeComparator(void *lhs, void *rhs, void *context)
     sortColIdx      = ctx->sortColIdx;
     tupDesc         = ctx->tupDesc;
 
-    for (nkey = 0; nkey < numSortCols; nkey++)
+    for (nkey = firstKey; nkey < numSortCols; nkey++)
     {
         AttrNumber  attno = sortColIdx[nkey];
         Datum       datum1,
@@ -1288,6 +1334,117 @@ CdbMergeComparator(void *lhs, void *rhs, void *context)
                                /* CdbMergeComparator */
 
 
+/*
+ * CdbMergeTree_Compare:
+ * Compare the current tuples of two merge sources.  The first sort key was
+ * extracted when the tuples were received; the tuples themselves are only
+ * looked at to break ties on it.
+ */
+static int
+CdbMergeTree_Compare(CdbMergeTree *tree, int lsrc, int rsrc)
+{
+    CdbMergeComparatorContext  *ctx = tree->cmpctx;
+    CdbMergeSource *l = &tree->sources[lsrc];
+    CdbMergeSource *r = &tree->sources[rsrc];
+    int32           compare;
+
+    /* A sender at end-of-stream sorts after everything else. */
+    if (l->eos || r->eos)
+        return (int) l->eos - (int) r->eos;
+
+    compare = ApplySortFunction(&ctx->sortFunctions[0],
+                                ctx->cmpFlags[0],
+                                l->datum1[l->next], l->isnull1[l->next],
+                                r->datum1[r->next], r->isnull1[r->next]);
+    if (compare != 0 || ctx->numSortCols == 1)
+        return compare;
+
+    return CdbMergeComparator(ctx, l->tuples[l->next], r->tuples[r->next], 1);
+}                               /* CdbMergeTree_Compare */
+
+
+/*
+ * CdbMergeTree_Replay:
+ * The current tuple of source src has changed; replay the matches on its
+ * path from the leaf to the root and store the new overall winner.
+ */
+static void
+CdbMergeTree_Replay(CdbMergeTree *tree, int src)
+{
+    int     winner = src;
+    int     n;
+
+    for (n = (tree->nsources + src) / 2; n > 0; n /= 2)
+    {
+        int     loser = tree->losers[n];
+
+        if (CdbMergeTree_Compare(tree, loser, winner) < 0)
+        {
+            tree->losers[n] = winner;
+            winner = loser;
+        }
+    }
+    tree->losers[0] = winner;
+}                               /* CdbMergeTree_Replay */
+
+
+/*
+ * CdbMergeSource_Fill:
+ * Receive the next run of tuples from a sender, blocking until at least one
+ * is available or the sender reaches end-of-stream, and extract their first
+ * sort key.
+ */
+static void
+CdbMergeSource_Fill(MotionState *node, CdbMergeSource *source)
+{
+    CdbMergeTree   *tree = (CdbMergeTree *) node->tupleheap;
+    CdbMergeComparatorContext  *ctx = tree->cmpctx;
+	Motion	   *motion = (Motion *) node->ps.plan;
+    AttrNumber      attno = ctx->sortColIdx[0];
+    int             i;
+
+    source->ntuples = RecvTupleBatchFrom(node->ps.state->motionlayer_context,
+                                         node->ps.state->interconnect_context,
+                                         motion->motionID,
+                                         source->tuples,
+                                         MOTION_MERGE_BATCH,
+                                         source->routeId);
+    source->next = 0;
+    source->eos = (source->ntuples == 0);
+
+    for (i = 0; i < source->ntuples; i++)
+    {
+        HeapTuple   tup = source->tuples[i];
+
+        if (is_heaptuple_memtuple(tup))
+            source->datum1[i] = memtuple_getattr((MemTuple) tup, ctx->mt_bind,
+                                                 attno, &source->isnull1[i]);
+        else
+            source->datum1[i] = heap_getattr(tup, attno, ctx->tupDesc,
+                                             &source->isnull1[i]);
+
+        node->numTuplesFromAMS++;
+
+#ifdef CDB_MOTION_DEBUG
+        if (node->numTuplesFromAMS <= 20)
+        {
+            StringInfoData  buf;
+
+            initStringInfo(&buf);
+            appendStringInfo(&buf, "   motion%-3d rcv<-%-3d %5d.",
+                             motion->motionID,
+                             source->routeId,
+                             node->numTuplesFromAMS);
+            formatTuple(&buf, tup, ExecGetResultType(&node->ps),
+                        node->outputFunArray);
+            elog(DEBUG3, buf.data);
+            pfree(buf.data);
+        }
+#endif
+    }
+}                               /* CdbMergeSource_Fill */
+
+
 /* Create context object for use by CdbMergeComparator */
 CdbMergeComparatorContext *
 CdbMergeComparator_CreateContext(TupleDesc      tupDesc,
@@ -1404,6 +1561,19 @@ evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h)
 	return cdbhashreduce(h);
 }
 
+/*
+ * qsort/bsearch comparator for the hot key hash array.
+ */
+static int
+cmp_uint32(const void *a, const void *b)
+{
+	uint32		va = *(const uint32 *) a;
+	uint32		vb = *(const uint32 *) b;
+
+	if (va == vb)
+		return 0;
+	return (va < vb) ? -1 : 1;
+}
 
 void
 doSendEndOfStream(Motion * motion, MotionState * node)
@@ -1551,6 +1721,20 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 		 * makeDefaultSegIdxArray() in cdbmutate.c (it is the trivial
 		 * map, and is passed around our system a fair amount!). */
 		Assert(targetRoute != BROADCAST_SEGIDX);
+
+		/*
+		 * Hot key of a skew-spreading hash join: the probe side spreads
+		 * it over all segments, the build side sends it everywhere.
+		 */
+		if (node->numHotHashes > 0 &&
+			bsearch(&node->cdbhash->hash, node->hotHashes, node->numHotHashes,
+					sizeof(uint32), cmp_uint32) != NULL)
+		{
+			if (motion->skewType == MOTIONSKEW_BROADCAST)
+				targetRoute = BROADCAST_SEGIDX;
+			else
+				targetRoute = motion->outputSegIdx[node->hotSpreadNext++ % motion->numOutputSegs];
+		}
 	}
 	else /* ExplicitRedistribute */
 	{
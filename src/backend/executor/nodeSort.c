@@ -20,6 +20,8 @@
 #include "executor/nodeSort.h"
 #include "lib/stringinfo.h"             /* StringInfo */
 #include "miscadmin.h"
+#include "parser/parsetree.h"
+#include "utils/lsyscache.h"
 #include "utils/tuplesort.h"
 #include "cdb/cdbvars.h" /* CDB *//* gp_sort_flags */
 #include "utils/workfile_mgr.h"
@@ -27,6 +29,7 @@
 #include "utils/faultinjector.h"
 
 static void ExecSortExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+static void ExecSortPushLimitFilter(SortState *sortstate);
 
 /* ----------------------------------------------------------------
  *		ExecSort
@@ -497,6 +500,15 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	ExecAssignScanTypeFromOuterPlan(&sortstate->ss);
 	sortstate->ss.ps.ps_ProjInfo = NULL;
 
+	/*
+	 * CDB: Whether the sort is bounded is only known when it starts, so
+	 * set up the filter for any sort that could be.
+	 */
+	sortstate->limitFilter = NULL;
+	if (gp_enable_mk_sort && gp_sort_limit_filter &&
+		!node->noduplicates && node->share_type == SHARE_NOTSHARED)
+		ExecSortPushLimitFilter(sortstate);
+
 	if(node->share_type != SHARE_NOTSHARED)
 	{
 		ShareNodeEntry *snEntry = ExecGetShareNodeEntry(estate, node->share_id, true);
@@ -512,6 +524,109 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	return sortstate;
 }
 
+/*
+ * Hand a LIMIT sort filter to the scan that the sort reads from, if the
+ * first sort key is a column of the scanned table.  See nodeSort.h.
+ */
+static void
+ExecSortPushLimitFilter(SortState *sortstate)
+{
+	Sort	   *node = (Sort *) sortstate->ss.ps.plan;
+	PlanState  *child = outerPlanState(sortstate);
+	SortLimitFilter *filter;
+	AttrNumber	scanAttno;
+	Oid			sortFunction;
+	bool		reverse;
+
+	switch (nodeTag(child))
+	{
+		case T_SeqScanState:
+		case T_AppendOnlyScanState:
+		case T_AOCSScanState:
+		case T_TableScanState:
+			break;
+		default:
+			return;
+	}
+
+	scanAttno = node->sortColIdx[0];
+	if (child->ps_ProjInfo != NULL)
+	{
+		TargetEntry *tle = get_tle_by_resno(child->plan->targetlist, scanAttno);
+		Var		   *var;
+
+		if (tle == NULL)
+			return;
+		var = (Var *) tle->expr;
+		if (!IsA(var, Var) || var->varattno <= 0)
+			return;
+		scanAttno = var->varattno;
+	}
+
+	if (!get_compare_function_for_ordering_op(node->sortOperators[0],
+											  &sortFunction, &reverse))
+		return;
+
+	filter = (SortLimitFilter *) palloc0(sizeof(SortLimitFilter));
+	filter->sortstate = sortstate;
+	filter->sortAttno = node->sortColIdx[0];
+	filter->scanAttno = scanAttno;
+	fmgr_info(sortFunction, &filter->cmpfunc);
+	filter->reverse = reverse;
+
+	sortstate->limitFilter = filter;
+	((ScanState *) child)->ss_sortLimitFilter = filter;
+}
+
+/*
+ * ExecSortLimitFilterPasses
+ *		Check a tuple of the scan below a LIMIT sort against the last tuple
+ *		that currently makes the cut.
+ */
+bool
+ExecSortLimitFilterPasses(SortLimitFilter *filter, ExprContext *econtext,
+						  TupleTableSlot *slot)
+{
+	SortState  *sortstate = filter->sortstate;
+	Tuplesortstate_mk *tuplesortstate;
+	MemoryContext oldContext;
+	Datum		threshold;
+	bool		thresholdIsNull;
+	Datum		value;
+	bool		isNull;
+	int32		cmp;
+
+	if (sortstate->sort_Done || sortstate->tuplesortstate == NULL)
+		return true;
+
+	tuplesortstate = sortstate->tuplesortstate->sortstore_mk;
+	if (tuplesortstate == NULL ||
+		!tuplesort_limit_threshold_mk(tuplesortstate, filter->sortAttno,
+									  &threshold, &thresholdIsNull) ||
+		thresholdIsNull)
+		return true;
+
+	value = slot_getattr(slot, filter->scanAttno, &isNull);
+	if (isNull)
+		return true;
+
+	filter->nchecked++;
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	cmp = DatumGetInt32(FunctionCall2(&filter->cmpfunc, value, threshold));
+	MemoryContextSwitchTo(oldContext);
+
+	if (filter->reverse)
+		cmp = -cmp;
+
+	if (cmp > 0)
+	{
+		filter->nrejected++;
+		return false;
+	}
+	return true;
+}
+
 int
 ExecCountSlotsSort(Sort *node)
 {
@@ -530,6 +645,10 @@ ExecEndSort(SortState *node)
 	SO1_printf("ExecEndSort: %s\n",
 			   "shutting down sort node");
 
+	if (node->limitFilter && node->limitFilter->nchecked > 0)
+		elog(DEBUG1, "sort limit filter rejected %.0f of %.0f input tuples",
+			 node->limitFilter->nrejected, node->limitFilter->nchecked);
+
 	ExecEagerFreeSort(node);
 
 	/*
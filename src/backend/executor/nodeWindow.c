@@ -96,6 +96,21 @@ typedef struct FrameBufferEntry
 	List	   *func_values;
 } FrameBufferEntry;
 
+/*
+ * An entry of the sliding aggregator of a function; see computeSlideAggs().
+ *
+ * 'value' is the preliminary value of a frame buffer entry, and 'suffix'
+ * combines the values from this entry up to the last entry of the front
+ * part of the aggregator.
+ */
+typedef struct SlideAggValue
+{
+	Datum		value;
+	bool		valueIsNull;
+	Datum		suffix;
+	bool		suffixIsNull;
+} SlideAggValue;
+
 /*
  * WindowStatePerLevelData - per-level working state
  */
@@ -239,6 +254,26 @@ typedef struct WindowStatePerLevelData
 	*/
 	char *serial_array;
 	Size max_size;
+
+	/*
+	 * State for the functions whose frame values are maintained by a sliding
+	 * aggregator instead of a scan of the frame buffer; see
+	 * computeSlideAggs().
+	 *
+	 * 'slide_pos' holds the frame buffer positions of the entries in the
+	 * aggregator, in [slide_head, slide_tail). The entries before
+	 * 'slide_split' are the front part, those from it on the back part.
+	 * 'slide_reader' points to the next frame buffer entry to be added.
+	 */
+	bool		has_slide_aggs;
+	MemoryContext slide_context;
+	Size		slide_max_bytes;
+	NTupleStoreAccessor *slide_reader;
+	NTupleStorePos *slide_pos;
+	int			slide_head;
+	int			slide_split;
+	int			slide_tail;
+	int			slide_size;
 }	WindowStatePerLevelData;
 
 /*
@@ -319,6 +354,16 @@ typedef struct WindowStatePerFunctionData
 	 * The total number of not NULL arguments for this function so far.
 	 */
 	uint64		numNotNulls;
+
+	/*
+	 * Indicate if the frame value is maintained by the sliding aggregator of
+	 * the level. 'slide_values' are its entries, indexed like 'slide_pos',
+	 * and 'slide_back' combines the values of its back part.
+	 */
+	bool		slide_agg;
+	SlideAggValue *slide_values;
+	Datum		slide_back;
+	bool		slide_backIsNull;
 }	WindowStatePerFunctionData;
 
 #define FRAME_TRAIL_ROWS	0
@@ -499,6 +544,7 @@ static void resetTransValues(WindowStatePerLevel level_state,
 				 WindowState * wstate);
 static void freeFrameBuffer(WindowFrameBuffer buffer);
 static void freeFrameBuffers(WindowState * wstate);
+static void resetSlideAggs(WindowStatePerLevel level_state);
 
 /*
  * WindowBufferCursor
@@ -683,6 +729,20 @@ createFrameBuffers(WindowState * wstate)
 			ntuplestore_create_accessor(level_state->frame_buffer->tuplestore, false);
 
 		level_state->frame_buffer->level_state = level_state;
+
+		if (level_state->has_slide_aggs)
+		{
+			level_state->slide_reader =
+				ntuplestore_create_accessor(level_state->frame_buffer->tuplestore, false);
+			level_state->slide_context =
+				AllocSetContextCreate(CurrentMemoryContext,
+									  "SlideAggContext",
+									  ALLOCSET_DEFAULT_MINSIZE,
+									  ALLOCSET_DEFAULT_INITSIZE,
+									  ALLOCSET_DEFAULT_MAXSIZE);
+			level_state->slide_max_bytes = bytes;
+			resetSlideAggs(level_state);
+		}
 	}
 }
 
@@ -747,6 +807,14 @@ resetFrameBuffers(WindowState * wstate)
 				ntuplestore_create_accessor(level_state->frame_buffer->tuplestore, false);
 			level_state->lead_reader =
 				ntuplestore_create_accessor(level_state->frame_buffer->tuplestore, false);
+
+			if (level_state->slide_reader)
+			{
+				ntuplestore_destroy_accessor(level_state->slide_reader);
+				level_state->slide_reader =
+					ntuplestore_create_accessor(level_state->frame_buffer->tuplestore, false);
+				resetSlideAggs(level_state);
+			}
 		}
 
 		level_state->num_trail_rows = 0;
@@ -791,6 +859,13 @@ freeFrameBuffers(WindowState * wstate)
 				ntuplestore_destroy_accessor(level_state->trail_reader);
 			if (level_state->lead_reader)
 				ntuplestore_destroy_accessor(level_state->lead_reader);
+			if (level_state->slide_reader)
+			{
+				ntuplestore_destroy_accessor(level_state->slide_reader);
+				level_state->slide_reader = NULL;
+				MemoryContextDelete(level_state->slide_context);
+				level_state->slide_context = NULL;
+			}
 
 			freeFrameBuffer(level_state->frame_buffer);
 			level_state->frame_buffer = NULL;
@@ -1883,6 +1958,440 @@ freeTransValue(Datum *transValue,
 	*noTransValue = true;
 }
 
+/*
+ * Sliding aggregator for frames that move forward.
+ *
+ * Aggregates like min() and max() have preliminary functions but no inverse
+ * preliminary functions, so the value of an entry that leaves the frame
+ * can not be removed from a transition value. Rather than scanning the
+ * whole frame for every row, such functions keep the preliminary values of
+ * the entries in the frame in a queue that is split in two parts. New
+ * entries are added to the back part, whose combined value is kept in
+ * 'slide_back'. Entries leave from the front part, each of which holds the
+ * combined value of itself and the entries after it in the front part.
+ * When the front part is empty, the back part becomes the front part and
+ * its combined values are computed once. So every entry is combined a
+ * constant number of times while it is in the frame, and the frame value is
+ * the front value of the queue combined with 'slide_back'.
+ */
+
+/*
+ * resetSlideAggs -- empty the sliding aggregator of a level.
+ */
+static void
+resetSlideAggs(WindowStatePerLevel level_state)
+{
+	ListCell   *lc;
+
+	MemoryContextReset(level_state->slide_context);
+	level_state->slide_pos = NULL;
+	level_state->slide_head = 0;
+	level_state->slide_split = 0;
+	level_state->slide_tail = 0;
+	level_state->slide_size = 0;
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+
+		funcstate->slide_values = NULL;
+		funcstate->slide_back = (Datum) 0;
+		funcstate->slide_backIsNull = true;
+	}
+}
+
+/*
+ * slidePosIsBefore -- return true if frame buffer position 'a' comes
+ * before 'b'.
+ */
+static inline bool
+slidePosIsBefore(NTupleStorePos *a, NTupleStorePos *b)
+{
+	return a->blockn < b->blockn ||
+		(a->blockn == b->blockn && a->slotn < b->slotn);
+}
+
+/*
+ * slideAggCombine -- combine two preliminary values of a function.
+ *
+ * The preliminary function is strict and the initial value is NULL, so
+ * NULL values are skipped. The result may be one of the inputs, or be
+ * allocated in the per-tuple memory.
+ */
+static Datum
+slideAggCombine(WindowStatePerFunction funcstate, WindowState * wstate,
+				Datum value1, bool isnull1, Datum value2, bool isnull2,
+				bool *isnull)
+{
+	ExprContext *econtext = wstate->ps.ps_ExprContext;
+	FunctionCallInfoData fcinfo;
+	MemoryContext oldctx;
+	Datum		result;
+
+	if (isnull1)
+	{
+		*isnull = isnull2;
+		return value2;
+	}
+	if (isnull2)
+	{
+		*isnull = false;
+		return value1;
+	}
+
+	InitFunctionCallInfoData(fcinfo, &funcstate->prelimfn, 2,
+							 (void *) wstate, NULL);
+	fcinfo.arg[0] = value1;
+	fcinfo.argnull[0] = false;
+	fcinfo.arg[1] = value2;
+	fcinfo.argnull[1] = false;
+
+	oldctx = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	result = FunctionCallInvoke(&fcinfo);
+	MemoryContextSwitchTo(oldctx);
+
+	*isnull = fcinfo.isnull;
+	return result;
+}
+
+/*
+ * slideAggCopy -- copy a value into the memory of the sliding aggregator.
+ */
+static Datum
+slideAggCopy(WindowStatePerLevel level_state, WindowStatePerFunction funcstate,
+			 Datum value, bool isnull)
+{
+	MemoryContext oldctx;
+
+	if (isnull || funcstate->aggTranstypeByVal)
+		return value;
+
+	oldctx = MemoryContextSwitchTo(level_state->slide_context);
+	value = datumCopy(value, false, funcstate->aggTranstypeLen);
+	MemoryContextSwitchTo(oldctx);
+
+	return value;
+}
+
+/*
+ * slideAggFree -- release a value copied by slideAggCopy().
+ */
+static void
+slideAggFree(WindowStatePerFunction funcstate, Datum value, bool isnull)
+{
+	if (!isnull && !funcstate->aggTranstypeByVal)
+		pfree(DatumGetPointer(value));
+}
+
+/*
+ * slideAggFlip -- turn the back part of the sliding aggregator into its
+ * front part.
+ */
+static void
+slideAggFlip(WindowStatePerLevel level_state, WindowState * wstate)
+{
+	ListCell   *lc;
+
+	Assert(level_state->slide_head == level_state->slide_split);
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+		SlideAggValue *values = funcstate->slide_values;
+		int			i;
+
+		if (!funcstate->slide_agg)
+			continue;
+
+		for (i = level_state->slide_tail - 1; i >= level_state->slide_head; i--)
+		{
+			Datum		suffix = values[i].value;
+			bool		suffixIsNull = values[i].valueIsNull;
+
+			if (i < level_state->slide_tail - 1)
+				suffix = slideAggCombine(funcstate, wstate,
+										 suffix, suffixIsNull,
+										 values[i + 1].suffix,
+										 values[i + 1].suffixIsNull,
+										 &suffixIsNull);
+
+			values[i].suffix = slideAggCopy(level_state, funcstate,
+											suffix, suffixIsNull);
+			values[i].suffixIsNull = suffixIsNull;
+		}
+
+		slideAggFree(funcstate, funcstate->slide_back,
+					 funcstate->slide_backIsNull);
+		funcstate->slide_back = (Datum) 0;
+		funcstate->slide_backIsNull = true;
+	}
+
+	level_state->slide_split = level_state->slide_tail;
+}
+
+/*
+ * slideAggPop -- remove the first entry from the sliding aggregator.
+ */
+static void
+slideAggPop(WindowStatePerLevel level_state, WindowState * wstate)
+{
+	ListCell   *lc;
+	int			head = level_state->slide_head;
+
+	Assert(head < level_state->slide_tail);
+
+	if (head == level_state->slide_split)
+		slideAggFlip(level_state, wstate);
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+		SlideAggValue *value;
+
+		if (!funcstate->slide_agg)
+			continue;
+
+		value = &funcstate->slide_values[head];
+		slideAggFree(funcstate, value->value, value->valueIsNull);
+		slideAggFree(funcstate, value->suffix, value->suffixIsNull);
+	}
+
+	level_state->slide_head++;
+}
+
+/*
+ * slideAggPush -- add a frame buffer entry to the sliding aggregator.
+ */
+static void
+slideAggPush(WindowStatePerLevel level_state, WindowState * wstate,
+			 NTupleStorePos *pos, FrameBufferEntry *entry)
+{
+	ListCell   *lc;
+	int			tail;
+
+	/*
+	 * Make room at the end of the arrays. Move the entries to the start
+	 * when at least half of the arrays is unused, otherwise double them.
+	 */
+	if (level_state->slide_tail == level_state->slide_size)
+	{
+		int			head = level_state->slide_head;
+		int			count = level_state->slide_tail - head;
+		int			new_size = level_state->slide_size;
+		MemoryContext oldctx;
+
+		if (new_size == 0)
+			new_size = 64;
+		else if (head < new_size / 2)
+			new_size *= 2;
+
+		oldctx = MemoryContextSwitchTo(level_state->slide_context);
+
+		if (new_size == level_state->slide_size)
+			memmove(level_state->slide_pos, level_state->slide_pos + head,
+					count * sizeof(NTupleStorePos));
+		else if (level_state->slide_pos == NULL)
+			level_state->slide_pos = palloc(new_size * sizeof(NTupleStorePos));
+		else
+			level_state->slide_pos = repalloc(level_state->slide_pos,
+											  new_size * sizeof(NTupleStorePos));
+
+		foreach(lc, level_state->level_funcs)
+		{
+			WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+
+			if (!funcstate->slide_agg)
+				continue;
+
+			if (new_size == level_state->slide_size)
+				memmove(funcstate->slide_values, funcstate->slide_values + head,
+						count * sizeof(SlideAggValue));
+			else if (funcstate->slide_values == NULL)
+				funcstate->slide_values = palloc(new_size * sizeof(SlideAggValue));
+			else
+				funcstate->slide_values = repalloc(funcstate->slide_values,
+												   new_size * sizeof(SlideAggValue));
+		}
+
+		MemoryContextSwitchTo(oldctx);
+
+		if (new_size == level_state->slide_size)
+		{
+			level_state->slide_head = 0;
+			level_state->slide_split -= head;
+			level_state->slide_tail = count;
+		}
+		level_state->slide_size = new_size;
+	}
+
+	tail = level_state->slide_tail;
+	level_state->slide_pos[tail] = *pos;
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+		WindowValue *entry_value;
+		SlideAggValue *value;
+		Datum		back;
+		bool		backIsNull;
+
+		if (!funcstate->slide_agg)
+			continue;
+
+		entry_value = (WindowValue *) list_nth(entry->func_values,
+											   funcstate->serial_index);
+		value = &funcstate->slide_values[tail];
+		value->value = slideAggCopy(level_state, funcstate,
+									entry_value->value,
+									entry_value->valueIsNull);
+		value->valueIsNull = entry_value->valueIsNull;
+		value->suffix = (Datum) 0;
+		value->suffixIsNull = true;
+
+		back = slideAggCombine(funcstate, wstate,
+							   funcstate->slide_back, funcstate->slide_backIsNull,
+							   value->value, value->valueIsNull,
+							   &backIsNull);
+		back = slideAggCopy(level_state, funcstate, back, backIsNull);
+		slideAggFree(funcstate, funcstate->slide_back,
+					 funcstate->slide_backIsNull);
+		funcstate->slide_back = back;
+		funcstate->slide_backIsNull = backIsNull;
+	}
+
+	level_state->slide_tail++;
+}
+
+/*
+ * computeSlideAggs -- compute the frame values of the functions that use
+ * the sliding aggregator.
+ *
+ * The trail_reader points to the first entry in the frame, and the
+ * lead_reader to the last one, or is invalid if the frame extends to the
+ * end of the frame buffer. The value of the row that has not been added to
+ * the frame buffer yet is left to the caller.
+ *
+ * Returns false, after turning the sliding aggregator off, if it grows
+ * beyond the memory of the frame buffer. The caller then scans the frame
+ * buffer instead.
+ */
+static bool
+computeSlideAggs(WindowStatePerLevel level_state, WindowState * wstate)
+{
+	NTupleStorePos start;
+	NTupleStorePos end;
+	NTupleStorePos pos;
+	bool		has_end;
+	ListCell   *lc;
+
+	if (!ntuplestore_acc_tell(level_state->trail_reader, &start))
+		return true;
+
+	has_end = ntuplestore_acc_tell(level_state->lead_reader, &end);
+	if (has_end && slidePosIsBefore(&end, &start))
+		return true;
+
+	/*
+	 * Frame edges only move forward within a partition. Start over if
+	 * either of them moved backward anyway.
+	 */
+	if (level_state->slide_head < level_state->slide_tail &&
+		(slidePosIsBefore(&start, &level_state->slide_pos[level_state->slide_head]) ||
+		 (has_end &&
+		  slidePosIsBefore(&end, &level_state->slide_pos[level_state->slide_tail - 1]))))
+		resetSlideAggs(level_state);
+
+	/* Remove the entries that left the frame. */
+	while (level_state->slide_head < level_state->slide_tail &&
+		   slidePosIsBefore(&level_state->slide_pos[level_state->slide_head], &start))
+		slideAggPop(level_state, wstate);
+
+	/*
+	 * Add the entries that entered the frame. The slide_reader normally
+	 * points to the entry after the last one added already.
+	 */
+	if (level_state->slide_head == level_state->slide_tail)
+	{
+		level_state->slide_head = level_state->slide_split =
+			level_state->slide_tail = 0;
+		ntuplestore_acc_seek(level_state->slide_reader, &start);
+	}
+	else if (!ntuplestore_acc_tell(level_state->slide_reader, NULL))
+	{
+		ntuplestore_acc_seek(level_state->slide_reader,
+							 &level_state->slide_pos[level_state->slide_tail - 1]);
+		ntuplestore_acc_advance(level_state->slide_reader, 1);
+	}
+
+	while (ntuplestore_acc_tell(level_state->slide_reader, &pos) &&
+		   (!has_end || !slidePosIsBefore(&end, &pos)))
+	{
+		bool		has_curr_entry;
+
+		has_curr_entry = getCurrentValue(level_state->slide_reader, level_state,
+										 level_state->curr_entry_buf);
+		Assert(has_curr_entry);
+
+		slideAggPush(level_state, wstate, &pos, level_state->curr_entry_buf);
+		ntuplestore_acc_advance(level_state->slide_reader, 1);
+
+		if (MemoryContextGetCurrentSpace(level_state->slide_context) >
+			level_state->slide_max_bytes)
+		{
+			foreach(lc, level_state->level_funcs)
+			{
+				WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+
+				funcstate->slide_agg = false;
+			}
+			level_state->has_slide_aggs = false;
+			resetSlideAggs(level_state);
+			return false;
+		}
+	}
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+		Datum		value = (Datum) 0;
+		bool		isnull = true;
+
+		if (!funcstate->slide_agg)
+			continue;
+
+		if (level_state->slide_head < level_state->slide_split)
+		{
+			value = funcstate->slide_values[level_state->slide_head].suffix;
+			isnull = funcstate->slide_values[level_state->slide_head].suffixIsNull;
+		}
+		value = slideAggCombine(funcstate, wstate, value, isnull,
+								funcstate->slide_back, funcstate->slide_backIsNull,
+								&isnull);
+
+		freeTransValue(&funcstate->final_aggTransValue,
+					   funcstate->aggTranstypeByVal,
+					   &funcstate->final_aggTransValueIsNull,
+					   &funcstate->final_aggNoTransValue,
+					   funcstate->final_aggShouldFree);
+
+		if (!isnull)
+		{
+			funcstate->final_aggTransValue =
+				datumCopyWithMemManager(0, value,
+										funcstate->aggTranstypeByVal,
+										funcstate->aggTranstypeLen,
+										&(wstate->mem_manager));
+			funcstate->final_aggTransValueIsNull = false;
+			funcstate->final_aggNoTransValue = false;
+			funcstate->final_aggShouldFree = true;
+		}
+		else
+			funcstate->final_aggShouldFree = false;
+	}
+
+	return true;
+}
+
 /*
  * computeTransValuesThroughScan -- compute transition values
  * for those functions in the given level whose aggregate values
@@ -1960,8 +2469,26 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 	if (has_tuples)
 	{
 		bool		include_last_agg = false;
+		bool		need_scan = false;
+
+		if (level_state->has_slide_aggs)
+			computeSlideAggs(level_state, wstate);
+
+		foreach(lc, level_state->level_funcs)
+		{
+			WindowStatePerFunction funcstate = (WindowStatePerFunction)
+			lfirst(lc);
+
+			if (!funcstate->trivial_frame &&
+				!funcstate->winpeercount &&
+				funcstate->isAgg &&
+				!OidIsValid(funcstate->invprelimfn_oid) &&
+				!funcstate->slide_agg)
+				need_scan = true;
+		}
 
-		while (ntuplestore_acc_tell(level_state->trail_reader, NULL))
+		while (need_scan &&
+			   ntuplestore_acc_tell(level_state->trail_reader, NULL))
 		{
 			if (ntuplestore_acc_tell(level_state->lead_reader, NULL) &&
 				ntuplestore_acc_is_before(level_state->lead_reader,
@@ -1987,7 +2514,8 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 					funcstate->winpeercount ||
 					(funcstate->isAgg &&
 					 OidIsValid(funcstate->invprelimfn_oid)) ||
-					!funcstate->isAgg)
+					!funcstate->isAgg ||
+					funcstate->slide_agg)
 					continue;
 
 				if (OidIsValid(funcstate->prelimfn_oid))
@@ -5829,6 +6357,39 @@ init_frames(WindowState * wstate)
 		level_state->has_only_trans_funcs = has_only_trans_funcs;
 	}
 
+	/*
+	 * Use the sliding aggregator for the aggregate functions that would
+	 * otherwise scan the whole frame for every row, when the frame edges
+	 * only move forward. That requires a strict preliminary function and a
+	 * NULL initial value, as for min() and max().
+	 */
+	for (level = 0; level < wstate->numlevels; level++)
+	{
+		WindowStatePerLevel level_state = &wstate->level_state[level];
+
+		if (level_state->has_delay_bound)
+			continue;
+
+		foreach(lc, level_state->level_funcs)
+		{
+			WindowStatePerFunction funcstate =
+			(WindowStatePerFunction) lfirst(lc);
+
+			if (funcstate->isAgg &&
+				!funcstate->trivial_frame &&
+				!funcstate->cumul_frame &&
+				!funcstate->winpeercount &&
+				!OidIsValid(funcstate->invprelimfn_oid) &&
+				OidIsValid(funcstate->prelimfn_oid) &&
+				funcstate->prelimfn.fn_strict &&
+				funcstate->aggInitValueIsNull)
+			{
+				funcstate->slide_agg = true;
+				level_state->has_slide_aggs = true;
+			}
+		}
+	}
+
 	/*
 	 * Allocate one FrameBufferEntry buffer for each level state, so that we
 	 * don't need to do pallocs/pfrees every time we read an entry from the
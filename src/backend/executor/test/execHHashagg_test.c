@@ -126,6 +126,48 @@ test__getSpillFile__Initialize_wfile_exception(void **state)
 	assert_true(false);
 }
 
+/* ==================== hha_find_empty_slot ==================== */
+/*
+ * Test that entries whose home group is full go to the following groups,
+ * wrapping around at the end of the table, and that the tags of a group
+ * are found by a probe.
+ */
+void
+test__hha_find_empty_slot__OverflowsToNextGroup(void **state)
+{
+	HashAggTable *hashtable = (HashAggTable *) palloc0(sizeof(HashAggTable));
+	uint32 hashkey = 0xfedcba98;
+	unsigned home;
+	unsigned slot;
+	int i;
+
+	hashtable->nbuckets = 32;
+	hashtable->bucket_shift = 32 - 5;
+	hashtable->tags = (uint8 *) palloc0(hashtable->nbuckets);
+
+	home = hha_home_group(hashtable, hashkey);
+	assert_true(home < hashtable->nbuckets / HHA_GROUP_SLOTS);
+	assert_true(hha_group_has_empty(hha_group_tags(hashtable, home)));
+	assert_false(hha_group_may_match(hha_group_tags(hashtable, home),
+									 HHA_TAG(hashkey)));
+
+	/* Fill the home group */
+	for (i = 0; i < HHA_GROUP_SLOTS; i++)
+	{
+		slot = hha_find_empty_slot(hashtable, hashkey);
+		assert_int_equal(slot, home * HHA_GROUP_SLOTS + i);
+		hashtable->tags[slot] = HHA_TAG(hashkey) ^ (i & 1);
+		hashtable->nused++;
+	}
+	assert_false(hha_group_has_empty(hha_group_tags(hashtable, home)));
+	assert_true(hha_group_may_match(hha_group_tags(hashtable, home),
+									HHA_TAG(hashkey)));
+
+	/* The next entry goes to the next group, wrapping around */
+	slot = hha_find_empty_slot(hashtable, hashkey);
+	assert_int_equal(slot, ((home + 1) % (hashtable->nbuckets / HHA_GROUP_SLOTS)) * HHA_GROUP_SLOTS);
+}
+
 /* ==================== main ==================== */
 int
 main(int argc, char* argv[])
@@ -134,7 +176,8 @@ main(int argc, char* argv[])
 
 	const UnitTest tests[] = {
 		unit_test(test__getSpillFile__Initialize_wfile_success),
-		unit_test(test__getSpillFile__Initialize_wfile_exception)
+		unit_test(test__getSpillFile__Initialize_wfile_exception),
+		unit_test(test__hha_find_empty_slot__OverflowsToNextGroup)
 	};
 
 	MemoryContextInit();
@@ -1087,6 +1087,8 @@ _copyMotion(Motion *from)
 
 	COPY_NODE_FIELD(hashExpr);
 	COPY_NODE_FIELD(hashDataTypes);
+	COPY_SCALAR_FIELD(skewType);
+	COPY_NODE_FIELD(hotHashes);
 
 	COPY_SCALAR_FIELD(numOutputSegs);
 	COPY_POINTER_FIELD(outputSegIdx, from->numOutputSegs * sizeof(int));
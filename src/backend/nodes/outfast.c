@@ -509,6 +509,8 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_NODE_FIELD(hashExpr);
 	WRITE_NODE_FIELD(hashDataTypes);
+	WRITE_ENUM_FIELD(skewType, MotionSkewType);
+	WRITE_NODE_FIELD(hotHashes);
 
 	WRITE_INT_FIELD(numOutputSegs);
 	WRITE_INT_ARRAY(outputSegIdx, node->numOutputSegs, int);
@@ -987,6 +987,8 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_NODE_FIELD(hashExpr);
 	WRITE_NODE_FIELD(hashDataTypes);
+	WRITE_ENUM_FIELD(skewType, MotionSkewType);
+	WRITE_NODE_FIELD(hotHashes);
 
 	WRITE_INT_FIELD(numOutputSegs);
 	appendStringInfoLiteral(str, " :outputSegIdx");
@@ -1947,6 +1949,8 @@ _outCdbMotionPath(StringInfo str, CdbMotionPath *node)
     _outPathInfo(str, &node->path);
 
     WRITE_NODE_FIELD(subpath);
+    WRITE_ENUM_FIELD(skewType, MotionSkewType);
+    WRITE_NODE_FIELD(hotHashes);
 }
 
 #ifndef COMPILING_BINARY_FUNCS
@@ -2214,6 +2214,8 @@ _readMotion(void)
 
 	READ_NODE_FIELD(hashExpr);
 	READ_NODE_FIELD(hashDataTypes);
+	READ_ENUM_FIELD(skewType, MotionSkewType);
+	READ_NODE_FIELD(hotHashes);
 
 	READ_INT_FIELD(numOutputSegs);
 	READ_INT_ARRAY(outputSegIdx, local_node->numOutputSegs, int);
@@ -2747,6 +2747,8 @@ create_hashjoin_path(PlannerInfo *root,
 {
     HashPath       *pathnode;
     CdbPathLocus    join_locus;
+    Path           *orig_outer_path = outer_path;
+    Path           *orig_inner_path = inner_path;
 
     /* CDB: Change jointype to JOIN_IN from JOIN_INNER (if eligible). */
     if (joinrel->dedup_info)
@@ -2765,6 +2767,15 @@ create_hashjoin_path(PlannerInfo *root,
     if (CdbPathLocus_IsNull(join_locus))
         return NULL;
 
+	/*
+	 * CDB: If both inputs are being redistributed for this join, spread
+	 * hot keys of the outer rel.  The spread rows can end up anywhere.
+	 */
+	if (outer_path != orig_outer_path &&
+		inner_path != orig_inner_path &&
+		cdbpath_skew_spread_join(root, jointype, outer_path, inner_path))
+		CdbPathLocus_MakeStrewn(&join_locus);
+
 	pathnode = makeNode(HashPath);
 
 	pathnode->jpath.path.pathtype = T_HashJoin;
@@ -36,6 +36,7 @@ static const struct{
 {
     {{"none", "false", "no", "off", "0", 0}, bfz_nothing_init},
     {{"zlib", 0}, bfz_zlib_init},
+    {{"lz", "fast", 0}, bfz_lz_init},
     {{0}}
 };
 
@@ -54,6 +55,12 @@ bfz_string_to_compression(const char *string)
 	return -1;
 }
 
+const char *
+bfz_compression_to_string(int compress)
+{
+	return compression_algorithms[compress].name[0];
+}
+
 /*
  * bfz_close_callback
  *		Callback for register for transaction end cleanups
@@ -513,6 +520,9 @@ bfz_append_end(bfz_t * thiz)
 		 (long long) tot_bytes, (long long) tot_compressed,
 		 tot_bytes == 0 ? 0 : (int) ((tot_bytes - tot_compressed) * 100 / tot_bytes));
 
+	thiz->rawBytes = tot_bytes;
+	thiz->storedBytes = tot_compressed;
+
 	return tot_compressed;
 }
 
@@ -0,0 +1,419 @@
+/* compress_lz.c */
+
+#include "postgres.h"
+
+#include "c.h"
+#include <unistd.h>
+#include <storage/bfz.h>
+#include <storage/fd.h>
+#include "portability/instr_time.h"
+
+/*
+ * This file implements bfz compression algorithm "lz".
+ *
+ * It is a byte-oriented LZ77 codec in the spirit of LZ4, meant to be cheap
+ * enough to leave on for spilling operators: a single hash probe per
+ * position, no entropy coding, and a decoder that only copies bytes.
+ *
+ * Every buffer handed to write_ex becomes one frame on disk, so that
+ * read_ex returns exactly the buffers that were written, as the
+ * checksumming in bfz.c requires.  A frame is a header of two int32s, the
+ * uncompressed and the stored length, followed by the stored bytes.  When
+ * compression does not make a buffer smaller, it is stored as is, and both
+ * lengths are equal.
+ *
+ * The compressed data is a sequence of tokens.  The high nibble of a token
+ * is the number of literal bytes that follow it, the low nibble the length
+ * of the match that follows the literals, minus LZ_MIN_MATCH.  A nibble of
+ * 15 is continued by bytes that are added to it, up to and including the
+ * first byte that is not 255.  A match is a two byte little-endian offset
+ * back into the output.  The last token of a buffer only has literals.
+ */
+
+#define LZ_MIN_MATCH		4
+#define LZ_MAX_OFFSET		65535
+#define LZ_HASH_BITS		12
+#define LZ_HASH_SIZE		(1 << LZ_HASH_BITS)
+
+/* Largest compressed size of a buffer of n bytes, including frame header. */
+#define LZ_FRAME_HEADER		(2 * sizeof(int32))
+#define LZ_MAX_STORED(n)	((n) + (n) / 255 + 16)
+
+struct bfz_lz_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	/* Frame buffer: header and stored bytes of one frame */
+	char frame[LZ_FRAME_HEADER + LZ_MAX_STORED(BFZ_BUFFER_SIZE)];
+};
+
+/*
+ * Append a length continuation: the bytes added to a nibble of 15.
+ */
+static inline uint8 *
+lz_put_length(uint8 *op, int len)
+{
+	while (len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (uint8) len;
+	return op;
+}
+
+/*
+ * Append a token with its literals and, when matchlen is not 0, its match.
+ *
+ * Returns the new end of the output, or NULL if it would go past opend.
+ */
+static uint8 *
+lz_put_sequence(uint8 *op, uint8 *opend, const uint8 *literals, int litlen,
+				int offset, int matchlen)
+{
+	uint8	   *token;
+	int			extra = matchlen == 0 ? 0 : matchlen - LZ_MIN_MATCH;
+
+	if (opend - op < 1 + litlen / 255 + 1 + litlen + 2 + extra / 255 + 1)
+		return NULL;
+
+	token = op++;
+	*token = (uint8) (Min(litlen, 15) << 4);
+	if (litlen >= 15)
+		op = lz_put_length(op, litlen - 15);
+	memcpy(op, literals, litlen);
+	op += litlen;
+
+	if (matchlen == 0)
+		return op;
+
+	*op++ = (uint8) (offset & 0xff);
+	*op++ = (uint8) (offset >> 8);
+	*token |= (uint8) Min(extra, 15);
+	if (extra >= 15)
+		op = lz_put_length(op, extra - 15);
+
+	return op;
+}
+
+/*
+ * Compress srclen bytes of src into dst, which has room for dstcap bytes.
+ *
+ * Returns the compressed length, or -1 if it does not fit into dstcap.
+ */
+static int
+bfz_lz_compress(const char *src, int srclen, char *dst, int dstcap)
+{
+	uint16		table[LZ_HASH_SIZE];
+	const uint8 *base = (const uint8 *) src;
+	const uint8 *ip = base;
+	const uint8 *anchor = base;
+	const uint8 *end = base + srclen;
+	uint8	   *op = (uint8 *) dst;
+	uint8	   *opend = op + dstcap;
+
+	Assert(srclen <= LZ_MAX_OFFSET);
+
+	memset(table, 0, sizeof(table));
+
+	while (ip + LZ_MIN_MATCH <= end)
+	{
+		uint32		seq;
+		uint32		h;
+		const uint8 *ref;
+		int			len;
+
+		memcpy(&seq, ip, sizeof(seq));
+		h = (seq * 2654435761U) >> (32 - LZ_HASH_BITS);
+		ref = base + table[h];
+		table[h] = (uint16) (ip - base);
+
+		if (ref >= ip || ip - ref > LZ_MAX_OFFSET ||
+			memcmp(ref, ip, LZ_MIN_MATCH) != 0)
+		{
+			/* Skip faster through data that does not compress. */
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+
+		len = LZ_MIN_MATCH;
+		while (ip + len < end && ref[len] == ip[len])
+			len++;
+
+		op = lz_put_sequence(op, opend, anchor, ip - anchor, ip - ref, len);
+		if (op == NULL)
+			return -1;
+
+		ip += len;
+		anchor = ip;
+	}
+
+	op = lz_put_sequence(op, opend, anchor, end - anchor, 0, 0);
+	if (op == NULL)
+		return -1;
+
+	return (char *) op - dst;
+}
+
+/*
+ * Decompress srclen bytes of src into the rawlen bytes of dst.
+ *
+ * Returns false if the compressed data is corrupt.
+ */
+static bool
+bfz_lz_decompress(const char *src, int srclen, char *dst, int rawlen)
+{
+	const uint8 *ip = (const uint8 *) src;
+	const uint8 *ipend = ip + srclen;
+	uint8	   *base = (uint8 *) dst;
+	uint8	   *op = base;
+	uint8	   *opend = base + rawlen;
+
+	for (;;)
+	{
+		uint8		token;
+		int			litlen;
+		int			matchlen;
+		int			offset;
+		uint8		b;
+
+		if (ip >= ipend)
+			return false;
+		token = *ip++;
+
+		litlen = token >> 4;
+		if (litlen == 15)
+		{
+			do
+			{
+				if (ip >= ipend)
+					return false;
+				b = *ip++;
+				litlen += b;
+			} while (b == 255);
+		}
+		if (litlen > ipend - ip || litlen > opend - op)
+			return false;
+		memcpy(op, ip, litlen);
+		op += litlen;
+		ip += litlen;
+
+		/* The last token has no match. */
+		if (ip == ipend)
+			return op == opend;
+
+		if (ipend - ip < 2)
+			return false;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		matchlen = token & 15;
+		if (matchlen == 15)
+		{
+			do
+			{
+				if (ip >= ipend)
+					return false;
+				b = *ip++;
+				matchlen += b;
+			} while (b == 255);
+		}
+		matchlen += LZ_MIN_MATCH;
+
+		if (offset == 0 || offset > op - base || matchlen > opend - op)
+			return false;
+
+		if (offset >= matchlen)
+		{
+			memcpy(op, op - offset, matchlen);
+			op += matchlen;
+		}
+		else
+		{
+			/* The match overlaps its own output; copy forward bytewise. */
+			const uint8 *ref = op - offset;
+
+			while (matchlen-- > 0)
+				*op++ = *ref++;
+		}
+	}
+}
+
+/*
+ * bfz_lz_close_ex
+ *  Close a file and freeing up descriptor, buffers etc.
+ *
+ *  This is also called from an xact end callback, hence it should
+ *  not contain any elog(ERROR) calls.
+ */
+static void
+bfz_lz_close_ex(bfz_t * thiz)
+{
+	gp_retry_close(thiz->fd);
+	thiz->fd = -1;
+	pfree(thiz->freeable_stuff);
+	thiz->freeable_stuff = NULL;
+}
+
+/*
+ * Read exactly size bytes, or nothing at the end of the file.
+ */
+static bool
+bfz_lz_read_fully(bfz_t * thiz, char *buffer, int size)
+{
+	int			orig_size = size;
+
+	while (size)
+	{
+		int			i = readAndRetry(thiz->fd, buffer, size);
+
+		if (i < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_ERROR),
+					errmsg("could not read from temporary file: %m")));
+		if (i == 0)
+		{
+			if (size == orig_size)
+				return false;
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_ERROR),
+					errmsg("unexpected end of compressed temporary file")));
+		}
+		buffer += i;
+		size -= i;
+	}
+	return true;
+}
+
+/*
+ * bfz_lz_read_ex
+ *  Read the next frame of the file, uncompressed, into buffer.
+ *
+ *  Returns the number of bytes read, 0 at the end of the file.
+ */
+static int
+bfz_lz_read_ex(bfz_t * thiz, char *buffer, int size)
+{
+	struct bfz_lz_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int32		rawlen;
+	int32		storedlen;
+
+	if (!bfz_lz_read_fully(thiz, fs->frame, LZ_FRAME_HEADER))
+		return 0;
+
+	memcpy(&rawlen, fs->frame, sizeof(int32));
+	memcpy(&storedlen, fs->frame + sizeof(int32), sizeof(int32));
+
+	if (rawlen < 0 || rawlen > size ||
+		storedlen < 0 || storedlen > LZ_MAX_STORED(BFZ_BUFFER_SIZE))
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_ERROR),
+				errmsg("invalid frame in compressed temporary file")));
+
+	if (storedlen == rawlen)
+	{
+		if (rawlen > 0)
+			bfz_lz_read_fully(thiz, buffer, rawlen);
+		return rawlen;
+	}
+
+	if (bfz_lz_read_fully(thiz, fs->frame, storedlen))
+	{
+		instr_time	starttime;
+		instr_time	endtime;
+		bool		ok;
+
+		INSTR_TIME_SET_CURRENT(starttime);
+		ok = bfz_lz_decompress(fs->frame, storedlen, buffer, rawlen);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+		thiz->compressSecs += INSTR_TIME_GET_DOUBLE(endtime);
+
+		if (ok)
+			return rawlen;
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_IO_ERROR),
+			errmsg("invalid frame in compressed temporary file")));
+	return 0;					/* keep compiler quiet */
+}
+
+static void
+bfz_lz_write_fully(bfz_t * thiz, const char *buffer, int size)
+{
+	while (size)
+	{
+		int			i = writeAndRetry(thiz->fd, buffer, size);
+
+		if (i < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_ERROR),
+					errmsg("could not write to temporary file: %m")));
+		buffer += i;
+		size -= i;
+	}
+}
+
+/*
+ * bfz_lz_write_ex
+ *  Compress buffer and write it out as one frame.
+ *  An exception is thrown if the data cannot be written for any reason.
+ */
+static void
+bfz_lz_write_ex(bfz_t * thiz, const char *buffer, int size)
+{
+	struct bfz_lz_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int32		rawlen = size;
+	int32		storedlen;
+	instr_time	starttime;
+	instr_time	endtime;
+
+	Assert(size <= BFZ_BUFFER_SIZE);
+
+	/* Keep the buffer as is unless compression saves something. */
+	INSTR_TIME_SET_CURRENT(starttime);
+	storedlen = bfz_lz_compress(buffer, size, fs->frame + LZ_FRAME_HEADER,
+								size - 1);
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_SUBTRACT(endtime, starttime);
+	thiz->compressSecs += INSTR_TIME_GET_DOUBLE(endtime);
+
+	if (storedlen < 0)
+	{
+		storedlen = rawlen;
+		memcpy(fs->frame, &rawlen, sizeof(int32));
+		memcpy(fs->frame + sizeof(int32), &storedlen, sizeof(int32));
+		bfz_lz_write_fully(thiz, fs->frame, LZ_FRAME_HEADER);
+		bfz_lz_write_fully(thiz, buffer, size);
+		return;
+	}
+
+	memcpy(fs->frame, &rawlen, sizeof(int32));
+	memcpy(fs->frame + sizeof(int32), &storedlen, sizeof(int32));
+	bfz_lz_write_fully(thiz, fs->frame, LZ_FRAME_HEADER + storedlen);
+}
+
+/*
+ * bfz_lz_init
+ *  Initialize the lz subsystem for a file.
+ *
+ *  The underlying file descriptor fd should already be opened
+ *  and valid. Memory is allocated in the current memory context.
+ */
+void
+bfz_lz_init(bfz_t * thiz)
+{
+	/*
+	 * Check that we are allocating in the TopMemoryContext since this
+	 * memory context must still be available when calling the transaction
+	 * callback at the time when the transaction aborts.
+	 */
+	Assert(TopMemoryContext == CurrentMemoryContext);
+	struct bfz_lz_freeable_stuff *fs = palloc(sizeof *fs);
+
+	thiz->freeable_stuff = &fs->super;
+	fs->super.read_ex = bfz_lz_read_ex;
+	fs->super.write_ex = bfz_lz_write_ex;
+	fs->super.close_ex = bfz_lz_close_ex;
+}
@@ -0,0 +1,127 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "c.h"
+
+/* Ignore ereport */
+#include "utils/elog.h"
+#undef ereport
+#undef errcode
+#undef errmsg
+#define ereport
+#define errcode
+#define errmsg
+
+#include "../compress_lz.c"
+
+#include "utils/memutils.h"
+
+/*
+ * Compresses len bytes of data, checks that they decompress to the same
+ * bytes, and returns the compressed length.
+ */
+static int
+lz_round_trip(const char *data, int len)
+{
+	char		compressed[LZ_MAX_STORED(BFZ_BUFFER_SIZE)];
+	char		decompressed[BFZ_BUFFER_SIZE];
+	int			compressedLen;
+
+	compressedLen = bfz_lz_compress(data, len, compressed, sizeof(compressed));
+	assert_true(compressedLen > 0);
+
+	assert_true(bfz_lz_decompress(compressed, compressedLen, decompressed, len));
+	assert_memory_equal(data, decompressed, len);
+
+	return compressedLen;
+}
+
+/* ==================== bfz_lz_compress =================== */
+/*
+ * Tests that repetitive data compresses, including matches that overlap
+ * their own output and long literal and match lengths.
+ */
+void
+test__bfz_lz_compress__RoundTripRepetitive(void **state)
+{
+	char		data[BFZ_BUFFER_SIZE];
+	int			i;
+
+	for (i = 0; i < BFZ_BUFFER_SIZE; i++)
+		data[i] = "abcabcabd"[i % 9];
+	assert_true(lz_round_trip(data, BFZ_BUFFER_SIZE) < BFZ_BUFFER_SIZE / 10);
+
+	memset(data, 'x', BFZ_BUFFER_SIZE);
+	assert_true(lz_round_trip(data, BFZ_BUFFER_SIZE) < 100);
+
+	/* Short inputs have no room for a match */
+	lz_round_trip(data, 3);
+	lz_round_trip(data, 0);
+}
+
+/*
+ * Tests that data that does not compress still round trips, and that it
+ * does not fit into a buffer smaller than the input.
+ */
+void
+test__bfz_lz_compress__RoundTripRandom(void **state)
+{
+	char		data[BFZ_BUFFER_SIZE];
+	char		compressed[BFZ_BUFFER_SIZE];
+	uint32		seed = 12345;
+	int			i;
+
+	for (i = 0; i < BFZ_BUFFER_SIZE; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		data[i] = (char) (seed >> 16);
+	}
+
+	lz_round_trip(data, BFZ_BUFFER_SIZE);
+
+	assert_int_equal(bfz_lz_compress(data, BFZ_BUFFER_SIZE, compressed,
+									 BFZ_BUFFER_SIZE - 1), -1);
+}
+
+/* ==================== bfz_lz_decompress =================== */
+/*
+ * Tests that truncated data and a wrong uncompressed length are detected.
+ */
+void
+test__bfz_lz_decompress__Corrupt(void **state)
+{
+	char		data[1000];
+	char		compressed[LZ_MAX_STORED(1000)];
+	char		decompressed[1000];
+	int			compressedLen;
+	int			i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = (char) (i % 50);
+
+	compressedLen = bfz_lz_compress(data, sizeof(data), compressed, sizeof(compressed));
+	assert_true(compressedLen > 0);
+
+	assert_false(bfz_lz_decompress(compressed, compressedLen - 1,
+								   decompressed, sizeof(data)));
+	assert_false(bfz_lz_decompress(compressed, compressedLen,
+								   decompressed, sizeof(data) - 1));
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__bfz_lz_compress__RoundTripRepetitive),
+		unit_test(test__bfz_lz_compress__RoundTripRandom),
+		unit_test(test__bfz_lz_decompress__Corrupt)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -33,6 +33,9 @@ typedef enum AOCSBK
 	AOCSBK_BLOB,
 }	AOCSBK;
 
+/* GUC: dictionary encode Original blocks of variable-length columns. */
+bool		gp_aocs_dictionary_encoding = false;
+
 
 static void
 datumstreamread_check_large_varlena_integrity(
@@ -611,6 +614,9 @@ create_datumstreamwrite(
 							   acc->datumStreamVersion,
 							   acc->rle_want_compression,
 							   acc->delta_want_compression,
+							   (gp_aocs_dictionary_encoding &&
+					 acc->datumStreamVersion == DatumStreamVersion_Original &&
+								acc->typeInfo.datumlen == -1),
 							   initialMaxDatumPerBlock,
 							   maxDatumPerBlock,
 							   acc->maxAoBlockSize - acc->maxAoHeaderSize,
@@ -1290,8 +1296,13 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
+/*
+ * Read the header of the next block, without reading its content. The
+ * caller must either call datumstreamread_block_content, or skip the
+ * block with AppendOnlyStorageRead_SkipCurrentBlock.
+ */
 int
-datumstreamread_block(DatumStreamRead * acc)
+datumstreamread_block_header(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1349,6 +1360,15 @@ datumstreamread_block(DatumStreamRead * acc)
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
+	return 0;
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc)
+{
+	if (datumstreamread_block_header(acc) < 0)
+		return -1;
+
 	datumstreamread_block_content(acc);
 
 	return 0;
@@ -5,6 +5,7 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
 #include "utils/datumstreamblock.h"
@@ -124,6 +125,87 @@ DatumStreamBlockRead_ResetOrig(DatumStreamBlockRead * dsr)
 
 	dsr->buffer_beginp = NULL;
 	dsr->datump = NULL;
+
+	/*
+	 * The dictionary belongs to the previous block.
+	 */
+	if (dsr->dictionary_items != NULL)
+	{
+		pfree(dsr->dictionary_items);
+		dsr->dictionary_items = NULL;
+	}
+	dsr->dictionary_count = 0;
+	dsr->dictionary_codesp = NULL;
+}
+
+/*
+ * Identifies the dictionaries read by this backend; never 0.
+ */
+static uint32 DatumStreamBlockRead_LastDictionaryId = 0;
+
+/*
+ * Set up the dictionary of a dictionary encoded Original block.  Its
+ * extension is at the beginning of the datum area.
+ */
+static void
+DatumStreamBlockRead_GetReadyDictionary(DatumStreamBlockRead * dsr)
+{
+	DatumStreamBlock_Dictionary_Extension *extension;
+	uint8	   *p;
+	uint8	   *dictionary_afterp;
+	int			i;
+
+	extension = (DatumStreamBlock_Dictionary_Extension *) dsr->datum_beginp;
+	if (dsr->typeInfo.datumlen != -1 ||
+		extension->dictionary_count <= 0 ||
+		extension->dictionary_count > DATUMSTREAM_DICTIONARY_MAX_COUNT ||
+		extension->dictionary_size <= 0 ||
+		sizeof(DatumStreamBlock_Dictionary_Extension) + extension->dictionary_size > dsr->physical_data_size)
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Original block dictionary (count %d, size %d, physical data size %d)",
+						extension->dictionary_count,
+						extension->dictionary_size,
+						dsr->physical_data_size),
+				 errOmitLocation(false),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	if (dsr->dictionary_items == NULL)
+		dsr->dictionary_items = (uint8 **)
+			MemoryContextAlloc(dsr->memctxt,
+							   DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(uint8 *));
+
+	p = dsr->datum_beginp + sizeof(DatumStreamBlock_Dictionary_Extension);
+	dictionary_afterp = p + extension->dictionary_size;
+	for (i = 0; i < extension->dictionary_count; i++)
+	{
+		/*
+		 * Skip any zero padding before a 4 byte header item.
+		 */
+		if (*p == 0)
+			p = (uint8 *) att_align_nominal(p, dsr->typeInfo.align);
+
+		if (p >= dictionary_afterp)
+			ereport(ERROR,
+					(errmsg("Datum stream Original block dictionary item %d out of bounds (count %d, size %d)",
+							i,
+							extension->dictionary_count,
+							extension->dictionary_size),
+					 errOmitLocation(false),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+
+		dsr->dictionary_items[i] = p;
+		p += VARSIZE_ANY(p);
+	}
+
+	dsr->dictionary_count = extension->dictionary_count;
+	dsr->dictionary_codesp = dictionary_afterp;
+	if (++DatumStreamBlockRead_LastDictionaryId == 0)
+		++DatumStreamBlockRead_LastDictionaryId;
+	dsr->dictionary_id = DatumStreamBlockRead_LastDictionaryId;
 }
 
 void
@@ -190,7 +272,8 @@ DatumStreamBlockRead_GetReadyOrig(
 	}
 
 	blockOrig = (DatumStreamBlock_Orig *) p;
-	if (blockOrig->version != DatumStreamVersion_Original)
+	if (blockOrig->version != DatumStreamVersion_Original &&
+		blockOrig->version != DatumStreamBlockVersion_Original_Dictionary)
 	{
 		ereport(ERROR,
 				(errmsg("Bad datum stream Original block version.  Found %d and expected %d",
@@ -200,6 +283,18 @@ DatumStreamBlockRead_GetReadyOrig(
 				 errdetail_datumstreamblockread(dsr),
 				 errcontext_datumstreamblockread(dsr)));
 	}
+	if ((blockOrig->flags & ~DSB_KNOWN_FLAGS_ORIG) != 0 ||
+		((blockOrig->flags & DSB_HAS_DICTIONARY) != 0) !=
+		(blockOrig->version == DatumStreamBlockVersion_Original_Dictionary))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Original block flags 0x%x for block version %d",
+						blockOrig->flags,
+						blockOrig->version),
+				 errOmitLocation(false),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
 
 	if (!minimalIntegrityChecks)
 	{
@@ -320,6 +415,9 @@ DatumStreamBlockRead_GetReadyOrig(
 #endif
 
 	dsr->datump = dsr->datum_beginp;
+
+	if ((blockOrig->flags & DSB_HAS_DICTIONARY) != 0)
+		DatumStreamBlockRead_GetReadyDictionary(dsr);
 }
 
 void
@@ -384,7 +482,11 @@ void
 DatumStreamBlockRead_Finish(
 							DatumStreamBlockRead * dsr)
 {
-	/* Place holder. */
+	if (dsr->dictionary_items != NULL)
+	{
+		pfree(dsr->dictionary_items);
+		dsr->dictionary_items = NULL;
+	}
 }
 
 /*
@@ -3625,6 +3727,112 @@ DatumStreamBlockWrite_GetReady(
 	}
 }
 
+/*
+ * Try to dictionary encode the variable-length items of the current
+ * Original block into dictionary_buffer.  Returns the encoded size, or 0
+ * when the block has too many distinct items or would not get smaller.
+ *
+ * Items are compared by their stored bytes, so equal values always get
+ * the same code: the put routines store a value the same way every time.
+ */
+static int32
+DatumStreamBlockWrite_DictionaryEncodeOrig(
+										   DatumStreamBlockWrite * dsw)
+{
+	DatumStreamBlock_Dictionary_Extension extension;
+	int32		dataSize;
+	int32		count;
+	uint8	   *item;
+	uint8	   *p;
+	int32		encodedSize;
+	int			i;
+
+	if (!dsw->dictionary_want_encoding || dsw->physical_datum_count < 2)
+		return 0;
+
+	Assert(dsw->typeInfo->datumlen == -1);
+	Assert(dsw->physical_datum_count <= dsw->maxDatumPerBlock);
+
+	dataSize = dsw->datump - dsw->datum_buffer;
+
+	for (i = 0; i < DATUMSTREAM_DICTIONARY_HASH_SIZE; i++)
+		dsw->dictionary_hash[i] = -1;
+
+	count = 0;
+	extension.dictionary_size = 0;
+	item = dsw->datum_buffer;
+	for (i = 0; i < dsw->physical_datum_count; i++)
+	{
+		int32		itemSize;
+		uint32		h;
+		int16		code;
+
+		/*
+		 * Skip any zero padding in front of the item, like the reader does.
+		 */
+		if (*item == 0)
+			item = (uint8 *) att_align_nominal(item, dsw->typeInfo->align);
+		itemSize = VARSIZE_ANY(item);
+
+		h = DatumGetUInt32(hash_any(item, itemSize)) &
+			(DATUMSTREAM_DICTIONARY_HASH_SIZE - 1);
+		while ((code = dsw->dictionary_hash[h]) != -1)
+		{
+			if (dsw->dictionary_item_sizes[code] == itemSize &&
+				memcmp(dsw->dictionary_items[code], item, itemSize) == 0)
+				break;
+			h = (h + 1) & (DATUMSTREAM_DICTIONARY_HASH_SIZE - 1);
+		}
+
+		if (code == -1)
+		{
+			if (count == DATUMSTREAM_DICTIONARY_MAX_COUNT)
+				return 0;
+
+			code = count++;
+			dsw->dictionary_hash[h] = code;
+			dsw->dictionary_items[code] = item;
+			dsw->dictionary_item_sizes[code] = itemSize;
+
+			/* Worst case padding; the exact size is known below. */
+			extension.dictionary_size += itemSize + MAXIMUM_ALIGNOF;
+			if (sizeof(DatumStreamBlock_Dictionary_Extension) +
+				extension.dictionary_size + dsw->physical_datum_count >= dataSize)
+				return 0;
+		}
+
+		dsw->dictionary_codes[i] = (uint8) code;
+		item += itemSize;
+	}
+
+	/*
+	 * Lay out the extension, the dictionary items (4 byte header items
+	 * aligned as in the datum area) and the codes.
+	 */
+	p = dsw->dictionary_buffer + sizeof(DatumStreamBlock_Dictionary_Extension);
+	for (i = 0; i < count; i++)
+	{
+		item = dsw->dictionary_items[i];
+		if (!VARATT_IS_SHORT(item))
+			p = (uint8 *) att_align_zero((char *) p, dsw->typeInfo->align);
+		memcpy(p, item, dsw->dictionary_item_sizes[i]);
+		p += dsw->dictionary_item_sizes[i];
+	}
+
+	extension.dictionary_count = count;
+	extension.dictionary_size =
+		(p - dsw->dictionary_buffer) - sizeof(DatumStreamBlock_Dictionary_Extension);
+	memcpy(dsw->dictionary_buffer, &extension, sizeof(DatumStreamBlock_Dictionary_Extension));
+
+	memcpy(p, dsw->dictionary_codes, dsw->physical_datum_count);
+	p += dsw->physical_datum_count;
+
+	encodedSize = p - dsw->dictionary_buffer;
+	Assert(encodedSize < dataSize);
+
+	return encodedSize;
+}
+
 static int64
 DatumStreamBlockWrite_BlockOrig(
 								DatumStreamBlockWrite * dsw,
@@ -3636,12 +3844,20 @@ DatumStreamBlockWrite_BlockOrig(
 	int32		rowCount;
 	int64		writesz;
 	bool		minimalIntegrityChecks;
+	int32		dictionarySize;
 
 	p = buffer;
 
+	dictionarySize = DatumStreamBlockWrite_DictionaryEncodeOrig(dsw);
+
 	/* First write header */
 	block.version = DatumStreamVersion_Original;
 	block.flags = dsw->has_null ? DSB_HAS_NULLBITMAP : 0;
+	if (dictionarySize > 0)
+	{
+		block.version = DatumStreamBlockVersion_Original_Dictionary;
+		block.flags |= DSB_HAS_DICTIONARY;
+	}
 	block.ndatum = dsw->nth;
 	block.unused = 0;
 /* NOTE:Unfortunately, this was not zeroed in the earlier releases of the code. */
@@ -3661,7 +3877,10 @@ DatumStreamBlockWrite_BlockOrig(
 		block.nullsz = MAXALIGN(unalignedNullSize);
 	}
 
-	block.sz = dsw->datump - dsw->datum_buffer;
+	if (dictionarySize > 0)
+		block.sz = dictionarySize;
+	else
+		block.sz = dsw->datump - dsw->datum_buffer;
 
 	/*
 	 * Serialize the different data in to the write buffer.
@@ -3689,7 +3908,10 @@ DatumStreamBlockWrite_BlockOrig(
 	}
 
 	/* Next write data */
-	memcpy(p, dsw->datum_buffer, block.sz);
+	if (dictionarySize > 0)
+		memcpy(p, dsw->dictionary_buffer, block.sz);
+	else
+		memcpy(p, dsw->datum_buffer, block.sz);
 	p += block.sz;
 
 	/* Calculate write size. */
@@ -4222,6 +4444,7 @@ DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dictionary_want_encoding,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
@@ -4238,6 +4461,7 @@ DatumStreamBlockWrite_Init(
 
 	dsw->rle_want_compression = rle_want_compression;
 	dsw->delta_want_compression = delta_want_compression;
+	dsw->dictionary_want_encoding = dictionary_want_encoding;
 
 	dsw->initialMaxDatumPerBlock = initialMaxDatumPerBlock;
 	dsw->maxDatumPerBlock = maxDatumPerBlock;
@@ -4275,6 +4499,26 @@ DatumStreamBlockWrite_Init(
 			}
 			dsw->null_bitmap_buffer = palloc(dsw->null_bitmap_buffer_size);
 
+			if (dsw->dictionary_want_encoding)
+			{
+				Assert(dsw->typeInfo->datumlen == -1);
+
+				/*
+				 * An encoded block is only used when it is smaller than the
+				 * datum area it replaces.
+				 */
+				dsw->dictionary_buffer_size = dsw->datum_buffer_size;
+				dsw->dictionary_buffer = palloc(dsw->dictionary_buffer_size);
+
+				dsw->dictionary_items =
+					palloc(DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(uint8 *));
+				dsw->dictionary_item_sizes =
+					palloc(DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(int32));
+				dsw->dictionary_hash =
+					palloc(DATUMSTREAM_DICTIONARY_HASH_SIZE * sizeof(int16));
+				dsw->dictionary_codes = palloc(dsw->maxDatumPerBlock);
+			}
+
 			if (Debug_appendonly_print_insert)
 			{
 				ereport(LOG,
@@ -4449,6 +4693,21 @@ DatumStreamBlockWrite_Finish(
 	if (dsw->delta_sign != NULL)
 		pfree(dsw->delta_sign);
 
+	if (dsw->dictionary_buffer != NULL)
+		pfree(dsw->dictionary_buffer);
+
+	if (dsw->dictionary_items != NULL)
+		pfree(dsw->dictionary_items);
+
+	if (dsw->dictionary_item_sizes != NULL)
+		pfree(dsw->dictionary_item_sizes);
+
+	if (dsw->dictionary_hash != NULL)
+		pfree(dsw->dictionary_hash);
+
+	if (dsw->dictionary_codes != NULL)
+		pfree(dsw->dictionary_codes);
+
 	MemoryContextSwitchTo(oldCtxt);
 }
 
@@ -4701,7 +4960,8 @@ DatumStreamBlock_IntegrityCheckOrig(
 	headerSize = minHeaderSize;
 	p = buffer + headerSize;
 
-	if (blockOrig->version != DatumStreamVersion_Original)
+	if (blockOrig->version != DatumStreamVersion_Original &&
+		blockOrig->version != DatumStreamBlockVersion_Original_Dictionary)
 	{
 		ereport(ERROR,
 				(errmsg("Bad datum stream Original block version.  Found %d and expected %d",
@@ -4712,13 +4972,24 @@ DatumStreamBlock_IntegrityCheckOrig(
 				 errcontextCallback(errcontextArg)));
 	}
 
+	if ((blockOrig->flags & ~DSB_KNOWN_FLAGS_ORIG) != 0 ||
+		((blockOrig->flags & DSB_HAS_DICTIONARY) != 0) !=
+		(blockOrig->version == DatumStreamBlockVersion_Original_Dictionary))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Original block flags 0x%x for block version %d",
+						blockOrig->flags,
+						blockOrig->version),
+				 errOmitLocation(false),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
 	if (minimalIntegrityChecks)
 	{
 		return;
 	}
 
-	/* CONSIDER: Verify reserved flags are Zero */
-
 	hasNull = ((blockOrig->flags & DSB_HAS_NULLBITMAP) != 0);
 
 	/* UNDONE: Add a whole bunch of other checking... */
@@ -4731,7 +5002,100 @@ DatumStreamBlock_IntegrityCheckOrig(
 		p += blockOrig->nullsz;
 	}
 
-	if (typeInfo->datumlen == -1)
+	if ((blockOrig->flags & DSB_HAS_DICTIONARY) != 0)
+	{
+		DatumStreamBlock_Dictionary_Extension *extension;
+		int32		dictionaryCount;
+		int32		codesCount;
+		int32		nullCount;
+		uint8	   *codesp;
+		int			i;
+
+		if (typeInfo->datumlen != -1)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream Original block has a dictionary but its items are not variable-length (datumlen %d)",
+							typeInfo->datumlen),
+					 errOmitLocation(false),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		/*
+		 * The datum area begins MAXALIGN after the header and NULL bit-map.
+		 */
+		p = buffer + MAXALIGN(p - buffer);
+
+		extension = (DatumStreamBlock_Dictionary_Extension *) p;
+		codesCount = blockOrig->sz -
+			(int32) sizeof(DatumStreamBlock_Dictionary_Extension) -
+			extension->dictionary_size;
+		if (extension->dictionary_count <= 0 ||
+			extension->dictionary_count > DATUMSTREAM_DICTIONARY_MAX_COUNT ||
+			extension->dictionary_size <= 0 ||
+			codesCount < 0)
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream Original block dictionary (count %d, size %d, data size %d)",
+							extension->dictionary_count,
+							extension->dictionary_size,
+							blockOrig->sz),
+					 errOmitLocation(false),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		p += sizeof(DatumStreamBlock_Dictionary_Extension);
+		dictionaryCount = DatumStreamBlock_IntegrityCheckVarlena(
+																 p,
+												extension->dictionary_size,
+											  DatumStreamVersion_Original,
+																 typeInfo,
+														  errdetailCallback,
+															   errdetailArg,
+														 errcontextCallback,
+															 errcontextArg);
+		if (dictionaryCount != extension->dictionary_count)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream Original block dictionary item count does not match.  Found %d, expected %d",
+							dictionaryCount,
+							extension->dictionary_count),
+					 errOmitLocation(false),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		nullCount = hasNull ?
+			DatumStreamBitMap_CountOn(buffer + headerSize, blockOrig->ndatum) : 0;
+		if (codesCount != blockOrig->ndatum - nullCount)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream Original block dictionary code count does not match.  Found %d, expected %d",
+							codesCount,
+							blockOrig->ndatum - nullCount),
+					 errOmitLocation(false),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		codesp = p + extension->dictionary_size;
+		for (i = 0; i < codesCount; i++)
+		{
+			if (codesp[i] >= dictionaryCount)
+			{
+				ereport(ERROR,
+						(errmsg("Datum stream Original block dictionary code %d of item #%d out of range (dictionary count %d)",
+								codesp[i],
+								i,
+								dictionaryCount),
+						 errOmitLocation(false),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
+		}
+	}
+	else if (typeInfo->datumlen == -1)
 	{
 		/*
 		 * Variable length items (i.e. varlena).
@@ -4943,13 +5307,21 @@ DatumStreamBlock_IntegrityCheckDense(
 				 errcontextCallback(errcontextArg)));
 	}
 
+	if ((blockDense->orig_4_bytes.flags & ~DSB_KNOWN_FLAGS_DENSE) != 0)
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Dense block flags 0x%x",
+						blockDense->orig_4_bytes.flags),
+				 errOmitLocation(false),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
 	if (minimalIntegrityChecks)
 	{
 		return;
 	}
 
-	/* CONSIDER: Verify reserved flags are Zero */
-
 	hasNull = ((blockDense->orig_4_bytes.flags & DSB_HAS_NULLBITMAP) != 0);
 	hasRleCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_RLE_COMPRESSION) != 0);
 	hasDeltaCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DELTA_COMPRESSION) != 0);
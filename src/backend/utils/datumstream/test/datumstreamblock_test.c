@@ -167,13 +167,124 @@ test__DeltaCompression__Core(void **state)
 	free(dsw);
 }
 
+/*
+ * Unit test function to test dictionary encoding of an Original block
+ * and the reading of its dictionary.
+ */
+void
+test__DictionaryEncode__Core(void **state)
+{
+	static const char *values[] = {"a", "bb", "a", "ccc", "bb", "a"};
+	const int	nvalues = 6;
+	const int	repeat = 30;
+	DatumStreamTypeInfo typeInfo;
+	DatumStreamBlock_Dictionary_Extension *extension;
+	DatumStreamBlockRead *dsr;
+	int32		encodedSize;
+	uint8	   *codes;
+	int			i;
+
+	DatumStreamBlockWrite *dsw = malloc(sizeof(DatumStreamBlockWrite));
+	memset(dsw, 0, sizeof(DatumStreamBlockWrite));
+
+	typeInfo.datumlen = -1;
+	typeInfo.typid = TEXTOID;
+	typeInfo.align = 'i';
+	typeInfo.byval = false;
+
+	strncpy(dsw->eyecatcher, DatumStreamBlockWrite_Eyecatcher, DatumStreamBlockWrite_EyecatcherLen);
+	dsw->datumStreamVersion = DatumStreamVersion_Original;
+	dsw->dictionary_want_encoding = true;
+	dsw->typeInfo = &typeInfo;
+	dsw->maxDataBlockSize = 32768;
+	dsw->maxDatumPerBlock = 256;
+	dsw->datum_buffer_size = dsw->maxDataBlockSize;
+	dsw->datum_buffer = malloc(dsw->datum_buffer_size);
+	dsw->dictionary_buffer_size = dsw->datum_buffer_size;
+	dsw->dictionary_buffer = malloc(dsw->dictionary_buffer_size);
+	dsw->dictionary_items = malloc(DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(uint8 *));
+	dsw->dictionary_item_sizes = malloc(DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(int32));
+	dsw->dictionary_hash = malloc(DATUMSTREAM_DICTIONARY_HASH_SIZE * sizeof(int16));
+	dsw->dictionary_codes = malloc(dsw->maxDatumPerBlock);
+
+	/* Store the items as short varlenas, like the put routine does */
+	dsw->datump = dsw->datum_buffer;
+	for (i = 0; i < nvalues * repeat; i++)
+	{
+		const char *value = values[i % nvalues];
+		int			len = strlen(value);
+
+		SET_VARSIZE_1B(dsw->datump, VARHDRSZ_SHORT + len);
+		memcpy(VARDATA_1B(dsw->datump), value, len);
+		dsw->datump += VARHDRSZ_SHORT + len;
+		dsw->physical_datum_count++;
+	}
+
+	/* All items hash alike; the probing must still tell them apart */
+	expect_any_count(hash_any, k, nvalues * repeat);
+	expect_any_count(hash_any, keylen, nvalues * repeat);
+	will_return_count(hash_any, UInt32GetDatum(0), nvalues * repeat);
+
+	encodedSize = DatumStreamBlockWrite_DictionaryEncodeOrig(dsw);
+
+	/* Extension, "a", "bb" and "ccc" once, then one code per item */
+	assert_int_equal(encodedSize,
+					 sizeof(DatumStreamBlock_Dictionary_Extension) + 2 + 3 + 4 + nvalues * repeat);
+	extension = (DatumStreamBlock_Dictionary_Extension *) dsw->dictionary_buffer;
+	assert_int_equal(extension->dictionary_count, 3);
+	assert_int_equal(extension->dictionary_size, 2 + 3 + 4);
+
+	codes = dsw->dictionary_buffer + sizeof(DatumStreamBlock_Dictionary_Extension) + extension->dictionary_size;
+	for (i = 0; i < repeat; i++)
+	{
+		assert_int_equal(codes[i * nvalues + 0], 0);
+		assert_int_equal(codes[i * nvalues + 1], 1);
+		assert_int_equal(codes[i * nvalues + 2], 0);
+		assert_int_equal(codes[i * nvalues + 3], 2);
+		assert_int_equal(codes[i * nvalues + 4], 1);
+		assert_int_equal(codes[i * nvalues + 5], 0);
+	}
+
+	/* Read the dictionary back */
+	dsr = malloc(sizeof(DatumStreamBlockRead));
+	memset(dsr, 0, sizeof(DatumStreamBlockRead));
+	memcpy(&dsr->typeInfo, &typeInfo, sizeof(DatumStreamTypeInfo));
+	dsr->dictionary_items = malloc(DATUMSTREAM_DICTIONARY_MAX_COUNT * sizeof(uint8 *));
+	dsr->datum_beginp = dsw->dictionary_buffer;
+	dsr->physical_data_size = encodedSize;
+
+	DatumStreamBlockRead_GetReadyDictionary(dsr);
+
+	assert_int_equal(dsr->dictionary_count, 3);
+	assert_true(dsr->dictionary_codesp == codes);
+	assert_true(dsr->dictionary_id != 0);
+	for (i = 0; i < 3; i++)
+	{
+		uint8	   *item = dsr->dictionary_items[i];
+
+		assert_int_equal(VARSIZE_ANY_EXHDR(item), strlen(values[i == 2 ? 3 : i]));
+		assert_true(memcmp(VARDATA_ANY(item), values[i == 2 ? 3 : i], VARSIZE_ANY_EXHDR(item)) == 0);
+	}
+
+	free(dsr->dictionary_items);
+	free(dsr);
+	free(dsw->datum_buffer);
+	free(dsw->dictionary_buffer);
+	free(dsw->dictionary_items);
+	free(dsw->dictionary_item_sizes);
+	free(dsw->dictionary_hash);
+	free(dsw->dictionary_codes);
+	free(dsw);
+}
+
 int 
 main(int argc, char* argv[]) 
 {
 	cmockery_parse_arguments(argc, argv);
 
 	const UnitTest tests[] = {
-			unit_test(test__DeltaCompression__Core)
+			unit_test(test__DeltaCompression__Core),
+			unit_test(test__DictionaryEncode__Core)
 	};
 	return run_tests(tests);
 }
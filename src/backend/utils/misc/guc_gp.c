@@ -19,6 +19,7 @@
 #include "access/transam.h"
 #include "access/url.h"
 #include "access/xlog_internal.h"
+#include "cdb/cdbaocsam.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbfilerep.h"
@@ -71,6 +72,8 @@ static double defunct_double = 0;
  */
 static const char *assign_hashagg_compress_spill_files(const char *newval, bool doit, GucSource source);
 static const char *assign_gp_workfile_compress_algorithm(const char *newval, bool doit, GucSource source);
+static const char *assign_gp_workfile_compress_hashjoin(const char *newval, bool doit, GucSource source);
+static const char *assign_gp_workfile_compress_hashagg(const char *newval, bool doit, GucSource source);
 static const char *assign_gp_workfile_type_hashjoin(const char *newval, bool doit, GucSource source);
 static const char *assign_debug_persistent_print_level(const char *newval,
 									bool doit, GucSource source);
@@ -175,6 +178,7 @@ bool		gp_persistent_statechange_suppress_error = false;
 bool		Debug_bitmap_print_insert = false;
 bool		Test_appendonly_override = false;
 bool		Test_print_direct_dispatch_info = false;
+bool		Test_print_slice_plan_dispatch_info = false;
 bool		gp_test_orientation_override = false;
 bool		gp_permit_persistent_metadata_update = false;
 bool		gp_permit_relation_node_change = false;
@@ -188,6 +192,8 @@ bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_verify_eof = true;
 bool		gp_appendonly_compaction = true;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_appendonly_read_ahead = 1024;
+int			gp_appendonly_decompress_workers = 0;
 bool		gp_heap_require_relhasoids_match = true;
 bool		Debug_appendonly_rezero_quicklz_compress_scratch = false;
 bool		Debug_appendonly_rezero_quicklz_decompress_scratch = false;
@@ -362,6 +368,8 @@ static char *gp_interconnect_fc_method_str;
  */
 static char *gp_hashagg_compress_spill_files_str;
 static char *gp_workfile_compress_algorithm_str;
+static char *gp_workfile_compress_hashjoin_str;
+static char *gp_workfile_compress_hashagg_str;
 static char *gp_workfile_type_hashjoin_str;
 static char *optimizer_log_failure_str;
 static char *optimizer_minidump_str;
@@ -462,6 +470,8 @@ bool		gp_enable_hashjoin_size_heuristic = false;
 bool		gp_enable_fallback_plan = true;
 bool		gp_enable_predicate_propagation = false;
 bool		gp_enable_multiphase_agg = true;
+bool		gp_enable_skew_spreading = false;
+double		gp_skew_hotkey_factor = 1.0;
 bool		gp_enable_preunique = TRUE;
 bool		gp_eager_preunique = FALSE;
 bool		gp_enable_sequential_window_plans = FALSE;
@@ -659,6 +669,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_enable_direct_dispatch,
 		true, NULL, NULL
 	},
+	{
+		{"gp_enable_slice_plan_dispatch", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Dispatch to each slice only the part of the plan it executes."),
+			gettext_noop("Reduces dispatch traffic for plans with many slices, at "
+						 "the cost of serializing the plan once per slice.")
+		},
+		&gp_enable_slice_plan_dispatch,
+		false, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -771,6 +790,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_enable_skew_spreading", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables spreading of hot join keys in redistributed hash joins."),
+			gettext_noop("Outer rows with a hot key are spread over all segments "
+						 "and the matching inner rows are broadcast.")
+		},
+		&gp_enable_skew_spreading,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_enable_hash_partitioned_tables", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable hash partitioned tables."),
@@ -974,6 +1003,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_sort_limit_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable filtering the input scan of a LIMIT sort by the sort key of the last tuple that makes the cut."),
+			NULL,
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_sort_limit_filter,
+		true, NULL, NULL
+	},
+
 
 #ifdef USE_ASSERT_CHECKING
 	{
@@ -1017,6 +1056,36 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_hashjoin_runtime_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable filtering outer scans of hash joins with a filter built from the inner join keys."),
+			NULL,
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_runtime_filter,
+		true, NULL, NULL
+	},
+
+	{
+		{"gp_hashjoin_cluster_tuples", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Lay out the tuples of large in-memory hash join tables in bucket order."),
+			NULL,
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_cluster_tuples,
+		true, NULL, NULL
+	},
+
+	{
+		{"gp_hashjoin_reverse_batches", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Build the hash table of a spilled inner join batch from its outer side when that side is smaller."),
+			NULL,
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_reverse_batches,
+		true, NULL, NULL
+	},
+
 	{
 		{"gp_selectivity_damping_for_scans", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Damping of selectivities for clauses over the same base relation."),
@@ -1165,6 +1234,36 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_zone_maps", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Keep per-block min/max summaries in the block directory of append-only tables, and use them to skip blocks in scans."),
+			gettext_noop("Summaries are only kept for tables that have a block directory, i.e. that have an index."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_zone_maps,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_late_materialization", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("In scans of column-oriented tables, read the columns that are not referenced by the filter only for rows that pass it."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_late_materialization,
+		true, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_dictionary_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Store the blocks of variable-length columns of column-oriented tables with few distinct values as a dictionary and codes."),
+			gettext_noop("Only affects columns without RLE_TYPE compression."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_aocs_dictionary_encoding,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -1965,6 +2064,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"test_print_slice_plan_dispatch_info", PGC_SUSET, DEVELOPER_OPTIONS,
+			gettext_noop("For testing purposes, print how many slices were dispatched a pruned plan."),
+			NULL,
+			GUC_SUPERUSER_ONLY | GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&Test_print_slice_plan_dispatch_info,
+		false, NULL, NULL
+	},
+
 	{
 		{"debug_bitmap_print_insert", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Print log messages for bitmap index insert routines (caution-- generate a lot of logs!)"),
@@ -3585,6 +3694,29 @@ struct config_int ConfigureNamesInt_gp[] =
 		10, 0, 100, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_read_ahead", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets how much data a scan of an append-only table asks the kernel to read ahead."),
+			gettext_noop("For column-oriented tables the amount is shared by all scanned columns. "
+						 "Zero disables read-ahead."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_read_ahead,
+		1024, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_decompress_workers", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets how many threads decompress the blocks ahead of a scan of a compressed append-only table."),
+			gettext_noop("The threads are shared by all scans of a session. Only zlib and zstd "
+						 "compressed blocks are decompressed ahead. Zero decompresses every "
+						 "block when the scan gets to it."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_decompress_workers,
+		0, 0, 32, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3605,6 +3737,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		100000, 0, INT_MAX, NULL, NULL,
 	},
 
+	{
+		{"gp_shareinput_shmem_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the shared memory used to pass shared Materialize results between slices of a segment."),
+			gettext_noop("One result may use at most 1/32 of it; the rest is passed in a workfile. 0 passes all results in workfiles."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_shmem_size,
+		0, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3989,6 +4131,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		5, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_prewarm_segworkers", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of idle segment worker groups to connect ahead of need."),
+			gettext_noop("Missing groups are connected in parallel when a statement needs "
+						 "segment workers. Limited by gp_cached_segworkers_threshold."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_prewarm_gang_count,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 
 	{
 #ifdef USE_ASSERT_CHECKING
@@ -4478,6 +4631,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		NUM_MINIPAGE_ENTRIES, 1, NUM_MINIPAGE_ENTRIES, NULL, NULL
 	},
 
+	{
+		{"gp_blockdirectory_minipage_cache_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Number of block directory minipages an index or bitmap scan of an append-only table keeps per column group."),
+			gettext_noop("Set to 0 to keep only the last minipage looked up."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_blockdirectory_minipage_cache_size,
+		8, 0, 1024, NULL, NULL
+	},
+
 
 	{
 		{"gp_segworker_relative_priority", PGC_POSTMASTER, RESOURCES_MGM,
@@ -4768,6 +4931,29 @@ struct config_real ConfigureNamesReal_gp[] =
 		0, 0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_skew_hotkey_factor", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets how skewed a join key must be for gp_enable_skew_spreading to spread it."),
+			gettext_noop("A most common value is hot when its frequency times the "
+						 "number of segments reaches this factor.")
+		},
+		&gp_skew_hotkey_factor,
+		1.0, 0.01, DBL_MAX, NULL, NULL
+	},
+
+	{
+		{"gp_hashagg_passthrough_ratio", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the groups per input row above which the bottom stage "
+						 "of a streamed two stage hashagg stops grouping."),
+			gettext_noop("Once a pass of the bottom stage reduces its input this little, "
+						 "the remaining rows are passed through to the top stage. "
+						 "Zero disables this."),
+			GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashagg_passthrough_ratio,
+		0.9, 0.0, 1.0, NULL, NULL
+	},
+
 	{
 		{"gp_hashagg_rewrite_limit", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("(Obsolete) Planner will not choose hashed aggregation if "
@@ -4905,13 +5091,35 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_workfile_compress_algorithm", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Specify the compression algorithm that work files in the query executor use."),
-			gettext_noop("Valid values are \"NONE\", \"ZLIB\"."),
+			gettext_noop("Valid values are \"NONE\", \"ZLIB\", \"LZ\"."),
 			GUC_GPDB_ADDOPT
 		},
 		&gp_workfile_compress_algorithm_str,
 		"none", assign_gp_workfile_compress_algorithm, NULL
 	},
 
+	{
+		{"gp_workfile_compress_hashjoin", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Specify the compression algorithm that hash join work files use."),
+			gettext_noop("Valid values are \"DEFAULT\", \"NONE\", \"ZLIB\", \"LZ\". "
+						 "DEFAULT uses gp_workfile_compress_algorithm."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_compress_hashjoin_str,
+		"default", assign_gp_workfile_compress_hashjoin, NULL
+	},
+
+	{
+		{"gp_workfile_compress_hashagg", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Specify the compression algorithm that hash aggregate work files use."),
+			gettext_noop("Valid values are \"DEFAULT\", \"NONE\", \"ZLIB\", \"LZ\". "
+						 "DEFAULT uses gp_workfile_compress_algorithm."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_compress_hashagg_str,
+		"default", assign_gp_workfile_compress_hashagg, NULL
+	},
+
 	{
 		{"gp_workfile_type_hashjoin", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Specify the type of work files to use for executing hash join plans."),
@@ -5802,6 +6010,38 @@ assign_gp_workfile_compress_algorithm(const char *newval, bool doit, GucSource s
 	return newval;				/* OK */
 }
 
+static const char *
+assign_gp_workfile_compress_hashjoin(const char *newval, bool doit, GucSource source)
+{
+	int			i = -1;
+
+	if (pg_strcasecmp(newval, "default") != 0)
+	{
+		i = bfz_string_to_compression(newval);
+		if (i == -1)
+			return NULL;		/* fail */
+	}
+	if (doit)
+		gp_workfile_compress_hashjoin = i;
+	return newval;				/* OK */
+}
+
+static const char *
+assign_gp_workfile_compress_hashagg(const char *newval, bool doit, GucSource source)
+{
+	int			i = -1;
+
+	if (pg_strcasecmp(newval, "default") != 0)
+	{
+		i = bfz_string_to_compression(newval);
+		if (i == -1)
+			return NULL;		/* fail */
+	}
+	if (doit)
+		gp_workfile_compress_hashagg = i;
+	return newval;				/* OK */
+}
+
 static const char *
 assign_gp_workfile_type_hashjoin(const char *newval, bool doit, GucSource source)
 {
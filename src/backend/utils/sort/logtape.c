@@ -57,6 +57,14 @@
  * not clear this helps much, but it can't hurt.  (XXX perhaps a LIFO
  * policy for free blocks would be better?)
  *
+ * Because of that, the blocks of a tape mostly follow each other in the
+ * file: an initial run takes its blocks from the end of the file, and a
+ * merge output takes the lowest free ones in order.  A tape that is read
+ * forward by a merge can be given a read-ahead buffer (see
+ * LogicalTapeSetReadAhead); it then reads that many blocks with a single
+ * request, and keeps those that turn out to continue the tape.  This turns
+ * the block-at-a-time reads of a wide merge into large sequential ones.
+ *
  * To support the above policy of writing to the lowest free block,
  * ltsGetFreeBlock sorts the list of free block numbers into decreasing
  * order each time it is asked for a block and the list isn't currently
@@ -114,6 +122,17 @@ struct LogicalTape
 
 	int64 		firstBlkNum;  /* First block block number */
 	LogicalTapePos   currPos;         /* current postion */
+
+	/*
+	 * Read-ahead buffer of a tape that is read forward and not frozen.
+	 * readAhead[readAheadNext .. readAheadCount - 1] are the blocks that
+	 * follow currBlk on the tape; readAhead[i] is block readAheadBlkNum + i.
+	 */
+	LogicalTapeBlock *readAhead;	/* NULL if the tape reads block at a time */
+	int			readAheadSize;	/* # of blocks readAhead has room for */
+	int			readAheadCount;	/* # of valid blocks in readAhead */
+	int			readAheadNext;	/* next block of readAhead to use */
+	int64		readAheadBlkNum;	/* block number of readAhead[0] */
 };
 
 /*
@@ -156,6 +175,7 @@ struct LogicalTapeSet
 
 static void ltsWriteBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer);
+static void ltsReadNextBlock(LogicalTapeSet *lts, LogicalTape *lt);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static void ltsReleaseBlock(LogicalTapeSet *lts, int64 blocknum);
 static LogicalTapeSet *LogicalTapeSetCreate_Named(const char *set_prefix, int ntapes, bool del_on_close);
@@ -208,6 +228,10 @@ LoadLogicalTapeSetState(ExecWorkFile *statefile, ExecWorkFile *tapefile)
 
 	lt->writing = false;
 	lt->frozen = true;
+	lt->readAhead = NULL;
+	lt->readAheadSize = 0;
+	lt->readAheadCount = 0;
+	lt->readAheadNext = 0;
 
 	readSize = ExecWorkFile_Read(statefile, &(lt->firstBlkNum), sizeof(lt->firstBlkNum));
 	if(readSize != sizeof(lt->firstBlkNum))
@@ -268,6 +292,66 @@ ltsReadBlock(LogicalTapeSet *lts, int64 blocknum, void *buffer)
 	}
 }
 
+/*
+ * Read the block that follows currBlk on a tape being read forward into
+ * currBlk.
+ *
+ * With a read-ahead buffer, the block is taken from the buffer if it is
+ * there.  Otherwise the buffer is refilled with one read of the block and
+ * the ones after it in the file, of which we keep those that the chain of
+ * next_blk links reaches without a gap.
+ */
+static void
+ltsReadNextBlock(LogicalTapeSet *lts, LogicalTape *lt)
+{
+	int64		blocknum = lt->currBlk.next_blk;
+	int64		nblocks;
+	uint64		nread;
+	int			count;
+
+	Assert(!lt->writing && blocknum != -1L);
+
+	if (lt->readAheadNext < lt->readAheadCount)
+	{
+		Assert(lt->readAheadBlkNum + lt->readAheadNext == blocknum);
+		memcpy(&lt->currBlk, &lt->readAhead[lt->readAheadNext], sizeof(LogicalTapeBlock));
+		lt->readAheadNext++;
+		return;
+	}
+
+	if (lt->readAhead == NULL || lt->frozen)
+	{
+		ltsReadBlock(lts, blocknum, &lt->currBlk);
+		return;
+	}
+
+	/*
+	 * Don't read past the blocks handed out so far.  The last of them may
+	 * still be in the memory of a tape being written; reading it short is
+	 * fine, since it cannot belong to this tape.
+	 */
+	nblocks = Min(lt->readAheadSize, lts->nFileBlocks - blocknum);
+	Assert(nblocks > 0);
+
+	nread = 0;
+	if (ExecWorkFile_Seek(lts->pfile, blocknum * BLCKSZ, SEEK_SET) == 0)
+		nread = ExecWorkFile_Read(lts->pfile, lt->readAhead, nblocks * BLCKSZ) / BLCKSZ;
+	if (nread == 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read block " INT64_FORMAT  " of temporary file: %m",
+						blocknum)));
+
+	count = 1;
+	while (count < nread && lt->readAhead[count - 1].next_blk == blocknum + count)
+		count++;
+
+	memcpy(&lt->currBlk, &lt->readAhead[0], sizeof(LogicalTapeBlock));
+	lt->readAheadBlkNum = blocknum;
+	lt->readAheadCount = count;
+	lt->readAheadNext = 1;
+}
+
 /*
  * qsort comparator for sorting freeBlocks[] into decreasing order.
  */
@@ -363,6 +447,10 @@ LogicalTapeCreate(LogicalTapeSet *lts, LogicalTape *lt)
 	lt->firstBlkNum = -1L;
 	lt->currPos.blkNum = -1L;
 	lt->currPos.offset = 0;
+	lt->readAhead = NULL;
+	lt->readAheadSize = 0;
+	lt->readAheadCount = 0;
+	lt->readAheadNext = 0;
 	return lt;
 }
 
@@ -454,8 +542,15 @@ LogicalTapeSet *LogicalTapeSetCreate_File(ExecWorkFile *ewfile, int ntapes)
 void
 LogicalTapeSetClose(LogicalTapeSet *lts, workfile_set *workset)
 {
+	int			i;
+
 	Assert(lts != NULL);
 	workfile_mgr_close_file(workset, lts->pfile);
+	for (i = 0; i < lts->nTapes; i++)
+	{
+		if (lts->tapes[i].readAhead)
+			pfree(lts->tapes[i].readAhead);
+	}
 	if(lts->freeBlocks)
 		pfree(lts->freeBlocks);
 	pfree(lts);
@@ -540,6 +635,9 @@ LogicalTapeRewind(LogicalTapeSet *lts, LogicalTape *lt, bool forWrite)
 {
 	AssertEquivalent(lt->firstBlkNum==-1, lt->currPos.blkNum == -1);
 
+	lt->readAheadCount = 0;
+	lt->readAheadNext = 0;
+
 	if (!forWrite)
 	{
 		if (lt->writing)
@@ -618,7 +716,7 @@ LogicalTapeRead(LogicalTapeSet *lts, LogicalTape *lt, void *ptr, size_t size)
 			
 			lt->currPos.blkNum = lt->currBlk.next_blk;
 			lt->currPos.offset = 0;
-			ltsReadBlock(lts, lt->currBlk.next_blk, &lt->currBlk);
+			ltsReadNextBlock(lts, lt);
 
 			if(!lt->frozen)
 			{
@@ -644,6 +742,34 @@ LogicalTapeRead(LogicalTapeSet *lts, LogicalTape *lt, void *ptr, size_t size)
 	return nread;
 }
 
+/*
+ * Give a tape a read-ahead buffer of nblocks blocks, to be used while it is
+ * read forward without being frozen, or take it away if nblocks is less
+ * than 2.  The buffer is allocated in the current memory context.
+ *
+ * Must not be called while the tape is being read.
+ */
+void
+LogicalTapeSetReadAhead(LogicalTapeSet *lts, LogicalTape *lt, int nblocks)
+{
+	Assert(lt->readAheadNext == lt->readAheadCount);
+
+	if (nblocks < 2)
+		nblocks = 0;
+	if (nblocks == lt->readAheadSize)
+		return;
+
+	if (lt->readAhead)
+		pfree(lt->readAhead);
+	lt->readAhead = NULL;
+	if (nblocks > 0)
+		lt->readAhead = (LogicalTapeBlock *) palloc(nblocks * sizeof(LogicalTapeBlock));
+
+	lt->readAheadSize = nblocks;
+	lt->readAheadCount = 0;
+	lt->readAheadNext = 0;
+}
+
 /*
  * "Freeze" the contents of a tape so that it can be read multiple times
  * and/or read backwards.  Once a tape is frozen, its contents will not
@@ -782,6 +908,10 @@ LogicalTape *LogicalTapeSetDuplicateTape(LogicalTapeSet *lts, LogicalTape *lt)
 
 	Assert(lt->frozen);
 	memcpy(dup, lt, sizeof(LogicalTape));
+	dup->readAhead = NULL;
+	dup->readAheadSize = 0;
+	dup->readAheadCount = 0;
+	dup->readAheadNext = 0;
 
 	return dup;
 }
@@ -0,0 +1,173 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../tuplestorenew.c"
+
+/* Sets up a pool of npages pages, as the postmaster does */
+static void
+create_pool(int npages)
+{
+	gp_shareinput_shmem_size = npages * (BLCKSZ / 1024);
+	IsUnderPostmaster = false;
+
+	expect_any(ShmemInitStruct, name);
+	expect_any(ShmemInitStruct, size);
+	expect_any(ShmemInitStruct, foundPtr);
+	will_assign_value(ShmemInitStruct, foundPtr, false);
+	will_return(ShmemInitStruct, malloc(ntuplestore_shmem_size()));
+
+	ntuplestore_shmem_init();
+
+	assert_int_equal(nts_shmem->npages, npages);
+
+	expect_value_count(LWLockAcquire, lockid, ShareInputShmemLock, -1);
+	expect_any_count(LWLockAcquire, mode, -1);
+	will_be_called_count(LWLockAcquire, -1);
+	expect_value_count(LWLockRelease, lockid, ShareInputShmemLock, -1);
+	will_be_called_count(LWLockRelease, -1);
+}
+
+static int
+count_free_pages(void)
+{
+	int count = 0;
+	int pagen;
+
+	for (pagen = nts_shmem->first_free; pagen >= 0; pagen = nts_shmem_links[pagen])
+		count++;
+
+	return count;
+}
+
+static NTupleStore *
+create_store(int rwflag, const char *name)
+{
+	NTupleStore *ts = (NTupleStore *) palloc0(sizeof(NTupleStore));
+
+	ts->rwflag = rwflag;
+	ts->first_ondisk_blockn = -1;
+	ts->shm_slot = -1;
+
+	if (rwflag == NTS_IS_WRITER)
+		nts_shmem_create_slot(ts, name);
+	else
+		nts_shmem_attach_slot(ts, name);
+
+	return ts;
+}
+
+static bool
+write_block(NTupleStore *ts, long blockn)
+{
+	NTupleStorePage *page = (NTupleStorePage *) palloc(BLCKSZ);
+
+	init_page(page);
+	nts_page_set_blockn(page, blockn);
+	nts_page_set_dirty(page, true);
+
+	return nts_shmem_write_block(ts, page);
+}
+
+/*
+ * A writer keeps at most its share of the pool, and continues in the
+ * workfile from there.  Readers find the blocks in the pool.
+ */
+void
+test__nts_shmem_write_block__ContinuesInFileAfterShare(void **state)
+{
+	NTupleStore *writer;
+	NTupleStore *reader;
+	NTupleStorePage *page;
+	int npages = 4 * NTS_SHMEM_SLOTS;
+	long blockn;
+
+	create_pool(npages);
+
+	writer = create_store(NTS_IS_WRITER, "share_1");
+	assert_true(writer->shm_slot >= 0);
+	assert_int_equal(writer->shm_nblocks, 1);
+
+	for (blockn = 1; blockn < 4; blockn++)
+		assert_true(write_block(writer, blockn));
+	assert_false(writer->shm_full);
+
+	/* Block 4 would be more than the share of one store */
+	assert_false(write_block(writer, 4));
+	assert_true(writer->shm_full);
+	assert_int_equal(writer->shm_nblocks, 4);
+	assert_int_equal(writer->first_ondisk_blockn, writer->shm_nblocks);
+	assert_false(write_block(writer, 5));
+	assert_int_equal(writer->first_ondisk_blockn, 4);
+
+	/* Block 0 is written last, and stays in the pool */
+	assert_true(write_block(writer, 0));
+
+	assert_int_equal(count_free_pages(), npages - 4);
+
+	reader = create_store(NTS_IS_READER, "share_1");
+	assert_int_equal(reader->shm_slot, writer->shm_slot);
+	assert_int_equal(reader->shm_nblocks, 4);
+
+	page = (NTupleStorePage *) palloc(BLCKSZ);
+	assert_true(nts_shmem_read_block(reader, 3, page));
+	assert_int_equal(nts_page_blockn(page), 3);
+
+	nts_shmem_release_slot(writer);
+	assert_int_equal(writer->shm_slot, -1);
+	assert_int_equal(count_free_pages(), npages);
+}
+
+/*
+ * A writer that finds no page left starts its store in the workfile; one
+ * that runs out after its first block continues in the workfile.
+ */
+void
+test__nts_shmem_write_block__ContinuesInFileWhenPoolRunsOut(void **state)
+{
+	NTupleStore *writer1;
+	NTupleStore *writer2;
+	NTupleStore *writer3;
+	NTupleStore *reader;
+
+	create_pool(2);
+	assert_int_equal(nts_shmem->slot_pages, 1);
+
+	writer1 = create_store(NTS_IS_WRITER, "share_1");
+	writer2 = create_store(NTS_IS_WRITER, "share_2");
+	writer3 = create_store(NTS_IS_WRITER, "share_3");
+
+	assert_true(writer1->shm_slot >= 0);
+	assert_true(writer2->shm_slot >= 0);
+	assert_int_equal(writer3->shm_slot, -1);
+	assert_int_equal(writer3->shm_nblocks, 0);
+	assert_int_equal(count_free_pages(), 0);
+
+	assert_false(write_block(writer1, 1));
+	assert_int_equal(writer1->shm_nblocks, 1);
+	assert_int_equal(writer1->first_ondisk_blockn, 1);
+
+	reader = create_store(NTS_IS_READER, "share_3");
+	assert_int_equal(reader->shm_slot, -1);
+	assert_int_equal(reader->shm_nblocks, 0);
+
+	nts_shmem_release_slot(writer1);
+	nts_shmem_release_slot(writer2);
+	assert_int_equal(count_free_pages(), 2);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__nts_shmem_write_block__ContinuesInFileAfterShare),
+		unit_test(test__nts_shmem_write_block__ContinuesInFileWhenPoolRunsOut)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -152,11 +152,17 @@ typedef enum
  *
  * MERGE_BUFFER_SIZE is how much data we'd like to read from each input
  * tape during a preread cycle (see discussion at top of file).
+ *
+ * MERGE_READAHEAD_SIZE is the most we give each tape for reading ahead
+ * blocks of the underlying file during merge passes, so that a wide merge
+ * reads in large sequential chunks (see LogicalTapeSetReadAhead).  It comes
+ * out of the memory of the merge, and so lowers the merge order.
  */
 #define MINORDER		6		/* minimum merge order */
 #define MAXORDER 		250 	/* maximum merge order */
 #define TAPE_BUFFER_OVERHEAD		(BLCKSZ * 3)
 #define MERGE_BUFFER_SIZE			(BLCKSZ * 32)
+#define MERGE_READAHEAD_SIZE		(BLCKSZ * 32)
 
 // #define PRINT_SPILL_AND_MEMORY_MESSAGES
 
@@ -212,6 +218,7 @@ struct Tuplesortstate_mk
 
     int		maxTapes;	/* number of tapes (Knuth's T) */
     int		tapeRange;	/* maxTapes-1 (Knuth's P) */
+    int		readAheadBlocks;	/* read-ahead blocks of each tape in merges */
     MemoryContext 	sortcontext;	/* memory context holding all sort data */
     LogicalTapeSet 	*tapeset;	/* logtape.c object for tapes in a temp file */
 
@@ -282,6 +289,13 @@ struct Tuplesortstate_mk
 
     int currentRun;
 
+    /*
+     * Tuples written to the current run so far.  In a LIMIT sort, only the
+     * first limit-many tuples of each run can make it into the result, so
+     * the rest of the run is dropped rather than written.
+     */
+    int64 currentRunTuples;
+
     /*
      * Unless otherwise noted, all pointer variables below are pointers to
      * arrays of length maxTapes, holding per-tape data.
@@ -464,6 +478,7 @@ static inline bool LACKMEM_WITH_ESTIMATE(Tuplesortstate_mk *state)
 static Tuplesortstate_mk *tuplesort_begin_common(ScanState * ss, int workMem, bool randomAccess, bool allocmemtuple);
 static void puttuple_common(Tuplesortstate_mk *state, MKEntry *e); 
 static void selectnewtape_mk(Tuplesortstate_mk *state);
+static int merge_order_mk(long allowedMem);
 static void mergeruns(Tuplesortstate_mk *state);
 static void beginmerge(Tuplesortstate_mk *state);
 static uint32 getlen(Tuplesortstate_mk *state, TuplesortPos_mk *pos, LogicalTape *lt, bool eofOK);
@@ -502,6 +517,7 @@ static void tuplesort_inmem_limit_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_inmem_nolimit_insert(Tuplesortstate_mk * state, MKEntry * e);
 static void tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e);
 static void tuplesort_limit_sort(Tuplesortstate_mk *state);
+static void writetup_limited(Tuplesortstate_mk *state, LogicalTape *lt, MKEntry *e);
 
 static void tupsort_refcnt(void *vp, int ref); 
 
@@ -978,18 +994,44 @@ tuplesort_begin_datum_mk(ScanState * ss,
 void
 tuplesort_set_bound_mk(Tuplesortstate_mk *state, int64 bound)
 {
+	/* Assert we're called before loading any tuples */
+	Assert(state->status == TSS_INITIAL);
+	Assert(state->totalNumTuples == 0);
+
 	/*
-	 * GPDB_83_MERGE_FIXME: bounded sort not implemented for tuplesort_mk.
-	 * The top-N feature was added to tuplesort.c in PostgreSQL 8.3, but it
-	 * hasn't been ported over to tuplesort_mk.c yet. Or perhaps we should just
-	 * pick the valuable parts of tuplesort_mk.c into tuplesort.c, and get
-	 * rid of the separate tuplesort_mk.c?
-	 *
-	 * Until we do something about this, everything's still going to work,
-	 * but the top-N optimization won't apply when tuplesort_mk is used.
-	 * Note that the planner doesn't know about that, so cost estimates
-	 * involving sorting with tuplesort_mk and LIMIT might be way off.
+	 * The bound is the same as a CDB limit, which keeps only the first
+	 * limit-many tuples in a heap; see cdb_tuplesort_init_mk.
 	 */
+	if (bound > 0 && bound < 10000000)
+	{
+		state->mkctxt.limit = (int32) bound;
+		state->mkctxt.limitmask = -1;
+	}
+}
+
+/*
+ * tuplesort_limit_threshold_mk
+ *
+ *	In a LIMIT sort that has already seen limit-many tuples, fetch attribute
+ *	attno of the last tuple that currently makes the cut.  An input tuple
+ *	that sorts after it on the first sort key can not be part of the result.
+ *
+ * Returns false if there is no such tuple (yet).  The value is only valid
+ * until the next tuple is put into the sort.
+ */
+bool
+tuplesort_limit_threshold_mk(Tuplesortstate_mk *state, AttrNumber attno,
+							 Datum *value, bool *isnull)
+{
+	if (state->status != TSS_INITIAL || state->mkheap == NULL ||
+		state->mkctxt.limit == 0 || state->mkctxt.unique ||
+		mkheap_empty(state->mkheap))
+		return false;
+
+	Assert(state->mt_bind);
+	*value = memtuple_getattr((MemTuple) state->mkheap->p->ptr,
+							  state->mt_bind, attno, isnull);
+	return true;
 }
 
 /*
@@ -1719,6 +1761,27 @@ tuplesort_merge_order(long allowedMem)
     return mOrder;
 }
 
+/*
+ * merge_order_mk - merge order of a mk sort for given memory
+ *
+ * Like tuplesort_merge_order, but each input tape also needs its read-ahead
+ * buffer.  A lower order means more merge passes, but each of them reads
+ * its input sequentially.
+ */
+static int
+merge_order_mk(long allowedMem)
+{
+    int			mOrder;
+
+    mOrder = (allowedMem - TAPE_BUFFER_OVERHEAD) /
+        (MERGE_BUFFER_SIZE + MERGE_READAHEAD_SIZE + TAPE_BUFFER_OVERHEAD);
+
+    mOrder = Max(mOrder, MINORDER);
+    mOrder = Min(mOrder, MAXORDER);
+
+    return mOrder;
+}
+
 /*
  * inittapes - initialize for tape sorting.
  *
@@ -1734,7 +1797,7 @@ inittapes_mk(Tuplesortstate_mk *state, const char* rwfile_prefix)
     Assert(is_under_sort_or_exec_ctxt(state));
 
     /* Compute number of tapes to use: merge order plus 1 */
-    maxTapes = tuplesort_merge_order(state->memAllowed) + 1;
+    maxTapes = merge_order_mk(state->memAllowed) + 1;
 
 #ifdef PRINT_SPILL_AND_MEMORY_MESSAGES
     elog(INFO, "Spilling after %d", (int) state->entry_count);
@@ -1838,6 +1901,7 @@ inittapes_mk(Tuplesortstate_mk *state, const char* rwfile_prefix)
     }
 
     state->currentRun = 0;
+    state->currentRunTuples = 0;
 
     /*
      * Initialize variables of Algorithm D (step D1).
@@ -1958,6 +2022,26 @@ mergeruns(Tuplesortstate_mk *state)
         LogicalTapeRewind(state->tapeset, lt, false);
     }
 
+    /*
+     * Every tape is read by some merge pass, so give each a read-ahead
+     * buffer.  Together they take at most half the memory of the merge.
+     */
+    state->readAheadBlocks = Min(MERGE_READAHEAD_SIZE,
+            state->memAllowed / (2 * state->maxTapes)) / BLCKSZ;
+    if (state->readAheadBlocks >= 2)
+    {
+        MemoryContext oldctxt = MemoryContextSwitchTo(state->sortcontext);
+
+        for (tapenum = 0; tapenum < state->maxTapes; tapenum++)
+        {
+            lt = LogicalTapeSetGetTape(state->tapeset, tapenum);
+            LogicalTapeSetReadAhead(state->tapeset, lt, state->readAheadBlocks);
+        }
+        MemoryContextSwitchTo(oldctxt);
+    }
+    else
+        state->readAheadBlocks = 0;
+
     /* Clear gpmon for respilling data */
     if(state->gpmon_pkt)
     {
@@ -2240,7 +2324,8 @@ beginmerge(Tuplesortstate_mk *state)
     totalSlots = (state->mkheap == NULL) ? state->entry_allocsize : state->mkheap->alloc_size;
     slotsPerTape = (totalSlots - state->mergefirstfree) / activeTapes;
     slotsPerTape = Max(slotsPerTape, 128);
-    spacePerTape = state->memAllowed / activeTapes;
+    spacePerTape = (state->memAllowed -
+            (long) state->maxTapes * state->readAheadBlocks * BLCKSZ) / activeTapes;
 
 
     oldctxt = MemoryContextSwitchTo(state->sortcontext);
@@ -2381,6 +2466,7 @@ dumptuples_mk(Tuplesortstate_mk *state, bool alltuples)
         {
             markrunend(state, state->tp_tapenum[state->destTape]);
             state->currentRun++;
+            state->currentRunTuples = 0;
             state->tp_runs[state->destTape]++;
             state->tp_dummy[state->destTape]--; /* per Alg D step D2 */
 
@@ -2403,7 +2489,7 @@ dumptuples_mk(Tuplesortstate_mk *state, bool alltuples)
 
         Assert(!mke_is_empty(&e));
 
-        WRITETUP(state, lt, &e); 
+        writetup_limited(state, lt, &e);
 
         /*
          * If the heap is empty *or* top run number has changed, we've
@@ -2416,6 +2502,7 @@ dumptuples_mk(Tuplesortstate_mk *state, bool alltuples)
 #endif
             markrunend(state, state->tp_tapenum[state->destTape]);
             state->currentRun++;
+            state->currentRunTuples = 0;
             state->tp_runs[state->destTape]++;
             state->tp_dummy[state->destTape]--; /* per Alg D step D2 */
 
@@ -3559,6 +3646,29 @@ tuplesort_inmem_nolimit_insert(Tuplesortstate_mk *state, MKEntry *entry)
 
 }
 
+/*
+ * writetup_limited
+ *   Write a tuple to the current run during run building, unless the run
+ *   already has all the tuples a LIMIT sort can use from it.
+ *
+ *   The runs are sorted, so the first limit-many tuples of all runs hold
+ *   the result.  Unique sorts keep everything, because duplicates are only
+ *   removed when merging.
+ */
+static void
+writetup_limited(Tuplesortstate_mk *state, LogicalTape *lt, MKEntry *e)
+{
+    if (state->mkctxt.limit != 0 && !state->mkctxt.unique &&
+        state->currentRunTuples >= state->mkctxt.limit)
+    {
+        state->mkctxt.freeTup(e);
+        return;
+    }
+
+    state->currentRunTuples++;
+    WRITETUP(state, lt, e);
+}
+
 static void tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e)
 {
     int ins;
@@ -3573,12 +3683,13 @@ static void tuplesort_heap_insert(Tuplesortstate_mk *state, MKEntry *e)
     {
         LogicalTape *lt = LogicalTapeSetGetTape(state->tapeset, state->tp_tapenum[state->destTape]);
 
-        WRITETUP(state, lt, e);
+        writetup_limited(state, lt, e);
 
         if(!mkheap_run_match(state->mkheap, state->currentRun))
         {
             markrunend(state, state->tp_tapenum[state->destTape]);
             state->currentRun++;
+            state->currentRunTuples = 0;
             state->tp_runs[state->destTape]++;
             state->tp_dummy[state->destTape]--;
 
@@ -7,6 +7,9 @@
 #include "access/heapam.h"
 #include "executor/instrument.h"
 #include "executor/execWorkfile.h"
+#include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "utils/tuplestorenew.h"
 #include "utils/memutils.h"
 #include "utils/gp_alloc.h"
@@ -140,6 +143,52 @@ static inline void update_page_slot_entry(NTupleStorePage *page, int len)
 #define NTS_IS_WRITER 2
 #define NTS_IS_READER 3
 
+/*
+ * Shared memory pool of readerwriter stores.
+ *
+ * The writer of a store shared across slices keeps the leading blocks of
+ * the store in pages of a pool in shared memory, so that the readers on the
+ * same segment copy them from there instead of reading them from the file.
+ * Block 0 gets its page when the writer creates the store, since it is the
+ * last block to be written.  A store takes at most its even share of the
+ * pool, 1/NTS_SHMEM_SLOTS of the pages, so that one large result cannot
+ * leave none for the others.  Once the store has its share, or the pool has
+ * no page for the next block, that block and all the following ones go to
+ * the file, starting at its beginning.  Readers attach to the pool slot by
+ * the name of the store.
+ *
+ * Pages of the pool are given out from a free list.  Each slot maps the
+ * blocks of its store to pages.  The slots and the free list are protected
+ * by ShareInputShmemLock; the pages themselves are only written by the
+ * writer before it notifies the readers.
+ */
+#define NTS_SHMEM_SLOTS 32
+#define NTS_SHMEM_NAMELEN 64
+
+typedef struct NTupleStoreShmemSlot
+{
+	char name[NTS_SHMEM_NAMELEN];	/* name of the store, empty if slot is free */
+	int nblocks;					/* leading blocks of the store in the pool */
+} NTupleStoreShmemSlot;
+
+typedef struct NTupleStoreShmem
+{
+	int npages;			/* pages in the pool */
+	int slot_pages;		/* most pages one slot may take */
+	int first_free;		/* first free page, -1 if none */
+	NTupleStoreShmemSlot slots[NTS_SHMEM_SLOTS];
+} NTupleStoreShmem;
+
+/* Pointers into the pool, NULL if there is none */
+static NTupleStoreShmem *nts_shmem = NULL;
+static int *nts_shmem_links;	/* next free page of each free page */
+static int *nts_shmem_maps;		/* page of each block, slot_pages per slot */
+static char *nts_shmem_pages;
+
+#define NTS_SHMEM_SLOT_PAGES(npages) Max((npages) / NTS_SHMEM_SLOTS, 1)
+#define NTS_SHMEM_MAP(slotn) (nts_shmem_maps + (slotn) * nts_shmem->slot_pages)
+#define NTS_SHMEM_PAGE(pagen) (nts_shmem_pages + (Size) (pagen) * BLCKSZ)
+
 struct NTupleStore
 {
 	int page_max;   /* max page the store can use */
@@ -161,6 +210,11 @@ struct NTupleStore
 	ExecWorkFile *plobfile;  /* underlying backed file for lobs (entries does not fit one page) */
 	int64     lobbytes;  /* number of bytes written to lob file */
 
+	int shm_slot;        /* slot in the shared memory pool, -1 if none */
+	long shm_nblocks;    /* leading blocks kept in the shared memory pool */
+	bool shm_full;       /* writer: no more blocks go to the pool */
+	char shm_name[NTS_SHMEM_NAMELEN];  /* name of the store in the pool */
+
 	List *accessors;    /* all current accessors of the store */
 	bool fwacc; 		/* if I had already has a write acc */
 
@@ -196,6 +250,11 @@ struct NTupleStoreAccessor
 
 static void ntuplestore_init_reader(NTupleStore *store, int maxBytes);
 static void ntuplestore_create_spill_files(NTupleStore *nts);
+static void nts_shmem_create_slot(NTupleStore *ts, const char *name);
+static void nts_shmem_attach_slot(NTupleStore *ts, const char *name);
+static void nts_shmem_release_slot(NTupleStore *ts);
+static bool nts_shmem_read_block(NTupleStore *ts, long blockn, NTupleStorePage *page);
+static bool nts_shmem_write_block(NTupleStore *ts, NTupleStorePage *page);
 
 void ntuplestore_setinstrument(NTupleStore *st, struct Instrumentation *instr)
 {
@@ -301,6 +360,9 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 {
 	long diskblockn = blockn - ts->first_ondisk_blockn;
 
+	if(blockn < ts->shm_nblocks)
+		return nts_shmem_read_block(ts, blockn, page);
+
 	if(!ts->pfile)
 		return false;
 	
@@ -328,6 +390,9 @@ static bool ntsWriteBlock(NTupleStore *ts, NTupleStorePage *page)
 	Assert(ts->rwflag != NTS_IS_READER);
 	Assert(nts_page_blockn(page) >= 0); 
 
+	if(ts->shm_slot >= 0 && nts_shmem_write_block(ts, page))
+		return true;
+
 	if(ts->first_ondisk_blockn == -1)
 	{
 		AssertImply(ts->rwflag == NTS_IS_WRITER, nts_page_blockn(page) == 0); 
@@ -638,6 +703,9 @@ static void ntuplestore_cleanup(NTupleStore *ts, bool fNormal)
 		ts->work_set = NULL;
 	}
 
+	if (ts->shm_slot >= 0 && ts->rwflag == NTS_IS_WRITER)
+		nts_shmem_release_slot(ts);
+
 	gp_free(ts);
 }
 
@@ -660,6 +728,10 @@ ntuplestore_create(int maxBytes)
 	store->work_set = NULL;
 	store->workfiles_created = false;
 
+	store->shm_slot = -1;
+	store->shm_nblocks = 0;
+	store->shm_full = true;
+
 	Assert(maxBytes >= 0);
 	store->page_max = maxBytes / BLCKSZ;
 	/* give me at least 16 pages */
@@ -716,6 +788,8 @@ ntuplestore_create_readerwriter(const char *filename, int maxBytes, bool isWrite
 		store->plobfile = ExecWorkFile_Create(filenamelob, BUFFILE,
 				true /* delOnClose */, 0 /* compressType */ );
 		store->lobbytes = 0;
+
+		nts_shmem_create_slot(store, filename);
 	}
 	else
 	{
@@ -723,6 +797,8 @@ ntuplestore_create_readerwriter(const char *filename, int maxBytes, bool isWrite
 		store->work_set = NULL;
 		store->workfiles_created = false;
 
+		nts_shmem_attach_slot(store, filename);
+
 		store->pfile = ExecWorkFile_Open(filenameprefix, BUFFILE,
 				false /* delOnClose */,
 				0 /* compressType */);
@@ -749,7 +825,8 @@ ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 	Assert(NULL != store->pfile);
 	Assert(NULL != store->plobfile);
 	
-	store->first_ondisk_blockn = 0;
+	/* The blocks that are not in the shared memory pool are in the file */
+	store->first_ondisk_blockn = store->shm_nblocks;
 	store->rwflag = NTS_IS_READER;
 	store->lobbytes = 0;
 
@@ -1470,4 +1547,275 @@ ntuplestore_create_spill_files(NTupleStore *nts)
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * ntuplestore_shmem_size
+ *		Size of the shared memory pool of readerwriter stores.
+ */
+Size
+ntuplestore_shmem_size(void)
+{
+	Size npages = (Size) gp_shareinput_shmem_size * 1024 / BLCKSZ;
+	Size size;
+
+	if (npages == 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(NTupleStoreShmem));
+	size = add_size(size, MAXALIGN(mul_size(npages, sizeof(int))));
+	size = add_size(size, MAXALIGN(mul_size(mul_size(NTS_SHMEM_SLOT_PAGES(npages), NTS_SHMEM_SLOTS), sizeof(int))));
+	size = add_size(size, mul_size(npages, BLCKSZ));
+
+	return size;
+}
+
+/*
+ * ntuplestore_shmem_init
+ *		Set up the shared memory pool of readerwriter stores.
+ */
+void
+ntuplestore_shmem_init(void)
+{
+	int npages = (Size) gp_shareinput_shmem_size * 1024 / BLCKSZ;
+	char *ptr;
+	bool found;
+	int i;
+
+	if (npages == 0)
+		return;
+
+	ptr = ShmemInitStruct("NTupleStore Shared Pool", ntuplestore_shmem_size(), &found);
+
+	nts_shmem = (NTupleStoreShmem *) ptr;
+	ptr += MAXALIGN(sizeof(NTupleStoreShmem));
+	nts_shmem_links = (int *) ptr;
+	ptr += MAXALIGN(npages * sizeof(int));
+	nts_shmem_maps = (int *) ptr;
+	ptr += MAXALIGN((Size) NTS_SHMEM_SLOT_PAGES(npages) * NTS_SHMEM_SLOTS * sizeof(int));
+	nts_shmem_pages = ptr;
+
+	if (!IsUnderPostmaster)
+	{
+		Assert(!found);
+
+		nts_shmem->npages = npages;
+		nts_shmem->slot_pages = NTS_SHMEM_SLOT_PAGES(npages);
+		nts_shmem->first_free = 0;
+		for (i = 0; i < npages; i++)
+			nts_shmem_links[i] = (i + 1 < npages) ? i + 1 : -1;
+
+		for (i = 0; i < NTS_SHMEM_SLOTS; i++)
+		{
+			nts_shmem->slots[i].name[0] = '\0';
+			nts_shmem->slots[i].nblocks = 0;
+		}
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Take a free slot of the pool for the writer of a readerwriter store, with
+ * the page of block 0.  The store is left on the file alone if there is no
+ * free slot or page.
+ */
+static void
+nts_shmem_create_slot(NTupleStore *ts, const char *name)
+{
+	NTupleStorePage *page;
+	int slotn;
+	int pagen = -1;
+
+	Assert(ts->rwflag == NTS_IS_WRITER);
+
+	if (nts_shmem == NULL || strlen(name) >= NTS_SHMEM_NAMELEN)
+		return;
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	for (slotn = 0; slotn < NTS_SHMEM_SLOTS; slotn++)
+	{
+		if (nts_shmem->slots[slotn].name[0] == '\0')
+			break;
+	}
+
+	if (slotn < NTS_SHMEM_SLOTS && nts_shmem->first_free >= 0)
+	{
+		pagen = nts_shmem->first_free;
+		nts_shmem->first_free = nts_shmem_links[pagen];
+
+		strlcpy(nts_shmem->slots[slotn].name, name, NTS_SHMEM_NAMELEN);
+		nts_shmem->slots[slotn].nblocks = 1;
+		NTS_SHMEM_MAP(slotn)[0] = pagen;
+	}
+
+	LWLockRelease(ShareInputShmemLock);
+
+	if (pagen < 0)
+		return;
+
+	/* Until the writer writes block 0, readers find an empty page there */
+	page = (NTupleStorePage *) NTS_SHMEM_PAGE(pagen);
+	init_page(page);
+	nts_page_set_blockn(page, 0);
+	nts_page_set_dirty(page, false);
+
+	ts->shm_slot = slotn;
+	ts->shm_nblocks = 1;
+	ts->shm_full = false;
+	strlcpy(ts->shm_name, name, NTS_SHMEM_NAMELEN);
+}
+
+/*
+ * Find the slot of the pool that the writer of a readerwriter store took.
+ */
+static void
+nts_shmem_attach_slot(NTupleStore *ts, const char *name)
+{
+	int slotn;
+
+	ts->shm_slot = -1;
+	ts->shm_nblocks = 0;
+	ts->shm_full = true;
+
+	if (nts_shmem == NULL || strlen(name) >= NTS_SHMEM_NAMELEN)
+		return;
+
+	LWLockAcquire(ShareInputShmemLock, LW_SHARED);
+
+	for (slotn = 0; slotn < NTS_SHMEM_SLOTS; slotn++)
+	{
+		if (strcmp(nts_shmem->slots[slotn].name, name) == 0)
+		{
+			ts->shm_slot = slotn;
+			ts->shm_nblocks = nts_shmem->slots[slotn].nblocks;
+			strlcpy(ts->shm_name, name, NTS_SHMEM_NAMELEN);
+			break;
+		}
+	}
+
+	LWLockRelease(ShareInputShmemLock);
+}
+
+/*
+ * Return the slot of a writer and its pages to the pool.
+ *
+ * This is also called from an xact end callback, hence it should
+ * not contain any elog(ERROR) calls.
+ */
+static void
+nts_shmem_release_slot(NTupleStore *ts)
+{
+	NTupleStoreShmemSlot *slot = &nts_shmem->slots[ts->shm_slot];
+	int *map = NTS_SHMEM_MAP(ts->shm_slot);
+	int i;
+
+	LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+	for (i = 0; i < slot->nblocks; i++)
+	{
+		nts_shmem_links[map[i]] = nts_shmem->first_free;
+		nts_shmem->first_free = map[i];
+	}
+	slot->nblocks = 0;
+	slot->name[0] = '\0';
+
+	LWLockRelease(ShareInputShmemLock);
+
+	ts->shm_slot = -1;
+	ts->shm_nblocks = 0;
+	ts->shm_full = true;
+}
+
+/*
+ * Copy a block of the store from the pool.
+ */
+static bool
+nts_shmem_read_block(NTupleStore *ts, long blockn, NTupleStorePage *page)
+{
+	NTupleStoreShmemSlot *slot = &nts_shmem->slots[ts->shm_slot];
+	bool found;
+
+	Assert(ts->shm_slot >= 0 && blockn < ts->shm_nblocks);
+
+	/*
+	 * The writer holds on to the slot until all readers are done, unless
+	 * it has failed, in which case the slot may have been taken since.
+	 */
+	LWLockAcquire(ShareInputShmemLock, LW_SHARED);
+
+	found = strcmp(slot->name, ts->shm_name) == 0;
+	if (found)
+		memcpy(page, NTS_SHMEM_PAGE(NTS_SHMEM_MAP(ts->shm_slot)[blockn]), BLCKSZ);
+
+	LWLockRelease(ShareInputShmemLock);
+
+	if (!found)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("shared tuplestore %s is no longer in shared memory", ts->shm_name)));
+
+	Assert(nts_page_blockn(page) == blockn);
+	Assert(!nts_page_is_dirty(page));
+
+	nts_page_set_pin_cnt(page, 0);
+	nts_page_set_prev(page, NULL);
+	nts_page_set_next(page, NULL);
+
+	return true;
+}
+
+/*
+ * Copy a block of the writer to the pool.  Returns false if the block
+ * goes to the file.
+ */
+static bool
+nts_shmem_write_block(NTupleStore *ts, NTupleStorePage *page)
+{
+	NTupleStoreShmemSlot *slot = &nts_shmem->slots[ts->shm_slot];
+	int *map = NTS_SHMEM_MAP(ts->shm_slot);
+	long blockn = nts_page_blockn(page);
+
+	Assert(ts->rwflag == NTS_IS_WRITER);
+
+	if (blockn >= ts->shm_nblocks)
+	{
+		int pagen = -1;
+
+		/* Only the next block can go to the pool, so that the rest follow it in the file */
+		if (!ts->shm_full && blockn == ts->shm_nblocks && blockn < nts_shmem->slot_pages)
+		{
+			LWLockAcquire(ShareInputShmemLock, LW_EXCLUSIVE);
+
+			pagen = nts_shmem->first_free;
+			if (pagen >= 0)
+			{
+				nts_shmem->first_free = nts_shmem_links[pagen];
+				map[blockn] = pagen;
+				slot->nblocks = blockn + 1;
+			}
+
+			LWLockRelease(ShareInputShmemLock);
+		}
+
+		if (pagen < 0)
+		{
+			if (!ts->shm_full)
+			{
+				elog(DEBUG1, "shared tuplestore %s continues in file after %ld blocks in shared memory",
+					 ts->shm_name, ts->shm_nblocks);
+				ts->shm_full = true;
+				ts->first_ondisk_blockn = ts->shm_nblocks;
+			}
+			return false;
+		}
+
+		ts->shm_nblocks = blockn + 1;
+	}
+
+	nts_page_set_dirty(page, false);
+	memcpy(NTS_SHMEM_PAGE(map[blockn]), page, BLCKSZ);
+
+	return true;
+}
+
 /* EOF */
@@ -14,7 +14,9 @@
 #include <sys/stat.h>
 
 #include "utils/workfile_mgr.h"
+#include "lib/stringinfo.h"
 #include "miscadmin.h"
+#include "storage/bfz.h"
 #include "cdb/cdbvars.h"
 #include "nodes/print.h"
 #include "utils/builtins.h"
@@ -291,6 +293,34 @@ create_workset_directory(NodeTag node_type, int slice_id)
 	return final_path;
 }
 
+/*
+ * Determine the bfz compression algorithm for the work files of an operator.
+ */
+static int
+get_operator_compress_type(NodeTag node_type)
+{
+	int compress_type = -1;
+
+	switch (node_type)
+	{
+		case T_HashJoinState:
+			compress_type = gp_workfile_compress_hashjoin;
+			break;
+		case T_AggState:
+			compress_type = gp_workfile_compress_hashagg;
+			break;
+		default:
+			break;
+	}
+
+	if (compress_type < 0)
+	{
+		compress_type = gp_workfile_compress_algorithm;
+	}
+
+	return compress_type;
+}
+
 /*
  * SharedCache callback. Populates a newly acquired workfile_set before
  * returning it to the caller.
@@ -311,12 +341,14 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 	work_set->in_progress_size = 0L;
 	work_set->node_type = set_info->nodeType;
 	work_set->metadata.type = set_info->file_type;
-	work_set->metadata.bfz_compress_type = gp_workfile_compress_algorithm;
+	work_set->metadata.bfz_compress_type = get_operator_compress_type(set_info->nodeType);
 	work_set->metadata.num_leaf_files = 0;
 	work_set->slice_id = currentSliceId;
 	work_set->session_id = gp_session_id;
 	work_set->command_count = gp_command_count;
 	work_set->session_start_time = set_info->session_start_time;
+	MemSet(&work_set->compress_stats, 0, sizeof(work_set->compress_stats));
+	work_set->compress_stats.compress_type = work_set->metadata.bfz_compress_type;
 
 	Assert(strlen(set_info->dir_path) < MAXPGPATH);
 	strncpy(work_set->path, set_info->dir_path, MAXPGPATH);
@@ -470,6 +502,35 @@ workfile_update_in_progress_size(ExecWorkFile *workfile, int64 size)
 	}
 }
 
+/*
+ * Appends the compression statistics of a workfile set to an EXPLAIN ANALYZE
+ * report. Nothing is reported for uncompressed work files.
+ */
+void
+workfile_mgr_explain_compression(workfile_compress_stats *stats, struct StringInfoData *buf)
+{
+	Assert(NULL != stats);
+
+	if (stats->compress_type == 0 || stats->raw_bytes == 0)
+	{
+		return;
+	}
+
+	appendStringInfo(buf,
+			"Work files compressed with %s: " INT64_FORMAT "K bytes stored in "
+			INT64_FORMAT "K bytes (%.1f%%)",
+			bfz_compression_to_string(stats->compress_type),
+			(stats->raw_bytes + 1023) / 1024,
+			(stats->stored_bytes + 1023) / 1024,
+			100.0 * stats->stored_bytes / stats->raw_bytes);
+
+	/* zlib compresses inside its file I/O, so its time is not known */
+	if (stats->secs > 0)
+		appendStringInfo(buf, ", %.3f ms compressing and decompressing",
+						 1000.0 * stats->secs);
+	appendStringInfoString(buf, ".\n");
+}
+
 /*
  * Reports corresponding error message when the query or segment size limit is exceeded.
  */
@@ -15,6 +15,7 @@
 #include "utils/rel.h"
 #include "access/memtup.h"
 #include "executor/tuptable.h"
+#include "utils/timestamp.h"
 
 #define APPENDONLY_COMPACTION_SEGNO_INVALID (-1)
 
@@ -31,6 +32,11 @@ extern bool AppendOnlyCompaction_ShouldCompact(
 	bool isFull);
 extern void AppendOnlyThrowAwayTuple(Relation rel, MemTuple tuple,
 		TupleTableSlot	*slot, MemTupleBinding *mt_bind);
+extern void AppendOnlyCompaction_ReportFinished(Relation aorel,
+		int segno,
+		int64 movedTupleCount,
+		int64 droppedTupleCount,
+		TimestampTz startTime);
 extern void AppendOnlyTruncateToEOF(Relation aorel);
 extern bool HasLockForSegmentFileDrop(Relation aorel);
 extern bool AppendOnlyCompaction_IsRelationEmpty(Relation aorel);
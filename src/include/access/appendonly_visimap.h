@@ -32,6 +32,36 @@
 #define APPENDONLY_VISIMAP_MAX_RANGE 32768
 #define APPENDONLY_VISIMAP_MAX_BITMAP_SIZE 4096
 
+/*
+ * Row number ranges of one segment file that have a visibility map entry,
+ * i.e. at least one hidden row.
+ *
+ * A sequential scan loads them when it moves to the segment file.  Rows of
+ * the other ranges are then known to be visible without looking for an entry
+ * in the visimap relation.
+ */
+typedef struct AppendOnlyVisimapSegmentCache
+{
+	/*
+	 * Segment file the ranges belong to.
+	 * -1 indicates that nothing is cached.
+	 */
+	int32 segmentFileNum;
+
+	/*
+	 * First row numbers of the entries, ascending.
+	 */
+	int64 *entryFirstRowNums;
+	int entryCount;
+
+	/*
+	 * First row number of the range found without entry by the last
+	 * lookup; all its rows are visible.
+	 * -1 indicates not set.
+	 */
+	int64 visibleRangeFirstRowNum;
+} AppendOnlyVisimapSegmentCache;
+
 /*
  * Data structure for the ao visibility map processing.
  *
@@ -57,6 +87,11 @@ typedef struct AppendOnlyVisimap
 	 */ 
 	AppendOnlyVisimapStore visimapStore;	
 
+	/*
+	 * Entry ranges of the segment file being scanned, if any.
+	 */
+	AppendOnlyVisimapSegmentCache segmentCache;
+
 } AppendOnlyVisimap;
 
 /*
@@ -109,6 +144,10 @@ bool AppendOnlyVisimap_IsVisible(
 	AppendOnlyVisimap *visiMap,
 	AOTupleId *tupleId);
 
+void AppendOnlyVisimap_SetSegmentFile(
+	AppendOnlyVisimap *visiMap,
+	int segno);
+
 void AppendOnlyVisimap_Finish(
 	AppendOnlyVisimap *visiMap,
 	LOCKMODE lockmode);
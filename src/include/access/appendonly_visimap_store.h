@@ -84,6 +84,11 @@ int64 AppendOnlyVisimapStore_GetSegmentFileHiddenTupleCount(
 	AppendOnlyVisimapEntry *visiMapEntry,
 	int segno);
 
+int64 *AppendOnlyVisimapStore_GetSegmentFileFirstRowNums(
+	AppendOnlyVisimapStore *visiMapStore,
+	int segno,
+	int *entryCount);
+
 int64 AppendOnlyVisimapStore_GetRelationHiddenTupleCount(
 	AppendOnlyVisimapStore *visiMapStore,
 	AppendOnlyVisimapEntry *visiMapEntry);
@@ -19,11 +19,18 @@
  * Macros to the attribute number for each attribute
  * in the block directory relation.
  */
-#define Natts_pg_aoblkdir              4
+#define Natts_pg_aoblkdir              5
 #define Anum_pg_aoblkdir_segno         1
 #define Anum_pg_aoblkdir_columngroupno 2
 #define Anum_pg_aoblkdir_firstrownum   3
 #define Anum_pg_aoblkdir_minipage      4
+#define Anum_pg_aoblkdir_zonemap       5
+
+/*
+ * Block directory relations created before zone maps were added have no
+ * zonemap column.
+ */
+#define AoBlkdirHasZoneMap(tupdesc) ((tupdesc)->natts >= Anum_pg_aoblkdir_zonemap)
 
 extern void AlterTableCreateAoBlkdirTableWithOid(
 	Oid relOid, Oid newOid, Oid newIndexOid,
@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Thu Apr 14 18:56:55 2016
+   on Mon Oct 19 15:08:10 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -2810,6 +2810,26 @@ DESCR("zlib decompressor");
 DATA(insert OID = 9924 ( gp_zlib_validator  PGNSP PGUID 12 1 0 0 f f f f i 1 0 2278 f "2281" _null_ _null_ _null_ _null_ zlib_validator _null_ _null_ _null_ n ));
 DESCR("zlib compression validator");
 
+/* gp_zstd_constructor(internal, internal, bool) => internal */ 
+DATA(insert OID = 3071 ( gp_zstd_constructor  PGNSP PGUID 12 1 0 0 f f f f v 3 0 2281 f "2281 2281 16" _null_ _null_ _null_ _null_ zstd_constructor _null_ _null_ _null_ n ));
+DESCR("zstd constructor");
+
+/* gp_zstd_destructor(internal) => void */ 
+DATA(insert OID = 3072 ( gp_zstd_destructor  PGNSP PGUID 12 1 0 0 f f f f v 1 0 2278 f "2281" _null_ _null_ _null_ _null_ zstd_destructor _null_ _null_ _null_ n ));
+DESCR("zstd destructor");
+
+/* gp_zstd_compress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 3073 ( gp_zstd_compress  PGNSP PGUID 12 1 0 0 f f f f i 6 0 2278 f "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ zstd_compress _null_ _null_ _null_ n ));
+DESCR("zstd compressor");
+
+/* gp_zstd_decompress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 3074 ( gp_zstd_decompress  PGNSP PGUID 12 1 0 0 f f f f i 6 0 2278 f "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ zstd_decompress _null_ _null_ _null_ n ));
+DESCR("zstd decompressor");
+
+/* gp_zstd_validator(internal) => void */ 
+DATA(insert OID = 3075 ( gp_zstd_validator  PGNSP PGUID 12 1 0 0 f f f f i 1 0 2278 f "2281" _null_ _null_ _null_ _null_ zstd_validator _null_ _null_ _null_ n ));
+DESCR("zstd compression validator");
+
 /* gp_rle_type_constructor(internal, internal, bool) => internal */ 
 DATA(insert OID = 9914 ( gp_rle_type_constructor  PGNSP PGUID 12 1 0 0 f f f f v 3 0 2281 f "2281 2281 16" _null_ _null_ _null_ _null_ rle_type_constructor _null_ _null_ _null_ n ));
 DESCR("Type specific RLE constructor");
@@ -28,6 +28,8 @@
 #include "cdb/cdbappendonlystoragewrite.h"
 #include "utils/datumstream.h"
 
+extern bool gp_aocs_late_materialization;
+
 /*
  * AOCSInsertDescData is used for inserting data into append-only columnar
  * relations. It serves an equivalent purpose as AOCSScanDescData
@@ -63,8 +65,30 @@ typedef struct AOCSInsertDescData
 	 * Certain statistics are then counted differently.
 	 */ 
 	bool update_mode;
+
+	/*
+	 * Rows added with aocs_insert_buffered() that are not yet written to
+	 * the datum streams.  They are kept column by column, so a flush fills
+	 * each column's blocks in one go.  The row numbers of buffered rows
+	 * follow lastSequence.
+	 */
+	MemoryContext batchContext;
+	Datum	  **batchValues;	/* [natts][AOCS_INSERT_BATCH_ROWS] */
+	bool	  **batchNulls;
+	int			batchCount;
+	Size		batchBytes;		/* bytes of by-reference values buffered */
+	bool		batchDisabled;	/* too many other inserts buffer rows */
 } AOCSInsertDescData;
 
+/*
+ * Limits on the rows aocs_insert_buffered() keeps before writing them, and
+ * on the number of inserts of a transaction that buffer rows at once (a
+ * COPY or INSERT into many partitions has an insert for each).
+ */
+#define AOCS_INSERT_BATCH_ROWS	1024
+#define AOCS_INSERT_BATCH_BYTES	(8 * 1024 * 1024)
+#define AOCS_INSERT_BATCH_MAX_INSERTS	8
+
 typedef AOCSInsertDescData *AOCSInsertDesc;
 
 /*
@@ -119,10 +143,58 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Zone maps from the block directory. zoneMapColumn is the column
+	 * whose blocks are skipped by them, or -1; the other columns are
+	 * moved past the rows of the skipped blocks.
+	 */
+	AppendOnlyZoneMapScan zoneMap;
+	int zoneMapColumn;
+
+	/*
+	 * Late materialization: lateProj marks the projected columns that are
+	 * only read for rows that pass lateQual, or is NULL. Late columns are
+	 * positioned by row number, so segment files written before 4.0,
+	 * whose blocks have none, read them eagerly; lateEager is set while
+	 * such a file is scanned.
+	 */
+	bool *lateProj;
+	bool lateEager;
+	List *lateQual;
+	struct ExprContext *lateQualContext;
+
+	/*
+	 * Qualifiers on a single variable-length column that are evaluated
+	 * once per code of its dictionary encoded blocks, or NULL.
+	 */
+	struct AOCSDictionaryQual *dictQual;
+	int ndictQual;
+	struct ExprContext *dictQualContext;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
 
+/*
+ * Result of the qualifiers on one column for each dictionary code of the
+ * column's current block.
+ */
+typedef enum AOCSDictionaryQualResult
+{
+	AOCSDictionaryQual_Unknown = 0,
+	AOCSDictionaryQual_Pass,
+	AOCSDictionaryQual_Fail
+} AOCSDictionaryQualResult;
+
+typedef struct AOCSDictionaryQual
+{
+	int col;
+	List *qual;					/* initialized qualifiers on col only */
+
+	uint32 dictionaryId;		/* dictionary that result belongs to */
+	char result[DATUMSTREAM_DICTIONARY_MAX_COUNT];
+} AOCSDictionaryQual;
+
 /*
  * Used for fetch individual tuples from specified by TID of append only relations
  * using the AO Block Directory.
@@ -204,10 +276,20 @@ extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
+extern void aocs_set_zonemap_qual(AOCSScanDesc scan, List *qual);
+extern void aocs_set_late_qual(AOCSScanDesc scan, bool *qualProj, List *qual,
+							   struct ExprContext *econtext);
+extern void aocs_set_dictionary_qual(AOCSScanDesc scan, List *qual,
+									 struct ExprContext *econtext);
 
 extern void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
+extern void aocs_insert_values_batch(AOCSInsertDesc idesc, int nrows,
+									 Datum **colValues, bool **colNulls,
+									 AOTupleId *aoTupleIds);
+extern Oid aocs_insert_buffered(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
+extern void aocs_insert_flush(AOCSInsertDesc idesc);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 {
 	Oid oid;
@@ -219,7 +301,24 @@ static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
 
 	return oid;
 }
+
+/*
+ * Like aocs_insert(), but the row may be written later, together with the
+ * rows that follow it.  Its TID is final right away.
+ */
+static inline Oid aocs_insert_slot_buffered(AOCSInsertDesc idesc, TupleTableSlot *slot)
+{
+	Oid oid;
+	AOTupleId aotid;
+
+	slot_getallattrs(slot);
+	oid = aocs_insert_buffered(idesc, slot_get_values(slot), slot_get_isnull(slot), &aotid);
+	slot_set_ctid(slot, (ItemPointer)&aotid);
+
+	return oid;
+}
 extern void aocs_insert_finish(AOCSInsertDesc idesc);
+extern void AtEOXact_AOCSInsert(void);
 extern AOCSFetchDesc aocs_fetch_init(Relation relation,
 									 Snapshot snapshot,
 									 Snapshot appendOnlyMetaDataSnapshot,
@@ -212,6 +212,12 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Zone maps from the block directory, used to skip blocks that
+	 * cannot contain rows satisfying the scan's qualifiers.
+	 */
+	AppendOnlyZoneMapScan zoneMap;
+
 }	AppendOnlyScanDescData;
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
@@ -328,6 +334,7 @@ extern AppendOnlyScanDesc appendonly_beginrangescan(Relation relation,
 		int nkeys, ScanKey keys);
 extern void appendonly_rescan(AppendOnlyScanDesc scan, ScanKey key);
 extern void appendonly_endscan(AppendOnlyScanDesc scan);
+extern void appendonly_set_zonemap_qual(AppendOnlyScanDesc scan, List *qual);
 extern MemTuple appendonly_getnext(AppendOnlyScanDesc scan, 
 									ScanDirection direction,
 									TupleTableSlot *slot);
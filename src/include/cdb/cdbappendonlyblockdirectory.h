@@ -17,9 +17,12 @@
 #include "access/aocssegfiles.h"
 #include "access/appendonlytid.h"
 #include "access/skey.h"
+#include "fmgr.h"
 
 extern int gp_blockdirectory_entry_min_range;
 extern int gp_blockdirectory_minipage_size;
+extern int gp_blockdirectory_minipage_cache_size;
+extern bool gp_appendonly_zone_maps;
 
 typedef struct AppendOnlyBlockDirectoryEntry
 {
@@ -61,6 +64,55 @@ typedef struct Minipage
 	MinipageEntry entry[1];
 } Minipage;
 
+/*
+ * The summary of one column over the rows of a minipage entry (a "zone
+ * map" entry): the smallest and largest value, and whether there are NULLs.
+ * Zone maps are only kept for pass-by-value types that have a default btree
+ * opclass, so minValue and maxValue are the Datums themselves.
+ */
+typedef struct ZoneMapEntry
+{
+	int64 minValue;
+	int64 maxValue;
+	int32 flags;
+	int32 pad;
+} ZoneMapEntry;
+
+#define ZONEMAP_VALID		0x01	/* summary covers every row of the entry */
+#define ZONEMAP_HASVALUES	0x02	/* minValue and maxValue are set */
+#define ZONEMAP_HASNULLS	0x04
+
+/*
+ * Define a varlena type for the zone map of a minipage. It is stored
+ * next to the minipage in the block directory relation, with nColumns
+ * entries for each of the nEntry minipage entries: one per attribute for
+ * row-oriented tables, and one for the column group's column for
+ * column-oriented tables.
+ */
+typedef struct ZoneMap
+{
+	/* Total length. Must be the first. */
+	int32 _len;
+	int32 version;
+	int32 nColumns;
+	uint32 nEntry;
+
+	/* Varlena array, entry[entryNo * nColumns + columnNo] */
+	ZoneMapEntry entry[1];
+} ZoneMap;
+
+/*
+ * A minipage kept by a search after another minipage of the column group
+ * was loaded.
+ */
+typedef struct MinipageCacheEntry
+{
+	int segmentFileNum;
+	FileSegInfo *segmentFileInfo;
+	Minipage *minipage;
+	uint32 numMinipageEntries;	/* 0 if the entry is unused */
+} MinipageCacheEntry;
+
 /*
  * Define the relevant info for a minipage for each
  * column group.
@@ -70,6 +122,22 @@ typedef struct MinipagePerColumnGroup
 	Minipage *minipage;
 	uint32 numMinipageEntries;
 	ItemPointerData tupleTid;
+
+	/*
+	 * Minipages a search loaded before the current one, most recently
+	 * used first, followed by the unused entries.
+	 */
+	MinipageCacheEntry *cache;
+	int numCached;
+
+	/*
+	 * Zone map of the minipage when inserting with zone maps, and the
+	 * summary of the values added since the last entry, together with
+	 * the number of values added for each column.
+	 */
+	ZoneMap *zonemap;
+	ZoneMapEntry *blockZone;
+	int64 *blockZoneCount;
 } MinipagePerColumnGroup;
 
 /*
@@ -108,6 +176,13 @@ typedef struct AppendOnlyBlockDirectory
 	 */
 	MinipagePerColumnGroup *minipages;
 
+	/*
+	 * Number of earlier minipages kept per column group by a search, so
+	 * that lookups going back to them do not probe the block directory
+	 * index again.  Always 0 when inserting.
+	 */
+	int minipageCacheSize;
+
 	/*
 	 * Some temporary space to help form tuples to be inserted into
 	 * the block directory, and to help the index scan.
@@ -118,8 +193,59 @@ typedef struct AppendOnlyBlockDirectory
 	ScanKey scanKeys;
 	StrategyNumber *strategyNumbers;
 
+	/*
+	 * Zone maps are kept when inserting, if the block directory relation
+	 * has a column for them and gp_appendonly_zone_maps is on.
+	 * zoneMapCmp[attno] is the btree comparison function of an attribute,
+	 * or NULL if the attribute is not summarized; zoneMapAttnos lists the
+	 * summarized attributes.
+	 */
+	bool keepZoneMaps;
+	int numZoneMapColumns;
+	FmgrInfo **zoneMapCmp;
+	int numZoneMapAttnos;
+	int *zoneMapAttnos;
+
 }	AppendOnlyBlockDirectory;
 
+/*
+ * One zone map entry of a segment file, as loaded for a scan.
+ */
+typedef struct ZoneMapRange
+{
+	int64 firstRowNum;
+	int64 rowCount;
+	int64 fileOffset;
+	ZoneMapEntry zone;
+} ZoneMapRange;
+
+/*
+ * State for skipping blocks of a sequential scan whose zone map shows
+ * that no row can satisfy the scan's simple predicates.
+ */
+typedef struct AppendOnlyZoneMapScan
+{
+	Relation aoRel;
+	Snapshot appendOnlyMetaDataSnapshot;
+	bool isAOCol;
+
+	/*
+	 * The predicates as btree scan keys: sk_attno is the column,
+	 * sk_strategy the operator's btree strategy, sk_argument the
+	 * constant and sk_func the column type's comparison function.
+	 * numKeys is 0 if there is nothing to skip by.
+	 */
+	int numKeys;
+	ScanKey keys;
+
+	/* Zone map of the current segment file, for each key */
+	MemoryContext memoryContext;
+	int *numRanges;
+	ZoneMapRange **ranges;
+
+	int64 blocksSkipped;
+} AppendOnlyZoneMapScan;
+
 
 typedef struct CurrentBlock
 {
@@ -216,6 +342,31 @@ extern void AppendOnlyBlockDirectory_End_forSearch(
 	AppendOnlyBlockDirectory *blockDirectory);
 extern void AppendOnlyBlockDirectory_End_addCol(
 	AppendOnlyBlockDirectory *blockDirectory);
+extern void AppendOnlyBlockDirectory_AddZoneMapValue(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int attno,
+	Datum value,
+	bool isnull);
+extern void AppendOnlyBlockDirectory_InvalidateZoneMap(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo);
+extern void AppendOnlyZoneMap_Init(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	Relation aoRel,
+	Snapshot appendOnlyMetaDataSnapshot,
+	List *qual);
+extern void AppendOnlyZoneMap_SetSegmentFile(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	FileSegInfo *segmentFileInfo);
+extern bool AppendOnlyZoneMap_CanSkipBlock(
+	AppendOnlyZoneMapScan *zoneMapScan,
+	int columnGroupNo,
+	int64 firstRowNum,
+	int64 rowCount,
+	int64 fileOffset);
+extern void AppendOnlyZoneMap_Finish(
+	AppendOnlyZoneMapScan *zoneMapScan);
 extern void AppendOnlyBlockDirectory_DeleteSegmentFile(
 	Relation aoRel,
 		Snapshot snapshot,
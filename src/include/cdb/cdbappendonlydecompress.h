@@ -0,0 +1,105 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbappendonlydecompress.h
+ *	  Decompress Append-Only Storage Blocks ahead of a scan on worker threads.
+ *
+ * A scan that reads compressed blocks in file order submits the blocks
+ * following the current one as soon as their bytes are in memory.  A small
+ * pool of threads, shared by all scans of the backend, decompresses them
+ * while the executor is still busy with the current block.  The scan then
+ * takes each block's content out of the pipeline instead of decompressing
+ * it itself.
+ *
+ * Blocks are identified by their header offset in the segment file, so a
+ * pipeline must be reset when the scan moves on to another file.
+ *
+ * Only codecs whose decompression is thread-safe and needs no backend
+ * services are handled (zlib and zstd).  Everything the worker threads touch
+ * is allocated by the scan beforehand; the threads never palloc or elog.
+ *
+ * Copyright (c) 2007-2009, Greenplum inc
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBAPPENDONLYDECOMPRESS_H
+#define CDBAPPENDONLYDECOMPRESS_H
+
+#include "utils/palloc.h"
+
+typedef struct AppendOnlyDecompressPipeline AppendOnlyDecompressPipeline;
+
+/*
+ * Create a pipeline for blocks compressed with compressType, whose content
+ * is at most maxBufferLen bytes compressed or not.  Up to 'workers' blocks
+ * are decompressed ahead.
+ *
+ * Returns NULL when the compression type is not supported or no worker
+ * thread could be started; the caller then decompresses inline.
+ */
+extern AppendOnlyDecompressPipeline *AppendOnlyDecompressPipeline_Create(
+	MemoryContext		memoryContext,
+	char				*compressType,
+	int32				maxBufferLen,
+	int					workers);
+
+/*
+ * True when the pipeline can take another block.
+ */
+extern bool AppendOnlyDecompressPipeline_HasFreeSlot(
+	AppendOnlyDecompressPipeline	*pipeline);
+
+/*
+ * True when the block at headerOffsetInFile was already submitted.
+ */
+extern bool AppendOnlyDecompressPipeline_HasBlock(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile);
+
+/*
+ * Queue a block for decompression.  The compressed bytes are copied, so the
+ * caller's buffer may be reused right away.
+ *
+ * Returns false when the block was not queued.
+ */
+extern bool AppendOnlyDecompressPipeline_Submit(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile,
+	uint8							*compressed,
+	int32							compressedLen,
+	int32							uncompressedLen);
+
+/*
+ * Copy the decompressed content of the block at headerOffsetInFile to
+ * contentOut, waiting for a worker still busy with it.  Blocks before it
+ * are forgotten.
+ *
+ * Returns false when the pipeline does not have the block decompressed; the
+ * caller must then decompress the block itself.
+ */
+extern bool AppendOnlyDecompressPipeline_Take(
+	AppendOnlyDecompressPipeline	*pipeline,
+	int64							headerOffsetInFile,
+	int32							compressedLen,
+	uint8							*contentOut,
+	int32							uncompressedLen);
+
+/*
+ * Forget all blocks, e.g. when the scan moves to another segment file.
+ */
+extern void AppendOnlyDecompressPipeline_Reset(
+	AppendOnlyDecompressPipeline	*pipeline);
+
+/*
+ * Forget all blocks and free the pipeline.
+ */
+extern void AppendOnlyDecompressPipeline_Free(
+	AppendOnlyDecompressPipeline	*pipeline);
+
+/*
+ * Transaction end hooks; see xact.c.
+ */
+extern void AtEOXact_AppendOnlyDecompress(void);
+extern void AtAbort_AppendOnlyDecompress(void);
+extern void AtSubAbort_AppendOnlyDecompress(SubTransactionId mySubid);
+
+#endif   /* CDBAPPENDONLYDECOMPRESS_H */
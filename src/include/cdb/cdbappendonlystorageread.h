@@ -10,6 +10,7 @@
 #define CDBAPPENDONLYSTORAGEREAD_H
 
 #include "catalog/pg_compression.h"
+#include "cdb/cdbappendonlydecompress.h"
 #include "cdb/cdbappendonlystorage.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbbufferedread.h"
@@ -180,6 +181,13 @@ typedef struct AppendOnlyStorageRead
 	PGFunction       *compression_functions; /* For AO or CO compression funciton pointers.  */
 			/* The array index corresponds to COMP_FUNC_*   */
 
+	AppendOnlyDecompressPipeline *decompressPipeline;
+			/*
+			 * Decompresses the blocks after the current one on worker
+			 * threads.  Created on the first compressed block when
+			 * gp_appendonly_decompress_workers is set, NULL otherwise.
+			 */
+
 
 
 } AppendOnlyStorageRead;
@@ -310,6 +318,14 @@ extern void AppendOnlyStorageRead_SetTemporaryRange(
 	int64						beginFileOffset,
 	int64						afterFileOffset);
 
+/*
+ * Set how many bytes past the current large read the kernel is asked to
+ * read ahead.  Zero disables read-ahead.
+ */
+extern void AppendOnlyStorageRead_SetReadAhead(
+	AppendOnlyStorageRead		*storageRead,
+	int32						readAheadLen);
+
 /*
  * Close the current segment file.
  *
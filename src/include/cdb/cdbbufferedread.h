@@ -72,6 +72,20 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * Read-ahead support.
+	 */
+	int32				readAheadLen;
+	int64				readAheadPosition;
+							/*
+							 * The kernel is asked to start reading up to
+							 * readAheadLen bytes past the current large read, so
+							 * the next large read finds its data in the page cache
+							 * instead of waiting on the disk.  readAheadPosition is
+							 * the end of the range already requested.  Zero
+							 * readAheadLen disables read-ahead.
+							 */
+
 } BufferedRead;
 
 /*
@@ -97,6 +111,15 @@ extern void BufferedReadInit(
     int32                maxLargeReadLen,
     char				 *relationName);
 
+/*
+ * Set the number of bytes to request ahead of the current large read.
+ *
+ * Zero disables read-ahead.  Takes effect with the next large read.
+ */
+extern void BufferedReadSetReadAhead(
+    BufferedRead         *bufferedRead,
+    int32                readAheadLen);
+
 /*
  * Takes an open file handle for the next file.
  */
@@ -163,6 +186,17 @@ uint8 *BufferedReadGrowBuffer(
     int32              newMaxReadAheadLen,
     int32              *growBufferLen);
 
+/*
+ * Look at file data at a position past the current buffer without
+ * consuming it.
+ *
+ * Returns NULL when the position is not within the current large read.
+ */
+extern uint8 *BufferedReadPeek(
+    BufferedRead       *bufferedRead,
+    int64              position,
+    int32              *availableLen);
+
 /*
  * Return the address of the current read buffer.
  */
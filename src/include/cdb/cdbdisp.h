@@ -55,6 +55,7 @@ typedef struct DispatcherInternalFuncs
 	void (*checkResults)(struct CdbDispatcherState *ds, DispatchWaitMode waitMode);
 	void (*dispatchToGang)(struct CdbDispatcherState *ds, struct Gang *gp,
 			int sliceIndex, CdbDispatchDirectDesc *direct);
+	void (*setQueryText)(struct CdbDispatcherState *ds, char *queryText, int queryTextLen);
 }DispatcherInternalFuncs;
 
 #define DISPATCH_WAIT_TIMEOUT_SEC 2
@@ -163,6 +164,18 @@ cdbdisp_makeDispatcherState(CdbDispatcherState *ds,
 							char *queryText,
 							int queryTextLen);
 
+/*
+ * Replace the message that subsequent cdbdisp_dispatchToGang() calls send.
+ * Gangs that have been dispatched to already are not affected.
+ *
+ * The text must stay valid until the dispatcher state is destroyed;
+ * allocate it in ds->dispatchStateContext.
+ */
+void
+cdbdisp_setQueryText(CdbDispatcherState *ds,
+					 char *queryText,
+					 int queryTextLen);
+
 /*
  * Free memory in CdbDispatcherState
  *
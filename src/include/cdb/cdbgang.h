@@ -59,6 +59,8 @@ extern Gang *allocateReaderGang(GangType type, char *portal_name);
 
 extern Gang *allocateWriterGang(void);
 
+extern void prepareReaderGangs(int nreaders);
+
 extern List *getCdbProcessList(Gang *gang, int sliceIndex, struct DirectDispatchInfo *directDispatch);
 
 extern bool gangOK(Gang *gp);
@@ -14,4 +14,6 @@
 
 extern CreateGangFunc pCreateGangFuncAsync;
 
+extern List *createReaderGangs_async(int first_gang_id, int ngangs);
+
 #endif
@@ -130,6 +130,17 @@ extern ReceiveReturnCode RecvTupleFrom(MotionLayerState *mlStates,
 									   HeapTuple *tup_i,
 									   int16 srcRoute);
 
+/* Receive a run of tuples from one sender of an order-preserving motion node.
+ * Blocks for the first tuple only; the rest are tuples that have already been
+ * reassembled.  Returns the number of tuples received, 0 at end-of-stream.
+ */
+extern int RecvTupleBatchFrom(MotionLayerState *mlStates,
+							  ChunkTransportState *transportStates,
+							  int16 motNodeID,
+							  HeapTuple *tuples,
+							  int maxTuples,
+							  int16 srcRoute);
+
 extern void SendStopMessage(MotionLayerState *mlStates,
 							ChunkTransportState *transportStates,
 							int16 motNodeID);
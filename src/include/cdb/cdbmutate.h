@@ -32,6 +32,8 @@ extern Motion *make_explicit_motion(Plan *lefttree, AttrNumber segidColIdx, bool
 void 
 cdbmutate_warn_ctid_without_segid(struct PlannerInfo *root, struct RelOptInfo *rel);
 
+extern Oid motion_hash_datatype(Oid typeoid);
+
 extern void add_slice_to_motion(Motion *m,
 		MotionType motionType, List *hashExpr, 
 		int numOutputSegs, int *outputSegIdx 
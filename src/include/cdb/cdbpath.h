@@ -33,6 +33,12 @@ cdbpath_motion_for_join(PlannerInfo    *root,
                         bool            outer_require_existing_order,
                         bool            inner_require_existing_order);
 
+bool
+cdbpath_skew_spread_join(PlannerInfo   *root,
+                         JoinType       jointype,
+                         Path          *outer_path,
+                         Path          *inner_path);
+
 void 
 cdbpath_dedup_fixup(PlannerInfo *root, Path *path);
 
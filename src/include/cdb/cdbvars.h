@@ -158,6 +158,13 @@ extern int qdPostmasterPort;
 /*How many gangs to keep around from stmt to stmt.*/
 extern int			gp_cached_gang_threshold;
 
+/*
+ * How many idle reader gangs the QD keeps connected ahead of need, so that
+ * statements with several slices don't wait for gang setup.  Capped at
+ * gp_cached_gang_threshold.
+ */
+extern int			gp_prewarm_gang_count;
+
 /*
  * gp_reject_percent_threshold
  *
@@ -558,6 +565,13 @@ extern bool gp_enable_fast_sri;
 /* Enable single-mirror pair dispatch. */
 extern bool gp_enable_direct_dispatch;
 
+/*
+ * Send each dispatched slice a copy of the plan in which the subtrees of
+ * other slices are cut off below their Motion nodes, instead of the whole
+ * plan to every slice.
+ */
+extern bool gp_enable_slice_plan_dispatch;
+
 /* Name of pseudo-function to access any table as if it was randomly distributed. */
 #define GP_DIST_RANDOM_NAME "GP_DIST_RANDOM"
 
@@ -640,6 +654,22 @@ extern int      gp_segments_for_planner;
  */
 extern bool gp_enable_multiphase_agg;
 
+/*
+ * "gp_enable_skew_spreading"
+ *
+ * When set, a hash join whose inputs are both redistributed on a single
+ * join column spreads the outer rows of that column's most common values
+ * over all segments, and broadcasts the inner rows with those values.
+ *
+ * "gp_skew_hotkey_factor"
+ *
+ * A most common value is treated as hot when its frequency times the
+ * number of segments is at least this factor, i.e. at 1.0 a key is hot
+ * once it alone would fill one segment's fair share of the rows.
+ */
+extern bool gp_enable_skew_spreading;
+extern double gp_skew_hotkey_factor;
+
 /*
  * Perform a post-planning scan of the final plan looking for motion deadlocks:
  * emit verbose messages about any found.
@@ -893,6 +923,12 @@ extern double gp_hashagg_rewrite_limit;
 /* If we use two stage hashagg, we can stream the bottom half */
 extern bool gp_hashagg_streambottom;
 
+/* When a pass of a streamed bottom hashagg produces at least this many groups
+ * per input row, the rest of the input is passed through without grouping.
+ * 0 disables this.
+ */
+extern double gp_hashagg_passthrough_ratio;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -901,6 +937,18 @@ extern int gp_hashagg_default_nbatches;
 /* Hashjoin use bloom filter */
 extern int gp_hashjoin_bloomfilter;
 
+/* Hashjoin pushes a filter of its inner join keys down to outer scans */
+extern bool gp_hashjoin_runtime_filter;
+
+/* LIMIT sort pushes a filter of its cut-off sort key down to its input scan */
+extern bool gp_sort_limit_filter;
+
+/* Hashjoin lays out large in-memory hash tables in bucket order */
+extern bool gp_hashjoin_cluster_tuples;
+
+/* Hashjoin builds the table of a spilled batch from its smaller side */
+extern bool gp_hashjoin_reverse_batches;
+
 /* Get statistics for partitioned parent from a child */
 extern bool 	gp_statistics_pullup_from_child_partition;
 
@@ -949,6 +997,8 @@ extern const char *gpvars_show_gp_gpperfmon_log_alert_level(void);
 
 extern int gp_hashagg_compress_spill_files;
 extern int gp_workfile_compress_algorithm;
+extern int gp_workfile_compress_hashjoin;
+extern int gp_workfile_compress_hashagg;
 extern bool gp_workfile_checksumming;
 extern double gp_workfile_limit_per_segment;
 extern double gp_workfile_limit_per_query;
@@ -957,6 +1007,8 @@ extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
 extern bool gp_workfile_faultinject;
 extern int gp_workfile_bytes_to_checksum;
+/* Shared memory for cross-slice shared Materialize results, in kilobytes */
+extern int gp_shareinput_shmem_size;
 /* The type of work files that HashJoin should use */
 extern int gp_workfile_type_hashjoin;
 
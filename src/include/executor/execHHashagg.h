@@ -40,7 +40,6 @@ typedef struct BatchFileInfo BatchFileInfo;
  */
 typedef struct HashAggEntry
 {
-	struct HashAggEntry	   *next; /* Next entry in chain. */
 	void *tuple_and_aggs; /* point to a chunk that contains both grouping keys
 						   * and aggregate values.
 						   */
@@ -161,9 +160,30 @@ typedef struct HashAggTable
 	/* Hash table */
 	MemoryContext   entry_cxt;	/* memory context for hash table entries */
 
-	unsigned nbuckets;
-	HashAggEntry  **buckets;
-	uint64 *bloom;
+	/*
+	 * The table is open-addressed: an entry lives in the first slot with
+	 * room, in probe order, of the groups of HHA_GROUP_SLOTS slots that
+	 * follow its home group.  A one-byte tag per slot (0 when empty,
+	 * otherwise 7 bits of the hash value with the high bit set) lets a
+	 * probe check a whole group with a single 64-bit word comparison,
+	 * before looking at any entry.  The table doubles when it is
+	 * HHA_MAX_FILL_PERCENT full, as long as memory allows.
+	 *
+	 * When all the grouping columns are passed by value, their values are
+	 * also kept in keys/keynulls, numCols per slot, so that comparing
+	 * grouping keys does not need to deform the entry's tuple.
+	 */
+	unsigned nbuckets;		/* number of slots, a power of 2 */
+	unsigned bucket_shift;	/* 32 - log2(nbuckets) */
+	unsigned nused;			/* number of occupied slots */
+	uint8 *tags;
+	HashAggEntry  **buckets;	/* entry in each occupied slot */
+	Datum *keys;			/* grouping keys of each slot, or NULL */
+	bool *keynulls;
+
+	/* Grouping keys of the record being looked up */
+	Datum *input_keys;
+	bool *input_keynulls;
 
 	/* Overflow batches */
 	SpillSet       *spill_set;
@@ -192,7 +212,6 @@ typedef struct HashAggTable
 
 	/* Variables during iteration */
 	int curr_bucket_idx;
-	HashAggEntry *next_entry;
 
 	/* buffer for calculating the hashkey */
 	HashKey *hashkey_buf;
@@ -208,12 +227,14 @@ typedef struct HashAggTable
 	uint32 num_reloads; /* number of times reloading a batch file */
 	uint32 num_batches; /* number of batch files */
 	uint64 num_tuples; /* Total input tuples so far*/
+	uint64 num_pass_start_tuples; /* num_tuples when the streaming pass began */
 	uint64 num_output_groups; /* Total output groups */
 	uint64 num_ht_groups; /* number of groups in the hash table */
 	uint64 num_spill_groups; /* number of spilled groups */
 	uint32 num_overflows; /* number of times hash table overflows */
 	uint64 total_buckets; /* total number of buckets allocated */
 	bool is_spilling; /* indicate that spilling happened for this batch. */
+	bool is_passthrough; /* streaming input rows one group each */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
     CdbExplain_Agg      chainlength;
 } HashAggTable;
@@ -22,6 +22,7 @@
 
 #include "cdb/cdbdef.h"                 /* CdbVisitOpt */
 
+struct AppendOnlyZoneMapScan;           /* #include "cdb/cdbappendonlyblockdirectory.h" */
 struct ChunkTransportState;             /* #include "cdb/cdbinterconnect.h" */
 
 /*
@@ -339,6 +340,8 @@ extern TupleTableSlot *AppendOnlyScanNext(ScanState *scanState);
 extern void BeginScanAppendOnlyRelation(ScanState *scanState);
 extern void EndScanAppendOnlyRelation(ScanState *scanState);
 extern void ReScanAppendOnlyRelation(ScanState *scanState);
+extern void ExplainZoneMapScan(ScanState *scanState,
+				   struct AppendOnlyZoneMapScan *zoneMapScan);
 
 /*
  * prototypes from functions in execAOCSScan.c
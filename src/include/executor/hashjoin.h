@@ -78,6 +78,27 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MemTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * Once the tuples of a batch take more than HJ_CLUSTER_MIN_SPACE, they are
+ * copied in bucket order into chunks of HJ_CLUSTER_CHUNK_SIZE bytes; see
+ * ExecHashTableCluster.
+ */
+#define HJ_CLUSTER_MIN_SPACE	(4 * 1024 * 1024)
+#define HJ_CLUSTER_CHUNK_SIZE	(1024 * 1024)
+
+/*
+ * Ask the CPU to start loading the cache line at addr, which need not be
+ * a valid address.
+ */
+#if defined(__GNUC__)
+#define HJ_PREFETCH(addr)		__builtin_prefetch(addr)
+#else
+#define HJ_PREFETCH(addr)		((void) 0)
+#endif
+
+/* How many buckets ahead to prefetch when walking the bucket array */
+#define HJ_PREFETCH_DISTANCE	8
+
 
 /* Statistics collection workareas for EXPLAIN ANALYZE */
 typedef struct HashJoinBatchStats
@@ -105,6 +126,11 @@ typedef struct HashJoinTableStats
     int                     nonemptybatches;    /* num of nontrivial batches */
     Size                    workmem_max;        /* work_mem high water mark */
     CdbExplain_Agg          chainlength;        /* hash chain length stats */
+    int                     reversedbatches;    /* num of batches built from
+                                                 * the outer side */
+
+    /* Workfile compression stats, saved when the workfile set is closed */
+    workfile_compress_stats compress_stats;
 } HashJoinTableStats;
 
 
@@ -123,6 +149,7 @@ typedef struct HashJoinBatchSide
 	 */
 	ExecWorkFile *workfile;
 	int total_tuples;
+	int64 total_bytes;			/* size of the tuples written */
 } HashJoinBatchSide;
 
 
@@ -156,6 +183,8 @@ typedef struct HashJoinTableData
 
 	int			nbatch;			/* number of batches */
 	int			curbatch;		/* current batch #; 0 during 1st pass */
+	bool		reversed;		/* hash table of current batch holds outer
+								 * tuples, and inner tuples probe it */
 
 	int			nbatch_original;	/* nbatch when we started inner scan */
 	int			nbatch_outstart;	/* nbatch when we started outer scan */
@@ -193,4 +222,72 @@ typedef struct HashJoinTableData
 
 } HashJoinTableData;
 
+/*
+ * Runtime join filter.
+ *
+ * An inner or IN hash join collects the hash values of its inner tuples
+ * while building the hash table, and turns them into a Bloom filter once
+ * the inner side is complete.  The scans on the outer side of the join,
+ * in the same slice, check the outer join keys of each scanned tuple
+ * against the filter and drop tuples that cannot find a match, before
+ * projecting them and passing them up through other joins.
+ *
+ * For a single integer join key, the range of the inner keys is kept too.
+ *
+ * Until the filter is ready (e.g. while the hash join fetches its first
+ * outer tuple before building), every tuple passes.
+ *
+ * The filter's memory is charged to the Hash node, and taken out of the
+ * operator memory the hash table may use.
+ */
+typedef struct HashJoinRuntimeFilter
+{
+	int			nkeys;
+	FmgrInfo   *outer_hashfunctions;	/* same as the hash table's */
+	bool	   *hashStrict;
+
+	/* Building: hash values of the inner tuples so far */
+	MemoryContext mcxt;
+	uint32	   *hashvalues;
+	int			nhashvalues;
+	int			maxhashvalues;
+	bool		overflowed;		/* too many inner tuples to be useful */
+	Size		space;			/* bytes taken from the hash table's spaceAllowed */
+
+	/* Ready: the Bloom filter */
+	bool		ready;
+	uint64	   *bits;
+	uint32		bitmask;		/* number of bits - 1 */
+
+	/* Range of a single integer key, or rangeKey is NULL */
+	ExprState  *rangeKey;		/* inner key expression */
+	Oid			innerRangeType;
+	Oid			outerRangeType;
+	bool		rangeEmpty;
+	int64		rangeMin;
+	int64		rangeMax;
+
+	/*
+	 * A filter that rejects too few of the first outer tuples after a build
+	 * is disabled until the next build.
+	 */
+	bool		disabled;
+	double		samplechecked;
+	double		samplerejected;
+
+	/* Statistics, for EXPLAIN ANALYZE and the debug message at the end */
+	double		nchecked;
+	double		nrejected;
+} HashJoinRuntimeFilter;
+
+/*
+ * A runtime filter as checked by one scan: the attributes of the scan
+ * tuple that hold the outer join keys.
+ */
+typedef struct HashJoinRuntimeFilterProbe
+{
+	HashJoinRuntimeFilter *filter;
+	AttrNumber *attnos;			/* [filter->nkeys] */
+} HashJoinRuntimeFilterProbe;
+
 #endif   /* HASHJOIN_H */
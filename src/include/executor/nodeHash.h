@@ -42,12 +42,21 @@ extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 						  uint32 hashvalue,
 						  int *bucketno,
 						  int *batchno);
+extern void ExecHashTableInsertReversed(HashState *hashState,
+						   HashJoinTable hashtable,
+						   TupleTableSlot *slot,
+						   uint32 hashvalue);
 extern HashJoinTuple ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
 				   ExprContext *econtext);
 extern void ExecHashTableReset(HashState *hashState, HashJoinTable hashtable);
+extern void ExecHashTableCluster(HashState *hashState, HashJoinTable hashtable);
 extern void ExecHashTableExplainInit(HashState *hashState, HashJoinState *hjstate,
                                      HashJoinTable  hashtable);
 extern void ExecHashTableExplainBatchEnd(HashState *hashState, HashJoinTable hashtable);
+extern bool ExecHashRuntimeFilterPasses(HashJoinRuntimeFilterProbe *probe,
+							ExprContext *econtext,
+							struct TupleTableSlot *slot);
+extern void ExecHashRuntimeFilterReport(HashJoinRuntimeFilter *filter);
 
 enum 
 {
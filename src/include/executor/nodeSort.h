@@ -16,6 +16,32 @@
 
 #include "nodes/execnodes.h"
 
+/*
+ * LIMIT sort filter.
+ *
+ * A sort that only keeps the first N tuples of its input knows, once it
+ * has seen N tuples, that any input tuple sorting after the last of the
+ * ones it keeps can not make the cut.  When the sort reads directly from a
+ * scan, the scan checks the first sort key of each tuple against that of
+ * the last kept tuple and skips the tuples that sort after it, before
+ * projecting them and copying them into the sort.
+ *
+ * Tuples whose key, or the key they are checked against, is NULL always
+ * pass.
+ */
+typedef struct SortLimitFilter
+{
+	SortState  *sortstate;
+	AttrNumber	sortAttno;		/* first sort key in the sort's input */
+	AttrNumber	scanAttno;		/* first sort key in the scan tuple */
+	FmgrInfo	cmpfunc;		/* btree comparison function of the key */
+	bool		reverse;		/* descending sort order? */
+
+	/* Statistics, for the debug message at the end */
+	double		nchecked;
+	double		nrejected;
+} SortLimitFilter;
+
 extern int	ExecCountSlotsSort(Sort *node);
 extern SortState *ExecInitSort(Sort *node, EState *estate, int eflags);
 extern struct TupleTableSlot *ExecSort(SortState *node);
@@ -24,6 +50,9 @@ extern void ExecSortMarkPos(SortState *node);
 extern void ExecSortRestrPos(SortState *node);
 extern void ExecReScanSort(SortState *node, ExprContext *exprCtxt);
 extern void ExecEagerFreeSort(SortState *node);
+extern bool ExecSortLimitFilterPasses(SortLimitFilter *filter,
+						  ExprContext *econtext,
+						  struct TupleTableSlot *slot);
 
 enum
 {
@@ -1645,6 +1645,18 @@ typedef struct ScanState
 
 	/* The type of the table that is being scanned */
 	TableType	tableType;
+
+	/*
+	 * Runtime filters pushed down by hash joins above the scan (list of
+	 * HashJoinRuntimeFilterProbe).  Tuples that fail one are skipped.
+	 */
+	List	   *ss_runtimeFilters;
+
+	/*
+	 * Filter pushed down by a LIMIT sort directly above the scan, or NULL.
+	 * Tuples that sort after the ones the sort already keeps are skipped.
+	 */
+	struct SortLimitFilter *ss_sortLimitFilter;
 } ScanState;
 
 /*
@@ -2233,6 +2245,9 @@ typedef struct HashJoinState
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
+
+	/* CDB: filter built from the inner side for outer scans, or NULL */
+	struct HashJoinRuntimeFilter *hj_RuntimeFilter;
 } HashJoinState;
 
 
@@ -2330,6 +2345,8 @@ typedef struct SortState
 
 	void	   *share_lk_ctxt;
 
+	/* CDB: filter for the input scan of a LIMIT sort, or NULL */
+	struct SortLimitFilter *limitFilter;
 } SortState;
 
 /* ---------------------
@@ -2484,6 +2501,7 @@ typedef struct HashState
 	bool		hs_quit_if_hashkeys_null;	/* quit building hash table if hashkeys are all null */
 	bool		hs_hashkeys_null;	/* found an instance wherein hashkeys are all null */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+	struct HashJoinRuntimeFilter *hs_runtimeFilter;	/* parent's runtime filter */
 } HashState;
 
 /* ----------------
@@ -2624,6 +2642,9 @@ typedef struct MotionState
 	bool		sentEndOfStream;	/* set when end-of-stream has successfully been sent */
 	List	   *hashExpr;		/* state struct used for evaluating the hash expressions */
 	struct CdbHash *cdbhash;	/* hash api object */
+	uint32	   *hotHashes;		/* sorted copy of the plan's hotHashes */
+	int			numHotHashes;	/* number of entries in hotHashes */
+	uint32		hotSpreadNext;	/* next route for MOTIONSKEW_SPREAD */
 
 	/* For Motion recv */
 	void	   *tupleheap;		/* data structure for match merge in sorted motion node */
@@ -1068,6 +1068,18 @@ typedef enum MotionType
 	MOTIONTYPE_EXPLICIT		/* Send tuples to the segment explicitly specified in their segid column */
 } MotionType;
 
+/*
+ * How a hash Motion treats tuples whose hash key is one of its hotHashes.
+ * Used in pairs below a hash join to avoid a single hot join key landing
+ * all of its probe rows on one segment.
+ */
+typedef enum MotionSkewType
+{
+	MOTIONSKEW_NONE,		/* hot keys are hashed like any other key */
+	MOTIONSKEW_SPREAD,		/* send hot-key tuples round robin to all segments */
+	MOTIONSKEW_BROADCAST	/* send hot-key tuples to every segment */
+} MotionSkewType;
+
 /*
  * Motion Node
  *
@@ -1083,6 +1095,9 @@ typedef struct Motion
 	/* For Hash */
 	List		*hashExpr;			/* list of hash expressions */
 	List		*hashDataTypes;	    /* list of hash expr data type oids */
+	MotionSkewType skewType;		/* how to route hot keys */
+	List		*hotHashes;			/* integer list of cdbhash values (before
+									 * reduction) of the hot keys */
 
 	/* Output segments */
 	int 	  	numOutputSegs;		/* number of seg indexes in outputSegIdx array, 0 for broadcast */
@@ -981,6 +981,8 @@ typedef struct CdbMotionPath
 {
 	Path		path;
     Path	   *subpath;
+    MotionSkewType skewType;    /* CDB: hot key routing of a hash motion */
+    List       *hotHashes;      /* CDB: cdbhash values of the hot keys */
 } CdbMotionPath;
 
 /*
@@ -59,17 +59,30 @@ typedef struct bfz
 	int64 numBlocks;
 	int64 blockNo;
 	int64 chosenBlockNo;
+
+	/*
+	 * Compression statistics: the bytes appended and the bytes they took
+	 * on disk, known once bfz_append_end is called, and the time spent in
+	 * the compressor and decompressor themselves.  Only algorithms that
+	 * compress separately from their I/O ("lz") can tell that time apart;
+	 * for the others it stays 0.
+	 */
+	int64 rawBytes;
+	int64 storedBytes;
+	double compressSecs;
 }	bfz_t;
 
 /* These functions are internal to bfz. */
 extern void bfz_nothing_init(bfz_t * thiz);
 extern void bfz_zlib_init(bfz_t * thiz);
 extern void bfz_lzop_init(bfz_t * thiz);
+extern void bfz_lz_init(bfz_t * thiz);
 extern void bfz_write_ex(bfz_t * thiz, const char *buffer, int size);
 extern int	bfz_read_ex(bfz_t * thiz, char *buffer, int size);
 
 /* These functions are interface to bfz. */
 extern int	bfz_string_to_compression(const char *string);
+extern const char *bfz_compression_to_string(int compress);
 
 extern bfz_t *bfz_create(const char *filePrefix, bool delOnClose, int compress);
 extern bfz_t *bfz_open(const char *fileName, bool delOnClose, int compress);
@@ -77,6 +77,7 @@ OpenNamedFile(const char   *fileName,
 
 extern void FileClose(File file);
 extern int	FileRead(File file, char *buffer, int amount);
+extern int	FilePrefetch(File file, int64 offset, int amount);
 extern int	FileWrite(File file, char *buffer, int amount);
 extern int	FileSync(File file);
 extern int64 FileSeek(File file, int64 offset, int whence);
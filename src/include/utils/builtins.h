@@ -1223,6 +1223,12 @@ extern Datum zlib_compress(PG_FUNCTION_ARGS);
 extern Datum zlib_decompress(PG_FUNCTION_ARGS);
 extern Datum zlib_validator(PG_FUNCTION_ARGS);
 
+extern Datum zstd_constructor(PG_FUNCTION_ARGS);
+extern Datum zstd_destructor(PG_FUNCTION_ARGS);
+extern Datum zstd_compress(PG_FUNCTION_ARGS);
+extern Datum zstd_decompress(PG_FUNCTION_ARGS);
+extern Datum zstd_validator(PG_FUNCTION_ARGS);
+
 extern Datum rle_type_constructor(PG_FUNCTION_ARGS);
 extern Datum rle_type_destructor(PG_FUNCTION_ARGS);
 extern Datum rle_type_compress(PG_FUNCTION_ARGS);
@@ -30,6 +30,8 @@
 /*	UNDONE: For now, just do Small Content */
 #define MAXDATUM_PER_AOCS_DENSE_BLOCK AONonBulkDenseContentHeader_MaxLargeRowCount
 
+extern bool gp_aocs_dictionary_encoding;
+
 typedef struct DatumStreamWrite
 {
 	DatumStreamTypeInfo typeInfo;
@@ -219,6 +221,19 @@ datumstreamread_nth(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Dictionary code of the current (non-NULL) datum, or -1 when its block is
+ * not dictionary encoded.  See DatumStreamBlockRead_DictionaryCode.
+ */
+inline static int
+datumstreamread_dictionary_code(DatumStreamRead * acc, uint32 * dictionaryId)
+{
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None)
+		return -1;
+
+	return DatumStreamBlockRead_DictionaryCode(&acc->blockRead, dictionaryId);
+}
+
 /* ------------------------------------------------------------------------------ */
 
 extern int datumstreamwrite_put(
@@ -276,6 +291,7 @@ extern void destroy_datumstreamread(DatumStreamRead * ds);
 extern int64 datumstreamwrite_block(DatumStreamWrite * ds);
 extern int64 datumstreamwrite_lob(DatumStreamWrite * ds, Datum d);
 extern int	datumstreamread_block(DatumStreamRead * ds);
+extern int	datumstreamread_block_header(DatumStreamRead * ds);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
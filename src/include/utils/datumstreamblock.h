@@ -27,6 +27,14 @@ typedef enum DatumStreamVersion
 	MaxDatumStreamVersion		/* must always be last */
 }	DatumStreamVersion;
 
+/*
+ * Block header version of dictionary encoded Original blocks.  Streams are
+ * still DatumStreamVersion_Original; only their dictionary encoded blocks
+ * carry this version, so that readers that predate dictionary encoding
+ * reject them as a bad block version rather than misreading them.
+ */
+#define DatumStreamBlockVersion_Original_Dictionary 3
+
 /*
  * Datum Stream Block (Original).
  * 16 bytes header.  Followed by data.
@@ -138,14 +146,50 @@ typedef struct DatumStreamBlock_Delta_Extension
 }	DatumStreamBlock_Delta_Extension;
 
 
+/*
+ * Datum Stream Block extension to DatumStreamBlock_Orig with a dictionary.
+ * 8 bytes more, at the start of the (MAXALIGN) datum area.
+ *
+ * A dictionary encoded block stores each distinct variable-length item of
+ * the block once, followed by one byte per physical datum holding the
+ * index of its value in the dictionary.  The header sz covers this
+ * extension, the dictionary and the codes.
+ */
+typedef struct DatumStreamBlock_Dictionary_Extension
+{
+	int32		dictionary_count;
+	/*
+	 * Number of distinct items in the dictionary.  At most
+	 * DATUMSTREAM_DICTIONARY_MAX_COUNT.
+	 */
+
+	int32		dictionary_size;
+	/*
+	 * Total size of the dictionary items, including their zero padding.
+	 * The codes follow right after.
+	 */
+}	DatumStreamBlock_Dictionary_Extension;
+
+/* Codes are one byte. */
+#define DATUMSTREAM_DICTIONARY_MAX_COUNT 256
+
+/* Open addressing table used to find the distinct items when writing. */
+#define DATUMSTREAM_DICTIONARY_HASH_SIZE (4 * DATUMSTREAM_DICTIONARY_MAX_COUNT)
+
 /* Flags */
 enum
 {
 	DSB_HAS_NULLBITMAP = 0x1,
 	DSB_HAS_RLE_COMPRESSION = 0x2,
 	DSB_HAS_DELTA_COMPRESSION = 0x4,
+	DSB_HAS_DICTIONARY = 0x8,	/* Original blocks only */
 };
 
+/* All the flags a reader knows; blocks with other flags are rejected */
+#define DSB_KNOWN_FLAGS_ORIG (DSB_HAS_NULLBITMAP | DSB_HAS_DICTIONARY)
+#define DSB_KNOWN_FLAGS_DENSE \
+	(DSB_HAS_NULLBITMAP | DSB_HAS_RLE_COMPRESSION | DSB_HAS_DELTA_COMPRESSION)
+
 typedef struct DatumStreamBitMapWrite
 {
 	uint8	   *buffer;
@@ -1012,6 +1056,21 @@ typedef struct DatumStreamBlockWrite
 	bool	   *delta_sign;
 	int32		deltas_maxcount;
 
+	/*
+	 * Dictionary encoding (Original variable-length items only).  The
+	 * items are put as usual and the block is re-encoded when it is
+	 * formatted, if its distinct items are few enough to make it smaller.
+	 */
+	bool		dictionary_want_encoding;
+
+	uint8	   *dictionary_buffer;
+	int32		dictionary_buffer_size;
+
+	uint8	  **dictionary_items;
+	int32	   *dictionary_item_sizes;
+	int16	   *dictionary_hash;
+	uint8	   *dictionary_codes;
+
 	/* EOF of current file */
 	int64		savings;
 	int64		remember_savings;
@@ -1094,6 +1153,17 @@ typedef struct DatumStreamBlockRead
 	bool		delta_block_was_compressed;
 	DatumStreamBitMapRead delta_bitmap;
 
+	/*
+	 * Dictionary variables.  dictionary_count is 0 unless the current block
+	 * is dictionary encoded.  dictionary_id is different for every
+	 * dictionary read, so callers can tell when codes they remember become
+	 * stale.
+	 */
+	int32		dictionary_count;
+	uint8	  **dictionary_items;
+	uint8	   *dictionary_codesp;
+	uint32		dictionary_id;
+
 	/*
 	 * Keep less frequently accessed fields down here for possible better CPU data cache
 	 * performance.
@@ -1417,6 +1487,16 @@ DatumStreamBlockRead_AdvanceOrig(DatumStreamBlockRead * dsr)
 	++dsr->physical_datum_index;
 	//Initially, -1.
 
+	if (dsr->dictionary_count > 0)
+	{
+		/*
+		 * Dictionary encoded block: the item is the dictionary entry of its
+		 * code.
+		 */
+		dsr->datump = dsr->dictionary_items[dsr->dictionary_codesp[dsr->physical_datum_index]];
+		return 1;
+	}
+
 		if (dsr->physical_datum_index == 0)
 	{
 		/* Pre-positioned by block read to first item. */
@@ -1872,6 +1952,16 @@ DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 	++dsr->physical_datum_index;
 	//Initially, -1.
 
+	if (dsr->dictionary_count > 0)
+	{
+		/*
+		 * Dictionary encoded block: the item is the dictionary entry of its
+		 * code.
+		 */
+		dsr->datump = dsr->dictionary_items[dsr->dictionary_codesp[dsr->physical_datum_index]];
+		return 1;
+	}
+
 		if (dsr->physical_datum_index == 0)
 	{
 		/* Pre-positioned by block read to first item. */
@@ -2013,6 +2103,23 @@ DatumStreamBlockRead_Nth(DatumStreamBlockRead * dsr)
 	return dsr->nth;
 }
 
+/*
+ * Dictionary code of the current item, or -1 when its block is not
+ * dictionary encoded.  Must not be called for a NULL item.  Items of the
+ * same block with the same code are equal; *dictionaryId identifies the
+ * block's dictionary.
+ */
+inline static int
+DatumStreamBlockRead_DictionaryCode(DatumStreamBlockRead * dsr, uint32 * dictionaryId)
+{
+	if (dsr->dictionary_count == 0)
+		return -1;
+
+	Assert(dsr->physical_datum_index >= 0);
+	*dictionaryId = dsr->dictionary_id;
+	return dsr->dictionary_codesp[dsr->physical_datum_index];
+}
+
 extern void DatumStreamBlockRead_GetReadyOrig(
 								  DatumStreamBlockRead * dsr,
 								  uint8 * buffer,
@@ -2103,6 +2210,7 @@ extern void DatumStreamBlockWrite_Init(
 						   DatumStreamVersion datumStreamVersion,
 						   bool rle_want_compression,
 						   bool delta_want_compression,
+						   bool dictionary_want_encoding,
 						   int32 initialMaxDatumPerBlock,
 						   int32 maxDatumPerBlock,
 						   int32 maxDataBlockSize,
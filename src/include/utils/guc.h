@@ -184,6 +184,16 @@ extern bool gp_appendonly_compaction;
  * 10% of the tuples are hidden.
  */ 
 extern int  gp_appendonly_compaction_threshold;
+
+/*
+ * Total read-ahead, in kB, requested by one scan of an append-only table.
+ * A column-oriented scan divides it among the columns it reads.
+ */
+extern int  gp_appendonly_read_ahead;
+/*
+ * Number of threads that decompress append-only blocks ahead of a scan.
+ */
+extern int  gp_appendonly_decompress_workers;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	Debug_appendonly_rezero_quicklz_compress_scratch;
 extern bool	Debug_appendonly_rezero_quicklz_decompress_scratch;
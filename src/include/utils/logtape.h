@@ -46,6 +46,7 @@ extern void LogicalTapeWrite(LogicalTapeSet *lts, LogicalTape *lt, void *ptr, si
 extern void LogicalTapeFlush(LogicalTapeSet *lts, LogicalTape *lt, ExecWorkFile *pstatefile);
 extern void LogicalTapeRewind(LogicalTapeSet *lts, LogicalTape *lt, bool forWrite);
 extern void LogicalTapeFreeze(LogicalTapeSet *lts, LogicalTape *lt);
+extern void LogicalTapeSetReadAhead(LogicalTapeSet *lts, LogicalTape *lt, int nblocks);
 extern bool LogicalTapeBackspace(LogicalTapeSet *lts, LogicalTape *lt, size_t size);
 extern bool LogicalTapeSeek(LogicalTapeSet *lts, LogicalTape *lt, LogicalTapePos *pos); 
 extern void LogicalTapeTell(LogicalTapeSet *lts, LogicalTape *lt, LogicalTapePos *pos);
@@ -107,6 +107,8 @@ extern void cdb_tuplesort_init_mk(Tuplesortstate_mk *state,
 
 extern void tuplesort_set_bound(Tuplesortstate *state, int64 bound);
 extern void tuplesort_set_bound_mk(Tuplesortstate_mk *state, int64 bound);
+extern bool tuplesort_limit_threshold_mk(Tuplesortstate_mk *state,
+							 AttrNumber attno, Datum *value, bool *isnull);
 
 extern void tuplesort_puttupleslot(Tuplesortstate *state, TupleTableSlot *slot);
 extern void tuplesort_puttupleslot_mk(Tuplesortstate_mk *state, TupleTableSlot *slot);
@@ -34,6 +34,10 @@ extern void ntuplestore_flush(NTupleStore *ts);
 extern void ntuplestore_destroy(NTupleStore *ts);
 extern void ntuplestore_trim(NTupleStore* ts, NTupleStorePos *pos);
 
+/* Shared memory pool of readerwriter stores */
+extern Size ntuplestore_shmem_size(void);
+extern void ntuplestore_shmem_init(void);
+
 /* Tuple store accessor method 
  * Create Accessor: current we support 1 writer, many reader per store.  After created, the accessor
  * is positioned at the first tuple or eof (if there is no tuple).
@@ -56,6 +56,20 @@ typedef struct
 
 } workfile_set_op_metadata;
 
+/* Compression statistics of the closed bfz files of a workfile set */
+typedef struct workfile_compress_stats
+{
+	/* bfz compression algorithm of the files */
+	int compress_type;
+
+	/* bytes written to the files, and the bytes they took on disk */
+	int64 raw_bytes;
+	int64 stored_bytes;
+
+	/* seconds spent compressing and decompressing, 0 if not measured */
+	double secs;
+} workfile_compress_stats;
+
 typedef uint32 workfile_set_hashkey_t;
 
 typedef struct workfile_set
@@ -94,6 +108,9 @@ typedef struct workfile_set
 	/* Operator-specific metadata */
 	workfile_set_op_metadata metadata;
 
+	/* Compression statistics, for EXPLAIN ANALYZE */
+	workfile_compress_stats compress_stats;
+
 } workfile_set;
 
 /* The key for an entry stored in the Queryspace Hashtable */
@@ -135,6 +152,8 @@ void workfile_mgr_mark_complete(workfile_set *work_set);
 Cache *workfile_mgr_get_cache(void);
 int32 workfile_mgr_clear_cache(int seg_id);
 void workfile_update_in_progress_size(ExecWorkFile *workfile, int64 size);
+void workfile_mgr_explain_compression(workfile_compress_stats *stats,
+		struct StringInfoData *buf);
 
 /* Workfile File operations */
 ExecWorkFile *workfile_mgr_create_file(workfile_set *work_set);
@@ -0,0 +1,283 @@
+#!/usr/bin/env python
+"""
+icbench -- Interconnect load generator for Greenplum Database
+
+Usage: icbench.py [options]
+
+Drives the motion layer (SendTuple/RecvTupleFrom in cdbmotion.c) of a
+running cluster with queries whose cost is dominated by tuple transport,
+and reports throughput and latency for each configuration.
+
+    -d dbname        : database to run in [default: $PGDATABASE]
+    -h host          : master host [default: $PGHOST]
+    -p port          : master port [default: $PGPORT]
+    -m mode          : gather, sorted-gather or redistribute. May be given
+                       more than once [default: all three]
+    -w width[,...]   : payload width(s) in bytes [default: 16,256,4096]
+    -r rows          : rows in the source table [default: 1000000]
+    -s senders       : only send the rows of segments 0..senders-1. The
+                       other segments still take part in the motion with
+                       no rows, so the fan-in and fan-out stay the number
+                       of segments [default: all]
+    -n iterations    : timed runs per configuration [default: 5]
+    --drop-percent N : synthetically drop N percent of received data
+                       packets (gp_udpic_dropxmit_percent, assert builds)
+    --drop-seg N     : only drop packets on segment N (gp_udpic_dropseg)
+    --set GUC=VALUE  : extra setting applied before each run, e.g.
+                       --set gp_interconnect_snd_queue_depth=4. May be
+                       given more than once.
+    --ic-stats       : collect packet and retransmit counts from the
+                       "Interconnect State" log lines (requires superuser,
+                       uses gp_toolkit.gp_log_system)
+    --keep           : do not drop the benchmark table when done
+    -?               : print this help text
+
+Each configuration runs in its own psql session. Latency percentiles are
+computed over the per-query wall clock times reported by psql \\timing,
+so they include dispatch and gang setup; compare configurations rather
+than reading absolute numbers.
+"""
+
+import getopt
+import os
+import re
+import subprocess
+import sys
+
+TABLE = 'icbench_src'
+MODES = ('gather', 'sorted-gather', 'redistribute')
+
+TIME_RE = re.compile(r'^Time: ([0-9.]+) ms', re.MULTILINE)
+STATS_RE = re.compile(r'snd_pkt_count (\d+) retransmits (\d+) crc_errors (\d+)'
+                      r' recv_pkt_count (\d+)')
+
+
+class Options(object):
+    def __init__(self):
+        self.dbname = None
+        self.host = None
+        self.port = None
+        self.modes = []
+        self.widths = [16, 256, 4096]
+        self.rows = 1000000
+        self.senders = None
+        self.iterations = 5
+        self.drop_percent = 0
+        self.drop_seg = None
+        self.settings = []
+        self.ic_stats = False
+        self.keep = False
+
+
+def usage(msg=None):
+    if msg:
+        sys.stderr.write('icbench: %s\n' % msg)
+    sys.stderr.write(__doc__)
+    sys.exit(msg and 2 or 0)
+
+
+def parse_args(argv):
+    opt = Options()
+    try:
+        pairs, rest = getopt.getopt(argv, 'd:h:p:m:w:r:s:n:?',
+                                    ['drop-percent=', 'drop-seg=', 'set=',
+                                     'ic-stats', 'keep', 'help'])
+    except getopt.GetoptError as e:
+        usage(str(e))
+    if rest:
+        usage('unexpected argument: %s' % rest[0])
+
+    for (k, v) in pairs:
+        if k == '-d':
+            opt.dbname = v
+        elif k == '-h':
+            opt.host = v
+        elif k == '-p':
+            opt.port = v
+        elif k == '-m':
+            if v not in MODES:
+                usage('unknown mode: %s' % v)
+            opt.modes.append(v)
+        elif k == '-w':
+            opt.widths = [int(x) for x in v.split(',')]
+        elif k == '-r':
+            opt.rows = int(v)
+        elif k == '-s':
+            opt.senders = int(v)
+        elif k == '-n':
+            opt.iterations = int(v)
+        elif k == '--drop-percent':
+            opt.drop_percent = int(v)
+        elif k == '--drop-seg':
+            opt.drop_seg = int(v)
+        elif k == '--set':
+            if '=' not in v:
+                usage('--set expects GUC=VALUE')
+            opt.settings.append(v.split('=', 1))
+        elif k == '--ic-stats':
+            opt.ic_stats = True
+        elif k == '--keep':
+            opt.keep = True
+        else:
+            usage()
+
+    if not opt.modes:
+        opt.modes = list(MODES)
+    if opt.iterations < 1:
+        usage('-n must be at least 1')
+    return opt
+
+
+def psql(opt, script):
+    """Run a script through psql and return its stdout."""
+    cmd = ['psql', '-X', '-q', '-A', '-t', '-v', 'ON_ERROR_STOP=1']
+    if opt.dbname:
+        cmd += ['-d', opt.dbname]
+    if opt.host:
+        cmd += ['-h', opt.host]
+    if opt.port:
+        cmd += ['-p', opt.port]
+    p = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, universal_newlines=True)
+    out, err = p.communicate(script)
+    if p.returncode != 0:
+        sys.stderr.write(err)
+        raise SystemExit('icbench: psql failed')
+    return out
+
+
+def setup(opt, width):
+    """
+    (Re)create the source table. Distributing by seq spreads rows evenly and
+    keeps k independent of the distribution key, so grouping by k has to
+    redistribute.
+    """
+    psql(opt, """
+SET gp_autostats_mode = none;
+DROP TABLE IF EXISTS %(t)s;
+CREATE TABLE %(t)s (seq int8, k int4, payload text) DISTRIBUTED BY (seq);
+INSERT INTO %(t)s
+    SELECT i, i %% 10007, repeat('x', %(w)d)
+    FROM generate_series(1, %(r)d) i;
+ANALYZE %(t)s;
+""" % {'t': TABLE, 'w': width, 'r': opt.rows})
+
+    where = sender_filter(opt)
+    out = psql(opt, 'SELECT count(*) FROM %s %s;' % (TABLE, where))
+    return int(out.strip())
+
+
+def sender_filter(opt):
+    """
+    Rows of the first opt.senders segments only. This filters rows, not
+    segments: the scan and the sending motion still run everywhere.
+    """
+    if opt.senders is None:
+        return ''
+    return 'WHERE gp_segment_id < %d' % opt.senders
+
+
+def query_for(opt, mode):
+    where = sender_filter(opt)
+    if mode == 'gather':
+        return 'SELECT seq, k, payload FROM %s %s;' % (TABLE, where)
+    if mode == 'sorted-gather':
+        return 'SELECT seq, k, payload FROM %s %s ORDER BY seq;' % (TABLE, where)
+    # Single-phase aggregation ships every row through the redistribute
+    # motion before grouping; only the tiny result goes through the gather.
+    return ('SELECT count(*) FROM (SELECT k, sum(length(payload)) FROM %s %s '
+            'GROUP BY k) s;' % (TABLE, where))
+
+
+def session_settings(opt):
+    lines = ['SET optimizer = off;',
+             'SET gp_enable_multiphase_agg = off;']
+    if opt.drop_percent:
+        lines.append('SET gp_udpic_dropxmit_percent = %d;' % opt.drop_percent)
+    if opt.drop_seg is not None:
+        lines.append('SET gp_udpic_dropseg = %d;' % opt.drop_seg)
+    if opt.ic_stats:
+        lines.append('SET gp_interconnect_log_stats = on;')
+    for (k, v) in opt.settings:
+        lines.append('SET %s = %s;' % (k, v))
+    return '\n'.join(lines)
+
+
+def run_mode(opt, mode):
+    """Run one configuration; returns (list of ms, session id)."""
+    script = [session_settings(opt),
+              'SELECT current_setting(\'gp_session_id\');',
+              '\\o /dev/null',
+              # warm-up run, not timed: allocates the gangs
+              query_for(opt, mode),
+              '\\timing on']
+    script += [query_for(opt, mode)] * opt.iterations
+    out = psql(opt, '\n'.join(script) + '\n')
+
+    session = out.strip().splitlines()[0].strip()
+    times = [float(t) for t in TIME_RE.findall(out)]
+    if len(times) != opt.iterations:
+        raise SystemExit('icbench: expected %d timings, got %d'
+                         % (opt.iterations, len(times)))
+    return times, session
+
+
+def ic_counters(opt, session):
+    """Sum packet counters logged by every QE of the given session."""
+    out = psql(opt, """
+SELECT logmessage FROM gp_toolkit.gp_log_system
+WHERE logsession = 'con%s' AND logmessage LIKE 'Interconnect State:%%';
+""" % session)
+    sent = retrans = crc = recv = 0
+    for m in STATS_RE.finditer(out):
+        sent += int(m.group(1))
+        retrans += int(m.group(2))
+        crc += int(m.group(3))
+        recv += int(m.group(4))
+    return sent, retrans, crc, recv
+
+
+def percentile(sorted_vals, pct):
+    if not sorted_vals:
+        return 0.0
+    idx = int(round((pct / 100.0) * (len(sorted_vals) - 1)))
+    return sorted_vals[idx]
+
+
+def report(opt, mode, width, rows, times, counters):
+    times = sorted(times)
+    mean_s = sum(times) / len(times) / 1000.0
+    tps = rows / mean_s if mean_s > 0 else 0.0
+    mbps = rows * (width + 12) / mean_s / (1024 * 1024) if mean_s > 0 else 0.0
+
+    line = ('%-14s width %6d  rows %10d  %12.0f tuples/s  %9.2f MB/s  '
+            'p50 %9.1f ms  p90 %9.1f ms  p99 %9.1f ms'
+            % (mode, width, rows, tps, mbps,
+               percentile(times, 50), percentile(times, 90),
+               percentile(times, 99)))
+    if counters is not None:
+        line += ('  pkts %d/%d  retransmits %d  crc_errors %d'
+                 % (counters[0], counters[3], counters[1], counters[2]))
+    print(line)
+    sys.stdout.flush()
+
+
+def main(argv):
+    opt = parse_args(argv)
+
+    try:
+        for width in opt.widths:
+            rows = setup(opt, width)
+            for mode in opt.modes:
+                times, session = run_mode(opt, mode)
+                counters = None
+                if opt.ic_stats:
+                    counters = ic_counters(opt, session)
+                report(opt, mode, width, rows, times, counters)
+    finally:
+        if not opt.keep:
+            psql(opt, 'DROP TABLE IF EXISTS %s;' % TABLE)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -1,5 +1,53 @@
 -- Misc tests related to dispatching queries to segments.
 
+-- Test that gp_prewarm_segworkers keeps idle reader gangs around. This has
+-- to run first in the session, before any reader gangs have been cached.
+-- Each segment counts the backends of this session: the writer gang QE,
+-- plus one QE for every idle reader gang.
+create function dispatch_count_session_qes(int) returns bigint as
+  'select count(*) from pg_stat_activity where sess_id = $1' language sql;
+
+select distinct dispatch_count_session_qes(current_setting('gp_session_id')::int)
+from gp_dist_random('gp_id');
+
+set gp_prewarm_segworkers = 3;
+select distinct dispatch_count_session_qes(current_setting('gp_session_id')::int)
+from gp_dist_random('gp_id');
+reset gp_prewarm_segworkers;
+
+drop function dispatch_count_session_qes(int);
+
+-- Test dispatching each slice only the part of the plan it runs.
+set gp_enable_slice_plan_dispatch = on;
+create table slice_disp_a (a int, b int) distributed by (a);
+create table slice_disp_b (a int, b int) distributed by (a);
+insert into slice_disp_a select i, i % 10 from generate_series(1, 100) i;
+insert into slice_disp_b select i, i % 10 from generate_series(1, 100) i;
+
+-- redistribute on both sides, and a gather on top
+select count(*) from slice_disp_a x join slice_disp_b y on x.b = y.b;
+-- sorted gather of a multi-slice plan
+select x.b, count(*) from slice_disp_a x join slice_disp_b y on x.b = y.a
+  group by x.b order by x.b;
+-- correlated subplan and initplan, each with motions of their own
+select count(*) from slice_disp_a x
+  where x.b in (select y.b from slice_disp_b y where y.a > x.a);
+select count(*) from slice_disp_a x
+  where x.a > (select avg(y.b) from slice_disp_b y);
+-- writer slice below a redistribute
+insert into slice_disp_a select b, a from slice_disp_b;
+select count(*), sum(a), sum(b) from slice_disp_a;
+
+-- the join slice receives from the other one and gets its subtree cut off;
+-- the sending slice runs below the join slice and needs the plan above it
+set test_print_slice_plan_dispatch_info = on;
+select count(*) from slice_disp_a x join slice_disp_b y on x.a = y.b;
+reset test_print_slice_plan_dispatch_info;
+
+drop table slice_disp_a;
+drop table slice_disp_b;
+reset gp_enable_slice_plan_dispatch;
+
 -- Test quoting of GUC values and databse names when they're sent to segments
 
 -- There used to be a bug in the quoting when the search_path setting was sent
@@ -42,3 +42,16 @@ insert into tbl_b values (1, 50), (1, 100), (1, 150), (2, 200), (4, 400);
 select tbl_a.id, median (t) from tbl_a, tbl_b
 where tbl_a.id = tbl_b.id and tbl_a.id = 1::int4
 group by tbl_a.id ;
+
+-- A streamed bottom stage that hardly reduces its input stops grouping and
+-- passes the rest of its rows through; the results must not change.
+create table hashagg_passthrough (a int, b int, c int) distributed by (a);
+insert into hashagg_passthrough select i, i % 50000, 1 from generate_series(1, 100000) i;
+set gp_hashagg_streambottom=on;
+set statement_mem='1000kB';
+set gp_hashagg_passthrough_ratio=0.1;
+select count(*), sum(s), sum(m) from (select b, sum(c) s, max(a) m from hashagg_passthrough group by b) t;
+set gp_hashagg_passthrough_ratio=0;
+select count(*), sum(s), sum(m) from (select b, sum(c) s, max(a) m from hashagg_passthrough group by b) t;
+reset gp_hashagg_passthrough_ratio;
+reset statement_mem;
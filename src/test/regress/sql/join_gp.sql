@@ -127,5 +127,132 @@ select enable_xform('CXformLeftAntiSemiJoinNotIn2HashJoinNotIn');
 select enable_xform('CXformLeftOuterJoin2HashJoin');
 select enable_xform('CXformLeftSemiJoin2HashJoin');
 
+--
+-- Hot key spreading in redistributed hash joins. 70% of the rows of
+-- skew_fact have cust = 0; the results must not change when those rows are
+-- spread and the matching skew_dim rows broadcast.
+--
+create table skew_fact (id int, cust int) distributed by (id);
+create table skew_dim (id int, cust int) distributed by (id);
+insert into skew_fact select i, case when i % 10 < 7 then 0 else i end from generate_series(1, 1000) i;
+insert into skew_dim select i, i % 50 from generate_series(1, 1000) i;
+analyze skew_fact;
+analyze skew_dim;
+set gp_enable_skew_spreading = on;
+select count(*) from skew_fact f join skew_dim d on f.cust = d.cust;
+select count(*) from skew_fact f left join skew_dim d on f.cust = d.cust;
+select count(*) from skew_fact f where f.cust in (select cust from skew_dim);
+select count(*) from skew_fact f where not exists (select 1 from skew_dim d where d.cust = f.cust);
+
+-- The plan must spread the hot key. Planning for many segments makes
+-- redistributing both sides cheaper than broadcasting either.
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+create or replace function join_gp_count_plan_lines(explain_query text, search_text text) returns int as
+$$
+rv = plpy.execute(explain_query)
+result = 0
+for i in range(len(rv)):
+    if search_text in rv[i]['QUERY PLAN']:
+        result = result + 1
+return result
+$$
+language plpythonu;
+set gp_segments_for_planner = 40;
+select join_gp_count_plan_lines('explain select count(*) from skew_fact f join skew_dim d on f.cust = d.cust', 'Hot Keys: 1 spread') as spread,
+       join_gp_count_plan_lines('explain select count(*) from skew_fact f join skew_dim d on f.cust = d.cust', 'Hot Keys: 1 broadcast') as broadcast;
+reset gp_segments_for_planner;
+reset gp_enable_skew_spreading;
+
+--
+-- Runtime join filters. The scans of rf_fact skip rows that have no match in
+-- the dimension tables; the results must not change when they do.
+--
+create table rf_fact (id int, d1 int, d2 bigint, v int) with (appendonly=true, orientation=column) distributed by (id);
+create table rf_dim1 (d1 int, name text) distributed by (d1);
+create table rf_dim2 (d2 int, name text) distributed by (d2);
+insert into rf_fact select i, i % 100, i % 30, i from generate_series(1, 3000) i;
+insert into rf_dim1 select i, 'd1_' || i from generate_series(10, 19) i;
+insert into rf_dim2 select i, 'd2_' || i from generate_series(0, 29, 3) i;
+analyze rf_fact;
+analyze rf_dim1;
+analyze rf_dim2;
+set gp_hashjoin_runtime_filter = on;
+select count(*), sum(f.v) from rf_fact f join rf_dim1 a on f.d1 = a.d1 join rf_dim2 b on f.d2 = b.d2;
+select count(*), sum(f.v) from rf_fact f where f.d1 in (select d1 from rf_dim1);
+set gp_hashjoin_runtime_filter = off;
+select count(*), sum(f.v) from rf_fact f join rf_dim1 a on f.d1 = a.d1 join rf_dim2 b on f.d2 = b.d2;
+select count(*), sum(f.v) from rf_fact f where f.d1 in (select d1 from rf_dim1);
+reset gp_hashjoin_runtime_filter;
+-- EXPLAIN ANALYZE reports how many outer rows the filter rejected. A filter
+-- that rejects almost none of the first outer rows is disabled.
+set gp_hashjoin_runtime_filter = on;
+select join_gp_count_plan_lines('explain analyze select count(*) from rf_fact f join rf_dim1 a on f.d1 = a.d1', 'Runtime filter rejected') as reported,
+       join_gp_count_plan_lines('explain analyze select count(*) from rf_fact f join rf_dim1 a on f.d1 = a.d1', 'Runtime filter rejected 0 of') as none_rejected;
+create table rf_big (id int, d1 int) distributed by (id);
+create table rf_dimall (d1 int, name text) distributed by (d1);
+insert into rf_big select i, i % 100 from generate_series(1, 30000) i;
+insert into rf_dimall select i, 'all_' || i from generate_series(0, 99) i;
+analyze rf_big;
+analyze rf_dimall;
+select join_gp_count_plan_lines('explain analyze select count(*) from rf_big f join rf_dimall a on f.d1 = a.d1', 'then was disabled') as disabled;
+select count(*) from rf_big f join rf_dimall a on f.d1 = a.d1;
+reset gp_hashjoin_runtime_filter;
+drop table rf_big;
+drop table rf_dimall;
+
+--
+-- Reversed hash join batches. rb_outer is analyzed before most of its rows
+-- are deleted, so the planner hashes rb_inner, which is larger. The batches
+-- that spill are built from their outer side; the results must not change.
+--
+create table rb_outer (a int, pad text) distributed by (a);
+create table rb_inner (a int, pad text) distributed by (a);
+insert into rb_outer select i, repeat('x', 100) from generate_series(1, 100000) i;
+insert into rb_inner select i % 5000, repeat('y', 100) from generate_series(1, 20000) i;
+analyze rb_outer;
+analyze rb_inner;
+delete from rb_outer where a > 3000;
+set statement_mem = '1MB';
+set gp_hashjoin_reverse_batches = on;
+select count(*), sum(o.a) from rb_outer o join rb_inner i on o.a = i.a;
+select count(*), sum(o.a) from rb_outer o left join rb_inner i on o.a = i.a;
+set gp_hashjoin_reverse_batches = off;
+select count(*), sum(o.a) from rb_outer o join rb_inner i on o.a = i.a;
+reset gp_hashjoin_reverse_batches;
+reset statement_mem;
+
+--
+-- Spilled hash join batches compressed with lz. The results must not
+-- change, and EXPLAIN ANALYZE reports the compression.
+--
+create or replace function join_gp_workfile_compression(explain_query text) returns setof text as
+$$
+import re
+rv = plpy.execute(explain_query)
+result = []
+for i in range(len(rv)):
+    line = rv[i]['QUERY PLAN']
+    if 'Work files compressed' in line:
+        result.append(re.sub(r'[0-9][0-9.]*', 'N', line.strip()))
+return result
+$$
+language plpythonu;
+create table wc_outer (a int, pad text) distributed by (a);
+create table wc_inner (a int, pad text) distributed by (a);
+insert into wc_outer select i, repeat('x', 100) from generate_series(1, 50000) i;
+insert into wc_inner select i % 50000, repeat('y', 200) from generate_series(1, 100000) i;
+analyze wc_outer;
+analyze wc_inner;
+set statement_mem = '1MB';
+set gp_workfile_compress_hashjoin = 'lz';
+select count(*), sum(o.a) from wc_outer o join wc_inner i on o.a = i.a;
+select join_gp_workfile_compression('explain analyze select count(*), sum(o.a) from wc_outer o join wc_inner i on o.a = i.a') as compression;
+set gp_workfile_compress_hashjoin = 'none';
+select count(*), sum(o.a) from wc_outer o join wc_inner i on o.a = i.a;
+reset gp_workfile_compress_hashjoin;
+reset statement_mem;
+
 set client_min_messages='warning'; -- silence drop-cascade NOTICEs
 drop schema pred cascade;
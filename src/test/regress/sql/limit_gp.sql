@@ -28,6 +28,17 @@ SELECT dkey, substring(tval from 1 for 2) as str  from (SELECT * from mksort_lim
 
 DROP TABLE  mksort_limit_test_table;
 
+-- LIMIT sorts filter their input scan by the sort key of the last tuple
+-- that makes the cut.  Check that no tuple of the result is lost.
+CREATE TABLE sort_limit_filter_test (a int, b int, c text) DISTRIBUTED BY (a);
+INSERT INTO sort_limit_filter_test SELECT i, (i * 7919) % 1000, 'x' || i FROM generate_series(1, 10000) i;
+INSERT INTO sort_limit_filter_test VALUES (10001, NULL, 'null');
+SELECT b, count(*) FROM (SELECT b FROM sort_limit_filter_test ORDER BY b LIMIT 25) t GROUP BY b ORDER BY b;
+SELECT b, count(*) FROM (SELECT b FROM sort_limit_filter_test ORDER BY b DESC LIMIT 12) t GROUP BY b ORDER BY b;
+SELECT a, b FROM sort_limit_filter_test ORDER BY b, a LIMIT 3 OFFSET 995;
+SELECT c FROM sort_limit_filter_test ORDER BY c LIMIT 3;
+DROP TABLE sort_limit_filter_test;
+
 -- Check invalid things in LIMIT
 
 select * from generate_series(1,10) g limit g;
@@ -1631,3 +1631,33 @@ FROM
   GROUP BY name,device_model
   HAVING COUNT(DISTINCT CASE WHEN ppp > 0 THEN device_id ELSE NULL END)>0
 ) b;
+
+-- Moving min() and max() frames, compared with the same values computed
+-- by a join
+create table olap_window_slide (p int, i int, v int) distributed by (p);
+insert into olap_window_slide
+  select i % 3, i, case when i % 7 = 0 then null else (i * 37) % 101 end
+  from generate_series(1, 600) i;
+select count(*)
+from
+(
+  select i,
+    max(v) over (partition by p order by i rows between 3 preceding and 1 following) as mx,
+    min(v) over (partition by p order by i rows between 2 following and 5 following) as mn,
+    max(v::numeric) over (partition by p order by i range between 4 preceding and current row) as mxn
+  from olap_window_slide
+) w
+join
+(
+  select a.i,
+    max(case when b.i between a.i - 9 and a.i + 3 then b.v end) as mx,
+    min(case when b.i between a.i + 6 and a.i + 15 then b.v end) as mn,
+    max(case when b.i between a.i - 4 and a.i then b.v::numeric end) as mxn
+  from olap_window_slide a join olap_window_slide b on a.p = b.p
+  group by a.i
+) s
+on w.i = s.i
+where w.mx is not distinct from s.mx
+  and w.mn is not distinct from s.mn
+  and w.mxn is not distinct from s.mxn;
+drop table olap_window_slide;
@@ -0,0 +1,22 @@
+--
+-- zstd compression for append-only tables.
+--
+-- Builds without zstd support reject compresstype=zstd; their results are
+-- in zstd_compression_1.out.
+--
+create table zstd_ao (a int, b text) with (appendonly=true, compresstype=zstd, compresslevel=1) distributed by (a);
+insert into zstd_ao select i, repeat('abc', i % 50) || i from generate_series(1, 10000) i;
+select count(*), sum(a), sum(length(b)) from zstd_ao;
+select a, b from zstd_ao where a in (1, 51, 100) order by a;
+
+create table zstd_aocs (a int, b text) with (appendonly=true, orientation=column, compresstype=zstd, compresslevel=19) distributed by (a);
+insert into zstd_aocs select i, repeat('abc', i % 50) || i from generate_series(1, 10000) i;
+select count(*), sum(a), sum(length(b)) from zstd_aocs;
+select a, b from zstd_aocs where a in (1, 51, 100) order by a;
+
+-- compresslevel must be between 1 and 19
+create table zstd_bad (a int) with (appendonly=true, compresstype=zstd, compresslevel=20) distributed by (a);
+create table zstd_bad (a int) with (appendonly=true, orientation=column, compresstype=zstd, compresslevel=20) distributed by (a);
+
+drop table zstd_ao;
+drop table zstd_aocs;